@@ -0,0 +1,234 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bench.h"
+
+
+/**
+ * _bench_thread_t
+ *
+ * The state of each thread started by bench_run.
+ *
+ */
+typedef struct _bench_thread_t
+{
+	pthread_t thread;
+	pthread_barrier_t * barrier;
+	bench_function_t function;
+	void * context;
+	double start;
+	double end;
+} _bench_thread_t;
+
+
+/**
+ * _benchmarks
+ *
+ * Every benchmark, by the name it is selected with on the command line.
+ *
+ */
+static const struct
+{
+	const char * name;
+	void ( * run )( void );
+}
+_benchmarks[] =
+{
+	{ "concurrent", bench_concurrent },
+	{ "pool", bench_pool },
+	{ "std", bench_std_allocator },
+	{ "stream", bench_stream },
+	{ "tlsf", bench_tlsf }
+};
+
+#define _BENCH_NUM_BENCHMARKS ( sizeof( _benchmarks ) / sizeof( _benchmarks[ 0 ] ) )
+
+
+/**
+ * _bench_start
+ *
+ * Waits for every other thread to be ready, then runs the thread's function,
+ * recording when it started and finished.
+ *
+ */
+static void * _bench_start( void * context )
+{
+	_bench_thread_t * thread = ( _bench_thread_t * ) context;
+	pthread_barrier_wait( thread->barrier );
+	thread->start = bench_now( );
+	thread->function( thread->context );
+	thread->end = bench_now( );
+	return 0;
+}
+
+
+/**
+ * _bench_compare
+ *
+ * qsort comparison of two doubles.
+ *
+ */
+static int _bench_compare( const void * a, const void * b )
+{
+	double x = *( ( const double * ) a ), y = *( ( const double * ) b );
+	return x < y ? -1 : x > y;
+}
+
+
+/**
+ * bench_now
+ *
+ * Returns the time of a monotonic clock, in seconds.
+ *
+ */
+double bench_now( void )
+{
+	struct timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return ( double ) now.tv_sec + ( double ) now.tv_nsec * 1e-9;
+}
+
+
+/**
+ * bench_run
+ *
+ * Runs the given function on the given number of threads at once, returning the
+ * time taken by all of them.
+ *
+ */
+double bench_run( size_t num_threads, bench_function_t function, void * contexts, size_t context_size )
+{
+	_bench_thread_t threads[ BENCH_MAX_THREADS ];
+	pthread_barrier_t barrier;
+	double start, end;
+	size_t i;
+
+	if ( num_threads > BENCH_MAX_THREADS )
+	{
+		num_threads = BENCH_MAX_THREADS;
+	}
+
+	/* Every thread waits for the others to be created before starting, and times
+	 * itself - the calling thread may not run again until they have all finished */
+	pthread_barrier_init( &barrier, 0, ( unsigned ) num_threads );
+	for ( i = 0; i < num_threads; ++i )
+	{
+		threads[ i ].barrier = &barrier;
+		threads[ i ].function = function;
+		threads[ i ].context = ( char * ) contexts + i * context_size;
+		pthread_create( &threads[ i ].thread, 0, _bench_start, &threads[ i ] );
+	}
+
+	for ( i = 0, start = end = 0.0; i < num_threads; ++i )
+	{
+		pthread_join( threads[ i ].thread, 0 );
+		if ( i == 0 || threads[ i ].start < start )
+		{
+			start = threads[ i ].start;
+		}
+		if ( i == 0 || threads[ i ].end > end )
+		{
+			end = threads[ i ].end;
+		}
+	}
+
+	pthread_barrier_destroy( &barrier );
+	return end - start;
+}
+
+
+/**
+ * bench_report
+ *
+ * Prints a line of results for the given benchmark and variant.
+ *
+ */
+void bench_report( const char * name, const char * variant, size_t num_threads, size_t operations, double seconds )
+{
+	printf(
+		"%-12s %-24s %3lu threads %10.1f ns/op %10.2f Mops/s\n",
+		name,
+		variant,
+		( unsigned long ) num_threads,
+		operations ? seconds * 1e9 / ( double ) operations : 0.0,
+		seconds > 0.0 ? ( double ) operations / seconds * 1e-6 : 0.0
+	);
+}
+
+
+/**
+ * bench_report_latency
+ *
+ * Prints the median, 99th percentile and maximum of the given latencies.
+ *
+ */
+void bench_report_latency( const char * name, const char * variant, const char * operation, double * samples, size_t count )
+{
+	if ( !count )
+	{
+		return;
+	}
+
+	qsort( samples, count, sizeof( double ), _bench_compare );
+	printf(
+		"%-12s %-24s %-8s p50 %8.1f ns   p99 %8.1f ns   max %10.1f ns\n",
+		name,
+		variant,
+		operation,
+		samples[ count / 2 ] * 1e9,
+		samples[ count - 1 - count / 100 ] * 1e9,
+		samples[ count - 1 ] * 1e9
+	);
+}
+
+
+/**
+ * main
+ *
+ * Runs the benchmarks named on the command line, or every benchmark if none are.
+ *
+ */
+int main( int argc, char * argv[] )
+{
+	size_t i;
+	int arg, found;
+
+	for ( arg = 1; arg < argc; ++arg )
+	{
+		for ( i = 0, found = 0; i < _BENCH_NUM_BENCHMARKS; ++i )
+		{
+			found = found || strcmp( argv[ arg ], _benchmarks[ i ].name ) == 0;
+		}
+
+		if ( !found )
+		{
+			fprintf( stderr, "usage: %s [benchmark...]\nbenchmarks:", argv[ 0 ] );
+			for ( i = 0; i < _BENCH_NUM_BENCHMARKS; ++i )
+			{
+				fprintf( stderr, " %s", _benchmarks[ i ].name );
+			}
+			fprintf( stderr, "\n" );
+			return 1;
+		}
+	}
+
+	for ( i = 0; i < _BENCH_NUM_BENCHMARKS; ++i )
+	{
+		for ( arg = 1, found = argc == 1; arg < argc && !found; ++arg )
+		{
+			found = strcmp( argv[ arg ], _benchmarks[ i ].name ) == 0;
+		}
+
+		if ( found )
+		{
+			_benchmarks[ i ].run( );
+		}
+	}
+
+	return 0;
+}
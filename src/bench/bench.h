@@ -0,0 +1,87 @@
+#ifndef __MEM_BENCH_H
+#define __MEM_BENCH_H
+
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * BENCH_MAX_THREADS
+ *
+ * The largest number of threads any benchmark sweeps up to.
+ *
+ */
+#define BENCH_MAX_THREADS 16
+
+
+/**
+ * bench_function_t
+ *
+ * The body of a benchmark thread, passed its own context.
+ *
+ */
+typedef void ( * bench_function_t )( void * context );
+
+
+/**
+ * bench_now
+ *
+ * Returns the time of a monotonic clock, in seconds.
+ *
+ */
+double bench_now( void );
+
+
+/**
+ * bench_run
+ *
+ * Runs the given function on the given number of threads at once, passing each
+ * the next of the given contexts (an array of elements of the given size), and
+ * returns the time in seconds from the first thread starting its work to the last
+ * thread finishing.
+ *
+ */
+double bench_run( size_t num_threads, bench_function_t function, void * contexts, size_t context_size );
+
+
+/**
+ * bench_report
+ *
+ * Prints a line of results for the given benchmark and variant, having performed
+ * the given number of operations on the given number of threads in the given time.
+ *
+ */
+void bench_report( const char * name, const char * variant, size_t num_threads, size_t operations, double seconds );
+
+
+/**
+ * bench_report_latency
+ *
+ * Prints the median, 99th percentile and maximum of the given latencies (in
+ * seconds) of the given operation of the given benchmark and variant. The samples
+ * are sorted in place.
+ *
+ */
+void bench_report_latency( const char * name, const char * variant, const char * operation, double * samples, size_t count );
+
+
+/**
+ * bench_*
+ *
+ * The benchmarks, each of which prints its own results.
+ *
+ */
+void bench_concurrent( void );
+void bench_pool( void );
+void bench_std_allocator( void );
+void bench_stream( void );
+void bench_tlsf( void );
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+#endif /* __MEM_BENCH_H */
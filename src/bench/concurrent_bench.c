@@ -0,0 +1,119 @@
+#include "../mem/allocator_concurrent.h"
+#include "../mem/allocator_tlsf.h"
+#include "bench.h"
+
+
+/**
+ * _CONCURRENT_BENCH_*
+ *
+ * The number of allocations made by each thread, the number of blocks each thread
+ * keeps live at once, the size of each TLSF region and the number of stripes.
+ *
+ */
+#define _CONCURRENT_BENCH_OPERATIONS 200000
+#define _CONCURRENT_BENCH_LIVE 32
+#define _CONCURRENT_BENCH_REGION ( 16 * 1024 * 1024 )
+#define _CONCURRENT_BENCH_STRIPES 8
+
+
+/**
+ * _concurrent_bench_context_t
+ *
+ * The state of each thread of the concurrent allocator benchmark.
+ *
+ */
+typedef struct _concurrent_bench_context_t
+{
+	allocator_t * allocator;
+	size_t seed;
+} _concurrent_bench_context_t;
+
+
+/**
+ * _concurrent_bench_thread
+ *
+ * Allocates blocks of varying size, freeing each once a fixed number of younger
+ * blocks have been allocated, so the parent sees a steady mix of both.
+ *
+ */
+static void _concurrent_bench_thread( void * context )
+{
+	_concurrent_bench_context_t * bench = ( _concurrent_bench_context_t * ) context;
+	void * live[ _CONCURRENT_BENCH_LIVE ] = { 0 };
+	size_t seed = bench->seed;
+	size_t i;
+
+	for ( i = 0; i < _CONCURRENT_BENCH_OPERATIONS; ++i )
+	{
+		size_t slot = i % _CONCURRENT_BENCH_LIVE;
+		seed = seed * 1103515245 + 12345;
+
+		allocator_free( live[ slot ], bench->allocator );
+		live[ slot ] = allocator_alloc( 16 + ( seed >> 16 ) % 240, bench->allocator );
+	}
+
+	for ( i = 0; i < _CONCURRENT_BENCH_LIVE; ++i )
+	{
+		allocator_free( live[ i ], bench->allocator );
+	}
+}
+
+
+/**
+ * bench_concurrent
+ *
+ * Sweeps the number of threads sharing a TLSF allocator through each concurrent
+ * allocator strategy (striping over several TLSF allocators).
+ *
+ */
+void bench_concurrent( void )
+{
+	static const char * const names[] = { "spinlock", "striped", "combining" };
+	static const int strategies[] = {
+		ALLOCATOR_CONCURRENT_SPINLOCK,
+		ALLOCATOR_CONCURRENT_STRIPED,
+		ALLOCATOR_CONCURRENT_COMBINING
+	};
+
+	_concurrent_bench_context_t contexts[ BENCH_MAX_THREADS ];
+	allocator_tlsf_t regions[ _CONCURRENT_BENCH_STRIPES ];
+	allocator_t * parents[ _CONCURRENT_BENCH_STRIPES ];
+	allocator_concurrent_t concurrent;
+	size_t strategy, threads, i;
+	double seconds;
+
+	for ( strategy = 0; strategy < sizeof( strategies ) / sizeof( strategies[ 0 ] ); ++strategy )
+	{
+		for ( threads = 1; threads <= BENCH_MAX_THREADS; threads *= 2 )
+		{
+			for ( i = 0; i < _CONCURRENT_BENCH_STRIPES; ++i )
+			{
+				allocator_tlsf_init_default( &regions[ i ], _CONCURRENT_BENCH_REGION );
+				parents[ i ] = allocator_tlsf_get( &regions[ i ] );
+			}
+
+			if ( strategies[ strategy ] == ALLOCATOR_CONCURRENT_STRIPED )
+			{
+				allocator_concurrent_init_striped( &concurrent, parents, _CONCURRENT_BENCH_STRIPES );
+			}
+			else
+			{
+				allocator_concurrent_init( &concurrent, parents[ 0 ], strategies[ strategy ] );
+			}
+
+			for ( i = 0; i < threads; ++i )
+			{
+				contexts[ i ].allocator = allocator_concurrent_get( &concurrent );
+				contexts[ i ].seed = i + 1;
+			}
+
+			seconds = bench_run( threads, _concurrent_bench_thread, contexts, sizeof( contexts[ 0 ] ) );
+			bench_report( "concurrent", names[ strategy ], threads, threads * _CONCURRENT_BENCH_OPERATIONS, seconds );
+
+			for ( i = 0; i < _CONCURRENT_BENCH_STRIPES; ++i )
+			{
+				allocator_tlsf_cleanup( &regions[ i ] );
+			}
+		}
+	}
+}
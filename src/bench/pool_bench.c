@@ -0,0 +1,78 @@
+#include "../mem/pool.h"
+#include "bench.h"
+
+
+/**
+ * _POOL_BENCH_*
+ *
+ * The number of increments made by each thread, and the size of each element.
+ *
+ */
+#define _POOL_BENCH_OPERATIONS 20000000
+#define _POOL_BENCH_ELEMENT_SIZE sizeof( size_t )
+
+
+/**
+ * _pool_bench_context_t
+ *
+ * The state of each thread of the false sharing benchmark.
+ *
+ */
+typedef struct _pool_bench_context_t
+{
+	/* The counter this thread increments, taken from the pool */
+	volatile size_t * counter;
+} _pool_bench_context_t;
+
+
+/**
+ * _pool_bench_thread
+ *
+ * Repeatedly increments the thread's own counter.
+ *
+ */
+static void _pool_bench_thread( void * context )
+{
+	_pool_bench_context_t * bench = ( _pool_bench_context_t * ) context;
+	size_t i;
+
+	for ( i = 0; i < _POOL_BENCH_OPERATIONS; ++i )
+	{
+		*bench->counter += 1;
+	}
+}
+
+
+/**
+ * bench_pool
+ *
+ * Sweeps the number of threads each incrementing its own counter, taken from
+ * a plain pool (where neighbouring counters share cache lines) and from a pool
+ * aligned to POOL_CACHE_LINE_SIZE (where each counter has its own).
+ *
+ */
+void bench_pool( void )
+{
+	_pool_bench_context_t contexts[ BENCH_MAX_THREADS ];
+	size_t aligned, threads, i;
+	double seconds;
+	pool_t pool;
+
+	for ( aligned = 0; aligned < 2; ++aligned )
+	{
+		for ( threads = 1; threads <= BENCH_MAX_THREADS; threads *= 2 )
+		{
+			pool_init_aligned( &pool, _POOL_BENCH_ELEMENT_SIZE, threads, aligned ? POOL_CACHE_LINE_SIZE : 0, allocator_default( ) );
+			for ( i = 0; i < threads; ++i )
+			{
+				contexts[ i ].counter = ( volatile size_t * ) pool_take( &pool );
+				*contexts[ i ].counter = 0;
+			}
+
+			seconds = bench_run( threads, _pool_bench_thread, contexts, sizeof( contexts[ 0 ] ) );
+			bench_report( "pool", aligned ? "pool_init_aligned" : "pool_init", threads, threads * _POOL_BENCH_OPERATIONS, seconds );
+
+			pool_cleanup( &pool );
+		}
+	}
+}
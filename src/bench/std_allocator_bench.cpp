@@ -0,0 +1,93 @@
+#include <map>
+#include <vector>
+
+#include "../mem/allocator_tlsf.h"
+#include "../mem/std_allocator.hpp"
+#include "bench.h"
+
+
+/**
+ * _STD_ALLOCATOR_BENCH_*
+ *
+ * The number of keys inserted into (and erased from) each map per round, the
+ * number of rounds, and the size of the TLSF region.
+ *
+ */
+#define _STD_ALLOCATOR_BENCH_KEYS 10000
+#define _STD_ALLOCATOR_BENCH_ROUNDS 50
+#define _STD_ALLOCATOR_BENCH_REGION ( 16 * 1024 * 1024 )
+
+
+/**
+ * _std_allocator_bench_map
+ *
+ * Fills the given (empty) map with keys in a scattered order, then erases them all
+ * again, for a number of rounds, reporting the time per insert or erase.
+ *
+ */
+template< typename Map >
+static void _std_allocator_bench_map( const char * variant, Map & map )
+{
+	std::size_t round, i, key;
+	double start = bench_now( );
+
+	for ( round = 0; round < _STD_ALLOCATOR_BENCH_ROUNDS; ++round )
+	{
+		for ( i = 0, key = round; i < _STD_ALLOCATOR_BENCH_KEYS; ++i )
+		{
+			key = ( key * 7921 + 1 ) % _STD_ALLOCATOR_BENCH_KEYS;
+			map[ ( int ) key ] = ( int ) i;
+		}
+
+		for ( i = 0; i < _STD_ALLOCATOR_BENCH_KEYS; ++i )
+		{
+			map.erase( ( int ) i );
+		}
+	}
+
+	bench_report( "std", variant, 1, 2 * _STD_ALLOCATOR_BENCH_ROUNDS * _STD_ALLOCATOR_BENCH_KEYS, bench_now( ) - start );
+}
+
+
+/**
+ * bench_std_allocator
+ *
+ * Compares a std::map using the standard allocator with one using StdAllocator
+ * (over the default allocator and over a TLSF allocator) and a std::pmr::map using
+ * MemoryResource, where available.
+ *
+ */
+void bench_std_allocator( void )
+{
+	typedef std::pair< const int, int > value_t;
+	typedef std::map< int, int, std::less< int >, mem::StdAllocator< value_t > > std_map_t;
+	allocator_tlsf_t tlsf;
+
+	{
+		std::map< int, int > map;
+		_std_allocator_bench_map( "std::allocator", map );
+	}
+
+	{
+		mem::StdAllocator< value_t > std_alloc( allocator_default( ) );
+		std_map_t map( std::less< int >( ), std_alloc );
+		_std_allocator_bench_map( "StdAllocator (default)", map );
+	}
+
+	allocator_tlsf_init_default( &tlsf, _STD_ALLOCATOR_BENCH_REGION );
+	{
+		mem::StdAllocator< value_t > std_alloc( allocator_tlsf_get( &tlsf ) );
+		std_map_t map( std::less< int >( ), std_alloc );
+		_std_allocator_bench_map( "StdAllocator (tlsf)", map );
+	}
+
+#if defined( LIBMEM_HAS_MEMORY_RESOURCE )
+	{
+		mem::MemoryResource resource( allocator_tlsf_get( &tlsf ) );
+		std::pmr::map< int, int > map( &resource );
+		_std_allocator_bench_map( "MemoryResource (tlsf)", map );
+	}
+#endif
+
+	allocator_tlsf_cleanup( &tlsf );
+}
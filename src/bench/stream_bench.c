@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../mem/buffer.h"
+#include "../mem/internal/atomic.h"
+#include "bench.h"
+
+
+/**
+ * _STREAM_BENCH_*
+ *
+ * The number of dependent loads made by the cache-sensitive workload, and the
+ * number of bytes each grow adds to the buffer (kept small, so that the cost of
+ * each grow is dominated by copying the existing data).
+ *
+ */
+#define _STREAM_BENCH_LOADS 10000000
+#define _STREAM_BENCH_GROW 4096
+
+
+/**
+ * _stream_bench_context_t
+ *
+ * The state of each thread of the streaming benchmark - either the thread growing
+ * a buffer, or the cache-sensitive workload running alongside it.
+ *
+ */
+typedef struct _stream_bench_context_t
+{
+	/* Non-zero for the cache-sensitive workload */
+	int is_workload;
+
+	/* Set by the workload once it has finished */
+	int * done;
+
+	/* The cycle of indices walked by the workload */
+	size_t * cycle;
+
+	/* The data copied by the growing thread, and its length */
+	void * data;
+	size_t length;
+
+	/* The stream threshold of the growing thread's buffer */
+	size_t threshold;
+
+	/* The number of bytes copied by the growing thread, or the time per load of
+	 * the workload */
+	double result;
+
+	/* The index the workload finished on (so the walk cannot be optimised away) */
+	size_t last;
+
+} _stream_bench_context_t;
+
+
+/**
+ * _stream_bench_thread
+ *
+ * Either walks the workload's cycle, timing each dependent load, or repeatedly
+ * grows a buffer holding the data until the workload has finished.
+ *
+ */
+static void _stream_bench_thread( void * context )
+{
+	_stream_bench_context_t * bench = ( _stream_bench_context_t * ) context;
+
+	if ( bench->is_workload )
+	{
+		double start = bench_now( );
+		size_t index = 0, i;
+
+		for ( i = 0; i < _STREAM_BENCH_LOADS; ++i )
+		{
+			index = bench->cycle[ index ];
+		}
+
+		bench->result = ( bench_now( ) - start ) / _STREAM_BENCH_LOADS;
+		bench->last = index;
+		ATOMIC_STORE_RELEASE( bench->done, 1 );
+	}
+	else
+	{
+		buffer_t buffer;
+
+		bench->result = 0;
+		while ( !ATOMIC_LOAD_ACQUIRE( bench->done ) )
+		{
+			size_t grows;
+
+			buffer_init( &buffer, allocator_default( ) );
+			buffer_set_stream_threshold( &buffer, bench->threshold );
+			buffer_append( &buffer, bench->length, bench->data );
+
+			for ( grows = 0; grows < 16 && !ATOMIC_LOAD_RELAXED( bench->done ); ++grows )
+			{
+				buffer_grow( &buffer, _STREAM_BENCH_GROW );
+				bench->result += ( double ) bench->length;
+			}
+
+			buffer_cleanup( &buffer );
+		}
+	}
+}
+
+
+/**
+ * bench_stream
+ *
+ * Measures how much a buffer repeatedly growing past its stream threshold slows
+ * down a concurrent workload whose working set is the other half of the last level
+ * cache, with the buffer copying through the cache and bypassing it. Results are
+ * only meaningful where the two threads run on separate cores sharing that cache.
+ *
+ */
+void bench_stream( void )
+{
+	_stream_bench_context_t contexts[ 2 ];
+	size_t threshold, entries, seed, swap, i, j;
+	buffer_t probe;
+	size_t * cycle;
+	double seconds;
+	void * data;
+	int done;
+
+	buffer_init( &probe, allocator_default( ) );
+	threshold = buffer_stream_threshold( &probe );
+	buffer_cleanup( &probe );
+
+	/* The workload walks a random cycle (Sattolo's algorithm) through half of the
+	 * last level cache, such that every load depends on the last */
+	entries = threshold / sizeof( size_t );
+	cycle = ( size_t * ) malloc( entries * sizeof( size_t ) );
+	data = malloc( 2 * threshold );
+	if ( !cycle || !data )
+	{
+		free( cycle );
+		free( data );
+		return;
+	}
+
+	memset( data, 1, 2 * threshold );
+	for ( i = 0; i < entries; ++i )
+	{
+		cycle[ i ] = i;
+	}
+	for ( i = entries - 1, seed = 1; i > 0; --i )
+	{
+		seed = seed * 1103515245 + 12345;
+		j = ( seed >> 16 ) % i;
+		swap = cycle[ i ];
+		cycle[ i ] = cycle[ j ];
+		cycle[ j ] = swap;
+	}
+
+	printf( "stream       threshold %lu bytes (half the last level cache)\n", ( unsigned long ) threshold );
+
+	for ( i = 0; i < 3; ++i )
+	{
+		static const char * const names[] = { "alone", "grow, cached copy", "grow, streaming copy" };
+
+		done = 0;
+		contexts[ 0 ].is_workload = 1;
+		contexts[ 1 ].is_workload = 0;
+		for ( j = 0; j < 2; ++j )
+		{
+			contexts[ j ].done = &done;
+			contexts[ j ].cycle = cycle;
+			contexts[ j ].data = data;
+			contexts[ j ].length = 2 * threshold;
+			contexts[ j ].threshold = i == 2 ? threshold : ( size_t ) -1;
+		}
+
+		seconds = bench_run( i ? 2 : 1, _stream_bench_thread, contexts, sizeof( contexts[ 0 ] ) );
+		printf(
+			"stream       %-24s workload %6.1f ns/load   grow %8.2f GB/s\n",
+			names[ i ],
+			contexts[ 0 ].result * 1e9,
+			i ? contexts[ 1 ].result / seconds * 1e-9 : 0.0
+		);
+	}
+
+	free( cycle );
+	free( data );
+}
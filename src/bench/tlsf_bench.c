@@ -0,0 +1,92 @@
+#include <stdlib.h>
+
+#include "../mem/allocator_tlsf.h"
+#include "bench.h"
+
+
+/**
+ * _TLSF_BENCH_*
+ *
+ * The number of allocations made, the number of blocks kept live at once, the
+ * largest block allocated and the size of the TLSF region.
+ *
+ */
+#define _TLSF_BENCH_OPERATIONS 200000
+#define _TLSF_BENCH_LIVE 1024
+#define _TLSF_BENCH_MAX_LENGTH 4096
+#define _TLSF_BENCH_REGION ( 64 * 1024 * 1024 )
+
+
+/**
+ * _tlsf_bench_latency
+ *
+ * Replaces randomly chosen live blocks with blocks of random size, timing every
+ * allocation and release individually, and reports the latency distribution of
+ * each. The timer itself adds a roughly constant overhead to every sample.
+ *
+ */
+static void _tlsf_bench_latency( const char * variant, allocator_t * allocator )
+{
+	void * live[ _TLSF_BENCH_LIVE ] = { 0 };
+	double * allocs = ( double * ) malloc( _TLSF_BENCH_OPERATIONS * sizeof( double ) );
+	double * frees = ( double * ) malloc( _TLSF_BENCH_OPERATIONS * sizeof( double ) );
+	size_t seed = 1, num_frees = 0, i;
+	double start;
+
+	if ( !allocs || !frees )
+	{
+		free( allocs );
+		free( frees );
+		return;
+	}
+
+	for ( i = 0; i < _TLSF_BENCH_OPERATIONS; ++i )
+	{
+		size_t slot, length;
+		seed = seed * 1103515245 + 12345;
+		slot = ( seed >> 16 ) % _TLSF_BENCH_LIVE;
+		seed = seed * 1103515245 + 12345;
+		length = 16 + ( seed >> 16 ) % ( _TLSF_BENCH_MAX_LENGTH - 16 );
+
+		if ( live[ slot ] )
+		{
+			start = bench_now( );
+			allocator_free( live[ slot ], allocator );
+			frees[ num_frees++ ] = bench_now( ) - start;
+		}
+
+		start = bench_now( );
+		live[ slot ] = allocator_alloc( length, allocator );
+		allocs[ i ] = bench_now( ) - start;
+	}
+
+	for ( i = 0; i < _TLSF_BENCH_LIVE; ++i )
+	{
+		allocator_free( live[ i ], allocator );
+	}
+
+	bench_report_latency( "tlsf", variant, "alloc", allocs, _TLSF_BENCH_OPERATIONS );
+	bench_report_latency( "tlsf", variant, "free", frees, num_frees );
+
+	free( allocs );
+	free( frees );
+}
+
+
+/**
+ * bench_tlsf
+ *
+ * Compares the tail latency of allocation and release from a TLSF allocator with
+ * that of the default allocator, under the same random workload.
+ *
+ */
+void bench_tlsf( void )
+{
+	allocator_tlsf_t tlsf;
+
+	_tlsf_bench_latency( "default", allocator_default( ) );
+
+	allocator_tlsf_init_default( &tlsf, _TLSF_BENCH_REGION );
+	_tlsf_bench_latency( "tlsf", allocator_tlsf_get( &tlsf ) );
+	allocator_tlsf_cleanup( &tlsf );
+}
@@ -1,3 +1,4 @@
+#define LIBMEM_INLINE
 #include "allocator.h"
 #include "internal/unused.h"
 
@@ -5,16 +6,14 @@
 /**
  * allocator_alloc
  *
- * Use the given allocator to allocate the given number of bytes.
+ * Use the given allocator to allocate the given number of bytes. The name is
+ * parenthesised (here and below) such that it is not replaced by the LIBMEM_INLINE
+ * macro of the same name.
  *
  */
-void * allocator_alloc( size_t length, allocator_t * allocator )
+void * ( allocator_alloc )( size_t length, allocator_t * allocator )
 {
-	if ( !allocator || !allocator->alloc_fn )
-	{
-		return 0;
-	}
-	return allocator->alloc_fn( length, allocator );
+	return allocator_alloc_inline( length, allocator );
 }
 
 
@@ -24,12 +23,9 @@ void * allocator_alloc( size_t length, allocator_t * allocator )
  * Use the given allocator to free the given memory address.
  *
  */
-void allocator_free( void * address, allocator_t * allocator )
+void ( allocator_free )( void * address, allocator_t * allocator )
 {
-	if ( allocator && allocator->free_fn )
-	{
-		allocator->free_fn( address, allocator );
-	}
+	allocator_free_inline( address, allocator );
 }
 
 
@@ -5,6 +5,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "inline.h"
+
 #if defined(__cplusplus)
 extern "C" {
 #endif
@@ -335,6 +337,44 @@ size_t allocator_counted_get_peak_count(
 	allocator_counted_t * allocator
 );
 
+
+#if defined(LIBMEM_INLINE)
+
+/**
+ * allocator_alloc_inline
+ *
+ * Header-inline equivalent of allocator_alloc (see LIBMEM_INLINE).
+ *
+ */
+MEM_INLINE void * allocator_alloc_inline( size_t length, allocator_t * allocator )
+{
+	if ( !allocator || !allocator->alloc_fn )
+	{
+		return 0;
+	}
+	return allocator->alloc_fn( length, allocator );
+}
+
+
+/**
+ * allocator_free_inline
+ *
+ * Header-inline equivalent of allocator_free (see LIBMEM_INLINE).
+ *
+ */
+MEM_INLINE void allocator_free_inline( void * address, allocator_t * allocator )
+{
+	if ( allocator && allocator->free_fn )
+	{
+		allocator->free_fn( address, allocator );
+	}
+}
+
+#define allocator_alloc( length, allocator ) allocator_alloc_inline( length, allocator )
+#define allocator_free( address, allocator ) allocator_free_inline( address, allocator )
+
+#endif /* LIBMEM_INLINE */
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif
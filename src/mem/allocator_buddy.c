@@ -0,0 +1,421 @@
+#include "allocator_buddy.h"
+
+#include <string.h>
+
+
+/**
+ * _allocator_buddy_node_t
+ *
+ * The links stored in each free block.
+ *
+ */
+typedef struct _allocator_buddy_node_t
+{
+	struct _allocator_buddy_node_t * prev;
+	struct _allocator_buddy_node_t * next;
+
+} _allocator_buddy_node_t;
+
+
+/**
+ * _allocator_buddy_map_length
+ *
+ * Returns the number of bytes needed for a bitmap with one bit per block, for the
+ * given number of levels.
+ *
+ */
+static size_t _allocator_buddy_map_length( size_t levels )
+{
+	return ( ( ( size_t ) 1 << levels ) + 7 ) / 8;
+}
+
+
+/**
+ * _allocator_buddy_bit / _allocator_buddy_set_bit / _allocator_buddy_clear_bit
+ *
+ * Bitmap accessors, indexed by block (node) number.
+ *
+ */
+static int _allocator_buddy_bit( uint8_t * map, size_t node )
+{
+	return ( map[ node / 8 ] >> ( node % 8 ) ) & 1;
+}
+
+static void _allocator_buddy_set_bit( uint8_t * map, size_t node )
+{
+	map[ node / 8 ] |= ( uint8_t )( 1 << ( node % 8 ) );
+}
+
+static void _allocator_buddy_clear_bit( uint8_t * map, size_t node )
+{
+	map[ node / 8 ] &= ( uint8_t ) ~( 1 << ( node % 8 ) );
+}
+
+
+/**
+ * _allocator_buddy_block
+ *
+ * Returns the address of the given block at the given level. Blocks are numbered
+ * as a binary tree stored breadth-first, with the whole region as block zero.
+ *
+ */
+static int8_t * _allocator_buddy_block( allocator_buddy_t * buddy, size_t node, size_t level )
+{
+	return buddy->region + ( node - ( ( ( size_t ) 1 << level ) - 1 ) ) * ( buddy->capacity >> level );
+}
+
+
+/**
+ * _allocator_buddy_node
+ *
+ * Returns the number of the block at the given address and level.
+ *
+ */
+static size_t _allocator_buddy_node( allocator_buddy_t * buddy, void * block, size_t level )
+{
+	size_t offset = ( size_t )( ( int8_t * ) block - buddy->region );
+	return ( ( ( size_t ) 1 << level ) - 1 ) + offset / ( buddy->capacity >> level );
+}
+
+
+/**
+ * _allocator_buddy_push
+ *
+ * Adds the given block to the free list of the given level.
+ *
+ */
+static void _allocator_buddy_push( allocator_buddy_t * buddy, size_t node, size_t level )
+{
+	_allocator_buddy_node_t * block = ( _allocator_buddy_node_t * ) _allocator_buddy_block( buddy, node, level );
+	_allocator_buddy_node_t * head = ( _allocator_buddy_node_t * ) buddy->free_lists[ level ];
+
+	block->prev = 0;
+	block->next = head;
+	if ( head )
+	{
+		head->prev = block;
+	}
+	buddy->free_lists[ level ] = block;
+	_allocator_buddy_set_bit( buddy->free_map, node );
+}
+
+
+/**
+ * _allocator_buddy_remove
+ *
+ * Removes the given block from the free list of the given level.
+ *
+ */
+static void _allocator_buddy_remove( allocator_buddy_t * buddy, size_t node, size_t level )
+{
+	_allocator_buddy_node_t * block = ( _allocator_buddy_node_t * ) _allocator_buddy_block( buddy, node, level );
+
+	if ( block->prev )
+	{
+		block->prev->next = block->next;
+	}
+	else
+	{
+		buddy->free_lists[ level ] = block->next;
+	}
+	if ( block->next )
+	{
+		block->next->prev = block->prev;
+	}
+	_allocator_buddy_clear_bit( buddy->free_map, node );
+}
+
+
+/**
+ * _allocator_buddy_alloc
+ *
+ * Allocates the smallest block that can hold the given number of bytes, splitting
+ * a larger free block if there is no free block of that size.
+ *
+ */
+static void * _allocator_buddy_alloc( size_t length, allocator_t * allocator )
+{
+	allocator_buddy_t * buddy = ( allocator_buddy_t * ) allocator;
+	size_t level, found, node;
+	void * block;
+
+	if ( !length || length > buddy->capacity )
+	{
+		return 0;
+	}
+
+	for ( level = buddy->levels - 1; level > 0 && ( buddy->capacity >> level ) < length; --level )
+	{
+	}
+
+	for ( found = level; !buddy->free_lists[ found ]; --found )
+	{
+		if ( !found )
+		{
+			return 0;
+		}
+	}
+
+	block = buddy->free_lists[ found ];
+	node = _allocator_buddy_node( buddy, block, found );
+	_allocator_buddy_remove( buddy, node, found );
+
+	/* Split the block, keeping the lower half and freeing the upper half */
+	for ( ; found < level; ++found )
+	{
+		_allocator_buddy_set_bit( buddy->split_map, node );
+		_allocator_buddy_push( buddy, 2 * node + 2, found + 1 );
+		node = 2 * node + 1;
+	}
+
+	buddy->used += buddy->capacity >> level;
+	return block;
+}
+
+
+/**
+ * _allocator_buddy_free
+ *
+ * Releases the given block, coalescing it with its buddy for as long as the buddy
+ * is also free.
+ *
+ */
+static void _allocator_buddy_free( void * address, allocator_t * allocator )
+{
+	allocator_buddy_t * buddy = ( allocator_buddy_t * ) allocator;
+	size_t level, node;
+
+	if ( !address )
+	{
+		return;
+	}
+
+	/* The block's level is that of the first block containing it whose parent is
+	 * split, searching upwards from the smallest block at the same address */
+	level = buddy->levels - 1;
+	node = _allocator_buddy_node( buddy, address, level );
+	while ( level > 0 && !_allocator_buddy_bit( buddy->split_map, ( node - 1 ) / 2 ) )
+	{
+		node = ( node - 1 ) / 2;
+		--level;
+	}
+
+	buddy->used -= buddy->capacity >> level;
+
+	while ( level > 0 )
+	{
+		size_t other = ( node % 2 ) ? node + 1 : node - 1;
+		if ( !_allocator_buddy_bit( buddy->free_map, other ) )
+		{
+			break;
+		}
+
+		_allocator_buddy_remove( buddy, other, level );
+		node = ( node - 1 ) / 2;
+		--level;
+		_allocator_buddy_clear_bit( buddy->split_map, node );
+	}
+
+	_allocator_buddy_push( buddy, node, level );
+}
+
+
+/**
+ * _allocator_buddy_setup
+ *
+ * Initialises the given buddy allocator to manage the given region, placing its
+ * bitmaps at the end of the region.
+ *
+ */
+static void _allocator_buddy_setup( allocator_buddy_t * buddy, int8_t * region, size_t length )
+{
+	size_t levels = 1, capacity = ALLOCATOR_BUDDY_MIN_BLOCK, level;
+
+	buddy->alloc.alloc_fn = &_allocator_buddy_alloc;
+	buddy->alloc.free_fn = &_allocator_buddy_free;
+	buddy->region = region;
+	buddy->capacity = 0;
+	buddy->levels = 0;
+	buddy->free_map = buddy->split_map = 0;
+	buddy->used = 0;
+
+	for ( level = 0; level < ALLOCATOR_BUDDY_MAX_LEVELS; ++level )
+	{
+		buddy->free_lists[ level ] = 0;
+	}
+
+	if ( !region || length < capacity + 2 * _allocator_buddy_map_length( levels ) )
+	{
+		return;
+	}
+
+	while (
+		levels < ALLOCATOR_BUDDY_MAX_LEVELS &&
+		capacity <= ( ( size_t ) -1 ) / 4 &&
+		2 * capacity + 2 * _allocator_buddy_map_length( levels + 1 ) <= length
+	)
+	{
+		capacity *= 2;
+		++levels;
+	}
+
+	buddy->capacity = capacity;
+	buddy->levels = levels;
+	buddy->free_map = ( uint8_t * )( region + capacity );
+	buddy->split_map = buddy->free_map + _allocator_buddy_map_length( levels );
+	memset( buddy->free_map, 0, 2 * _allocator_buddy_map_length( levels ) );
+	_allocator_buddy_push( buddy, 0, 0 );
+}
+
+
+/**
+ * allocator_buddy_init
+ *
+ * Initialises the given buddy allocator with a region able to hold a block of at
+ * least the given number of bytes, allocated from the given parent allocator.
+ *
+ */
+void allocator_buddy_init(
+	allocator_buddy_t * allocator,
+	size_t capacity,
+	allocator_t * parent
+)
+{
+	size_t levels = 1, rounded = ALLOCATOR_BUDDY_MIN_BLOCK;
+	int8_t * region = 0;
+
+	if ( !allocator )
+	{
+		return;
+	}
+
+	while ( rounded < capacity && levels < ALLOCATOR_BUDDY_MAX_LEVELS && rounded <= ( ( size_t ) -1 ) / 4 )
+	{
+		rounded *= 2;
+		++levels;
+	}
+
+	if ( rounded >= capacity )
+	{
+		region = ( int8_t * ) allocator_alloc( rounded + 2 * _allocator_buddy_map_length( levels ), parent );
+	}
+
+	_allocator_buddy_setup( allocator, region, rounded + 2 * _allocator_buddy_map_length( levels ) );
+	allocator->parent = parent;
+}
+
+
+/**
+ * allocator_buddy_init_default
+ *
+ * Initialises the given buddy allocator, using the default allocator as its parent.
+ *
+ */
+void allocator_buddy_init_default(
+	allocator_buddy_t * allocator,
+	size_t capacity
+)
+{
+	allocator_buddy_init( allocator, capacity, allocator_default( ) );
+}
+
+
+/**
+ * allocator_buddy_init_storage
+ *
+ * Initialises the given buddy allocator with a caller-provided region of the given
+ * number of bytes.
+ *
+ */
+void allocator_buddy_init_storage(
+	allocator_buddy_t * allocator,
+	void * storage,
+	size_t length
+)
+{
+	if ( allocator )
+	{
+		_allocator_buddy_setup( allocator, ( int8_t * ) storage, length );
+		allocator->parent = 0;
+	}
+}
+
+
+/**
+ * allocator_buddy_cleanup
+ *
+ * Releases the region of the given buddy allocator (unless caller-provided).
+ *
+ */
+void allocator_buddy_cleanup(
+	allocator_buddy_t * allocator
+)
+{
+	if ( allocator )
+	{
+		if ( allocator->parent && allocator->region )
+		{
+			allocator_free( allocator->region, allocator->parent );
+		}
+
+		_allocator_buddy_setup( allocator, 0, 0 );
+
+		/* Note that the parent is deliberately retained */
+	}
+}
+
+
+/**
+ * allocator_buddy_get
+ *
+ * Returns the given buddy allocator as an allocator_t pointer.
+ *
+ */
+allocator_t * allocator_buddy_get(
+	allocator_buddy_t * allocator
+)
+{
+	return ( allocator_t * ) allocator;
+}
+
+
+/**
+ * allocator_buddy_stats
+ *
+ * Fills the given report with the current state of the given buddy allocator's
+ * region.
+ *
+ */
+void allocator_buddy_stats(
+	allocator_buddy_t * allocator,
+	allocator_buddy_stats_t * stats
+)
+{
+	size_t level;
+
+	if ( !stats )
+	{
+		return;
+	}
+
+	stats->capacity = allocator ? allocator->capacity : 0;
+	stats->used = allocator ? allocator->used : 0;
+	stats->free = stats->capacity - stats->used;
+	stats->largest_free = 0;
+	stats->free_blocks = 0;
+
+	for ( level = 0; allocator && level < allocator->levels; ++level )
+	{
+		_allocator_buddy_node_t * block = ( _allocator_buddy_node_t * ) allocator->free_lists[ level ];
+
+		if ( block && !stats->largest_free )
+		{
+			stats->largest_free = allocator->capacity >> level;
+		}
+
+		for ( ; block; block = block->next )
+		{
+			++stats->free_blocks;
+		}
+	}
+}
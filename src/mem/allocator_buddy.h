@@ -0,0 +1,188 @@
+#ifndef __MEM_ALLOCATOR_BUDDY_H
+#define __MEM_ALLOCATOR_BUDDY_H
+
+#include "allocator.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * ALLOCATOR_BUDDY_MIN_BLOCK
+ *
+ * The size of the smallest block handed out by a buddy allocator (a power of two,
+ * large enough to hold two pointers). Every block is aligned to its own size,
+ * relative to the start of the region (up to the alignment of the region itself).
+ *
+ */
+#ifndef ALLOCATOR_BUDDY_MIN_BLOCK
+#define ALLOCATOR_BUDDY_MIN_BLOCK 32
+#endif
+
+
+/**
+ * ALLOCATOR_BUDDY_MAX_LEVELS
+ *
+ * The maximum number of block sizes a buddy allocator can manage, which bounds
+ * its capacity at ALLOCATOR_BUDDY_MIN_BLOCK << ( ALLOCATOR_BUDDY_MAX_LEVELS - 1 ).
+ *
+ */
+#define ALLOCATOR_BUDDY_MAX_LEVELS 40
+
+
+/**
+ * allocator_buddy_stats_t
+ *
+ * A report of the state of a buddy allocator's region. The external fragmentation
+ * of the region can be derived as 1 - largest_free / free.
+ *
+ */
+typedef struct allocator_buddy_stats_t
+{
+	/* The number of bytes managed by the allocator */
+	size_t capacity;
+
+	/* The number of bytes in allocated blocks (including rounding up to a block) */
+	size_t used;
+
+	/* The number of bytes in free blocks */
+	size_t free;
+
+	/* The size of the largest free block, i.e. the largest possible allocation */
+	size_t largest_free;
+
+	/* The number of free blocks */
+	size_t free_blocks;
+
+} allocator_buddy_stats_t;
+
+
+/**
+ * allocator_buddy_t
+ *
+ * An allocator that hands out power of two sized blocks of a fixed region, splitting
+ * larger blocks in half as required and coalescing free blocks with their buddies
+ * when released, in O(log n) time. The state of each block is tracked in bitmaps
+ * stored at the end of the region, and free blocks are linked through their own
+ * memory, so no per-block header is required.
+ *
+ * Note that the buddy allocator is not thread-safe (see allocator_concurrent_t).
+ *
+ */
+typedef struct allocator_buddy_t
+{
+	/* The allocation functions for this allocator */
+	allocator_t alloc;
+
+	/* The parent allocator the region was allocated from (null if caller-provided) */
+	allocator_t * parent;
+
+	/* The start of the region */
+	int8_t * region;
+
+	/* The number of bytes managed (the largest block size) */
+	size_t capacity;
+
+	/* The number of block sizes, from capacity down to ALLOCATOR_BUDDY_MIN_BLOCK */
+	size_t levels;
+
+	/* One bit per block, set while the block is free */
+	uint8_t * free_map;
+
+	/* One bit per block, set while the block is split into two halves */
+	uint8_t * split_map;
+
+	/* The first free block of each size, largest first */
+	void * free_lists[ ALLOCATOR_BUDDY_MAX_LEVELS ];
+
+	/* The number of bytes in allocated blocks */
+	size_t used;
+
+} allocator_buddy_t;
+
+
+/**
+ * allocator_buddy_init
+ *
+ * Initialises the given buddy allocator with a region able to hold a block of at
+ * least the given number of bytes (rounded up to a power of two), allocated from
+ * the given parent allocator. Should call allocator_buddy_cleanup to release the
+ * region. If the region cannot be allocated, the allocator has zero capacity.
+ *
+ */
+void allocator_buddy_init(
+	allocator_buddy_t * allocator,
+	size_t capacity,
+	allocator_t * parent
+);
+
+
+/**
+ * allocator_buddy_init_default
+ *
+ * Initialises the given buddy allocator, using the default allocator as its parent.
+ *
+ */
+void allocator_buddy_init_default(
+	allocator_buddy_t * allocator,
+	size_t capacity
+);
+
+
+/**
+ * allocator_buddy_init_storage
+ *
+ * Initialises the given buddy allocator with a caller-provided region (e.g. a shared
+ * or huge page mapping) of the given number of bytes, which must outlive the
+ * allocator. The allocator's bitmaps are placed at the end of the region, and the
+ * capacity is the largest power of two that fits in the remainder.
+ *
+ */
+void allocator_buddy_init_storage(
+	allocator_buddy_t * allocator,
+	void * storage,
+	size_t length
+);
+
+
+/**
+ * allocator_buddy_cleanup
+ *
+ * Releases the region of the given buddy allocator (unless caller-provided). All
+ * blocks allocated from it are invalidated.
+ *
+ */
+void allocator_buddy_cleanup(
+	allocator_buddy_t * allocator
+);
+
+
+/**
+ * allocator_buddy_get
+ *
+ * Returns the given buddy allocator as an allocator_t pointer.
+ *
+ */
+allocator_t * allocator_buddy_get(
+	allocator_buddy_t * allocator
+);
+
+
+/**
+ * allocator_buddy_stats
+ *
+ * Fills the given report with the current state of the given buddy allocator's
+ * region. Takes time proportional to the number of free blocks.
+ *
+ */
+void allocator_buddy_stats(
+	allocator_buddy_t * allocator,
+	allocator_buddy_stats_t * stats
+);
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+#endif /* __MEM_ALLOCATOR_BUDDY_H */
@@ -0,0 +1,271 @@
+#include "allocator_budget.h"
+#include "internal/atomic.h"
+
+
+/**
+ * _ALLOCATOR_BUDGET_HEADER
+ *
+ * The size of the header preceding each block, which records the number of bytes
+ * charged for it. Sized to preserve the alignment of the parent's allocations.
+ *
+ */
+#define _ALLOCATOR_BUDGET_HEADER 16
+
+
+/**
+ * _allocator_budget_uncharge
+ *
+ * Removes the given number of bytes from the given budget and its ancestors, up to
+ * (but not including) the given budget.
+ *
+ */
+static void _allocator_budget_uncharge( allocator_budget_t * budget, allocator_budget_t * end, size_t length )
+{
+	for ( ; budget != end; budget = budget->parent_budget )
+	{
+		size_t current = ATOMIC_FETCH_SUB_RELAXED( &budget->current, length ) - length;
+		if ( budget->soft_limit && current <= budget->soft_limit )
+		{
+			ATOMIC_STORE_RELAXED( &budget->pressure, 0 );
+		}
+	}
+}
+
+
+/**
+ * _allocator_budget_charge
+ *
+ * Adds the given number of bytes to the given budget and its ancestors, unless any
+ * of them would exceed its hard limit. Returns non-zero if the bytes were charged.
+ *
+ */
+static int _allocator_budget_charge( allocator_budget_t * budget, size_t length )
+{
+	allocator_budget_t * level;
+
+	for ( level = budget; level; level = level->parent_budget )
+	{
+		size_t current = ATOMIC_LOAD_RELAXED( &level->current ), peak;
+
+		do
+		{
+			if ( current > ( size_t ) -1 - length || ( level->hard_limit && current + length > level->hard_limit ) )
+			{
+				ATOMIC_FETCH_ADD_RELAXED( &level->failures, 1 );
+				_allocator_budget_uncharge( budget, level, length );
+				return 0;
+			}
+		}
+		while ( !ATOMIC_COMPARE_EXCHANGE_RELAXED( &level->current, &current, current + length ) );
+
+		current += length;
+		peak = ATOMIC_LOAD_RELAXED( &level->peak );
+		while ( current > peak && !ATOMIC_COMPARE_EXCHANGE_RELAXED( &level->peak, &peak, current ) )
+		{
+		}
+	}
+
+	/* Only once the whole hierarchy is charged, report any soft limits crossed */
+	for ( level = budget; level; level = level->parent_budget )
+	{
+		if (
+			level->soft_limit &&
+			ATOMIC_LOAD_RELAXED( &level->current ) > level->soft_limit &&
+			!ATOMIC_EXCHANGE_ACQUIRE( &level->pressure, 1 ) &&
+			level->callback
+		)
+		{
+			level->callback( level, level->context );
+		}
+	}
+
+	return 1;
+}
+
+
+/**
+ * _allocator_budget_alloc
+ *
+ * Charges the given number of bytes to the budget, and allocates them from the
+ * parent allocator.
+ *
+ */
+static void * _allocator_budget_alloc( size_t length, allocator_t * allocator )
+{
+	allocator_budget_t * budget = ( allocator_budget_t * ) allocator;
+	int8_t * block;
+
+	if ( !length || length > ( size_t ) -1 - _ALLOCATOR_BUDGET_HEADER )
+	{
+		return 0;
+	}
+
+	if ( !_allocator_budget_charge( budget, length ) )
+	{
+		return 0;
+	}
+
+	block = ( int8_t * ) allocator_alloc( _ALLOCATOR_BUDGET_HEADER + length, budget->parent );
+	if ( !block )
+	{
+		_allocator_budget_uncharge( budget, 0, length );
+		return 0;
+	}
+
+	*( ( size_t * ) block ) = length;
+	return block + _ALLOCATOR_BUDGET_HEADER;
+}
+
+
+/**
+ * _allocator_budget_free
+ *
+ * Releases the given block to the parent allocator, and removes it from the budget.
+ *
+ */
+static void _allocator_budget_free( void * address, allocator_t * allocator )
+{
+	allocator_budget_t * budget = ( allocator_budget_t * ) allocator;
+	int8_t * block;
+
+	if ( !address )
+	{
+		return;
+	}
+
+	block = ( ( int8_t * ) address ) - _ALLOCATOR_BUDGET_HEADER;
+	_allocator_budget_uncharge( budget, 0, *( ( size_t * ) block ) );
+	allocator_free( block, budget->parent );
+}
+
+
+/**
+ * allocator_budget_init
+ *
+ * Initialises the given budget allocator with the given soft and hard limits,
+ * forwarding allocations to the given parent allocator.
+ *
+ */
+void allocator_budget_init(
+	allocator_budget_t * allocator,
+	allocator_t * parent,
+	size_t soft_limit,
+	size_t hard_limit
+)
+{
+	if ( allocator )
+	{
+		allocator->alloc.alloc_fn = &_allocator_budget_alloc;
+		allocator->alloc.free_fn = &_allocator_budget_free;
+		allocator->parent = parent;
+		allocator->parent_budget = 0;
+		allocator->soft_limit = soft_limit;
+		allocator->hard_limit = hard_limit;
+		allocator->current = 0;
+		allocator->peak = 0;
+		allocator->failures = 0;
+		allocator->pressure = 0;
+		allocator->callback = 0;
+		allocator->context = 0;
+	}
+}
+
+
+/**
+ * allocator_budget_init_default
+ *
+ * Initialises the given budget allocator, using the default allocator as its parent.
+ *
+ */
+void allocator_budget_init_default(
+	allocator_budget_t * allocator,
+	size_t soft_limit,
+	size_t hard_limit
+)
+{
+	allocator_budget_init( allocator, allocator_default( ), soft_limit, hard_limit );
+}
+
+
+/**
+ * allocator_budget_init_child
+ *
+ * Initialises the given budget allocator as a child of the given budget.
+ *
+ */
+void allocator_budget_init_child(
+	allocator_budget_t * allocator,
+	allocator_budget_t * parent_budget,
+	size_t soft_limit,
+	size_t hard_limit
+)
+{
+	allocator_budget_init( allocator, parent_budget ? parent_budget->parent : 0, soft_limit, hard_limit );
+	if ( allocator )
+	{
+		allocator->parent_budget = parent_budget;
+	}
+}
+
+
+/**
+ * allocator_budget_set_callback
+ *
+ * Sets the function called when the given budget's usage rises above its soft
+ * limit.
+ *
+ */
+void allocator_budget_set_callback(
+	allocator_budget_t * allocator,
+	allocator_budget_callback_t callback,
+	void * context
+)
+{
+	if ( allocator )
+	{
+		allocator->callback = callback;
+		allocator->context = context;
+	}
+}
+
+
+/**
+ * allocator_budget_get
+ *
+ * Returns the given budget allocator as an allocator_t pointer.
+ *
+ */
+allocator_t * allocator_budget_get(
+	allocator_budget_t * allocator
+)
+{
+	return ( allocator_t * ) allocator;
+}
+
+
+/**
+ * allocator_budget_get_current_count
+ *
+ * Returns the number of bytes currently charged to the given budget.
+ *
+ */
+size_t allocator_budget_get_current_count(
+	allocator_budget_t * allocator
+)
+{
+	return allocator ? ATOMIC_LOAD_RELAXED( &allocator->current ) : 0;
+}
+
+
+/**
+ * allocator_budget_get_peak_count
+ *
+ * Returns the maximum number of bytes ever charged to the given budget.
+ *
+ */
+size_t allocator_budget_get_peak_count(
+	allocator_budget_t * allocator
+)
+{
+	return allocator ? ATOMIC_LOAD_RELAXED( &allocator->peak ) : 0;
+}
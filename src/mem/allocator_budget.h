@@ -0,0 +1,172 @@
+#ifndef __MEM_ALLOCATOR_BUDGET_H
+#define __MEM_ALLOCATOR_BUDGET_H
+
+#include "allocator.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+struct allocator_budget_t;
+
+
+/**
+ * allocator_budget_callback_t
+ *
+ * Called when a budget's usage rises above its soft limit, with the context given
+ * to allocator_budget_set_callback. Called on the allocating thread, once per
+ * crossing - it is not called again until usage has fallen back to the soft limit
+ * or below. Typically used to trim caches (see trim_all) or shed load.
+ *
+ */
+typedef void ( * allocator_budget_callback_t )( struct allocator_budget_t * budget, void * context );
+
+
+/**
+ * allocator_budget_t
+ *
+ * Forwards allocations to a parent allocator while enforcing a limit on the number
+ * of bytes allocated. Allocations that would take usage above the hard limit fail,
+ * while crossing the soft limit calls the budget's callback. Budgets can be nested,
+ * such that every allocation from a child budget is also charged to each of its
+ * ancestors (and fails if any of them would exceed its hard limit) - e.g. one child
+ * budget per tenant, within a budget for the whole process.
+ *
+ * Accounting is atomic, so a budget may be shared between threads - provided its
+ * parent allocator is itself thread-safe (see allocator_concurrent_t).
+ *
+ */
+typedef struct allocator_budget_t
+{
+	/* The allocation functions for this allocator */
+	allocator_t alloc;
+
+	/* The parent allocator to which all allocations will be forwarded */
+	allocator_t * parent;
+
+	/* The budget that allocations are also charged to (null if none) */
+	struct allocator_budget_t * parent_budget;
+
+	/* The number of bytes above which the callback is called (zero for none) */
+	size_t soft_limit;
+
+	/* The number of bytes that cannot be exceeded (zero for none) */
+	size_t hard_limit;
+
+	/* The number of bytes currently charged to the budget */
+	size_t current;
+
+	/* The maximum number of bytes ever charged to the budget */
+	size_t peak;
+
+	/* The number of allocations refused because of this budget's hard limit */
+	size_t failures;
+
+	/* Non-zero while usage is above the soft limit */
+	int pressure;
+
+	/* The function called when usage rises above the soft limit, and its context */
+	allocator_budget_callback_t callback;
+	void * context;
+
+} allocator_budget_t;
+
+
+/**
+ * allocator_budget_init
+ *
+ * Initialises the given budget allocator with the given soft and hard limits (either
+ * of which may be zero for no limit), forwarding allocations to the given parent
+ * allocator.
+ *
+ */
+void allocator_budget_init(
+	allocator_budget_t * allocator,
+	allocator_t * parent,
+	size_t soft_limit,
+	size_t hard_limit
+);
+
+
+/**
+ * allocator_budget_init_default
+ *
+ * Initialises the given budget allocator, using the default allocator as its parent.
+ *
+ */
+void allocator_budget_init_default(
+	allocator_budget_t * allocator,
+	size_t soft_limit,
+	size_t hard_limit
+);
+
+
+/**
+ * allocator_budget_init_child
+ *
+ * Initialises the given budget allocator as a child of the given budget, which must
+ * outlive it. Allocations are forwarded to the parent budget's parent allocator,
+ * and charged to both budgets (and any further ancestors).
+ *
+ */
+void allocator_budget_init_child(
+	allocator_budget_t * allocator,
+	allocator_budget_t * parent_budget,
+	size_t soft_limit,
+	size_t hard_limit
+);
+
+
+/**
+ * allocator_budget_set_callback
+ *
+ * Sets the function called when the given budget's usage rises above its soft
+ * limit. Should be called before the budget is shared between threads.
+ *
+ */
+void allocator_budget_set_callback(
+	allocator_budget_t * allocator,
+	allocator_budget_callback_t callback,
+	void * context
+);
+
+
+/**
+ * allocator_budget_get
+ *
+ * Returns the given budget allocator as an allocator_t pointer.
+ *
+ */
+allocator_t * allocator_budget_get(
+	allocator_budget_t * allocator
+);
+
+
+/**
+ * allocator_budget_get_current_count
+ *
+ * Returns the number of bytes currently charged to the given budget (including
+ * allocations from its children).
+ *
+ */
+size_t allocator_budget_get_current_count(
+	allocator_budget_t * allocator
+);
+
+
+/**
+ * allocator_budget_get_peak_count
+ *
+ * Returns the maximum number of bytes ever charged to the given budget.
+ *
+ */
+size_t allocator_budget_get_peak_count(
+	allocator_budget_t * allocator
+);
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+#endif /* __MEM_ALLOCATOR_BUDGET_H */
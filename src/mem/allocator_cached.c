@@ -0,0 +1,487 @@
+#include "allocator_cached.h"
+
+
+/**
+ * _ALLOCATOR_CACHED_HEADER
+ *
+ * The size of the header preceding each block, which records the block's size
+ * class. Sized to preserve the alignment of the parent's allocations.
+ *
+ */
+#define _ALLOCATOR_CACHED_HEADER 16
+
+
+/**
+ * _ALLOCATOR_CACHED_UNCACHED
+ *
+ * The size class recorded in the header of blocks too large to be cached.
+ *
+ */
+#define _ALLOCATOR_CACHED_UNCACHED ( ( size_t ) -1 )
+
+
+/**
+ * _allocator_cached_thread_t
+ *
+ * A single thread's cache of free blocks. Each free block holds a pointer to the
+ * next free block of the same size class.
+ *
+ */
+typedef struct _allocator_cached_thread_t
+{
+	/* The allocator the cache belongs to */
+	allocator_cached_t * owner;
+
+	/* The first free block of each size class */
+	void * heads[ ALLOCATOR_CACHED_MAX_CLASSES ];
+
+	/* The number of free blocks of each size class */
+	size_t counts[ ALLOCATOR_CACHED_MAX_CLASSES ];
+
+} _allocator_cached_thread_t;
+
+
+/**
+ * _allocator_cached_header
+ *
+ * Returns a pointer to the size class recorded in the header of the given block.
+ *
+ */
+static size_t * _allocator_cached_header( void * block )
+{
+	return ( size_t * )( ( ( int8_t * ) block ) - _ALLOCATOR_CACHED_HEADER );
+}
+
+
+/**
+ * _allocator_cached_alloc_block
+ *
+ * Allocates a block of the given size and size class from the parent allocator.
+ * The caller must hold the allocator's lock.
+ *
+ */
+static void * _allocator_cached_alloc_block( allocator_cached_t * cached, size_t length, size_t index )
+{
+	int8_t * block;
+
+	if ( length > ( size_t ) -1 - _ALLOCATOR_CACHED_HEADER )
+	{
+		return 0;
+	}
+
+	block = ( int8_t * ) allocator_alloc( _ALLOCATOR_CACHED_HEADER + length, cached->parent );
+	if ( !block )
+	{
+		return 0;
+	}
+
+	block += _ALLOCATOR_CACHED_HEADER;
+	*_allocator_cached_header( block ) = index;
+	return block;
+}
+
+
+/**
+ * _allocator_cached_free_block
+ *
+ * Releases the given block to the parent allocator. The caller must hold the
+ * allocator's lock.
+ *
+ */
+static void _allocator_cached_free_block( allocator_cached_t * cached, void * block )
+{
+	allocator_free( _allocator_cached_header( block ), cached->parent );
+}
+
+
+/**
+ * _allocator_cached_release
+ *
+ * Releases up to the given number of blocks of the given size class from the given
+ * thread's cache to the parent allocator, taking the lock only once.
+ *
+ */
+static void _allocator_cached_release( _allocator_cached_thread_t * thread, size_t index, size_t count )
+{
+	allocator_cached_t * cached = thread->owner;
+
+	pthread_mutex_lock( &cached->lock );
+	while ( count-- && thread->heads[ index ] )
+	{
+		void * block = thread->heads[ index ];
+		thread->heads[ index ] = *( ( void ** ) block );
+		--thread->counts[ index ];
+		_allocator_cached_free_block( cached, block );
+	}
+	pthread_mutex_unlock( &cached->lock );
+}
+
+
+/**
+ * _allocator_cached_release_all
+ *
+ * Releases every block in the given thread's cache to the parent allocator.
+ *
+ */
+static void _allocator_cached_release_all( _allocator_cached_thread_t * thread )
+{
+	size_t index;
+
+	for ( index = 0; index < thread->owner->num_classes; ++index )
+	{
+		_allocator_cached_release( thread, index, thread->counts[ index ] );
+	}
+}
+
+
+/**
+ * _allocator_cached_thread_exit
+ *
+ * Releases a thread's cache when the thread exits.
+ *
+ */
+static void _allocator_cached_thread_exit( void * value )
+{
+	_allocator_cached_thread_t * thread = ( _allocator_cached_thread_t * ) value;
+	allocator_cached_t * cached = thread->owner;
+
+	_allocator_cached_release_all( thread );
+
+	pthread_mutex_lock( &cached->lock );
+	allocator_free( thread, cached->parent );
+	pthread_mutex_unlock( &cached->lock );
+}
+
+
+/**
+ * _allocator_cached_thread
+ *
+ * Returns the calling thread's cache, creating it if necessary. Returns null if the
+ * cache could not be created.
+ *
+ */
+static _allocator_cached_thread_t * _allocator_cached_thread( allocator_cached_t * cached )
+{
+	_allocator_cached_thread_t * thread;
+	size_t index;
+
+	thread = ( _allocator_cached_thread_t * ) pthread_getspecific( cached->key );
+	if ( thread )
+	{
+		return thread;
+	}
+
+	pthread_mutex_lock( &cached->lock );
+	thread = ( _allocator_cached_thread_t * ) allocator_alloc( sizeof( *thread ), cached->parent );
+	pthread_mutex_unlock( &cached->lock );
+
+	if ( !thread )
+	{
+		return 0;
+	}
+
+	thread->owner = cached;
+	for ( index = 0; index < ALLOCATOR_CACHED_MAX_CLASSES; ++index )
+	{
+		thread->heads[ index ] = 0;
+		thread->counts[ index ] = 0;
+	}
+
+	if ( pthread_setspecific( cached->key, thread ) != 0 )
+	{
+		pthread_mutex_lock( &cached->lock );
+		allocator_free( thread, cached->parent );
+		pthread_mutex_unlock( &cached->lock );
+		return 0;
+	}
+
+	return thread;
+}
+
+
+/**
+ * _allocator_cached_alloc
+ *
+ * Allocates a block from the calling thread's cache, refilling the cache from the
+ * parent allocator in a batch if it is empty. Blocks too large to be cached are
+ * allocated directly from the parent.
+ *
+ */
+static void * _allocator_cached_alloc( size_t length, allocator_t * allocator )
+{
+	allocator_cached_t * cached = ( allocator_cached_t * ) allocator;
+	_allocator_cached_thread_t * thread = 0;
+	void * block;
+	size_t index;
+
+	if ( !length )
+	{
+		return 0;
+	}
+
+	for ( index = 0; index < cached->num_classes && cached->sizes[ index ] < length; ++index )
+	{
+	}
+
+	if ( index < cached->num_classes )
+	{
+		thread = _allocator_cached_thread( cached );
+	}
+
+	if ( !thread )
+	{
+		pthread_mutex_lock( &cached->lock );
+		block = _allocator_cached_alloc_block( cached, length, _ALLOCATOR_CACHED_UNCACHED );
+		pthread_mutex_unlock( &cached->lock );
+		return block;
+	}
+
+	if ( !thread->heads[ index ] )
+	{
+		size_t count;
+
+		pthread_mutex_lock( &cached->lock );
+		for ( count = 0; count < cached->batch || !count; ++count )
+		{
+			block = _allocator_cached_alloc_block( cached, cached->sizes[ index ], index );
+			if ( !block )
+			{
+				break;
+			}
+			*( ( void ** ) block ) = thread->heads[ index ];
+			thread->heads[ index ] = block;
+			++thread->counts[ index ];
+		}
+		pthread_mutex_unlock( &cached->lock );
+	}
+
+	block = thread->heads[ index ];
+	if ( block )
+	{
+		thread->heads[ index ] = *( ( void ** ) block );
+		--thread->counts[ index ];
+	}
+	return block;
+}
+
+
+/**
+ * _allocator_cached_free
+ *
+ * Returns the given block to the calling thread's cache, releasing a batch of
+ * blocks to the parent allocator if the cache has grown beyond its limit.
+ *
+ */
+static void _allocator_cached_free( void * address, allocator_t * allocator )
+{
+	allocator_cached_t * cached = ( allocator_cached_t * ) allocator;
+	_allocator_cached_thread_t * thread = 0;
+	size_t index;
+
+	if ( !address )
+	{
+		return;
+	}
+
+	index = *_allocator_cached_header( address );
+	if ( index < cached->num_classes )
+	{
+		thread = _allocator_cached_thread( cached );
+	}
+
+	if ( !thread )
+	{
+		pthread_mutex_lock( &cached->lock );
+		_allocator_cached_free_block( cached, address );
+		pthread_mutex_unlock( &cached->lock );
+		return;
+	}
+
+	*( ( void ** ) address ) = thread->heads[ index ];
+	thread->heads[ index ] = address;
+
+	if ( ++thread->counts[ index ] > cached->limit )
+	{
+		size_t surplus = thread->counts[ index ] - cached->limit;
+		_allocator_cached_release( thread, index, surplus > cached->batch ? surplus : cached->batch );
+	}
+}
+
+
+/**
+ * allocator_cached_init
+ *
+ * Initialises the given cached allocator, caching blocks of the given sizes
+ * allocated from the given parent allocator, sorted into ascending order.
+ *
+ */
+void allocator_cached_init(
+	allocator_cached_t * allocator,
+	allocator_t * parent,
+	const size_t * sizes,
+	size_t num_sizes
+)
+{
+	size_t index, sorted, size;
+
+	if ( !allocator )
+	{
+		return;
+	}
+
+	allocator->alloc.alloc_fn = &_allocator_cached_alloc;
+	allocator->alloc.free_fn = &_allocator_cached_free;
+	allocator->parent = parent;
+	allocator->limit = ALLOCATOR_CACHED_LIMIT;
+	allocator->batch = ALLOCATOR_CACHED_BATCH;
+	allocator->num_classes = 0;
+	pthread_mutex_init( &allocator->lock, 0 );
+
+	if ( pthread_key_create( &allocator->key, &_allocator_cached_thread_exit ) != 0 )
+	{
+		/* Every allocation will be passed straight through to the parent */
+		return;
+	}
+
+	if ( !sizes || !num_sizes )
+	{
+		for ( index = 0; index < 8; ++index )
+		{
+			allocator->sizes[ index ] = ( size_t ) 16 << index;
+		}
+		allocator->num_classes = 8;
+		return;
+	}
+
+	for ( index = 0; index < num_sizes && index < ALLOCATOR_CACHED_MAX_CLASSES; ++index )
+	{
+		/* Each free block must be able to hold a pointer to the next */
+		size = sizes[ index ] < sizeof( void * ) ? sizeof( void * ) : sizes[ index ];
+
+		/* Allocations use the first class large enough, so the classes are kept in
+		 * ascending order */
+		for ( sorted = index; sorted > 0 && allocator->sizes[ sorted - 1 ] > size; --sorted )
+		{
+			allocator->sizes[ sorted ] = allocator->sizes[ sorted - 1 ];
+		}
+		allocator->sizes[ sorted ] = size;
+	}
+	allocator->num_classes = index;
+}
+
+
+/**
+ * allocator_cached_init_default
+ *
+ * Initialises the given cached allocator with the default size classes, using the
+ * default allocator as its parent.
+ *
+ */
+void allocator_cached_init_default(
+	allocator_cached_t * allocator
+)
+{
+	allocator_cached_init( allocator, allocator_default( ), 0, 0 );
+}
+
+
+/**
+ * allocator_cached_cleanup
+ *
+ * Releases the calling thread's cached blocks, and the allocator's resources.
+ *
+ */
+void allocator_cached_cleanup(
+	allocator_cached_t * allocator
+)
+{
+	if ( !allocator )
+	{
+		return;
+	}
+
+	if ( allocator->num_classes )
+	{
+		_allocator_cached_thread_t * thread =
+			( _allocator_cached_thread_t * ) pthread_getspecific( allocator->key );
+
+		if ( thread )
+		{
+			pthread_setspecific( allocator->key, 0 );
+			_allocator_cached_thread_exit( thread );
+		}
+
+		pthread_key_delete( allocator->key );
+		allocator->num_classes = 0;
+	}
+
+	pthread_mutex_destroy( &allocator->lock );
+}
+
+
+/**
+ * allocator_cached_get
+ *
+ * Returns the given cached allocator as an allocator_t pointer.
+ *
+ */
+allocator_t * allocator_cached_get(
+	allocator_cached_t * allocator
+)
+{
+	return ( allocator_t * ) allocator;
+}
+
+
+/**
+ * allocator_cached_flush
+ *
+ * Releases all blocks cached by the calling thread, and the thread's cache itself,
+ * to the parent allocator.
+ *
+ */
+void allocator_cached_flush(
+	allocator_cached_t * allocator
+)
+{
+	if ( allocator && allocator->num_classes )
+	{
+		_allocator_cached_thread_t * thread =
+			( _allocator_cached_thread_t * ) pthread_getspecific( allocator->key );
+
+		/* Detach the cache as well as emptying it, as once allocator_cached_cleanup
+		 * has deleted the key its destructor will no longer release it */
+		if ( thread )
+		{
+			pthread_setspecific( allocator->key, 0 );
+			_allocator_cached_thread_exit( thread );
+		}
+	}
+}
+
+
+/**
+ * allocator_cached_count
+ *
+ * Returns the number of free blocks currently cached by the calling thread.
+ *
+ */
+size_t allocator_cached_count(
+	allocator_cached_t * allocator
+)
+{
+	size_t count = 0, index;
+
+	if ( allocator && allocator->num_classes )
+	{
+		_allocator_cached_thread_t * thread =
+			( _allocator_cached_thread_t * ) pthread_getspecific( allocator->key );
+
+		for ( index = 0; thread && index < allocator->num_classes; ++index )
+		{
+			count += thread->counts[ index ];
+		}
+	}
+
+	return count;
+}
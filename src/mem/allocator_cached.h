@@ -0,0 +1,170 @@
+#ifndef __MEM_ALLOCATOR_CACHED_H
+#define __MEM_ALLOCATOR_CACHED_H
+
+#include <pthread.h>
+
+#include "allocator.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * ALLOCATOR_CACHED_MAX_CLASSES
+ *
+ * The maximum number of size classes a cached allocator can cache.
+ *
+ */
+#define ALLOCATOR_CACHED_MAX_CLASSES 16
+
+
+/**
+ * ALLOCATOR_CACHED_LIMIT
+ *
+ * The default maximum number of free blocks of each size class cached per thread.
+ *
+ */
+#ifndef ALLOCATOR_CACHED_LIMIT
+#define ALLOCATOR_CACHED_LIMIT 64
+#endif
+
+
+/**
+ * ALLOCATOR_CACHED_BATCH
+ *
+ * The default number of blocks allocated from, or released to, the parent allocator
+ * at once when a thread's cache of a size class runs empty or overflows.
+ *
+ */
+#ifndef ALLOCATOR_CACHED_BATCH
+#define ALLOCATOR_CACHED_BATCH 32
+#endif
+
+
+/**
+ * allocator_cached_t
+ *
+ * Keeps per-thread lists of free blocks for a set of small size classes in front
+ * of a parent allocator, such that most allocations and frees are satisfied without
+ * calling the parent at all. Blocks are allocated from and released to the parent
+ * in batches, under a lock - so the parent need not be thread-safe. Larger blocks
+ * are passed straight through to the parent (also under the lock). A thread's
+ * cached blocks are released to the parent when it exits.
+ *
+ * Blocks may be freed by any thread, joining that thread's cache.
+ *
+ */
+typedef struct allocator_cached_t
+{
+	/* The allocation functions for this allocator */
+	allocator_t alloc;
+
+	/* The parent allocator to which cache misses are forwarded */
+	allocator_t * parent;
+
+	/* The block sizes that are cached, in ascending order */
+	size_t sizes[ ALLOCATOR_CACHED_MAX_CLASSES ];
+
+	/* The number of size classes in use (zero if caching is unavailable) */
+	size_t num_classes;
+
+	/* The maximum number of free blocks of each size class cached per thread, which
+	 * may be changed after initialisation but before any other thread uses the
+	 * allocator (it is read without synchronisation) */
+	size_t limit;
+
+	/* The number of blocks transferred to or from the parent at once, which may be
+	 * changed under the same conditions as limit */
+	size_t batch;
+
+	/* The key under which each thread's cache is stored */
+	pthread_key_t key;
+
+	/* Serialises calls to the parent allocator */
+	pthread_mutex_t lock;
+
+} allocator_cached_t;
+
+
+/**
+ * allocator_cached_init
+ *
+ * Initialises the given cached allocator, caching blocks of the given sizes (up to
+ * ALLOCATOR_CACHED_MAX_CLASSES of them, in any order) allocated from the given
+ * parent allocator. If no sizes are given, powers of two from 16 to 2048
+ * bytes are cached. Should call allocator_cached_cleanup to release cached blocks.
+ *
+ */
+void allocator_cached_init(
+	allocator_cached_t * allocator,
+	allocator_t * parent,
+	const size_t * sizes,
+	size_t num_sizes
+);
+
+
+/**
+ * allocator_cached_init_default
+ *
+ * Initialises the given cached allocator with the default size classes, using the
+ * default allocator as its parent.
+ *
+ */
+void allocator_cached_init_default(
+	allocator_cached_t * allocator
+);
+
+
+/**
+ * allocator_cached_cleanup
+ *
+ * Releases the calling thread's cached blocks, and the allocator's resources. Every
+ * other thread that used the allocator must have exited (or called
+ * allocator_cached_flush) beforehand, or its cached blocks will be leaked.
+ *
+ */
+void allocator_cached_cleanup(
+	allocator_cached_t * allocator
+);
+
+
+/**
+ * allocator_cached_get
+ *
+ * Returns the given cached allocator as an allocator_t pointer.
+ *
+ */
+allocator_t * allocator_cached_get(
+	allocator_cached_t * allocator
+);
+
+
+/**
+ * allocator_cached_flush
+ *
+ * Releases all blocks cached by the calling thread, and the thread's cache itself,
+ * to the parent allocator. The cache is recreated should the thread use the
+ * allocator again.
+ *
+ */
+void allocator_cached_flush(
+	allocator_cached_t * allocator
+);
+
+
+/**
+ * allocator_cached_count
+ *
+ * Returns the number of free blocks currently cached by the calling thread.
+ *
+ */
+size_t allocator_cached_count(
+	allocator_cached_t * allocator
+);
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+#endif /* __MEM_ALLOCATOR_CACHED_H */
@@ -0,0 +1,359 @@
+#include <pthread.h>
+
+#include "allocator_concurrent.h"
+#include "internal/spinlock.h"
+
+
+/**
+ * _ALLOCATOR_CONCURRENT_HEADER
+ *
+ * The size of the header preceding each block allocated by the striped strategy,
+ * which records the block's stripe. Sized to preserve the alignment of the
+ * parent's allocations.
+ *
+ */
+#define _ALLOCATOR_CONCURRENT_HEADER 16
+
+
+/**
+ * _ALLOCATOR_CONCURRENT_*
+ *
+ * The states of a combining request.
+ *
+ */
+#define _ALLOCATOR_CONCURRENT_IDLE 0
+#define _ALLOCATOR_CONCURRENT_PENDING 1
+#define _ALLOCATOR_CONCURRENT_DONE 2
+
+
+/* The key holding each thread's hint, and the number of hints handed out so far */
+static pthread_key_t _allocator_concurrent_key;
+static pthread_once_t _allocator_concurrent_key_once = PTHREAD_ONCE_INIT;
+static int _allocator_concurrent_key_valid = 0;
+static size_t _allocator_concurrent_next_hint = 0;
+
+
+/**
+ * _allocator_concurrent_key_init
+ *
+ * Creates the key holding each thread's hint.
+ *
+ */
+static void _allocator_concurrent_key_init( void )
+{
+	_allocator_concurrent_key_valid = pthread_key_create( &_allocator_concurrent_key, 0 ) == 0;
+}
+
+
+/**
+ * _allocator_concurrent_thread_hint
+ *
+ * Returns a number that is stable for the calling thread, used to spread threads
+ * over stripes and request slots. Hints are handed out in sequence as each thread
+ * first asks for one, so that N threads occupy N distinct stripes or slots where
+ * there are at least N. Threads sharing a hint remain correct, only contending
+ * with each other.
+ *
+ */
+static size_t _allocator_concurrent_thread_hint( void )
+{
+	size_t hint;
+
+	pthread_once( &_allocator_concurrent_key_once, _allocator_concurrent_key_init );
+	if ( !_allocator_concurrent_key_valid )
+	{
+		return 0;
+	}
+
+	/* Hints are stored off by one, as a null value means none has been assigned */
+	hint = ( size_t ) pthread_getspecific( _allocator_concurrent_key );
+	if ( !hint )
+	{
+		hint = ATOMIC_FETCH_ADD_RELAXED( &_allocator_concurrent_next_hint, 1 ) + 1;
+		pthread_setspecific( _allocator_concurrent_key, ( void * ) hint );
+	}
+
+	return hint - 1;
+}
+
+
+/**
+ * _allocator_concurrent_serve
+ *
+ * Serves every pending request in the given combining allocator. The caller must
+ * hold the allocator's lock.
+ *
+ */
+static void _allocator_concurrent_serve( allocator_concurrent_t * concurrent )
+{
+	size_t index;
+
+	for ( index = 0; index < ALLOCATOR_CONCURRENT_SLOTS; ++index )
+	{
+		allocator_concurrent_request_t * request = &concurrent->requests[ index ];
+
+		if ( ATOMIC_LOAD_ACQUIRE( &request->state ) == _ALLOCATOR_CONCURRENT_PENDING )
+		{
+			if ( request->length )
+			{
+				request->address = allocator_alloc( request->length, concurrent->parents[ 0 ] );
+			}
+			else
+			{
+				allocator_free( request->address, concurrent->parents[ 0 ] );
+			}
+			ATOMIC_STORE_RELEASE( &request->state, _ALLOCATOR_CONCURRENT_DONE );
+		}
+	}
+}
+
+
+/**
+ * _allocator_concurrent_combine
+ *
+ * Publishes a request to allocate the given number of bytes (or free the given
+ * address if zero) and waits for it to be served - serving it, and any other
+ * pending requests, itself if the lock is available. Returns the allocated address.
+ *
+ */
+static void * _allocator_concurrent_combine( allocator_concurrent_t * concurrent, size_t length, void * address )
+{
+	allocator_concurrent_request_t * request;
+	size_t slot = _allocator_concurrent_thread_hint( ) % ALLOCATOR_CONCURRENT_SLOTS;
+	size_t attempts = 0;
+
+	for ( ;; )
+	{
+		request = &concurrent->requests[ slot ];
+		if ( !ATOMIC_LOAD_RELAXED( &request->claimed ) && !ATOMIC_EXCHANGE_ACQUIRE( &request->claimed, 1 ) )
+		{
+			break;
+		}
+
+		slot = ( slot + 1 ) % ALLOCATOR_CONCURRENT_SLOTS;
+		if ( ++attempts % ALLOCATOR_CONCURRENT_SLOTS == 0 )
+		{
+			sched_yield( );
+		}
+	}
+
+	request->length = length;
+	request->address = address;
+	ATOMIC_STORE_RELEASE( &request->state, _ALLOCATOR_CONCURRENT_PENDING );
+
+	for ( attempts = 0; ATOMIC_LOAD_ACQUIRE( &request->state ) != _ALLOCATOR_CONCURRENT_DONE; ++attempts )
+	{
+		if ( spinlock_try_lock( &concurrent->locks[ 0 ] ) )
+		{
+			_allocator_concurrent_serve( concurrent );
+			spinlock_unlock( &concurrent->locks[ 0 ] );
+		}
+		else if ( attempts % SPINLOCK_SPINS == SPINLOCK_SPINS - 1 )
+		{
+			sched_yield( );
+		}
+	}
+
+	address = request->address;
+	ATOMIC_STORE_RELAXED( &request->state, _ALLOCATOR_CONCURRENT_IDLE );
+	ATOMIC_STORE_RELEASE( &request->claimed, 0 );
+	return address;
+}
+
+
+/**
+ * _allocator_concurrent_alloc
+ *
+ * Allocates a block from the parent allocator using the allocator's strategy.
+ *
+ */
+static void * _allocator_concurrent_alloc( size_t length, allocator_t * allocator )
+{
+	allocator_concurrent_t * concurrent = ( allocator_concurrent_t * ) allocator;
+	int8_t * block;
+	size_t stripe;
+
+	if ( !length )
+	{
+		return 0;
+	}
+
+	switch ( concurrent->strategy )
+	{
+	case ALLOCATOR_CONCURRENT_STRIPED:
+		if ( length > ( size_t ) -1 - _ALLOCATOR_CONCURRENT_HEADER )
+		{
+			return 0;
+		}
+
+		stripe = _allocator_concurrent_thread_hint( ) % concurrent->num_stripes;
+		spinlock_lock( &concurrent->locks[ stripe ] );
+		block = ( int8_t * ) allocator_alloc( _ALLOCATOR_CONCURRENT_HEADER + length, concurrent->parents[ stripe ] );
+		spinlock_unlock( &concurrent->locks[ stripe ] );
+
+		if ( !block )
+		{
+			return 0;
+		}
+
+		*( ( size_t * ) block ) = stripe;
+		return block + _ALLOCATOR_CONCURRENT_HEADER;
+
+	case ALLOCATOR_CONCURRENT_COMBINING:
+		return _allocator_concurrent_combine( concurrent, length, 0 );
+
+	default:
+		spinlock_lock( &concurrent->locks[ 0 ] );
+		block = ( int8_t * ) allocator_alloc( length, concurrent->parents[ 0 ] );
+		spinlock_unlock( &concurrent->locks[ 0 ] );
+		return block;
+	}
+}
+
+
+/**
+ * _allocator_concurrent_free
+ *
+ * Releases a block to the parent allocator it was allocated from, using the
+ * allocator's strategy.
+ *
+ */
+static void _allocator_concurrent_free( void * address, allocator_t * allocator )
+{
+	allocator_concurrent_t * concurrent = ( allocator_concurrent_t * ) allocator;
+	int8_t * block;
+	size_t stripe;
+
+	if ( !address )
+	{
+		return;
+	}
+
+	switch ( concurrent->strategy )
+	{
+	case ALLOCATOR_CONCURRENT_STRIPED:
+		block = ( ( int8_t * ) address ) - _ALLOCATOR_CONCURRENT_HEADER;
+		stripe = *( ( size_t * ) block );
+		spinlock_lock( &concurrent->locks[ stripe ] );
+		allocator_free( block, concurrent->parents[ stripe ] );
+		spinlock_unlock( &concurrent->locks[ stripe ] );
+		break;
+
+	case ALLOCATOR_CONCURRENT_COMBINING:
+		_allocator_concurrent_combine( concurrent, 0, address );
+		break;
+
+	default:
+		spinlock_lock( &concurrent->locks[ 0 ] );
+		allocator_free( address, concurrent->parents[ 0 ] );
+		spinlock_unlock( &concurrent->locks[ 0 ] );
+		break;
+	}
+}
+
+
+/**
+ * allocator_concurrent_init_striped
+ *
+ * Initialises the given concurrent allocator with the striped strategy, spreading
+ * allocations over the given parent allocators.
+ *
+ */
+void allocator_concurrent_init_striped(
+	allocator_concurrent_t * allocator,
+	allocator_t ** parents,
+	size_t num_parents
+)
+{
+	size_t index;
+
+	if ( !allocator )
+	{
+		return;
+	}
+
+	allocator->alloc.alloc_fn = &_allocator_concurrent_alloc;
+	allocator->alloc.free_fn = &_allocator_concurrent_free;
+	allocator->strategy = ALLOCATOR_CONCURRENT_STRIPED;
+	allocator->num_stripes = 0;
+
+	for ( index = 0; index < ALLOCATOR_CONCURRENT_MAX_STRIPES; ++index )
+	{
+		allocator->parents[ index ] = 0;
+		allocator->locks[ index ] = 0;
+	}
+
+	for ( index = 0; parents && index < num_parents && index < ALLOCATOR_CONCURRENT_MAX_STRIPES; ++index )
+	{
+		allocator->parents[ index ] = parents[ index ];
+		++allocator->num_stripes;
+	}
+
+	if ( !allocator->num_stripes )
+	{
+		allocator->num_stripes = 1;
+	}
+
+	for ( index = 0; index < ALLOCATOR_CONCURRENT_SLOTS; ++index )
+	{
+		allocator->requests[ index ].claimed = 0;
+		allocator->requests[ index ].state = _ALLOCATOR_CONCURRENT_IDLE;
+		allocator->requests[ index ].length = 0;
+		allocator->requests[ index ].address = 0;
+	}
+}
+
+
+/**
+ * allocator_concurrent_init
+ *
+ * Initialises the given concurrent allocator, forwarding allocations to the given
+ * parent allocator using the given strategy.
+ *
+ */
+void allocator_concurrent_init(
+	allocator_concurrent_t * allocator,
+	allocator_t * parent,
+	int strategy
+)
+{
+	allocator_concurrent_init_striped( allocator, &parent, 1 );
+	if ( allocator && strategy == ALLOCATOR_CONCURRENT_COMBINING )
+	{
+		allocator->strategy = strategy;
+	}
+	else if ( allocator && strategy != ALLOCATOR_CONCURRENT_STRIPED )
+	{
+		allocator->strategy = ALLOCATOR_CONCURRENT_SPINLOCK;
+	}
+}
+
+
+/**
+ * allocator_concurrent_init_default
+ *
+ * Initialises the given concurrent allocator with the given strategy, using the
+ * default allocator as its parent.
+ *
+ */
+void allocator_concurrent_init_default(
+	allocator_concurrent_t * allocator,
+	int strategy
+)
+{
+	allocator_concurrent_init( allocator, allocator_default( ), strategy );
+}
+
+
+/**
+ * allocator_concurrent_get
+ *
+ * Returns the given concurrent allocator as an allocator_t pointer.
+ *
+ */
+allocator_t * allocator_concurrent_get(
+	allocator_concurrent_t * allocator
+)
+{
+	return ( allocator_t * ) allocator;
+}
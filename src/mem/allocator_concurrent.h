@@ -0,0 +1,179 @@
+#ifndef __MEM_ALLOCATOR_CONCURRENT_H
+#define __MEM_ALLOCATOR_CONCURRENT_H
+
+#include "allocator.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * ALLOCATOR_CONCURRENT_SPINLOCK
+ *
+ * Concurrent allocator strategy - every call to the parent allocator is made
+ * under a single spinlock. Cheapest when contention is low.
+ *
+ */
+#define ALLOCATOR_CONCURRENT_SPINLOCK 0
+
+
+/**
+ * ALLOCATOR_CONCURRENT_STRIPED
+ *
+ * Concurrent allocator strategy - allocations are spread over a number of parent
+ * allocators (stripes), each under its own spinlock, with each thread favouring
+ * one stripe. Blocks are returned to the stripe they were allocated from, whichever
+ * thread frees them. Scales with the number of stripes, at the cost of a small
+ * header per block.
+ *
+ */
+#define ALLOCATOR_CONCURRENT_STRIPED 1
+
+
+/**
+ * ALLOCATOR_CONCURRENT_COMBINING
+ *
+ * Concurrent allocator strategy - each thread publishes its request in a slot, and
+ * whichever thread holds the lock serves every published request in one pass (flat
+ * combining), so the parent's state stays in one core's cache under heavy
+ * contention.
+ *
+ */
+#define ALLOCATOR_CONCURRENT_COMBINING 2
+
+
+/**
+ * ALLOCATOR_CONCURRENT_MAX_STRIPES
+ *
+ * The maximum number of parent allocators a striped concurrent allocator can use.
+ *
+ */
+#define ALLOCATOR_CONCURRENT_MAX_STRIPES 16
+
+
+/**
+ * ALLOCATOR_CONCURRENT_SLOTS
+ *
+ * The number of request slots used by a combining concurrent allocator. Threads
+ * beyond this number wait for a free slot.
+ *
+ */
+#ifndef ALLOCATOR_CONCURRENT_SLOTS
+#define ALLOCATOR_CONCURRENT_SLOTS 16
+#endif
+
+
+/**
+ * allocator_concurrent_request_t
+ *
+ * A request published by a thread to a combining concurrent allocator.
+ *
+ */
+typedef struct allocator_concurrent_request_t
+{
+	/* Non-zero while a thread owns the slot */
+	int claimed;
+
+	/* The state of the request (idle, pending or done) */
+	int state;
+
+	/* The number of bytes to allocate, or zero to free the address */
+	size_t length;
+
+	/* The address to free, or the allocated address once done */
+	void * address;
+
+} allocator_concurrent_request_t;
+
+
+/**
+ * allocator_concurrent_t
+ *
+ * Makes any allocator safe to share between threads, using one of the
+ * ALLOCATOR_CONCURRENT_* strategies. No mutexes are used - waiting threads spin
+ * briefly, then yield.
+ *
+ */
+typedef struct allocator_concurrent_t
+{
+	/* The allocation functions for this allocator */
+	allocator_t alloc;
+
+	/* The ALLOCATOR_CONCURRENT_* strategy in use */
+	int strategy;
+
+	/* The parent allocators (only the first is used unless striped) */
+	allocator_t * parents[ ALLOCATOR_CONCURRENT_MAX_STRIPES ];
+
+	/* The number of parent allocators */
+	size_t num_stripes;
+
+	/* The lock guarding each parent allocator (a spinlock_t) */
+	int locks[ ALLOCATOR_CONCURRENT_MAX_STRIPES ];
+
+	/* The request slots used by the combining strategy */
+	allocator_concurrent_request_t requests[ ALLOCATOR_CONCURRENT_SLOTS ];
+
+} allocator_concurrent_t;
+
+
+/**
+ * allocator_concurrent_init
+ *
+ * Initialises the given concurrent allocator, forwarding allocations to the given
+ * parent allocator using the given ALLOCATOR_CONCURRENT_* strategy. Striping over
+ * a single parent is equivalent to the spinlock strategy - see
+ * allocator_concurrent_init_striped.
+ *
+ */
+void allocator_concurrent_init(
+	allocator_concurrent_t * allocator,
+	allocator_t * parent,
+	int strategy
+);
+
+
+/**
+ * allocator_concurrent_init_striped
+ *
+ * Initialises the given concurrent allocator with the striped strategy, spreading
+ * allocations over the given parent allocators (up to
+ * ALLOCATOR_CONCURRENT_MAX_STRIPES). Each parent must be independent of the others.
+ *
+ */
+void allocator_concurrent_init_striped(
+	allocator_concurrent_t * allocator,
+	allocator_t ** parents,
+	size_t num_parents
+);
+
+
+/**
+ * allocator_concurrent_init_default
+ *
+ * Initialises the given concurrent allocator with the given strategy, using the
+ * default allocator as its parent.
+ *
+ */
+void allocator_concurrent_init_default(
+	allocator_concurrent_t * allocator,
+	int strategy
+);
+
+
+/**
+ * allocator_concurrent_get
+ *
+ * Returns the given concurrent allocator as an allocator_t pointer.
+ *
+ */
+allocator_t * allocator_concurrent_get(
+	allocator_concurrent_t * allocator
+);
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+#endif /* __MEM_ALLOCATOR_CONCURRENT_H */
@@ -0,0 +1,435 @@
+#include "allocator_stack.h"
+
+
+/**
+ * _allocator_stack_block_t
+ *
+ * The header immediately preceding each block in the stack's storage.
+ *
+ */
+typedef struct _allocator_stack_block_t
+{
+	/* The number of bytes of storage in use before this block was allocated */
+	size_t length;
+
+	/* The offset of the block below this one (plus one, or zero if there is none) */
+	size_t previous;
+
+	/* The sequence number of the block, identifying it to markers, shifted left by
+	 * one - the low bit is set once the block has been freed */
+	size_t state;
+
+} _allocator_stack_block_t;
+
+
+/**
+ * _allocator_stack_align
+ *
+ * Rounds the given address up to the stack's alignment.
+ *
+ */
+static size_t _allocator_stack_align( size_t address )
+{
+	return ( address + ALLOCATOR_STACK_ALIGNMENT - 1 ) /
+		ALLOCATOR_STACK_ALIGNMENT * ALLOCATOR_STACK_ALIGNMENT;
+}
+
+
+/**
+ * _allocator_stack_truncate
+ *
+ * Sets the number of bytes of the stack's storage in use.
+ *
+ */
+static void _allocator_stack_truncate( allocator_stack_t * stack, size_t length )
+{
+	buffer_rewind( &stack->storage );
+	buffer_commit( &stack->storage, length );
+}
+
+
+/**
+ * _allocator_stack_block
+ *
+ * Returns the header of the block at the given offset (plus one) in the stack's
+ * storage.
+ *
+ */
+static _allocator_stack_block_t * _allocator_stack_block( allocator_stack_t * stack, size_t top )
+{
+	return ( ( _allocator_stack_block_t * )( stack->storage.begin + top - 1 ) ) - 1;
+}
+
+
+/**
+ * _allocator_stack_release
+ *
+ * Releases the topmost blocks of the stack for as long as they have been freed.
+ *
+ */
+static void _allocator_stack_release( allocator_stack_t * stack )
+{
+	while ( stack->top )
+	{
+		_allocator_stack_block_t * block = _allocator_stack_block( stack, stack->top );
+
+		if ( !( block->state & 1 ) )
+		{
+			break;
+		}
+
+		_allocator_stack_truncate( stack, block->length );
+		stack->top = block->previous;
+	}
+}
+
+
+/**
+ * _allocator_stack_alloc_overflow
+ *
+ * Allocates a block from the parent allocator, once the stack's storage is full.
+ *
+ */
+static void * _allocator_stack_alloc_overflow( allocator_stack_t * stack, size_t length )
+{
+	size_t extra = sizeof( allocator_stack_overflow_t ) + ALLOCATOR_STACK_ALIGNMENT - 1;
+	allocator_stack_overflow_t * header;
+	void * block;
+
+	if ( length > ( size_t ) -1 - extra )
+	{
+		return 0;
+	}
+
+	block = allocator_alloc( extra + length, stack->parent );
+	if ( !block )
+	{
+		return 0;
+	}
+
+	/* Align the memory, leaving room for the header beneath it */
+	header = ( ( allocator_stack_overflow_t * ) _allocator_stack_align(
+		( size_t )( ( allocator_stack_overflow_t * ) block + 1 ) ) ) - 1;
+	header->next = stack->overflow;
+	header->block = block;
+	header->sequence = ++stack->sequence;
+	stack->overflow = header;
+	return header + 1;
+}
+
+
+/**
+ * _allocator_stack_free_overflow
+ *
+ * Releases the overflow block at the given address, if there is one.
+ *
+ */
+static void _allocator_stack_free_overflow( allocator_stack_t * stack, void * address )
+{
+	allocator_stack_overflow_t ** link = &stack->overflow;
+
+	while ( *link )
+	{
+		allocator_stack_overflow_t * header = *link;
+		if ( ( void * )( header + 1 ) == address )
+		{
+			*link = header->next;
+			allocator_free( header->block, stack->parent );
+			return;
+		}
+		link = &header->next;
+	}
+}
+
+
+/**
+ * _allocator_stack_alloc
+ *
+ * Allocates the given number of bytes from the top of the stack, or from the parent
+ * allocator if the stack is full and may overflow.
+ *
+ */
+static void * _allocator_stack_alloc( size_t length, allocator_t * allocator )
+{
+	allocator_stack_t * stack = ( allocator_stack_t * ) allocator;
+	int8_t * begin = stack->storage.begin;
+
+	if ( !length )
+	{
+		return 0;
+	}
+
+	if ( begin )
+	{
+		size_t used = buffer_data_length( &stack->storage );
+		size_t capacity = stack->storage.capacity;
+		size_t address = ( size_t )( begin + used ) + sizeof( _allocator_stack_block_t );
+		size_t offset;
+
+		/* Align the block, leaving room for its header beneath it */
+		address = _allocator_stack_align( address );
+		offset = address - ( size_t ) begin;
+
+		if ( offset <= capacity && length <= capacity - offset )
+		{
+			_allocator_stack_block_t * block = ( ( _allocator_stack_block_t * )( begin + offset ) ) - 1;
+			block->length = used;
+			block->previous = stack->top;
+			block->state = ( ++stack->sequence ) << 1;
+
+			stack->top = offset + 1;
+			buffer_commit( &stack->storage, offset + length - used );
+			return begin + offset;
+		}
+	}
+
+	if ( stack->flags & ALLOCATOR_STACK_OVERFLOW )
+	{
+		return _allocator_stack_alloc_overflow( stack, length );
+	}
+
+	return 0;
+}
+
+
+/**
+ * _allocator_stack_free
+ *
+ * Frees the given block. Blocks in the stack's storage are released once every
+ * block above them has been freed, while overflow blocks are released immediately.
+ *
+ */
+static void _allocator_stack_free( void * address, allocator_t * allocator )
+{
+	allocator_stack_t * stack = ( allocator_stack_t * ) allocator;
+	int8_t * begin = stack->storage.begin;
+
+	if ( !address )
+	{
+		return;
+	}
+
+	if ( begin && ( int8_t * ) address >= begin && ( int8_t * ) address < begin + stack->storage.capacity )
+	{
+		( ( ( _allocator_stack_block_t * ) address ) - 1 )->state |= 1;
+		_allocator_stack_release( stack );
+	}
+	else
+	{
+		_allocator_stack_free_overflow( stack, address );
+	}
+}
+
+
+/**
+ * _allocator_stack_init_fields
+ *
+ * Initialises all fields of the given stack allocator other than its storage.
+ *
+ */
+static void _allocator_stack_init_fields( allocator_stack_t * allocator, allocator_t * parent, int flags )
+{
+	allocator->alloc.alloc_fn = &_allocator_stack_alloc;
+	allocator->alloc.free_fn = &_allocator_stack_free;
+	allocator->top = 0;
+	allocator->parent = parent;
+	allocator->flags = flags;
+	allocator->overflow = 0;
+	allocator->sequence = 0;
+}
+
+
+/**
+ * allocator_stack_init
+ *
+ * Initialises the given stack allocator with the given number of bytes of storage,
+ * allocated from the given parent allocator.
+ *
+ */
+void allocator_stack_init(
+	allocator_stack_t * allocator,
+	size_t capacity,
+	allocator_t * parent,
+	int flags
+)
+{
+	if ( allocator )
+	{
+		_allocator_stack_init_fields( allocator, parent, flags );
+		buffer_init( &allocator->storage, parent );
+		if ( capacity && !buffer_grow( &allocator->storage, capacity ) )
+		{
+			buffer_init( &allocator->storage, parent );
+		}
+	}
+}
+
+
+/**
+ * allocator_stack_init_default
+ *
+ * Initialises the given stack allocator, using the default allocator as its parent.
+ *
+ */
+void allocator_stack_init_default(
+	allocator_stack_t * allocator,
+	size_t capacity,
+	int flags
+)
+{
+	allocator_stack_init( allocator, capacity, allocator_default( ), flags );
+}
+
+
+/**
+ * allocator_stack_init_storage
+ *
+ * Initialises the given stack allocator with caller-provided storage of the given
+ * number of bytes, which must outlive the allocator.
+ *
+ */
+void allocator_stack_init_storage(
+	allocator_stack_t * allocator,
+	void * storage,
+	size_t capacity,
+	allocator_t * parent,
+	int flags
+)
+{
+	if ( allocator )
+	{
+		_allocator_stack_init_fields( allocator, parent, flags );
+		buffer_init_storage( &allocator->storage, storage, capacity, parent );
+	}
+}
+
+
+/**
+ * allocator_stack_cleanup
+ *
+ * Releases the storage and any overflow blocks of the given stack allocator.
+ *
+ */
+void allocator_stack_cleanup(
+	allocator_stack_t * allocator
+)
+{
+	if ( allocator )
+	{
+		allocator_stack_reset( allocator );
+		buffer_cleanup( &allocator->storage );
+	}
+}
+
+
+/**
+ * allocator_stack_get
+ *
+ * Returns the given stack allocator as an allocator_t pointer.
+ *
+ */
+allocator_t * allocator_stack_get(
+	allocator_stack_t * allocator
+)
+{
+	return ( allocator_t * ) allocator;
+}
+
+
+/**
+ * allocator_stack_mark
+ *
+ * Returns a marker for the current position of the given stack allocator.
+ *
+ */
+allocator_stack_marker_t allocator_stack_mark(
+	allocator_stack_t * allocator
+)
+{
+	allocator_stack_marker_t marker;
+	marker.length = 0;
+	marker.top = 0;
+	marker.top_sequence = 0;
+	marker.sequence = 0;
+
+	if ( allocator )
+	{
+		marker.length = buffer_data_length( &allocator->storage );
+		marker.top = allocator->top;
+		marker.top_sequence = allocator->top ? _allocator_stack_block( allocator, allocator->top )->state >> 1 : 0;
+		marker.sequence = allocator->sequence;
+	}
+
+	return marker;
+}
+
+
+/**
+ * allocator_stack_restore
+ *
+ * Releases every block allocated since the given marker was taken (including any
+ * overflow blocks).
+ *
+ */
+void allocator_stack_restore(
+	allocator_stack_t * allocator,
+	allocator_stack_marker_t marker
+)
+{
+	if ( !allocator )
+	{
+		return;
+	}
+
+	while ( allocator->overflow && allocator->overflow->sequence > marker.sequence )
+	{
+		allocator_stack_overflow_t * header = allocator->overflow;
+		allocator->overflow = header->next;
+		allocator_free( header->block, allocator->parent );
+	}
+
+	/* Ignore stale markers - those whose topmost block has already been released,
+	 * whether or not another block has since been allocated in its place */
+	if ( marker.length <= buffer_data_length( &allocator->storage ) &&
+		( !marker.top || _allocator_stack_block( allocator, marker.top )->state >> 1 == marker.top_sequence ) )
+	{
+		_allocator_stack_truncate( allocator, marker.length );
+		allocator->top = marker.top;
+
+		/* Blocks beneath the marker may have been freed in the meantime */
+		_allocator_stack_release( allocator );
+	}
+}
+
+
+/**
+ * allocator_stack_reset
+ *
+ * Releases every block allocated from the given stack allocator.
+ *
+ */
+void allocator_stack_reset(
+	allocator_stack_t * allocator
+)
+{
+	allocator_stack_marker_t marker;
+	marker.length = 0;
+	marker.top = 0;
+	marker.top_sequence = 0;
+	marker.sequence = 0;
+	allocator_stack_restore( allocator, marker );
+}
+
+
+/**
+ * allocator_stack_used
+ *
+ * Returns the number of bytes of the stack's storage currently in use.
+ *
+ */
+size_t allocator_stack_used(
+	allocator_stack_t * allocator
+)
+{
+	return allocator ? buffer_data_length( &allocator->storage ) : 0;
+}
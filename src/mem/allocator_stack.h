@@ -0,0 +1,241 @@
+#ifndef __MEM_ALLOCATOR_STACK_H
+#define __MEM_ALLOCATOR_STACK_H
+
+#include "buffer.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * ALLOCATOR_STACK_ALIGNMENT
+ *
+ * The alignment of every block returned by a stack allocator.
+ *
+ */
+#ifndef ALLOCATOR_STACK_ALIGNMENT
+#define ALLOCATOR_STACK_ALIGNMENT 16
+#endif
+
+
+/**
+ * ALLOCATOR_STACK_OVERFLOW
+ *
+ * Stack allocator flag - once the stack's storage is full, further allocations are
+ * forwarded to the parent allocator (rather than failing).
+ *
+ */
+#define ALLOCATOR_STACK_OVERFLOW 0x1
+
+
+/**
+ * allocator_stack_overflow_t
+ *
+ * The header of a block allocated from the parent allocator once the stack's storage
+ * is full. The block's (aligned) memory immediately follows the header.
+ *
+ */
+typedef struct allocator_stack_overflow_t
+{
+	/* The previously allocated overflow block */
+	struct allocator_stack_overflow_t * next;
+
+	/* The memory returned by the parent allocator, which contains the header */
+	void * block;
+
+	/* The sequence number of this block, used to unwind blocks to a marker */
+	size_t sequence;
+
+} allocator_stack_overflow_t;
+
+
+/**
+ * allocator_stack_marker_t
+ *
+ * A saved position of a stack allocator (see allocator_stack_mark).
+ *
+ */
+typedef struct allocator_stack_marker_t
+{
+	/* The number of bytes of storage in use */
+	size_t length;
+
+	/* The offset of the topmost block (plus one, or zero if there is none) */
+	size_t top;
+
+	/* The sequence number of the topmost block, identifying it should another
+	 * block later be allocated at the same offset */
+	size_t top_sequence;
+
+	/* The sequence number of the most recently allocated block */
+	size_t sequence;
+
+} allocator_stack_marker_t;
+
+
+/**
+ * allocator_stack_t
+ *
+ * An allocator that hands out blocks of a fixed buffer in strict LIFO order. Freeing
+ * the topmost block releases it immediately (along with any blocks below it that
+ * were already freed), while freeing any other block only marks it for release once
+ * the blocks above it have been freed. Markers allow many blocks to be released at
+ * once.
+ *
+ * Note that the stack allocator is not thread-safe.
+ *
+ */
+typedef struct allocator_stack_t
+{
+	/* The allocation functions for this allocator */
+	allocator_t alloc;
+
+	/* The stack's storage, which is never grown */
+	buffer_t storage;
+
+	/* The offset of the topmost block (plus one, or zero if there is none) */
+	size_t top;
+
+	/* The parent allocator, used for the storage and any overflow blocks */
+	allocator_t * parent;
+
+	/* The ALLOCATOR_STACK_* flags the allocator was initialised with */
+	int flags;
+
+	/* The overflow blocks currently allocated, most recent first */
+	allocator_stack_overflow_t * overflow;
+
+	/* The sequence number of the most recently allocated block (in the storage or
+	 * overflowing it) */
+	size_t sequence;
+
+} allocator_stack_t;
+
+
+/**
+ * allocator_stack_init
+ *
+ * Initialises the given stack allocator with the given number of bytes of storage,
+ * allocated from the given parent allocator. flags is a combination of the
+ * ALLOCATOR_STACK_* flags. Should call allocator_stack_cleanup to release the
+ * storage. If the storage cannot be allocated, the stack has zero capacity.
+ *
+ */
+void allocator_stack_init(
+	allocator_stack_t * allocator,
+	size_t capacity,
+	allocator_t * parent,
+	int flags
+);
+
+
+/**
+ * allocator_stack_init_default
+ *
+ * Initialises the given stack allocator, using the default allocator as its parent.
+ *
+ */
+void allocator_stack_init_default(
+	allocator_stack_t * allocator,
+	size_t capacity,
+	int flags
+);
+
+
+/**
+ * allocator_stack_init_storage
+ *
+ * Initialises the given stack allocator with caller-provided storage (e.g. an array
+ * on the stack) of the given number of bytes, which must outlive the allocator. The
+ * parent allocator is only used for overflow blocks (and may be null if flags does
+ * not include ALLOCATOR_STACK_OVERFLOW).
+ *
+ */
+void allocator_stack_init_storage(
+	allocator_stack_t * allocator,
+	void * storage,
+	size_t capacity,
+	allocator_t * parent,
+	int flags
+);
+
+
+/**
+ * allocator_stack_cleanup
+ *
+ * Releases the storage and any overflow blocks of the given stack allocator. All
+ * blocks allocated from it are invalidated.
+ *
+ */
+void allocator_stack_cleanup(
+	allocator_stack_t * allocator
+);
+
+
+/**
+ * allocator_stack_get
+ *
+ * Returns the given stack allocator as an allocator_t pointer.
+ *
+ */
+allocator_t * allocator_stack_get(
+	allocator_stack_t * allocator
+);
+
+
+/**
+ * allocator_stack_mark
+ *
+ * Returns a marker for the current position of the given stack allocator, which
+ * can later be passed to allocator_stack_restore.
+ *
+ */
+allocator_stack_marker_t allocator_stack_mark(
+	allocator_stack_t * allocator
+);
+
+
+/**
+ * allocator_stack_restore
+ *
+ * Releases every block allocated since the given marker was taken (including any
+ * overflow blocks). Markers must be restored in LIFO order - restoring a marker
+ * invalidates any markers taken after it. A marker whose topmost block has since
+ * been released (having been freed along with every block above it) is stale, and
+ * is ignored other than releasing any overflow blocks allocated after it.
+ *
+ */
+void allocator_stack_restore(
+	allocator_stack_t * allocator,
+	allocator_stack_marker_t marker
+);
+
+
+/**
+ * allocator_stack_reset
+ *
+ * Releases every block allocated from the given stack allocator.
+ *
+ */
+void allocator_stack_reset(
+	allocator_stack_t * allocator
+);
+
+
+/**
+ * allocator_stack_used
+ *
+ * Returns the number of bytes of the stack's storage currently in use (including
+ * block headers and padding, and blocks that are freed but not yet released).
+ *
+ */
+size_t allocator_stack_used(
+	allocator_stack_t * allocator
+);
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+#endif /* __MEM_ALLOCATOR_STACK_H */
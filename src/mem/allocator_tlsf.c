@@ -0,0 +1,534 @@
+#include "allocator_tlsf.h"
+
+
+/**
+ * _ALLOCATOR_TLSF_*
+ *
+ * Block flags, stored in the low bits of each block's size.
+ *
+ */
+#define _ALLOCATOR_TLSF_FREE 0x1
+#define _ALLOCATOR_TLSF_PREV_FREE 0x2
+#define _ALLOCATOR_TLSF_FLAGS 0x3
+
+
+/**
+ * _ALLOCATOR_TLSF_SL_LOG2
+ *
+ * The base two logarithm of ALLOCATOR_TLSF_SL_COUNT.
+ *
+ */
+#define _ALLOCATOR_TLSF_SL_LOG2 4
+
+
+/**
+ * _ALLOCATOR_TLSF_SMALL
+ *
+ * Blocks smaller than this all belong to the first first level class, divided
+ * linearly into second level classes of ALLOCATOR_TLSF_ALIGNMENT bytes each.
+ *
+ */
+#define _ALLOCATOR_TLSF_SMALL ( ALLOCATOR_TLSF_SL_COUNT * ALLOCATOR_TLSF_ALIGNMENT )
+
+
+/**
+ * _allocator_tlsf_block_t
+ *
+ * The header of a block. The block's memory immediately follows the header, and
+ * holds the free list links while the block is free.
+ *
+ */
+typedef struct _allocator_tlsf_block_t
+{
+	/* The physically preceding block (only valid if that block is free) */
+	struct _allocator_tlsf_block_t * prev_phys;
+
+	/* The size of the block's memory, combined with the _ALLOCATOR_TLSF_* flags */
+	size_t size;
+
+} _allocator_tlsf_block_t;
+
+
+/**
+ * _allocator_tlsf_links_t
+ *
+ * The free list links stored in the memory of a free block.
+ *
+ */
+typedef struct _allocator_tlsf_links_t
+{
+	_allocator_tlsf_block_t * next;
+	_allocator_tlsf_block_t * prev;
+
+} _allocator_tlsf_links_t;
+
+
+/**
+ * _allocator_tlsf_fls
+ *
+ * Returns the index of the most significant set bit of the given non-zero value.
+ *
+ */
+static int _allocator_tlsf_fls( size_t value )
+{
+	if ( sizeof( size_t ) > sizeof( unsigned long ) )
+	{
+		return ( int )( sizeof( size_t ) * 8 ) - 1 - __builtin_clzll( value );
+	}
+	return ( int )( sizeof( unsigned long ) * 8 ) - 1 - __builtin_clzl( ( unsigned long ) value );
+}
+
+
+/**
+ * _allocator_tlsf_size
+ *
+ * Returns the size of the given block's memory.
+ *
+ */
+static size_t _allocator_tlsf_size( _allocator_tlsf_block_t * block )
+{
+	return block->size & ~( size_t ) _ALLOCATOR_TLSF_FLAGS;
+}
+
+
+/**
+ * _allocator_tlsf_memory / _allocator_tlsf_links
+ *
+ * Returns the memory of the given block, or the free list links stored in it.
+ *
+ */
+static void * _allocator_tlsf_memory( _allocator_tlsf_block_t * block )
+{
+	return block + 1;
+}
+
+static _allocator_tlsf_links_t * _allocator_tlsf_links( _allocator_tlsf_block_t * block )
+{
+	return ( _allocator_tlsf_links_t * ) _allocator_tlsf_memory( block );
+}
+
+
+/**
+ * _allocator_tlsf_next
+ *
+ * Returns the block physically following the given block.
+ *
+ */
+static _allocator_tlsf_block_t * _allocator_tlsf_next( _allocator_tlsf_block_t * block )
+{
+	return ( _allocator_tlsf_block_t * )( ( int8_t * ) _allocator_tlsf_memory( block ) + _allocator_tlsf_size( block ) );
+}
+
+
+/**
+ * _allocator_tlsf_mark_free / _allocator_tlsf_mark_used
+ *
+ * Flags the given block as free or used, updating the following block's record of
+ * its predecessor.
+ *
+ */
+static void _allocator_tlsf_mark_free( _allocator_tlsf_block_t * block )
+{
+	_allocator_tlsf_block_t * next = _allocator_tlsf_next( block );
+	block->size |= _ALLOCATOR_TLSF_FREE;
+	next->size |= _ALLOCATOR_TLSF_PREV_FREE;
+	next->prev_phys = block;
+}
+
+static void _allocator_tlsf_mark_used( _allocator_tlsf_block_t * block )
+{
+	block->size &= ~( size_t ) _ALLOCATOR_TLSF_FREE;
+	_allocator_tlsf_next( block )->size &= ~( size_t ) _ALLOCATOR_TLSF_PREV_FREE;
+}
+
+
+/**
+ * _allocator_tlsf_mapping
+ *
+ * Computes the size class (first and second level indices) containing blocks of
+ * the given size.
+ *
+ */
+static void _allocator_tlsf_mapping( size_t size, size_t * fl, size_t * sl )
+{
+	if ( size < _ALLOCATOR_TLSF_SMALL )
+	{
+		*fl = 0;
+		*sl = size / ALLOCATOR_TLSF_ALIGNMENT;
+	}
+	else
+	{
+		int bit = _allocator_tlsf_fls( size );
+		*sl = ( size >> ( bit - _ALLOCATOR_TLSF_SL_LOG2 ) ) ^ ALLOCATOR_TLSF_SL_COUNT;
+		*fl = ( size_t ) bit - ( size_t ) _allocator_tlsf_fls( _ALLOCATOR_TLSF_SMALL ) + 1;
+	}
+}
+
+
+/**
+ * _allocator_tlsf_insert
+ *
+ * Adds the given free block to the list of its size class.
+ *
+ */
+static void _allocator_tlsf_insert( allocator_tlsf_t * tlsf, _allocator_tlsf_block_t * block )
+{
+	_allocator_tlsf_block_t * head;
+	size_t fl, sl;
+
+	_allocator_tlsf_mapping( _allocator_tlsf_size( block ), &fl, &sl );
+	head = ( _allocator_tlsf_block_t * ) tlsf->blocks[ fl ][ sl ];
+
+	_allocator_tlsf_links( block )->next = head;
+	_allocator_tlsf_links( block )->prev = 0;
+	if ( head )
+	{
+		_allocator_tlsf_links( head )->prev = block;
+	}
+
+	tlsf->blocks[ fl ][ sl ] = block;
+	tlsf->fl_bitmap |= ( uint32_t ) 1 << fl;
+	tlsf->sl_bitmaps[ fl ] |= ( uint32_t ) 1 << sl;
+}
+
+
+/**
+ * _allocator_tlsf_remove
+ *
+ * Removes the given free block from the list of its size class.
+ *
+ */
+static void _allocator_tlsf_remove( allocator_tlsf_t * tlsf, _allocator_tlsf_block_t * block )
+{
+	_allocator_tlsf_links_t * links = _allocator_tlsf_links( block );
+	size_t fl, sl;
+
+	_allocator_tlsf_mapping( _allocator_tlsf_size( block ), &fl, &sl );
+
+	if ( links->next )
+	{
+		_allocator_tlsf_links( links->next )->prev = links->prev;
+	}
+	if ( links->prev )
+	{
+		_allocator_tlsf_links( links->prev )->next = links->next;
+	}
+	else
+	{
+		tlsf->blocks[ fl ][ sl ] = links->next;
+		if ( !links->next )
+		{
+			tlsf->sl_bitmaps[ fl ] &= ~( ( uint32_t ) 1 << sl );
+			if ( !tlsf->sl_bitmaps[ fl ] )
+			{
+				tlsf->fl_bitmap &= ~( ( uint32_t ) 1 << fl );
+			}
+		}
+	}
+}
+
+
+/**
+ * _allocator_tlsf_find
+ *
+ * Returns a free block of at least the given size, or null if there is none. The
+ * size is rounded up to the next size class boundary, such that any block in the
+ * resulting class is large enough.
+ *
+ */
+static _allocator_tlsf_block_t * _allocator_tlsf_find( allocator_tlsf_t * tlsf, size_t size )
+{
+	uint32_t map;
+	size_t fl, sl;
+
+	if ( size >= _ALLOCATOR_TLSF_SMALL )
+	{
+		size_t round = ( ( size_t ) 1 << ( _allocator_tlsf_fls( size ) - _ALLOCATOR_TLSF_SL_LOG2 ) ) - 1;
+		if ( size > ( size_t ) -1 - round )
+		{
+			return 0;
+		}
+		size += round;
+	}
+
+	_allocator_tlsf_mapping( size, &fl, &sl );
+	if ( fl >= ALLOCATOR_TLSF_FL_COUNT )
+	{
+		return 0;
+	}
+
+	map = tlsf->sl_bitmaps[ fl ] & ( ~( uint32_t ) 0 << sl );
+	if ( !map )
+	{
+		map = fl + 1 < ALLOCATOR_TLSF_FL_COUNT ? tlsf->fl_bitmap & ( ~( uint32_t ) 0 << ( fl + 1 ) ) : 0;
+		if ( !map )
+		{
+			return 0;
+		}
+
+		fl = ( size_t ) __builtin_ctz( map );
+		map = tlsf->sl_bitmaps[ fl ];
+	}
+
+	sl = ( size_t ) __builtin_ctz( map );
+	return ( _allocator_tlsf_block_t * ) tlsf->blocks[ fl ][ sl ];
+}
+
+
+/**
+ * _allocator_tlsf_alloc
+ *
+ * Allocates a block from the smallest suitable size class, splitting off and
+ * freeing any remainder large enough to form a block of its own.
+ *
+ */
+static void * _allocator_tlsf_alloc( size_t length, allocator_t * allocator )
+{
+	allocator_tlsf_t * tlsf = ( allocator_tlsf_t * ) allocator;
+	_allocator_tlsf_block_t * block;
+	size_t size;
+
+	if ( !length || length > tlsf->capacity )
+	{
+		return 0;
+	}
+
+	size = ( length + ALLOCATOR_TLSF_ALIGNMENT - 1 ) & ~( ALLOCATOR_TLSF_ALIGNMENT - 1 );
+	block = _allocator_tlsf_find( tlsf, size );
+	if ( !block )
+	{
+		return 0;
+	}
+
+	_allocator_tlsf_remove( tlsf, block );
+
+	if ( _allocator_tlsf_size( block ) >= size + sizeof( _allocator_tlsf_block_t ) + ALLOCATOR_TLSF_ALIGNMENT )
+	{
+		_allocator_tlsf_block_t * rest = ( _allocator_tlsf_block_t * )( ( int8_t * ) _allocator_tlsf_memory( block ) + size );
+		rest->size = _allocator_tlsf_size( block ) - size - sizeof( _allocator_tlsf_block_t );
+		block->size = size | ( block->size & _ALLOCATOR_TLSF_FLAGS );
+		_allocator_tlsf_mark_free( rest );
+		_allocator_tlsf_insert( tlsf, rest );
+	}
+
+	_allocator_tlsf_mark_used( block );
+	tlsf->used += _allocator_tlsf_size( block );
+	return _allocator_tlsf_memory( block );
+}
+
+
+/**
+ * _allocator_tlsf_free
+ *
+ * Releases the given block, merging it with its physical neighbours if they are
+ * free.
+ *
+ */
+static void _allocator_tlsf_free( void * address, allocator_t * allocator )
+{
+	allocator_tlsf_t * tlsf = ( allocator_tlsf_t * ) allocator;
+	_allocator_tlsf_block_t * block, * next;
+
+	if ( !address )
+	{
+		return;
+	}
+
+	block = ( ( _allocator_tlsf_block_t * ) address ) - 1;
+	tlsf->used -= _allocator_tlsf_size( block );
+
+	if ( block->size & _ALLOCATOR_TLSF_PREV_FREE )
+	{
+		_allocator_tlsf_block_t * prev = block->prev_phys;
+		_allocator_tlsf_remove( tlsf, prev );
+		prev->size += sizeof( _allocator_tlsf_block_t ) + _allocator_tlsf_size( block );
+		block = prev;
+	}
+
+	next = _allocator_tlsf_next( block );
+	if ( next->size & _ALLOCATOR_TLSF_FREE )
+	{
+		_allocator_tlsf_remove( tlsf, next );
+		block->size += sizeof( _allocator_tlsf_block_t ) + _allocator_tlsf_size( next );
+	}
+
+	_allocator_tlsf_mark_free( block );
+	_allocator_tlsf_insert( tlsf, block );
+}
+
+
+/**
+ * _allocator_tlsf_setup
+ *
+ * Initialises the given TLSF allocator to manage the given region as a single free
+ * block, followed by a permanently used, empty sentinel block.
+ *
+ */
+static void _allocator_tlsf_setup( allocator_tlsf_t * tlsf, void * region, size_t length )
+{
+	size_t fl, sl, offset;
+
+	tlsf->alloc.alloc_fn = &_allocator_tlsf_alloc;
+	tlsf->alloc.free_fn = &_allocator_tlsf_free;
+	tlsf->region = region;
+	tlsf->fl_bitmap = 0;
+	tlsf->capacity = 0;
+	tlsf->used = 0;
+
+	for ( fl = 0; fl < ALLOCATOR_TLSF_FL_COUNT; ++fl )
+	{
+		tlsf->sl_bitmaps[ fl ] = 0;
+		for ( sl = 0; sl < ALLOCATOR_TLSF_SL_COUNT; ++sl )
+		{
+			tlsf->blocks[ fl ][ sl ] = 0;
+		}
+	}
+
+	offset = ( ALLOCATOR_TLSF_ALIGNMENT - ( ( size_t ) region ) % ALLOCATOR_TLSF_ALIGNMENT ) % ALLOCATOR_TLSF_ALIGNMENT;
+	if ( !region || length < offset + 3 * ALLOCATOR_TLSF_ALIGNMENT )
+	{
+		return;
+	}
+
+	length = ( length - offset ) & ~( ALLOCATOR_TLSF_ALIGNMENT - 1 );
+
+	/* The largest block must be representable by the size classes */
+	if ( ( length >> _allocator_tlsf_fls( _ALLOCATOR_TLSF_SMALL ) ) >> ( ALLOCATOR_TLSF_FL_COUNT - 1 ) )
+	{
+		length = ( ( size_t ) _ALLOCATOR_TLSF_SMALL << ( ALLOCATOR_TLSF_FL_COUNT - 1 ) ) - ALLOCATOR_TLSF_ALIGNMENT;
+	}
+
+	{
+		_allocator_tlsf_block_t * block = ( _allocator_tlsf_block_t * )( ( int8_t * ) region + offset );
+		_allocator_tlsf_block_t * sentinel;
+
+		block->prev_phys = 0;
+		block->size = length - 2 * sizeof( _allocator_tlsf_block_t );
+		sentinel = _allocator_tlsf_next( block );
+		sentinel->size = 0;
+
+		_allocator_tlsf_mark_free( block );
+		_allocator_tlsf_insert( tlsf, block );
+		/* The largest request that rounds up to the block's size class */
+		tlsf->capacity = _allocator_tlsf_size( block );
+		if ( tlsf->capacity >= _ALLOCATOR_TLSF_SMALL )
+		{
+			tlsf->capacity &= ~( ( ( size_t ) 1 << ( _allocator_tlsf_fls( tlsf->capacity ) - _ALLOCATOR_TLSF_SL_LOG2 ) ) - 1 );
+		}
+	}
+}
+
+
+/**
+ * allocator_tlsf_init
+ *
+ * Initialises the given TLSF allocator with a region able to hold a single block
+ * of at least the given number of bytes, allocated from the given parent allocator.
+ *
+ */
+void allocator_tlsf_init(
+	allocator_tlsf_t * allocator,
+	size_t capacity,
+	allocator_t * parent
+)
+{
+	size_t length = 0;
+	void * region = 0;
+
+	if ( !allocator )
+	{
+		return;
+	}
+
+	/* Round the capacity up to a size class boundary, such that a request for the
+	 * whole capacity finds the block */
+	if ( capacity >= _ALLOCATOR_TLSF_SMALL )
+	{
+		size_t round = ( ( size_t ) 1 << ( _allocator_tlsf_fls( capacity ) - _ALLOCATOR_TLSF_SL_LOG2 ) ) - 1;
+		capacity = capacity <= ( size_t ) -1 - round ? ( capacity + round ) & ~round : ( size_t ) -1;
+	}
+
+	/* Allow for the block header, the sentinel and aligning the region */
+	if ( capacity <= ( size_t ) -1 - 4 * ALLOCATOR_TLSF_ALIGNMENT )
+	{
+		length = ( ( capacity + ALLOCATOR_TLSF_ALIGNMENT - 1 ) & ~( ALLOCATOR_TLSF_ALIGNMENT - 1 ) ) + 3 * ALLOCATOR_TLSF_ALIGNMENT;
+		region = allocator_alloc( length, parent );
+	}
+
+	_allocator_tlsf_setup( allocator, region, length );
+	allocator->parent = parent;
+}
+
+
+/**
+ * allocator_tlsf_init_default
+ *
+ * Initialises the given TLSF allocator, using the default allocator as its parent.
+ *
+ */
+void allocator_tlsf_init_default(
+	allocator_tlsf_t * allocator,
+	size_t capacity
+)
+{
+	allocator_tlsf_init( allocator, capacity, allocator_default( ) );
+}
+
+
+/**
+ * allocator_tlsf_init_storage
+ *
+ * Initialises the given TLSF allocator with a caller-provided region of the given
+ * number of bytes.
+ *
+ */
+void allocator_tlsf_init_storage(
+	allocator_tlsf_t * allocator,
+	void * storage,
+	size_t length
+)
+{
+	if ( allocator )
+	{
+		_allocator_tlsf_setup( allocator, storage, length );
+		allocator->parent = 0;
+	}
+}
+
+
+/**
+ * allocator_tlsf_cleanup
+ *
+ * Releases the region of the given TLSF allocator (unless caller-provided).
+ *
+ */
+void allocator_tlsf_cleanup(
+	allocator_tlsf_t * allocator
+)
+{
+	if ( allocator )
+	{
+		if ( allocator->parent && allocator->region )
+		{
+			allocator_free( allocator->region, allocator->parent );
+		}
+
+		_allocator_tlsf_setup( allocator, 0, 0 );
+
+		/* Note that the parent is deliberately retained */
+	}
+}
+
+
+/**
+ * allocator_tlsf_get
+ *
+ * Returns the given TLSF allocator as an allocator_t pointer.
+ *
+ */
+allocator_t * allocator_tlsf_get(
+	allocator_tlsf_t * allocator
+)
+{
+	return ( allocator_t * ) allocator;
+}
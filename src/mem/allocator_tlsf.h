@@ -0,0 +1,158 @@
+#ifndef __MEM_ALLOCATOR_TLSF_H
+#define __MEM_ALLOCATOR_TLSF_H
+
+#include "allocator.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * ALLOCATOR_TLSF_ALIGNMENT
+ *
+ * The alignment of every block returned by a TLSF allocator, which is also the size
+ * of each block's header.
+ *
+ */
+#define ALLOCATOR_TLSF_ALIGNMENT ( 2 * sizeof( void * ) )
+
+
+/**
+ * ALLOCATOR_TLSF_FL_COUNT
+ *
+ * The number of first level (power of two) size classes of a TLSF allocator, which
+ * bounds the largest block at just under 2^( ALLOCATOR_TLSF_FL_COUNT - 1 ) times
+ * ALLOCATOR_TLSF_SL_COUNT * ALLOCATOR_TLSF_ALIGNMENT bytes - 2^39 bytes on 64-bit
+ * platforms. Larger regions are truncated to this size.
+ *
+ */
+#define ALLOCATOR_TLSF_FL_COUNT 32
+
+
+/**
+ * ALLOCATOR_TLSF_SL_COUNT
+ *
+ * The number of second level (linear) subdivisions of each first level size class.
+ *
+ */
+#define ALLOCATOR_TLSF_SL_COUNT 16
+
+
+/**
+ * allocator_tlsf_t
+ *
+ * A Two-Level Segregated Fit allocator over a fixed region. Free blocks are kept in
+ * lists segregated by size class, with a bitmap of non-empty lists at each level,
+ * so a suitable block is found with two find-first-set operations. Blocks are
+ * split on allocation and immediately coalesced with free neighbours on release.
+ *
+ * Worst case bound: allocator_alloc and allocator_free perform a fixed number of
+ * bitmap and list operations, independent of the number or layout of blocks in
+ * the region - there are no loops over blocks or size classes. The cost of a
+ * request is one class lookup, at most one split and at most two merges. Rounding
+ * each request up to its size class wastes at most 1/ALLOCATOR_TLSF_SL_COUNT of the
+ * block, plus the header.
+ *
+ * Note that the TLSF allocator is not thread-safe (see allocator_concurrent_t).
+ *
+ */
+typedef struct allocator_tlsf_t
+{
+	/* The allocation functions for this allocator */
+	allocator_t alloc;
+
+	/* The parent allocator the region was allocated from (null if caller-provided) */
+	allocator_t * parent;
+
+	/* The region, as allocated or provided */
+	void * region;
+
+	/* One bit per first level class, set if any of its lists are non-empty */
+	uint32_t fl_bitmap;
+
+	/* One bit per second level class of each first level class, set if its list is
+	 * non-empty */
+	uint32_t sl_bitmaps[ ALLOCATOR_TLSF_FL_COUNT ];
+
+	/* The first free block of each size class */
+	void * blocks[ ALLOCATOR_TLSF_FL_COUNT ][ ALLOCATOR_TLSF_SL_COUNT ];
+
+	/* The largest block that can be allocated from the region while it is empty */
+	size_t capacity;
+
+	/* The number of bytes in allocated blocks (excluding headers) */
+	size_t used;
+
+} allocator_tlsf_t;
+
+
+/**
+ * allocator_tlsf_init
+ *
+ * Initialises the given TLSF allocator with a region able to hold a single block
+ * of at least the given number of bytes, allocated from the given parent allocator.
+ * Should call allocator_tlsf_cleanup to release the region. If the region cannot be
+ * allocated, the allocator has zero capacity.
+ *
+ */
+void allocator_tlsf_init(
+	allocator_tlsf_t * allocator,
+	size_t capacity,
+	allocator_t * parent
+);
+
+
+/**
+ * allocator_tlsf_init_default
+ *
+ * Initialises the given TLSF allocator, using the default allocator as its parent.
+ *
+ */
+void allocator_tlsf_init_default(
+	allocator_tlsf_t * allocator,
+	size_t capacity
+);
+
+
+/**
+ * allocator_tlsf_init_storage
+ *
+ * Initialises the given TLSF allocator with a caller-provided region of the given
+ * number of bytes, which must outlive the allocator.
+ *
+ */
+void allocator_tlsf_init_storage(
+	allocator_tlsf_t * allocator,
+	void * storage,
+	size_t length
+);
+
+
+/**
+ * allocator_tlsf_cleanup
+ *
+ * Releases the region of the given TLSF allocator (unless caller-provided). All
+ * blocks allocated from it are invalidated.
+ *
+ */
+void allocator_tlsf_cleanup(
+	allocator_tlsf_t * allocator
+);
+
+
+/**
+ * allocator_tlsf_get
+ *
+ * Returns the given TLSF allocator as an allocator_t pointer.
+ *
+ */
+allocator_t * allocator_tlsf_get(
+	allocator_tlsf_t * allocator
+);
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+#endif /* __MEM_ALLOCATOR_TLSF_H */
@@ -1,7 +1,24 @@
+#define LIBMEM_INLINE
 #include "buffer.h"
+#include "internal/buffer_file.h"
+#include "internal/simd.h"
 
 #include <string.h>
 
+
+/**
+ * _buffer_can_grow
+ *
+ * Returns non-zero if the given buffer has storage it can grow - either an
+ * allocator, or a backing file.
+ *
+ */
+static int _buffer_can_grow( buffer_t * buffer )
+{
+	return buffer->allocator || ( buffer->flags & BUFFER_FILE );
+}
+
+
 /**
  * buffer_new
  *
@@ -53,6 +70,31 @@ void buffer_init( buffer_t * buffer, allocator_t * allocator )
 		buffer->allocator = allocator;
 		buffer->begin = buffer->pos = 0;
 		buffer->capacity = 0;
+		buffer->flags = 0;
+		buffer->fd = -1;
+		buffer->stream_threshold = 0;
+	}
+}
+
+
+/**
+ * buffer_init_storage
+ *
+ * Initialises the given buffer_t object as an empty buffer whose initial storage
+ * is the given block of memory, holding the given number of bytes. The buffer uses
+ * this storage until it must grow beyond it, at which point the data is copied into
+ * memory from the given allocator. The storage is never released by the buffer.
+ *
+ */
+void buffer_init_storage( buffer_t * buffer, void * storage, size_t capacity, allocator_t * allocator )
+{
+	buffer_init( buffer, allocator );
+
+	if ( buffer && storage && capacity )
+	{
+		buffer->begin = buffer->pos = ( int8_t * ) storage;
+		buffer->capacity = capacity;
+		buffer->flags = BUFFER_BORROWED;
 	}
 }
 
@@ -69,7 +111,11 @@ void buffer_cleanup( buffer_t * buffer )
 {
 	if ( buffer )
 	{
-		if ( buffer->begin && buffer->allocator )
+		if ( buffer->flags & BUFFER_FILE )
+		{
+			buffer_file_cleanup( buffer );
+		}
+		else if ( buffer->begin && buffer->allocator && !( buffer->flags & BUFFER_BORROWED ) )
 		{
 			allocator_free( buffer->begin, buffer->allocator );
 		}
@@ -77,6 +123,7 @@ void buffer_cleanup( buffer_t * buffer )
 		buffer->begin = 0;
 		buffer->pos = 0;
 		buffer->capacity = 0;
+		buffer->flags = 0;
 
 		/* Note that we deliberately do not reset the allocator pointer here,
 		 * such that it is retained for buffer_delete, should buffer_cleanup
@@ -115,6 +162,11 @@ size_t buffer_capacity( buffer_t * buffer )
  */
 size_t buffer_grow( buffer_t * buffer, size_t amount_in_bytes )
 {
+	if ( buffer && ( buffer->flags & BUFFER_FILE ) )
+	{
+		return buffer_file_grow( buffer, amount_in_bytes );
+	}
+
 	if ( buffer && buffer->allocator )
 	{
 		if ( amount_in_bytes == 0 )
@@ -140,12 +192,27 @@ size_t buffer_grow( buffer_t * buffer, size_t amount_in_bytes )
 				return 0;
 			}
 
-			/* Copy original data into new buffer. */
+			/* Copy original data into new buffer, bypassing the cache if there
+			 * is too much of it to be worth caching */
 			data_length = buffer_data_length( buffer );
-			memcpy( new_buffer, buffer->begin, data_length );
+			if ( data_length >= buffer_stream_threshold( buffer ) )
+			{
+				simd_copy_streaming( new_buffer, buffer->begin, data_length );
+			}
+			else
+			{
+				memcpy( new_buffer, buffer->begin, data_length );
+			}
 
-			/* Release the old buffer */
-			allocator_free( buffer->begin, buffer->allocator );
+			/* Release the old buffer, unless it belongs to the caller */
+			if ( buffer->flags & BUFFER_BORROWED )
+			{
+				buffer->flags &= ~BUFFER_BORROWED;
+			}
+			else
+			{
+				allocator_free( buffer->begin, buffer->allocator );
+			}
 
 			/* Update the buffer structure */
 			buffer->capacity = new_capacity;
@@ -169,6 +236,43 @@ size_t buffer_grow( buffer_t * buffer, size_t amount_in_bytes )
 }
 
 
+/**
+ * buffer_set_stream_threshold
+ *
+ * Sets the amount of data above which growing the buffer copies the data with
+ * non-temporal stores, bypassing the cache (zero selects the default threshold).
+ *
+ */
+void buffer_set_stream_threshold( buffer_t * buffer, size_t threshold )
+{
+	if ( buffer )
+	{
+		buffer->stream_threshold = threshold;
+	}
+}
+
+
+/**
+ * buffer_stream_threshold
+ *
+ * Returns the amount of data above which growing the buffer bypasses the cache,
+ * resolving the default threshold if none has been set.
+ *
+ */
+size_t buffer_stream_threshold( buffer_t * buffer )
+{
+	size_t cache_size;
+
+	if ( buffer && buffer->stream_threshold )
+	{
+		return buffer->stream_threshold;
+	}
+
+	cache_size = simd_cache_size( );
+	return cache_size ? cache_size / 2 : BUFFER_STREAM_THRESHOLD;
+}
+
+
 /**
  * buffer_data_length
  *
@@ -218,6 +322,72 @@ void buffer_rewind( buffer_t * buffer )
 }
 
 
+/**
+ * buffer_trim
+ *
+ * Reduces the buffer's capacity to the given maximum, or to its data length if that
+ * is greater, releasing the memory beyond it. Returns the new capacity of the buffer.
+ *
+ */
+size_t buffer_trim( buffer_t * buffer, size_t max_capacity )
+{
+	size_t data_length, new_capacity;
+	void * new_buffer = 0;
+
+	if ( !buffer || !buffer->begin )
+	{
+		return 0;
+	}
+
+	data_length = buffer_data_length( buffer );
+	new_capacity = data_length > max_capacity ? data_length : max_capacity;
+	if ( new_capacity >= buffer->capacity || ( buffer->flags & BUFFER_BORROWED ) )
+	{
+		return buffer->capacity;
+	}
+
+	if ( buffer->flags & BUFFER_FILE )
+	{
+		return buffer_file_shrink( buffer, new_capacity );
+	}
+
+	if ( !buffer->allocator )
+	{
+		return buffer->capacity;
+	}
+
+	/* Move the data into a smaller block (or none at all) */
+	if ( new_capacity )
+	{
+		new_buffer = allocator_alloc( new_capacity, buffer->allocator );
+		if ( !new_buffer )
+		{
+			return buffer->capacity;
+		}
+		memcpy( new_buffer, buffer->begin, data_length );
+	}
+
+	allocator_free( buffer->begin, buffer->allocator );
+
+	buffer->capacity = new_capacity;
+	buffer->begin = ( int8_t * ) new_buffer;
+	buffer->pos = buffer->begin + data_length;
+	return new_capacity;
+}
+
+
+/**
+ * buffer_shrink_to_fit
+ *
+ * Reduces the buffer's capacity to its data length. Returns the new capacity.
+ *
+ */
+size_t buffer_shrink_to_fit( buffer_t * buffer )
+{
+	return buffer_trim( buffer, 0 );
+}
+
+
 /**
  * buffer_append
  *
@@ -253,6 +423,64 @@ size_t buffer_append( buffer_t * buffer, size_t length, void * data )
 }
 
 
+/**
+ * buffer_fill
+ *
+ * Appends the given number of bytes with the given value to the end of the given
+ * buffer_t object, growing the buffer if necessary. Returns the number of bytes
+ * appended (either 0 or the given length).
+ *
+ */
+size_t buffer_fill( buffer_t * buffer, size_t length, int value )
+{
+	void * pos = buffer_reserve( buffer, length );
+	if ( !pos )
+	{
+		return 0;
+	}
+
+	simd_fill( pos, value, length );
+	return length;
+}
+
+
+/**
+ * buffer_find
+ *
+ * Returns a pointer to the first byte with the given value in the buffer's data,
+ * starting at the given offset, or null if there is none.
+ *
+ */
+void * buffer_find( buffer_t * buffer, size_t offset, int value )
+{
+	size_t data_length = buffer_data_length( buffer );
+	if ( offset >= data_length )
+	{
+		return 0;
+	}
+
+	return simd_find( buffer->begin + offset, value, data_length - offset );
+}
+
+
+/**
+ * buffer_equal
+ *
+ * Returns 1 if the buffer's data is identical to the given block of memory (of the
+ * given length), or 0 otherwise.
+ *
+ */
+int buffer_equal( buffer_t * buffer, size_t length, const void * data )
+{
+	if ( !buffer || buffer_data_length( buffer ) != length )
+	{
+		return 0;
+	}
+
+	return !length || ( data && simd_equal( buffer->begin, data, length ) );
+}
+
+
 /**
  * buffer_reserve
  *
@@ -270,14 +498,17 @@ size_t buffer_append( buffer_t * buffer, size_t length, void * data )
  * effect of reinitialising the buffer, and must therefore be cleaned
  * up again with buffer_cleanup once the buffer is no longer required.
  *
+ * The name is parenthesised such that it is not replaced by the LIBMEM_INLINE
+ * macro of the same name.
+ *
  */
-void * buffer_reserve( buffer_t * buffer, size_t length )
+void * ( buffer_reserve )( buffer_t * buffer, size_t length )
 {
 	size_t current_size, new_size;
 	void * result;
 
 	/* Validate arguments */
-	if ( !buffer || !length || !buffer->allocator )
+	if ( !buffer || !length || !_buffer_can_grow( buffer ) )
 	{
 		return 0;
 	}
@@ -305,3 +536,55 @@ void * buffer_reserve( buffer_t * buffer, size_t length )
 	buffer->pos += length;
 	return result;
 }
+
+
+/**
+ * buffer_prepare
+ *
+ * Ensures that at least the given number of bytes are available beyond the current
+ * write position in the buffer (growing the buffer if necessary), and returns a
+ * pointer to them, without moving the write position. Once some or all of these
+ * bytes have been initialised (e.g. by a call to read), they can be appended to the
+ * data in the buffer with buffer_commit. Returns null on failure.
+ *
+ * Note that the returned block of memory will be invalidated if the buffer
+ * is deleted, cleaned up, or grown.
+ *
+ */
+void * buffer_prepare( buffer_t * buffer, size_t length )
+{
+	void * result = buffer_reserve( buffer, length );
+	if ( result )
+	{
+		buffer->pos -= length;
+	}
+	return result;
+}
+
+
+/**
+ * buffer_commit
+ *
+ * Moves the current write position forward by the given number of bytes, such that
+ * bytes initialised after a call to buffer_prepare become part of the buffer's data.
+ * Returns the number of bytes committed, which is limited to the buffer's capacity.
+ *
+ */
+size_t buffer_commit( buffer_t * buffer, size_t length )
+{
+	size_t available;
+
+	if ( !buffer || !buffer->begin )
+	{
+		return 0;
+	}
+
+	available = buffer->capacity - buffer_data_length( buffer );
+	if ( length > available )
+	{
+		length = available;
+	}
+
+	buffer->pos += length;
+	return length;
+}
@@ -7,6 +7,40 @@
 extern "C" {
 #endif
 
+/**
+ * BUFFER_FILE
+ *
+ * Buffer flag - the buffer's storage is a memory mapped file rather than memory
+ * from its allocator (see buffer_init_file).
+ *
+ */
+#define BUFFER_FILE 0x1
+
+
+/**
+ * BUFFER_BORROWED
+ *
+ * Buffer flag - the buffer's storage was provided by the caller (see
+ * buffer_init_storage), so is never released by the buffer.
+ *
+ */
+#define BUFFER_BORROWED 0x2
+
+
+/**
+ * BUFFER_STREAM_THRESHOLD
+ *
+ * The amount of data (in bytes) above which growing a buffer copies its data with
+ * non-temporal stores, such that copying a large buffer does not evict everything
+ * else from the cache - used only when the default threshold (half the size of the
+ * last level cache) cannot be detected. See buffer_set_stream_threshold.
+ *
+ */
+#ifndef BUFFER_STREAM_THRESHOLD
+#define BUFFER_STREAM_THRESHOLD ( 4 * 1024 * 1024 )
+#endif
+
+
 /**
  * buffer_t
  *
@@ -27,6 +61,16 @@ typedef struct buffer_t
 	/* The allocator to use when growing the buffer */
 	allocator_t * allocator;
 
+	/* The BUFFER_* flags describing the buffer's storage */
+	int flags;
+
+	/* The file backing the buffer when BUFFER_FILE is set (-1 otherwise) */
+	int fd;
+
+	/* The data length above which growing the buffer bypasses the cache (0 to
+	 * use the default threshold) */
+	size_t stream_threshold;
+
 } buffer_t;
 
 
@@ -61,6 +105,39 @@ void buffer_delete( buffer_t * buffer );
 void buffer_init( buffer_t * buffer, allocator_t * allocator );
 
 
+/**
+ * buffer_init_storage
+ *
+ * Initialises the given buffer_t object as an empty buffer whose initial storage
+ * is the given block of memory (e.g. an array on the stack, or embedded in another
+ * object), holding the given number of bytes. The buffer uses this storage until it
+ * must grow beyond it, at which point the data is copied into memory from the given
+ * allocator - so buffers that stay small never call the allocator. The storage is
+ * never released by the buffer, and must outlive it (or at least its use of the
+ * storage). Should call buffer_cleanup to release any memory later allocated.
+ *
+ */
+void buffer_init_storage( buffer_t * buffer, void * storage, size_t capacity, allocator_t * allocator );
+
+
+/**
+ * buffer_init_file
+ *
+ * Initialises the given buffer_t object with storage memory mapped from the file at
+ * the given path, which is created if it does not exist. Any existing contents of
+ * the file become the buffer's data, so further appends extend the file. Growing
+ * the buffer extends and remaps the file rather than copying its data, and at least
+ * doubles the capacity (rounded up to a whole number of pages) to keep the number
+ * of remaps low. Should call buffer_cleanup, which truncates the file to the data
+ * length of the buffer, unmaps it and closes it. Returns 1 on success, 0 otherwise
+ * (in which case the buffer is left empty, and cannot grow).
+ *
+ * Note that such a buffer has no allocator, so cannot be used with buffer_delete.
+ *
+ */
+int buffer_init_file( buffer_t * buffer, const char * path );
+
+
 /**
  * buffer_cleanup
  *
@@ -95,6 +172,28 @@ size_t buffer_capacity( buffer_t * buffer );
 size_t buffer_grow( buffer_t * buffer, size_t amount_in_bytes );
 
 
+/**
+ * buffer_set_stream_threshold
+ *
+ * Sets the amount of data above which growing the buffer copies the data with
+ * non-temporal stores, bypassing the cache. Zero selects the default threshold -
+ * half the size of the last level cache, or BUFFER_STREAM_THRESHOLD if that cannot
+ * be detected - and ( size_t ) -1 effectively disables streaming copies.
+ *
+ */
+void buffer_set_stream_threshold( buffer_t * buffer, size_t threshold );
+
+
+/**
+ * buffer_stream_threshold
+ *
+ * Returns the amount of data above which growing the buffer bypasses the cache,
+ * resolving the default threshold if none has been set.
+ *
+ */
+size_t buffer_stream_threshold( buffer_t * buffer );
+
+
 /**
  * buffer_data_length
  *
@@ -124,6 +223,32 @@ void * buffer_data_pointer( buffer_t * buffer );
 void buffer_rewind( buffer_t * buffer );
 
 
+/**
+ * buffer_trim
+ *
+ * Reduces the buffer's capacity to the given maximum, or to its data length if that
+ * is greater, releasing the memory beyond it (a capacity of zero releases the
+ * buffer's storage entirely). Returns the new capacity of the buffer, which is left
+ * unchanged if the memory could not be reallocated, or if the buffer's storage was
+ * provided by the caller. File-backed buffers are rounded up to a whole number of
+ * pages.
+ *
+ * Note that pointers into the buffer will be invalidated if its capacity changes.
+ *
+ */
+size_t buffer_trim( buffer_t * buffer, size_t max_capacity );
+
+
+/**
+ * buffer_shrink_to_fit
+ *
+ * Reduces the buffer's capacity to its data length - equivalent to calling
+ * buffer_trim with a maximum capacity of zero. Returns the new capacity.
+ *
+ */
+size_t buffer_shrink_to_fit( buffer_t * buffer );
+
+
 /**
  * buffer_append
  *
@@ -139,6 +264,37 @@ void buffer_rewind( buffer_t * buffer );
 size_t buffer_append( buffer_t * buffer, size_t length, void * data );
 
 
+/**
+ * buffer_fill
+ *
+ * Appends the given number of bytes with the given value to the end of the given
+ * buffer_t object, growing the buffer if necessary. Returns the number of bytes
+ * appended (either 0 or the given length).
+ *
+ */
+size_t buffer_fill( buffer_t * buffer, size_t length, int value );
+
+
+/**
+ * buffer_find
+ *
+ * Returns a pointer to the first byte with the given value in the buffer's data,
+ * starting at the given offset, or null if there is none.
+ *
+ */
+void * buffer_find( buffer_t * buffer, size_t offset, int value );
+
+
+/**
+ * buffer_equal
+ *
+ * Returns 1 if the buffer's data is identical to the given block of memory (of the
+ * given length), or 0 otherwise.
+ *
+ */
+int buffer_equal( buffer_t * buffer, size_t length, const void * data );
+
+
 /**
  * buffer_reserve
  *
@@ -160,6 +316,73 @@ size_t buffer_append( buffer_t * buffer, size_t length, void * data );
 void * buffer_reserve( buffer_t * buffer, size_t length );
 
 
+/**
+ * buffer_prepare
+ *
+ * Ensures that at least the given number of bytes are available beyond the current
+ * write position in the buffer (growing the buffer if necessary), and returns a
+ * pointer to them, without moving the write position. Once some or all of these
+ * bytes have been initialised (e.g. by a call to read), they can be appended to the
+ * data in the buffer with buffer_commit. Returns null on failure.
+ *
+ * Note that the returned block of memory will be invalidated if the buffer
+ * is deleted, cleaned up, or grown.
+ *
+ */
+void * buffer_prepare( buffer_t * buffer, size_t length );
+
+
+/**
+ * buffer_commit
+ *
+ * Moves the current write position forward by the given number of bytes, such that
+ * bytes initialised after a call to buffer_prepare become part of the buffer's data.
+ * Returns the number of bytes committed, which is limited to the buffer's capacity.
+ *
+ */
+size_t buffer_commit( buffer_t * buffer, size_t length );
+
+
+/**
+ * buffer_sync
+ *
+ * Flushes the data of a file-backed buffer to its file, blocking until the write
+ * has completed. Until the buffer is cleaned up, the file may also hold zeroed
+ * bytes beyond the data, up to the buffer's capacity. Returns 1 on success, 0 on
+ * failure or if the buffer is not file-backed.
+ *
+ */
+int buffer_sync( buffer_t * buffer );
+
+
+#if defined(LIBMEM_INLINE)
+
+/**
+ * buffer_reserve_inline
+ *
+ * Header-inline equivalent of buffer_reserve (see LIBMEM_INLINE). Only the case
+ * where the buffer already has enough capacity is handled inline - growing the
+ * buffer is left to the out-of-line function.
+ *
+ */
+MEM_INLINE void * buffer_reserve_inline( buffer_t * buffer, size_t length )
+{
+	if ( buffer && length && buffer->begin &&
+		buffer->capacity - ( size_t )( buffer->pos - buffer->begin ) >= length )
+	{
+		void * result = buffer->pos;
+		buffer->pos += length;
+		return result;
+	}
+
+	return ( buffer_reserve )( buffer, length );
+}
+
+#define buffer_reserve( buffer, length ) buffer_reserve_inline( buffer, length )
+
+#endif /* LIBMEM_INLINE */
+
+
 /**
  * buffer_allocator_t
  *
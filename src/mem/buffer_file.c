@@ -0,0 +1,315 @@
+#define _GNU_SOURCE
+
+#include "buffer.h"
+#include "internal/buffer_file.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define BUFFER_FILE_SUPPORTED
+#endif
+
+
+#if defined(BUFFER_FILE_SUPPORTED)
+
+/**
+ * _buffer_file_capacity
+ *
+ * Returns the capacity a file-backed buffer should grow to in order to hold the
+ * given number of bytes - at least double its current capacity, rounded up to a
+ * whole number of pages - or 0 on overflow.
+ *
+ */
+static size_t _buffer_file_capacity( buffer_t * buffer, size_t required )
+{
+	size_t page_size = ( size_t ) sysconf( _SC_PAGESIZE );
+	size_t capacity = required;
+
+	if ( buffer->capacity <= ( ( size_t ) -1 ) / 2 && capacity < 2 * buffer->capacity )
+	{
+		capacity = 2 * buffer->capacity;
+	}
+
+	if ( capacity > ( size_t ) -1 - ( page_size - 1 ) )
+	{
+		return 0;
+	}
+
+	return ( capacity + page_size - 1 ) / page_size * page_size;
+}
+
+
+/**
+ * _buffer_file_remap
+ *
+ * Replaces the mapping of the given buffer with one of the given capacity, which
+ * the file has already been extended to. Returns the new mapping, or null on
+ * failure (in which case the existing mapping is untouched).
+ *
+ */
+static int8_t * _buffer_file_remap( buffer_t * buffer, size_t capacity )
+{
+	void * mapping;
+
+#if defined(MREMAP_MAYMOVE)
+	if ( buffer->begin )
+	{
+		mapping = mremap( buffer->begin, buffer->capacity, capacity, MREMAP_MAYMOVE );
+		return mapping == MAP_FAILED ? 0 : ( int8_t * ) mapping;
+	}
+#endif
+
+	/* Both mappings share the file's pages, so no data needs copying */
+	mapping = mmap( 0, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, buffer->fd, 0 );
+	if ( mapping == MAP_FAILED )
+	{
+		return 0;
+	}
+
+	if ( buffer->begin )
+	{
+		munmap( buffer->begin, buffer->capacity );
+	}
+
+	return ( int8_t * ) mapping;
+}
+
+#endif /* BUFFER_FILE_SUPPORTED */
+
+
+/**
+ * buffer_init_file
+ *
+ * Initialises the given buffer_t object with storage memory mapped from the file at
+ * the given path, which is created if it does not exist. Any existing contents of
+ * the file become the buffer's data. Returns 1 on success, 0 otherwise.
+ *
+ */
+int buffer_init_file( buffer_t * buffer, const char * path )
+{
+#if defined(BUFFER_FILE_SUPPORTED)
+	struct stat status;
+	size_t length;
+	int fd;
+
+	if ( !buffer )
+	{
+		return 0;
+	}
+
+	buffer_init( buffer, 0 );
+
+	if ( !path )
+	{
+		return 0;
+	}
+
+	fd = open( path, O_RDWR | O_CREAT | O_CLOEXEC, 0666 );
+	if ( fd < 0 )
+	{
+		return 0;
+	}
+
+	if ( fstat( fd, &status ) != 0 )
+	{
+		close( fd );
+		return 0;
+	}
+
+	/* Files too large to map in their entirety are refused */
+	length = ( size_t ) status.st_size;
+	if ( ( off_t ) length != status.st_size )
+	{
+		close( fd );
+		return 0;
+	}
+
+	if ( length )
+	{
+		void * mapping = mmap( 0, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+		if ( mapping == MAP_FAILED )
+		{
+			close( fd );
+			return 0;
+		}
+
+		buffer->begin = ( int8_t * ) mapping;
+		buffer->pos = buffer->begin + length;
+		buffer->capacity = length;
+	}
+
+	buffer->flags = BUFFER_FILE;
+	buffer->fd = fd;
+	return 1;
+#else
+	buffer_init( buffer, 0 );
+	( void ) path;
+	return 0;
+#endif
+}
+
+
+/**
+ * buffer_file_grow
+ *
+ * Grows a file-backed buffer (see buffer_grow), returning its new capacity, or 0
+ * if the file could not be extended or remapped.
+ *
+ */
+size_t buffer_file_grow( buffer_t * buffer, size_t amount_in_bytes )
+{
+#if defined(BUFFER_FILE_SUPPORTED)
+	size_t data_length, capacity;
+	int8_t * mapping;
+
+	if ( amount_in_bytes == 0 )
+	{
+		return buffer->capacity;
+	}
+
+	if ( buffer->capacity + amount_in_bytes < buffer->capacity )
+	{
+		return buffer->capacity;
+	}
+
+	capacity = _buffer_file_capacity( buffer, buffer->capacity + amount_in_bytes );
+	if ( !capacity || ( off_t ) capacity < 0 )
+	{
+		return 0;
+	}
+
+	if ( ftruncate( buffer->fd, ( off_t ) capacity ) != 0 )
+	{
+		return 0;
+	}
+
+	mapping = _buffer_file_remap( buffer, capacity );
+	if ( !mapping )
+	{
+		/* Restore the original file size */
+		if ( ftruncate( buffer->fd, ( off_t ) buffer->capacity ) != 0 )
+		{
+			/* Nothing more can be done - the extra bytes are zeroes */
+		}
+		return 0;
+	}
+
+	data_length = buffer_data_length( buffer );
+	buffer->begin = mapping;
+	buffer->pos = mapping + data_length;
+	buffer->capacity = capacity;
+	return capacity;
+#else
+	( void ) buffer;
+	( void ) amount_in_bytes;
+	return 0;
+#endif
+}
+
+
+/**
+ * buffer_file_shrink
+ *
+ * Shrinks a file-backed buffer to the given capacity, rounded up to a whole number
+ * of pages (see buffer_trim), returning its new capacity.
+ *
+ */
+size_t buffer_file_shrink( buffer_t * buffer, size_t capacity )
+{
+#if defined(BUFFER_FILE_SUPPORTED)
+	size_t page_size = ( size_t ) sysconf( _SC_PAGESIZE );
+	size_t data_length = buffer_data_length( buffer );
+
+	capacity = ( capacity + page_size - 1 ) / page_size * page_size;
+	if ( !buffer->begin || capacity >= buffer->capacity )
+	{
+		return buffer->capacity;
+	}
+
+	/* Unmap the pages beyond the new capacity, then release them from the file */
+	if ( munmap( buffer->begin + capacity, buffer->capacity - capacity ) != 0 )
+	{
+		return buffer->capacity;
+	}
+
+	if ( !capacity )
+	{
+		buffer->begin = 0;
+	}
+
+	buffer->pos = buffer->begin + data_length;
+	buffer->capacity = capacity;
+
+	if ( ftruncate( buffer->fd, ( off_t ) capacity ) != 0 )
+	{
+		/* The file keeps its zeroed tail until the buffer is cleaned up */
+	}
+
+	return capacity;
+#else
+	( void ) capacity;
+	return buffer->capacity;
+#endif
+}
+
+
+/**
+ * buffer_file_cleanup
+ *
+ * Truncates the file backing the given buffer to the buffer's data length, then
+ * unmaps and closes it, leaving the buffer empty (see buffer_cleanup).
+ *
+ */
+void buffer_file_cleanup( buffer_t * buffer )
+{
+#if defined(BUFFER_FILE_SUPPORTED)
+	size_t data_length = buffer_data_length( buffer );
+
+	if ( buffer->begin )
+	{
+		munmap( buffer->begin, buffer->capacity );
+	}
+
+	if ( ftruncate( buffer->fd, ( off_t ) data_length ) != 0 )
+	{
+		/* The file keeps its zeroed tail - there is no way to report this */
+	}
+
+	close( buffer->fd );
+#endif
+
+	buffer->begin = buffer->pos = 0;
+	buffer->capacity = 0;
+	buffer->flags = 0;
+	buffer->fd = -1;
+}
+
+
+/**
+ * buffer_sync
+ *
+ * Flushes the data of a file-backed buffer to its file, blocking until the write
+ * has completed. Returns 1 on success, 0 on failure or if the buffer is not
+ * file-backed.
+ *
+ */
+int buffer_sync( buffer_t * buffer )
+{
+	if ( !buffer || !( buffer->flags & BUFFER_FILE ) )
+	{
+		return 0;
+	}
+
+#if defined(BUFFER_FILE_SUPPORTED)
+	if ( !buffer->begin || buffer->pos == buffer->begin )
+	{
+		return 1;
+	}
+
+	return msync( buffer->begin, buffer_data_length( buffer ), MS_SYNC ) == 0;
+#else
+	return 0;
+#endif
+}
@@ -0,0 +1,467 @@
+#include "chain.h"
+
+#include <string.h>
+
+
+/**
+ * _chain_segment_data
+ *
+ * Returns a pointer to the data held by the given segment.
+ *
+ */
+static int8_t * _chain_segment_data( chain_segment_t * segment )
+{
+	return ( int8_t * )( segment + 1 );
+}
+
+
+/**
+ * _chain_add_segment
+ *
+ * Allocates an empty segment and links it into the chain after the given segment
+ * (or at the head of the chain if null). Returns the new segment, or null if it
+ * could not be allocated.
+ *
+ */
+static chain_segment_t * _chain_add_segment( chain_t * chain, chain_segment_t * after )
+{
+	chain_segment_t * segment;
+
+	if ( chain->segment_size > ( size_t ) -1 - sizeof( chain_segment_t ) )
+	{
+		return 0;
+	}
+
+	segment = ( chain_segment_t * ) allocator_alloc(
+		sizeof( chain_segment_t ) + chain->segment_size,
+		chain->allocator
+	);
+
+	if ( !segment )
+	{
+		return 0;
+	}
+
+	segment->length = 0;
+
+	if ( after )
+	{
+		segment->next = after->next;
+		after->next = segment;
+	}
+	else
+	{
+		segment->next = chain->head;
+		chain->head = segment;
+	}
+
+	return segment;
+}
+
+
+/**
+ * _chain_next_segment
+ *
+ * Advances the tail of the chain to the next segment - reusing an empty segment
+ * retained by chain_rewind if there is one, or allocating a new one otherwise.
+ * Returns the new tail, or null if a segment could not be allocated.
+ *
+ */
+static chain_segment_t * _chain_next_segment( chain_t * chain )
+{
+	chain_segment_t * segment;
+
+	if ( chain->tail && chain->tail->next )
+	{
+		chain->tail = chain->tail->next;
+		return chain->tail;
+	}
+
+	segment = _chain_add_segment( chain, chain->tail );
+	if ( segment )
+	{
+		chain->tail = segment;
+	}
+	return segment;
+}
+
+
+/**
+ * chain_new
+ *
+ * Allocate a new chain_t object using the given allocator, and initialise it as
+ * with chain_init. Should call chain_delete to release the chain_t object, and
+ * its segments.
+ *
+ */
+chain_t * chain_new( size_t segment_size, allocator_t * allocator )
+{
+	chain_t * chain = ( chain_t * ) allocator_alloc( sizeof( chain_t ), allocator );
+	if ( chain )
+	{
+		chain_init( chain, segment_size, allocator );
+	}
+	return chain;
+}
+
+
+/**
+ * chain_delete
+ *
+ * Releases the given chain_t object and its segments. Use this function to release
+ * a chain_t object created with chain_new.
+ *
+ */
+void chain_delete( chain_t * chain )
+{
+	if ( chain )
+	{
+		allocator_t * allocator = chain->allocator;
+		chain_cleanup( chain );
+		allocator_free( chain, allocator );
+	}
+}
+
+
+/**
+ * chain_init
+ *
+ * Initialises the given chain_t object as an empty chain, whose segments will each
+ * hold the given number of bytes (or CHAIN_DEFAULT_SEGMENT_SIZE if zero) and be
+ * allocated with the given allocator. Should call chain_cleanup to release the
+ * segments.
+ *
+ */
+void chain_init( chain_t * chain, size_t segment_size, allocator_t * allocator )
+{
+	if ( chain )
+	{
+		chain->head = chain->tail = 0;
+		chain->segment_size = segment_size ? segment_size : CHAIN_DEFAULT_SEGMENT_SIZE;
+		chain->length = 0;
+		chain->allocator = allocator;
+	}
+}
+
+
+/**
+ * chain_cleanup
+ *
+ * Releases all segments of the given chain_t object (the chain_t object itself is
+ * not released). Use this function to clean up a chain_t object that was initialised
+ * with the chain_init function.
+ *
+ */
+void chain_cleanup( chain_t * chain )
+{
+	if ( chain )
+	{
+		chain_segment_t * segment = chain->head;
+		while ( segment )
+		{
+			chain_segment_t * next = segment->next;
+			allocator_free( segment, chain->allocator );
+			segment = next;
+		}
+
+		chain->head = chain->tail = 0;
+		chain->length = 0;
+
+		/* Note that the allocator is deliberately retained for chain_delete */
+	}
+}
+
+
+/**
+ * chain_data_length
+ *
+ * Returns the total number of bytes that have been written to the chain.
+ *
+ */
+size_t chain_data_length( chain_t * chain )
+{
+	return chain ? chain->length : 0;
+}
+
+
+/**
+ * chain_segment_count
+ *
+ * Returns the number of segments holding data, i.e. the number of spans that
+ * chain_spans will describe.
+ *
+ */
+size_t chain_segment_count( chain_t * chain )
+{
+	size_t count = 0;
+
+	if ( chain && chain->tail )
+	{
+		chain_segment_t * segment;
+		for ( segment = chain->head; segment != chain->tail->next; segment = segment->next )
+		{
+			if ( segment->length )
+			{
+				++count;
+			}
+		}
+	}
+
+	return count;
+}
+
+
+/**
+ * chain_rewind
+ *
+ * Discards all data in the chain, retaining its segments for reuse.
+ *
+ */
+void chain_rewind( chain_t * chain )
+{
+	if ( chain && chain->tail )
+	{
+		chain_segment_t * segment;
+		for ( segment = chain->head; segment != chain->tail->next; segment = segment->next )
+		{
+			segment->length = 0;
+		}
+
+		chain->tail = chain->head;
+		chain->length = 0;
+	}
+}
+
+
+/**
+ * chain_append
+ *
+ * Copies the given number of bytes to the end of the chain, adding segments as
+ * required. Returns the number of bytes appended, which is less than the given
+ * length only if a segment could not be allocated.
+ *
+ */
+size_t chain_append( chain_t * chain, size_t length, const void * data )
+{
+	const int8_t * source = ( const int8_t * ) data;
+	size_t remaining = length;
+
+	if ( !chain || !data )
+	{
+		return 0;
+	}
+
+	while ( remaining )
+	{
+		chain_segment_t * segment = chain->tail;
+		size_t amount;
+
+		if ( !segment || segment->length == chain->segment_size )
+		{
+			segment = _chain_next_segment( chain );
+			if ( !segment )
+			{
+				break;
+			}
+		}
+
+		amount = chain->segment_size - segment->length;
+		if ( amount > remaining )
+		{
+			amount = remaining;
+		}
+
+		memcpy( _chain_segment_data( segment ) + segment->length, source, amount );
+		segment->length += amount;
+		chain->length += amount;
+		source += amount;
+		remaining -= amount;
+	}
+
+	return length - remaining;
+}
+
+
+/**
+ * chain_reserve
+ *
+ * Reserves the given number of contiguous bytes at the end of the chain, returning
+ * a pointer to them such that they can be initialised at some later point.
+ *
+ */
+void * chain_reserve( chain_t * chain, size_t length )
+{
+	chain_segment_t * segment;
+	void * result;
+
+	if ( !chain || !length || length > chain->segment_size )
+	{
+		return 0;
+	}
+
+	segment = chain->tail;
+	if ( !segment || chain->segment_size - segment->length < length )
+	{
+		segment = _chain_next_segment( chain );
+		if ( !segment )
+		{
+			return 0;
+		}
+	}
+
+	result = _chain_segment_data( segment ) + segment->length;
+	segment->length += length;
+	chain->length += length;
+	return result;
+}
+
+
+/**
+ * chain_prepare
+ *
+ * Ensures that at least the given number of bytes are available at the end of the
+ * chain (adding segments if necessary), and describes them as a list of spans
+ * without adding them to the chain's data, writing up to the given maximum number
+ * of spans. Returns the number of spans written.
+ *
+ */
+size_t chain_prepare( chain_t * chain, size_t length, span_t * spans, size_t max_spans )
+{
+	chain_segment_t * segment;
+	size_t count = 0, available = 0;
+
+	if ( !chain || !length || !spans || !max_spans )
+	{
+		return 0;
+	}
+
+	segment = chain->tail ? chain->tail : _chain_next_segment( chain );
+
+	while ( segment )
+	{
+		size_t amount = chain->segment_size - segment->length;
+		if ( amount > length - available )
+		{
+			amount = length - available;
+		}
+
+		if ( amount )
+		{
+			spans[ count ].data = _chain_segment_data( segment ) + segment->length;
+			spans[ count ].length = amount;
+			available += amount;
+			++count;
+		}
+
+		if ( available == length || count == max_spans )
+		{
+			break;
+		}
+
+		segment = segment->next ? segment->next : _chain_add_segment( chain, segment );
+	}
+
+	return count;
+}
+
+
+/**
+ * chain_commit
+ *
+ * Appends the given number of bytes, previously described by chain_prepare, to the
+ * chain's data. Returns the number of bytes committed, which is limited to the
+ * space available in the chain's segments.
+ *
+ */
+size_t chain_commit( chain_t * chain, size_t length )
+{
+	chain_segment_t * segment;
+	size_t committed = 0;
+
+	if ( !chain )
+	{
+		return 0;
+	}
+
+	for ( segment = chain->tail; segment && committed < length; segment = segment->next )
+	{
+		size_t amount = chain->segment_size - segment->length;
+		if ( amount > length - committed )
+		{
+			amount = length - committed;
+		}
+
+		if ( amount )
+		{
+			segment->length += amount;
+			committed += amount;
+			chain->tail = segment;
+		}
+	}
+
+	chain->length += committed;
+	return committed;
+}
+
+
+/**
+ * chain_spans
+ *
+ * Describes the data in the chain as a list of spans (one per segment holding
+ * data), writing up to the given maximum number of spans. Returns the number of
+ * spans written.
+ *
+ */
+size_t chain_spans( chain_t * chain, span_t * spans, size_t max_spans )
+{
+	size_t count = 0;
+
+	if ( chain && chain->tail && spans )
+	{
+		chain_segment_t * segment;
+		for ( segment = chain->head; segment != chain->tail->next && count < max_spans; segment = segment->next )
+		{
+			if ( segment->length )
+			{
+				spans[ count ].data = _chain_segment_data( segment );
+				spans[ count ].length = segment->length;
+				++count;
+			}
+		}
+	}
+
+	return count;
+}
+
+
+/**
+ * chain_flatten
+ *
+ * Appends a contiguous copy of all data in the chain to the given buffer. Returns
+ * the number of bytes appended.
+ *
+ */
+size_t chain_flatten( chain_t * chain, buffer_t * buffer )
+{
+	chain_segment_t * segment;
+	int8_t * destination;
+
+	if ( !chain || !chain->length )
+	{
+		return 0;
+	}
+
+	destination = ( int8_t * ) buffer_reserve( buffer, chain->length );
+	if ( !destination )
+	{
+		return 0;
+	}
+
+	for ( segment = chain->head; segment != chain->tail->next; segment = segment->next )
+	{
+		memcpy( destination, _chain_segment_data( segment ), segment->length );
+		destination += segment->length;
+	}
+
+	return chain->length;
+}
@@ -0,0 +1,213 @@
+#ifndef __MEM_CHAIN_H
+#define __MEM_CHAIN_H
+
+#include "buffer.h"
+#include "span.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * CHAIN_DEFAULT_SEGMENT_SIZE
+ *
+ * The segment size used by chain_init when given a segment size of zero.
+ *
+ */
+#define CHAIN_DEFAULT_SEGMENT_SIZE 65536
+
+
+/**
+ * chain_segment_t
+ *
+ * The header of a single chain segment. The segment's data immediately follows
+ * the header in memory.
+ *
+ */
+typedef struct chain_segment_t
+{
+	/* The next segment in the chain */
+	struct chain_segment_t * next;
+
+	/* The number of bytes written to this segment */
+	size_t length;
+
+} chain_segment_t;
+
+
+/**
+ * chain_t
+ *
+ * A segmented buffer that grows by linking additional fixed-size segments, such
+ * that data already in the buffer is never moved or copied.
+ *
+ */
+typedef struct chain_t
+{
+	/* The first segment in the chain */
+	chain_segment_t * head;
+
+	/* The segment currently being written to. Any segments following it are
+	 * empty, and are retained for reuse after chain_rewind */
+	chain_segment_t * tail;
+
+	/* The capacity of each segment in bytes (excluding the segment header) */
+	size_t segment_size;
+
+	/* The total number of bytes written to the chain */
+	size_t length;
+
+	/* The allocator to use when adding segments */
+	allocator_t * allocator;
+
+} chain_t;
+
+
+/**
+ * chain_new
+ *
+ * Allocate a new chain_t object using the given allocator, and initialise it as
+ * with chain_init. Should call chain_delete to release the chain_t object, and
+ * its segments.
+ *
+ */
+chain_t * chain_new( size_t segment_size, allocator_t * allocator );
+
+
+/**
+ * chain_delete
+ *
+ * Releases the given chain_t object and its segments. Use this function to release
+ * a chain_t object created with chain_new.
+ *
+ */
+void chain_delete( chain_t * chain );
+
+
+/**
+ * chain_init
+ *
+ * Initialises the given chain_t object as an empty chain, whose segments will each
+ * hold the given number of bytes (or CHAIN_DEFAULT_SEGMENT_SIZE if zero) and be
+ * allocated with the given allocator. Should call chain_cleanup to release the
+ * segments.
+ *
+ */
+void chain_init( chain_t * chain, size_t segment_size, allocator_t * allocator );
+
+
+/**
+ * chain_cleanup
+ *
+ * Releases all segments of the given chain_t object (the chain_t object itself is
+ * not released). Use this function to clean up a chain_t object that was initialised
+ * with the chain_init function.
+ *
+ */
+void chain_cleanup( chain_t * chain );
+
+
+/**
+ * chain_data_length
+ *
+ * Returns the total number of bytes that have been written to the chain.
+ *
+ */
+size_t chain_data_length( chain_t * chain );
+
+
+/**
+ * chain_segment_count
+ *
+ * Returns the number of segments holding data, i.e. the number of spans that
+ * chain_spans will describe.
+ *
+ */
+size_t chain_segment_count( chain_t * chain );
+
+
+/**
+ * chain_rewind
+ *
+ * Discards all data in the chain, retaining its segments for reuse.
+ *
+ */
+void chain_rewind( chain_t * chain );
+
+
+/**
+ * chain_append
+ *
+ * Copies the given number of bytes to the end of the chain, adding segments as
+ * required. Returns the number of bytes appended, which is less than the given
+ * length only if a segment could not be allocated.
+ *
+ */
+size_t chain_append( chain_t * chain, size_t length, const void * data );
+
+
+/**
+ * chain_reserve
+ *
+ * Reserves the given number of contiguous bytes at the end of the chain, returning
+ * a pointer to them such that they can be initialised at some later point. The
+ * length cannot exceed the segment size. If the current segment does not have
+ * enough space remaining, the reserved bytes start a new segment. Returns null on
+ * failure.
+ *
+ */
+void * chain_reserve( chain_t * chain, size_t length );
+
+
+/**
+ * chain_prepare
+ *
+ * Ensures that at least the given number of bytes are available at the end of the
+ * chain (adding segments if necessary), and describes them as a list of spans
+ * without adding them to the chain's data, writing up to the given maximum number
+ * of spans. Once some or all of these bytes have been initialised (e.g. by a call
+ * to readv), they can be appended to the chain's data with chain_commit. Returns
+ * the number of spans written, which may describe fewer bytes than requested if
+ * the maximum number of spans is reached or a segment could not be allocated.
+ *
+ */
+size_t chain_prepare( chain_t * chain, size_t length, span_t * spans, size_t max_spans );
+
+
+/**
+ * chain_commit
+ *
+ * Appends the given number of bytes, previously described by chain_prepare, to the
+ * chain's data. Returns the number of bytes committed, which is limited to the
+ * space available in the chain's segments.
+ *
+ */
+size_t chain_commit( chain_t * chain, size_t length );
+
+
+/**
+ * chain_spans
+ *
+ * Describes the data in the chain as a list of spans (one per segment holding
+ * data), writing up to the given maximum number of spans. Returns the number of
+ * spans written.
+ *
+ */
+size_t chain_spans( chain_t * chain, span_t * spans, size_t max_spans );
+
+
+/**
+ * chain_flatten
+ *
+ * Appends a contiguous copy of all data in the chain to the given buffer. Returns
+ * the number of bytes appended.
+ *
+ */
+size_t chain_flatten( chain_t * chain, buffer_t * buffer );
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+#endif /* __MEM_CHAIN_H */
@@ -0,0 +1,303 @@
+#ifndef __MEM_FIXED_POOL_HPP
+#define __MEM_FIXED_POOL_HPP
+
+#include <cstddef>
+
+#include "allocator.h"
+
+/**
+ * FIXED_POOL_INLINE_LIMIT
+ *
+ * The largest storage size, in bytes, that a FixedPool holds inline within the
+ * FixedPool object itself. Larger pools obtain their storage from an allocator_t.
+ * May be defined before including this header to override the default.
+ *
+ */
+#ifndef FIXED_POOL_INLINE_LIMIT
+#define FIXED_POOL_INLINE_LIMIT 4096
+#endif
+
+namespace mem
+{
+
+namespace detail
+{
+
+constexpr std::size_t fixed_pool_max( std::size_t a, std::size_t b )
+{
+	return a > b ? a : b;
+}
+
+constexpr std::size_t fixed_pool_round_up( std::size_t value, std::size_t alignment )
+{
+	return ( value + alignment - 1 ) & ~( alignment - 1 );
+}
+
+constexpr bool fixed_pool_is_power_of_two( std::size_t value )
+{
+	return value && !( value & ( value - 1 ) );
+}
+
+constexpr std::size_t fixed_pool_log2( std::size_t value )
+{
+	return value > 1 ? 1 + fixed_pool_log2( value >> 1 ) : 0;
+}
+
+/**
+ * FixedPoolStorage
+ *
+ * The storage for a FixedPool - held inline when Inline is true, and allocated
+ * from an allocator_t otherwise.
+ *
+ */
+template< std::size_t Size, std::size_t Alignment, bool Inline >
+class FixedPoolStorage;
+
+template< std::size_t Size, std::size_t Alignment >
+class FixedPoolStorage< Size, Alignment, true >
+{
+public:
+
+	constexpr FixedPoolStorage( ) : bytes_( )
+	{
+	}
+
+	/* Inline storage needs no allocator, which is accepted only for symmetry with
+	 * allocator-backed storage */
+	constexpr explicit FixedPoolStorage( allocator_t * ) : bytes_( )
+	{
+	}
+
+	constexpr bool valid( ) const
+	{
+		return true;
+	}
+
+	unsigned char * data( )
+	{
+		return bytes_;
+	}
+
+	const unsigned char * data( ) const
+	{
+		return bytes_;
+	}
+
+private:
+
+	alignas( Alignment ) unsigned char bytes_[ Size ];
+};
+
+template< std::size_t Size, std::size_t Alignment >
+class FixedPoolStorage< Size, Alignment, false >
+{
+public:
+
+	FixedPoolStorage( ) : FixedPoolStorage( allocator_default( ) )
+	{
+	}
+
+	explicit FixedPoolStorage( allocator_t * allocator ) : allocator_( allocator )
+	{
+		raw_ = ( unsigned char * ) allocator_alloc( Size + Alignment - 1, allocator_ );
+		bytes_ = raw_ ? ( unsigned char * ) fixed_pool_round_up( ( std::size_t ) raw_, Alignment ) : 0;
+	}
+
+	~FixedPoolStorage( )
+	{
+		allocator_free( raw_, allocator_ );
+	}
+
+	bool valid( ) const
+	{
+		return bytes_ != 0;
+	}
+
+	unsigned char * data( )
+	{
+		return bytes_;
+	}
+
+	const unsigned char * data( ) const
+	{
+		return bytes_;
+	}
+
+	FixedPoolStorage( const FixedPoolStorage & ) = delete;
+	FixedPoolStorage & operator=( const FixedPoolStorage & ) = delete;
+
+private:
+
+	unsigned char * bytes_;
+	unsigned char * raw_;
+	allocator_t * allocator_;
+};
+
+} /* namespace detail */
+
+/**
+ * FixedPool
+ *
+ * A pool of Capacity elements of ElementSize bytes, each aligned to Alignment,
+ * whose geometry is fixed at compile time. Unlike pool_t, the element stride and
+ * storage size are constants (index arithmetic becomes shifts wherever the stride
+ * is a power of two), and take and release perform no range checks, such that
+ * both compile down to a handful of instructions once inlined.
+ *
+ * Pools whose storage fits within FIXED_POOL_INLINE_LIMIT hold their elements
+ * inline, and can be constructed in a constant expression (so a pool with static
+ * storage duration needs no dynamic initialisation). Larger pools allocate their
+ * storage from an allocator_t on construction.
+ *
+ */
+template< std::size_t ElementSize, std::size_t Capacity, std::size_t Alignment = alignof( std::max_align_t ) >
+class FixedPool
+{
+	static_assert( ElementSize > 0, "FixedPool elements must not be empty" );
+	static_assert( Capacity > 0, "FixedPool must hold at least one element" );
+	static_assert( detail::fixed_pool_is_power_of_two( Alignment ), "FixedPool alignment must be a power of two" );
+
+public:
+
+	/* The number of bytes requested for each element */
+	static constexpr std::size_t element_size = ElementSize;
+
+	/* The number of elements in the pool */
+	static constexpr std::size_t capacity = Capacity;
+
+	/* The alignment of each element (free elements hold a pointer to the next free
+	 * element, so are always at least pointer aligned) */
+	static constexpr std::size_t alignment = detail::fixed_pool_max( Alignment, alignof( void * ) );
+
+	/* The distance in bytes between consecutive elements */
+	static constexpr std::size_t stride = detail::fixed_pool_round_up( detail::fixed_pool_max( ElementSize, sizeof( void * ) ), alignment );
+
+	/* The total size of the pool's storage in bytes */
+	static constexpr std::size_t storage_size = stride * Capacity;
+
+	/* Whether the storage is held inline within the FixedPool object */
+	static constexpr bool is_inline = storage_size <= FIXED_POOL_INLINE_LIMIT;
+
+	static_assert( storage_size / stride == Capacity, "FixedPool storage size overflows" );
+
+	/**
+	 * FixedPool::FixedPool
+	 *
+	 * Creates a pool with every element available. Allocator-backed pools allocate
+	 * their storage from the given allocator (the default allocator if omitted) and,
+	 * should that fail, are created empty.
+	 *
+	 */
+	constexpr FixedPool( ) : storage_( ), free_( 0 ), used_( storage_.valid( ) ? 0 : Capacity )
+	{
+	}
+
+	explicit FixedPool( allocator_t * allocator ) : storage_( allocator ), free_( 0 ), used_( storage_.valid( ) ? 0 : Capacity )
+	{
+	}
+
+	/**
+	 * FixedPool::take
+	 *
+	 * Takes an element from the pool, returning null if the pool is empty. Returned
+	 * elements are reused first, and the remaining storage is handed out in order.
+	 *
+	 */
+	void * take( )
+	{
+		void * element = free_;
+		if ( element )
+		{
+			free_ = *( void ** ) element;
+			return element;
+		}
+
+		if ( used_ < Capacity )
+		{
+			return at( used_++ );
+		}
+
+		return 0;
+	}
+
+	/**
+	 * FixedPool::release
+	 *
+	 * Returns an element obtained from take to the pool. The element must belong to
+	 * this pool, which (unlike pool_return) is not checked.
+	 *
+	 */
+	void release( void * element )
+	{
+		*( void ** ) element = free_;
+		free_ = element;
+	}
+
+	/**
+	 * FixedPool::at
+	 *
+	 * Returns the element at the given index in the pool's storage.
+	 *
+	 */
+	void * at( std::size_t index )
+	{
+		return storage_.data( ) + ( stride_is_power_of_two ? index << stride_shift : index * stride );
+	}
+
+	/**
+	 * FixedPool::index_of
+	 *
+	 * Returns the index of the given element within the pool's storage.
+	 *
+	 */
+	std::size_t index_of( const void * element ) const
+	{
+		std::size_t offset = ( std::size_t )( ( const unsigned char * ) element - storage_.data( ) );
+		return stride_is_power_of_two ? offset >> stride_shift : offset / stride;
+	}
+
+	/**
+	 * FixedPool::contains
+	 *
+	 * Returns true if the given address is the start of an element in this pool.
+	 *
+	 */
+	bool contains( const void * element ) const
+	{
+		const unsigned char * address = ( const unsigned char * ) element;
+		const unsigned char * data = storage_.data( );
+		return data && address >= data && address < data + storage_size && ( std::size_t )( address - data ) % stride == 0;
+	}
+
+	/**
+	 * FixedPool::empty
+	 *
+	 * Returns true if there are no more elements available in the pool.
+	 *
+	 */
+	bool empty( ) const
+	{
+		return !free_ && used_ == Capacity;
+	}
+
+	FixedPool( const FixedPool & ) = delete;
+	FixedPool & operator=( const FixedPool & ) = delete;
+
+private:
+
+	static constexpr bool stride_is_power_of_two = detail::fixed_pool_is_power_of_two( stride );
+	static constexpr std::size_t stride_shift = detail::fixed_pool_log2( stride );
+
+	detail::FixedPoolStorage< storage_size, alignment, is_inline > storage_;
+
+	/* The most recently returned element, heading a list threaded through the free
+	 * elements themselves */
+	void * free_;
+
+	/* The number of elements, in order, that have ever been taken from the storage */
+	std::size_t used_;
+};
+
+} /* namespace mem */
+
+#endif /* __MEM_FIXED_POOL_HPP */
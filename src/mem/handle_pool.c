@@ -0,0 +1,284 @@
+#include "handle_pool.h"
+
+
+/**
+ * _HANDLE_POOL_INDEX_MASK
+ *
+ * The bits of a handle or slot holding an index. An index with all of these bits
+ * set marks the end of the free list.
+ *
+ */
+#define _HANDLE_POOL_INDEX_MASK ( ( ( uint32_t ) 1 << HANDLE_POOL_INDEX_BITS ) - 1 )
+
+
+/**
+ * _handle_pool_generation
+ *
+ * Returns the generation bits of the given handle or slot.
+ *
+ */
+static uint32_t _handle_pool_generation( uint32_t value )
+{
+	return value & ~_HANDLE_POOL_INDEX_MASK;
+}
+
+
+/**
+ * _handle_pool_slot
+ *
+ * Returns the slot of the element referred to by the given handle, or null if the
+ * handle does not refer to an element currently taken from the pool. Elements are
+ * taken with their slot's current generation, which is advanced when they are
+ * returned.
+ *
+ */
+static uint32_t * _handle_pool_slot( handle_pool_t * pool, handle_t handle )
+{
+	size_t index = handle_index( handle );
+	uint32_t * slot;
+
+	if ( !pool || handle == HANDLE_NULL || index >= pool->num_elements )
+	{
+		return 0;
+	}
+
+	slot = &pool->slots[ index ];
+	return _handle_pool_generation( *slot ) == _handle_pool_generation( handle ) &&
+		( *slot & _HANDLE_POOL_INDEX_MASK ) == index ? slot : 0;
+}
+
+
+/**
+ * handle_pool_new
+ *
+ * Allocate a new handle_pool_t object using the given allocator, and initialise it
+ * as with handle_pool_init.
+ *
+ */
+handle_pool_t * handle_pool_new( size_t element_size, size_t num_elements, allocator_t * allocator )
+{
+	handle_pool_t * pool = ( handle_pool_t * ) allocator_alloc( sizeof( handle_pool_t ), allocator );
+	if ( pool )
+	{
+		handle_pool_init( pool, element_size, num_elements, allocator );
+	}
+	return pool;
+}
+
+
+/**
+ * handle_pool_delete
+ *
+ * Releases the given handle_pool_t object and its elements.
+ *
+ */
+void handle_pool_delete( handle_pool_t * pool )
+{
+	if ( pool )
+	{
+		allocator_t * allocator = pool->allocator;
+		handle_pool_cleanup( pool );
+		allocator_free( pool, allocator );
+	}
+}
+
+
+/**
+ * handle_pool_init
+ *
+ * Initialises the given handle_pool_t object with the given number of elements of
+ * the given size, allocated with the given allocator.
+ *
+ */
+void handle_pool_init( handle_pool_t * pool, size_t element_size, size_t num_elements, allocator_t * allocator )
+{
+	size_t slots_offset, index;
+
+	if ( !pool )
+	{
+		return;
+	}
+
+	pool->elements = 0;
+	pool->slots = 0;
+	pool->element_size = element_size;
+	pool->num_elements = 0;
+	pool->count = 0;
+	pool->next = _HANDLE_POOL_INDEX_MASK;
+	pool->allocator = allocator;
+
+	if (
+		!num_elements ||
+		num_elements >= _HANDLE_POOL_INDEX_MASK ||
+		element_size > ( ( size_t ) -1 - sizeof( uint32_t ) ) / ( num_elements + 1 )
+	)
+	{
+		return;
+	}
+
+	/* The slots follow the elements, aligned for uint32_t */
+	slots_offset = ( element_size * num_elements + sizeof( uint32_t ) - 1 ) & ~( sizeof( uint32_t ) - 1 );
+	pool->elements = ( int8_t * ) allocator_alloc( slots_offset + num_elements * sizeof( uint32_t ), allocator );
+	if ( !pool->elements )
+	{
+		return;
+	}
+
+	pool->slots = ( uint32_t * )( pool->elements + slots_offset );
+	pool->num_elements = num_elements;
+
+	/* Generations start at one, such that no handle is ever HANDLE_NULL */
+	for ( index = 0; index < num_elements; ++index )
+	{
+		pool->slots[ index ] = ( ( uint32_t ) 1 << HANDLE_POOL_INDEX_BITS ) |
+			( index + 1 < num_elements ? ( uint32_t )( index + 1 ) : _HANDLE_POOL_INDEX_MASK );
+	}
+	pool->next = 0;
+}
+
+
+/**
+ * handle_pool_cleanup
+ *
+ * Releases the elements of the given handle_pool_t object.
+ *
+ */
+void handle_pool_cleanup( handle_pool_t * pool )
+{
+	if ( pool )
+	{
+		allocator_free( pool->elements, pool->allocator );
+		pool->elements = 0;
+		pool->slots = 0;
+		pool->num_elements = 0;
+		pool->count = 0;
+		pool->next = _HANDLE_POOL_INDEX_MASK;
+
+		/* Note that the allocator is deliberately retained for handle_pool_delete */
+	}
+}
+
+
+/**
+ * handle_pool_take
+ *
+ * Takes an unused element from the pool, returning a handle to it, or HANDLE_NULL
+ * if the pool is empty.
+ *
+ */
+handle_t handle_pool_take( handle_pool_t * pool )
+{
+	uint32_t index, * slot;
+
+	if ( !pool || pool->next == _HANDLE_POOL_INDEX_MASK )
+	{
+		return HANDLE_NULL;
+	}
+
+	index = pool->next;
+	slot = &pool->slots[ index ];
+	pool->next = *slot & _HANDLE_POOL_INDEX_MASK;
+
+	/* While taken, a slot's index bits hold its own index */
+	*slot = _handle_pool_generation( *slot ) | index;
+	++pool->count;
+	return *slot;
+}
+
+
+/**
+ * handle_pool_return
+ *
+ * Returns the element referred to by the given handle to the pool, invalidating the
+ * handle. Returns 1 if the element was returned, or 0 if the handle is stale.
+ *
+ */
+int handle_pool_return( handle_pool_t * pool, handle_t handle )
+{
+	uint32_t * slot = _handle_pool_slot( pool, handle );
+	uint32_t generation;
+
+	if ( !slot )
+	{
+		return 0;
+	}
+
+	/* Advance the generation, skipping zero on wrapping around */
+	generation = _handle_pool_generation( *slot + ( ( uint32_t ) 1 << HANDLE_POOL_INDEX_BITS ) );
+	if ( !generation )
+	{
+		generation = ( uint32_t ) 1 << HANDLE_POOL_INDEX_BITS;
+	}
+
+	*slot = generation | pool->next;
+	pool->next = ( uint32_t ) handle_index( handle );
+	--pool->count;
+	return 1;
+}
+
+
+/**
+ * handle_pool_get
+ *
+ * Returns a pointer to the element referred to by the given handle, or null if the
+ * handle is stale.
+ *
+ */
+void * handle_pool_get( handle_pool_t * pool, handle_t handle )
+{
+	return _handle_pool_slot( pool, handle ) ? pool->elements + handle_index( handle ) * pool->element_size : 0;
+}
+
+
+/**
+ * handle_pool_is_valid
+ *
+ * Returns 1 if the given handle refers to an element currently taken from the pool,
+ * or 0 otherwise.
+ *
+ */
+int handle_pool_is_valid( handle_pool_t * pool, handle_t handle )
+{
+	return _handle_pool_slot( pool, handle ) ? 1 : 0;
+}
+
+
+/**
+ * handle_pool_handle
+ *
+ * Returns the handle to the element with the given index if it is currently taken,
+ * or HANDLE_NULL otherwise.
+ *
+ */
+handle_t handle_pool_handle( handle_pool_t * pool, size_t index )
+{
+	if ( !pool || index >= pool->num_elements || ( pool->slots[ index ] & _HANDLE_POOL_INDEX_MASK ) != index )
+	{
+		return HANDLE_NULL;
+	}
+	return pool->slots[ index ];
+}
+
+
+/**
+ * handle_pool_is_empty
+ *
+ * Returns 1 if there are no more free elements in the pool, or 0 otherwise.
+ *
+ */
+int handle_pool_is_empty( handle_pool_t * pool )
+{
+	return !pool || pool->next == _HANDLE_POOL_INDEX_MASK;
+}
+
+
+/**
+ * handle_index
+ *
+ * Returns the index of the element referred to by the given handle.
+ *
+ */
+size_t handle_index( handle_t handle )
+{
+	return handle & _HANDLE_POOL_INDEX_MASK;
+}
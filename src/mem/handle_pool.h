@@ -0,0 +1,199 @@
+#ifndef __MEM_HANDLE_POOL_H
+#define __MEM_HANDLE_POOL_H
+
+#include "allocator.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * HANDLE_POOL_INDEX_BITS
+ *
+ * The number of bits of a handle holding the element's index, which limits a pool
+ * to ( 1 << HANDLE_POOL_INDEX_BITS ) - 1 elements. The remaining bits hold the
+ * element's generation, which is incremented each time the element is returned, so
+ * a stale handle is only mistaken for a live one after the element has been reused
+ * 2^( 32 - HANDLE_POOL_INDEX_BITS ) - 1 times.
+ *
+ */
+#ifndef HANDLE_POOL_INDEX_BITS
+#define HANDLE_POOL_INDEX_BITS 20
+#endif
+
+
+/**
+ * HANDLE_NULL
+ *
+ * A handle that never refers to an element.
+ *
+ */
+#define HANDLE_NULL 0
+
+
+/**
+ * handle_t
+ *
+ * A 32-bit reference to an element of a handle_pool_t, combining the element's
+ * index with its generation.
+ *
+ */
+typedef uint32_t handle_t;
+
+
+/**
+ * handle_pool_t
+ *
+ * A fixed-size pool of fixed-size elements, referred to by generational handles
+ * rather than pointers. Handles are resolved to pointers in constant time, and
+ * handles to elements that have since been returned to the pool are rejected.
+ * Element i is stored at elements + i * element_size, with no minimum element size.
+ *
+ */
+typedef struct handle_pool_t
+{
+	/* The storage for the elements (which also holds the slots) */
+	int8_t * elements;
+
+	/* One slot per element, holding the element's generation in its upper bits, and
+	 * in its lower bits the index of the next free element while it is free, or its
+	 * own index while it is taken */
+	uint32_t * slots;
+
+	/* The size of each element in bytes */
+	size_t element_size;
+
+	/* The number of elements in the pool */
+	size_t num_elements;
+
+	/* The number of elements currently taken */
+	size_t count;
+
+	/* The index of the first free element (all index bits set if none) */
+	uint32_t next;
+
+	/* The allocator used to allocate the elements */
+	allocator_t * allocator;
+
+} handle_pool_t;
+
+
+/**
+ * handle_pool_new
+ *
+ * Allocate a new handle_pool_t object using the given allocator, and initialise it
+ * as with handle_pool_init. Should call handle_pool_delete to release it.
+ *
+ */
+handle_pool_t * handle_pool_new( size_t element_size, size_t num_elements, allocator_t * allocator );
+
+
+/**
+ * handle_pool_delete
+ *
+ * Releases the given handle_pool_t object and its elements. Use this function to
+ * release a handle_pool_t object created with handle_pool_new.
+ *
+ */
+void handle_pool_delete( handle_pool_t * pool );
+
+
+/**
+ * handle_pool_init
+ *
+ * Initialises the given handle_pool_t object with the given number of elements of
+ * the given size (at most ( 1 << HANDLE_POOL_INDEX_BITS ) - 1), allocated with the
+ * given allocator. Should call handle_pool_cleanup to release the elements. If the
+ * elements cannot be allocated, the pool has no elements.
+ *
+ * An element size of zero allocates only the handles, for pools whose elements are
+ * stored elsewhere (see soa_pool_t). handle_pool_get is then meaningless.
+ *
+ */
+void handle_pool_init( handle_pool_t * pool, size_t element_size, size_t num_elements, allocator_t * allocator );
+
+
+/**
+ * handle_pool_cleanup
+ *
+ * Releases the elements of the given handle_pool_t object (the handle_pool_t object
+ * itself is not released). All handles are invalidated.
+ *
+ */
+void handle_pool_cleanup( handle_pool_t * pool );
+
+
+/**
+ * handle_pool_take
+ *
+ * Takes an unused element from the pool, returning a handle to it, or HANDLE_NULL
+ * if the pool is empty.
+ *
+ */
+handle_t handle_pool_take( handle_pool_t * pool );
+
+
+/**
+ * handle_pool_return
+ *
+ * Returns the element referred to by the given handle to the pool, invalidating the
+ * handle. Returns 1 if the element was returned, or 0 if the handle is stale (or
+ * otherwise invalid).
+ *
+ */
+int handle_pool_return( handle_pool_t * pool, handle_t handle );
+
+
+/**
+ * handle_pool_get
+ *
+ * Returns a pointer to the element referred to by the given handle, or null if the
+ * handle is stale (or otherwise invalid).
+ *
+ */
+void * handle_pool_get( handle_pool_t * pool, handle_t handle );
+
+
+/**
+ * handle_pool_is_valid
+ *
+ * Returns 1 if the given handle refers to an element currently taken from the pool,
+ * or 0 otherwise.
+ *
+ */
+int handle_pool_is_valid( handle_pool_t * pool, handle_t handle );
+
+
+/**
+ * handle_pool_handle
+ *
+ * Returns the handle to the element with the given index if it is currently taken,
+ * or HANDLE_NULL otherwise - e.g. to skip free elements when scanning every index.
+ *
+ */
+handle_t handle_pool_handle( handle_pool_t * pool, size_t index );
+
+
+/**
+ * handle_pool_is_empty
+ *
+ * Returns 1 if there are no more free elements in the pool, or 0 otherwise.
+ *
+ */
+int handle_pool_is_empty( handle_pool_t * pool );
+
+
+/**
+ * handle_index
+ *
+ * Returns the index of the element referred to by the given handle.
+ *
+ */
+size_t handle_index( handle_t handle );
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+#endif /* __MEM_HANDLE_POOL_H */
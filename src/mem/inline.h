@@ -0,0 +1,33 @@
+#ifndef __MEM_INLINE_H
+#define __MEM_INLINE_H
+
+/**
+ * LIBMEM_INLINE
+ *
+ * Define LIBMEM_INLINE before including any libmem header to replace calls to the
+ * hottest functions (allocator_alloc, allocator_free, pool_take, pool_return and
+ * buffer_reserve) with header-inline equivalents, allowing them to be inlined at
+ * the call site instead of going through the shared library. The out-of-line
+ * functions remain exported, and behave identically.
+ *
+ */
+
+
+/**
+ * MEM_INLINE
+ *
+ * Storage class for header-inline functions. Uses the best inline keyword the
+ * compiler offers, falling back to plain static for strict C90 compilers.
+ *
+ */
+#if defined(__cplusplus) || ( defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L )
+#define MEM_INLINE static inline
+#elif defined(__GNUC__)
+#define MEM_INLINE static __inline__
+#elif defined(_MSC_VER)
+#define MEM_INLINE static __inline
+#else
+#define MEM_INLINE static
+#endif
+
+#endif /* __MEM_INLINE_H */
@@ -0,0 +1,30 @@
+#ifndef __MEM_INTERNAL_ATOMIC_H
+#define __MEM_INTERNAL_ATOMIC_H
+
+/**
+ * ATOMIC_*
+ *
+ * Atomic operations for the thread-safe parts of libmem, implemented with the
+ * GCC __atomic builtins (GCC 4.7 or later, and clang - including clang-cl, which
+ * does not define __GNUC__), as C90 has no atomics of its own. There is no
+ * fallback, as C11 atomics cannot be applied to the plain objects used here.
+ *
+ */
+#if !defined(__GNUC__) && !defined(__clang__)
+#error "libmem requires a compiler providing the GCC __atomic builtins (GCC 4.7 or later, or clang)"
+#endif
+
+#define ATOMIC_LOAD_RELAXED( ptr ) __atomic_load_n( ptr, __ATOMIC_RELAXED )
+#define ATOMIC_LOAD_ACQUIRE( ptr ) __atomic_load_n( ptr, __ATOMIC_ACQUIRE )
+#define ATOMIC_STORE_RELAXED( ptr, value ) __atomic_store_n( ptr, value, __ATOMIC_RELAXED )
+#define ATOMIC_STORE_RELEASE( ptr, value ) __atomic_store_n( ptr, value, __ATOMIC_RELEASE )
+#define ATOMIC_EXCHANGE_ACQUIRE( ptr, value ) __atomic_exchange_n( ptr, value, __ATOMIC_ACQUIRE )
+#define ATOMIC_FETCH_ADD_RELAXED( ptr, value ) __atomic_fetch_add( ptr, value, __ATOMIC_RELAXED )
+#define ATOMIC_FETCH_SUB_RELAXED( ptr, value ) __atomic_fetch_sub( ptr, value, __ATOMIC_RELAXED )
+#define ATOMIC_COMPARE_EXCHANGE_RELAXED( ptr, expected, desired ) \
+	__atomic_compare_exchange_n( ptr, expected, desired, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED )
+#define ATOMIC_COMPARE_EXCHANGE_ACQ_REL( ptr, expected, desired ) \
+	__atomic_compare_exchange_n( ptr, expected, desired, 1, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE )
+#define ATOMIC_ALWAYS_LOCK_FREE( size ) __atomic_always_lock_free( size, 0 )
+
+#endif /* __MEM_INTERNAL_ATOMIC_H */
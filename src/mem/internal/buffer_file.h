@@ -0,0 +1,35 @@
+#ifndef __MEM_INTERNAL_BUFFER_FILE_H
+#define __MEM_INTERNAL_BUFFER_FILE_H
+
+#include "../buffer.h"
+
+/**
+ * buffer_file_grow
+ *
+ * Grows a file-backed buffer (see buffer_grow), returning its new capacity, or 0
+ * if the file could not be extended or remapped.
+ *
+ */
+size_t buffer_file_grow( buffer_t * buffer, size_t amount_in_bytes );
+
+
+/**
+ * buffer_file_shrink
+ *
+ * Shrinks a file-backed buffer to the given capacity, rounded up to a whole number
+ * of pages (see buffer_trim), returning its new capacity.
+ *
+ */
+size_t buffer_file_shrink( buffer_t * buffer, size_t capacity );
+
+
+/**
+ * buffer_file_cleanup
+ *
+ * Truncates the file backing the given buffer to the buffer's data length, then
+ * unmaps and closes it, leaving the buffer empty (see buffer_cleanup).
+ *
+ */
+void buffer_file_cleanup( buffer_t * buffer );
+
+#endif /* __MEM_INTERNAL_BUFFER_FILE_H */
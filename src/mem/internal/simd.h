@@ -0,0 +1,96 @@
+#ifndef __MEM_INTERNAL_SIMD_H
+#define __MEM_INTERNAL_SIMD_H
+
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * SIMD_*
+ *
+ * The instruction set levels the simd_* kernels can be dispatched to. Each level
+ * is only used if supported by both the compiler and the CPU.
+ *
+ */
+#define SIMD_SCALAR 0
+#define SIMD_SSE2 1
+#define SIMD_AVX2 2
+#define SIMD_AVX512 3
+
+
+/**
+ * simd_level
+ *
+ * Returns the level the kernels are currently dispatched to - initially the
+ * highest level supported by the CPU.
+ *
+ */
+int simd_level( void );
+
+
+/**
+ * simd_set_level
+ *
+ * Dispatches the kernels to the given level, or the highest supported level if
+ * that is lower (e.g. to test each kernel, or to avoid AVX-512 frequency scaling).
+ * Returns the level now in use.
+ *
+ */
+int simd_set_level( int level );
+
+
+/**
+ * simd_cache_size
+ *
+ * Returns the size in bytes of the CPU's last level data cache, or 0 if it cannot
+ * be determined (currently only detected on Linux, via sysfs).
+ *
+ */
+size_t simd_cache_size( void );
+
+
+/**
+ * simd_fill
+ *
+ * Sets the given number of bytes to the given value, as memset.
+ *
+ */
+void simd_fill( void * destination, int value, size_t length );
+
+
+/**
+ * simd_copy_streaming
+ *
+ * Copies the given number of bytes, as memcpy, but with non-temporal stores that
+ * bypass the cache - for copies too large to benefit from being cached. The source
+ * is prefetched ahead of the loads, without being retained in the cache.
+ *
+ */
+void simd_copy_streaming( void * destination, const void * source, size_t length );
+
+
+/**
+ * simd_find
+ *
+ * Returns a pointer to the first byte with the given value, or null if there is
+ * none, as memchr.
+ *
+ */
+void * simd_find( const void * data, int value, size_t length );
+
+
+/**
+ * simd_equal
+ *
+ * Returns 1 if the given blocks of memory hold the same bytes, or 0 otherwise.
+ *
+ */
+int simd_equal( const void * a, const void * b, size_t length );
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+#endif /* __MEM_INTERNAL_SIMD_H */
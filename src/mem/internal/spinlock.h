@@ -0,0 +1,77 @@
+#ifndef __MEM_INTERNAL_SPINLOCK_H
+#define __MEM_INTERNAL_SPINLOCK_H
+
+#include <sched.h>
+
+#include "atomic.h"
+#include "../inline.h"
+
+/**
+ * SPINLOCK_SPINS
+ *
+ * The number of times spinlock_lock polls a held lock before yielding the CPU to
+ * the thread holding it.
+ *
+ */
+#define SPINLOCK_SPINS 64
+
+
+/**
+ * spinlock_t
+ *
+ * A minimal test-and-test-and-set lock for guarding short critical sections. A
+ * zero-initialised spinlock_t is unlocked.
+ *
+ */
+typedef int spinlock_t;
+
+
+/**
+ * spinlock_lock
+ *
+ * Acquires the given lock, spinning until it becomes available, and yielding if
+ * it remains held for more than a few polls.
+ *
+ */
+MEM_INLINE void spinlock_lock( spinlock_t * lock )
+{
+	while ( ATOMIC_EXCHANGE_ACQUIRE( lock, 1 ) )
+	{
+		int spins = 0;
+		while ( ATOMIC_LOAD_RELAXED( lock ) )
+		{
+			if ( ++spins == SPINLOCK_SPINS )
+			{
+				sched_yield( );
+				spins = 0;
+			}
+		}
+	}
+}
+
+
+/**
+ * spinlock_try_lock
+ *
+ * Acquires the given lock if it is available, returning non-zero if it was
+ * acquired.
+ *
+ */
+MEM_INLINE int spinlock_try_lock( spinlock_t * lock )
+{
+	return !ATOMIC_LOAD_RELAXED( lock ) && !ATOMIC_EXCHANGE_ACQUIRE( lock, 1 );
+}
+
+
+/**
+ * spinlock_unlock
+ *
+ * Releases the given lock, which must be held by the caller.
+ *
+ */
+MEM_INLINE void spinlock_unlock( spinlock_t * lock )
+{
+	ATOMIC_STORE_RELEASE( lock, 0 );
+}
+
+#endif /* __MEM_INTERNAL_SPINLOCK_H */
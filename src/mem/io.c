@@ -0,0 +1,211 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "io.h"
+
+#include <errno.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+
+/**
+ * _io_vectors
+ *
+ * Copies the given spans into an array of iovec structures.
+ *
+ */
+static int _io_vectors( span_t * spans, size_t count, struct iovec * vectors )
+{
+	size_t i;
+
+	for ( i = 0; i < count; ++i )
+	{
+		vectors[ i ].iov_base = spans[ i ].data;
+		vectors[ i ].iov_len = spans[ i ].length;
+	}
+
+	return ( int ) count;
+}
+
+
+/**
+ * buffer_read_fd
+ *
+ * Reads up to the given number of bytes from the given file descriptor directly
+ * into the end of the buffer (growing it if necessary), and appends the bytes that
+ * were actually read to the buffer's data. Returns the result of read.
+ *
+ */
+ssize_t buffer_read_fd( buffer_t * buffer, int fd, size_t length )
+{
+	ssize_t result;
+	void * destination;
+
+	if ( !length )
+	{
+		return 0;
+	}
+
+	destination = buffer_prepare( buffer, length );
+	if ( !destination )
+	{
+		errno = ENOMEM;
+		return -1;
+	}
+
+	result = read( fd, destination, length );
+	if ( result > 0 )
+	{
+		buffer_commit( buffer, ( size_t ) result );
+	}
+	return result;
+}
+
+
+/**
+ * buffer_write_fd
+ *
+ * Writes the buffer's data, starting at the given offset, to the given file
+ * descriptor. Returns the result of write.
+ *
+ */
+ssize_t buffer_write_fd( buffer_t * buffer, int fd, size_t offset )
+{
+	size_t length = buffer_data_length( buffer );
+
+	if ( offset >= length )
+	{
+		return 0;
+	}
+
+	return write( fd, ( int8_t * ) buffer_data_pointer( buffer ) + offset, length - offset );
+}
+
+
+/**
+ * chain_read_fd
+ *
+ * Reads up to the given number of bytes from the given file descriptor directly
+ * into the end of the chain (adding segments if necessary) with a single call to
+ * readv, and appends the bytes that were actually read to the chain's data.
+ *
+ */
+ssize_t chain_read_fd( chain_t * chain, int fd, size_t length )
+{
+	span_t spans[ IO_MAX_SPANS ];
+	struct iovec vectors[ IO_MAX_SPANS ];
+	size_t count;
+	ssize_t result;
+
+	if ( !length )
+	{
+		return 0;
+	}
+
+	count = chain_prepare( chain, length, spans, IO_MAX_SPANS );
+	if ( !count )
+	{
+		errno = ENOMEM;
+		return -1;
+	}
+
+	result = readv( fd, vectors, _io_vectors( spans, count, vectors ) );
+	if ( result > 0 )
+	{
+		chain_commit( chain, ( size_t ) result );
+	}
+	return result;
+}
+
+
+/**
+ * chain_write_fd
+ *
+ * Writes the chain's data, starting at the given offset, to the given file
+ * descriptor with a single call to writev.
+ *
+ */
+ssize_t chain_write_fd( chain_t * chain, int fd, size_t offset )
+{
+	struct iovec vectors[ IO_MAX_SPANS ];
+	chain_segment_t * segment;
+	int count = 0;
+
+	if ( !chain || !chain->tail || offset >= chain->length )
+	{
+		return 0;
+	}
+
+	for ( segment = chain->head; segment != chain->tail->next && count < IO_MAX_SPANS; segment = segment->next )
+	{
+		if ( offset >= segment->length )
+		{
+			offset -= segment->length;
+			continue;
+		}
+
+		vectors[ count ].iov_base = ( int8_t * )( segment + 1 ) + offset;
+		vectors[ count ].iov_len = segment->length - offset;
+		offset = 0;
+		++count;
+	}
+
+	return writev( fd, vectors, count );
+}
+
+
+/**
+ * ring_read_fd
+ *
+ * Reads as many bytes as will fit into the ring from the given file descriptor with
+ * a single call to readv, and commits the bytes that were actually read.
+ *
+ */
+ssize_t ring_read_fd( ring_t * ring, int fd )
+{
+	span_t spans[ 2 ];
+	struct iovec vectors[ 2 ];
+	size_t count;
+	ssize_t result;
+
+	count = ring_reserve_spans( ring, spans );
+	if ( !count )
+	{
+		return 0;
+	}
+
+	result = readv( fd, vectors, _io_vectors( spans, count, vectors ) );
+	if ( result > 0 )
+	{
+		ring_commit( ring, ( size_t ) result );
+	}
+	return result;
+}
+
+
+/**
+ * ring_write_fd
+ *
+ * Writes the ring's data to the given file descriptor with a single call to writev,
+ * and consumes the bytes that were actually written.
+ *
+ */
+ssize_t ring_write_fd( ring_t * ring, int fd )
+{
+	span_t spans[ 2 ];
+	struct iovec vectors[ 2 ];
+	size_t count;
+	ssize_t result;
+
+	count = ring_peek_spans( ring, spans );
+	if ( !count )
+	{
+		return 0;
+	}
+
+	result = writev( fd, vectors, _io_vectors( spans, count, vectors ) );
+	if ( result > 0 )
+	{
+		ring_consume( ring, ( size_t ) result );
+	}
+	return result;
+}
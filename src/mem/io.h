@@ -0,0 +1,94 @@
+#ifndef __MEM_IO_H
+#define __MEM_IO_H
+
+#include <sys/types.h>
+
+#include "buffer.h"
+#include "chain.h"
+#include "ring.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * IO_MAX_SPANS
+ *
+ * The maximum number of spans passed to a single readv / writev call.
+ *
+ */
+#define IO_MAX_SPANS 64
+
+
+/**
+ * buffer_read_fd
+ *
+ * Reads up to the given number of bytes from the given file descriptor directly
+ * into the end of the buffer (growing it if necessary), and appends the bytes that
+ * were actually read to the buffer's data. Returns the result of read: the number
+ * of bytes read, 0 at end of file, or -1 on error (with errno set).
+ *
+ */
+ssize_t buffer_read_fd( buffer_t * buffer, int fd, size_t length );
+
+
+/**
+ * buffer_write_fd
+ *
+ * Writes the buffer's data, starting at the given offset, to the given file
+ * descriptor. Returns the result of write: the number of bytes written (which
+ * may be fewer than requested), or -1 on error (with errno set).
+ *
+ */
+ssize_t buffer_write_fd( buffer_t * buffer, int fd, size_t offset );
+
+
+/**
+ * chain_read_fd
+ *
+ * Reads up to the given number of bytes from the given file descriptor directly
+ * into the end of the chain (adding segments if necessary) with a single call to
+ * readv, and appends the bytes that were actually read to the chain's data.
+ * Returns the result of readv.
+ *
+ */
+ssize_t chain_read_fd( chain_t * chain, int fd, size_t length );
+
+
+/**
+ * chain_write_fd
+ *
+ * Writes the chain's data, starting at the given offset, to the given file
+ * descriptor with a single call to writev. Returns the result of writev.
+ *
+ */
+ssize_t chain_write_fd( chain_t * chain, int fd, size_t offset );
+
+
+/**
+ * ring_read_fd
+ *
+ * Reads as many bytes as will fit into the ring from the given file descriptor with
+ * a single call to readv, and commits the bytes that were actually read. Returns
+ * the result of readv (or 0 without reading if the ring is full).
+ *
+ */
+ssize_t ring_read_fd( ring_t * ring, int fd );
+
+
+/**
+ * ring_write_fd
+ *
+ * Writes the ring's data to the given file descriptor with a single call to writev,
+ * and consumes the bytes that were actually written. Returns the result of writev
+ * (or 0 without writing if the ring is empty).
+ *
+ */
+ssize_t ring_write_fd( ring_t * ring, int fd );
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+#endif /* __MEM_IO_H */
@@ -0,0 +1,175 @@
+#ifndef __MEM_OBJECT_POOL_HPP
+#define __MEM_OBJECT_POOL_HPP
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "pool.h"
+
+namespace mem
+{
+
+/**
+ * ObjectPool
+ *
+ * A typed, fixed-capacity pool of T objects built on pool_t. Elements are sized and
+ * aligned for T, constructed in place when taken from the pool and destroyed when
+ * returned to it. Every object taken from the pool must be returned before the
+ * pool itself is destroyed.
+ *
+ */
+template< typename T >
+class ObjectPool
+{
+public:
+
+	/**
+	 * ObjectPool::Deleter
+	 *
+	 * A std::unique_ptr deleter that destroys the object and returns its memory
+	 * to the pool it was taken from.
+	 *
+	 */
+	class Deleter
+	{
+	public:
+
+		Deleter( ) : pool_( 0 )
+		{
+		}
+
+		explicit Deleter( ObjectPool * pool ) : pool_( pool )
+		{
+		}
+
+		void operator( )( T * object ) const
+		{
+			if ( pool_ )
+			{
+				pool_->destroy( object );
+			}
+		}
+
+	private:
+
+		ObjectPool * pool_;
+	};
+
+	/* An owning pointer to an object that returns it to the pool when released */
+	typedef std::unique_ptr< T, Deleter > Handle;
+
+	/**
+	 * ObjectPool::ObjectPool
+	 *
+	 * Creates a pool with capacity for the given number of objects, using the given
+	 * allocator for the underlying storage.
+	 *
+	 */
+	explicit ObjectPool( std::size_t capacity, allocator_t * allocator = allocator_default( ) )
+	{
+		pool_init_aligned( &pool_, sizeof( T ), capacity, alignment( ), allocator );
+	}
+
+	~ObjectPool( )
+	{
+		pool_cleanup( &pool_ );
+	}
+
+	/**
+	 * ObjectPool::construct
+	 *
+	 * Takes an element from the pool and constructs a T in it from the given
+	 * arguments. Returns null if the pool is empty. If the constructor throws, the
+	 * element is returned to the pool before the exception propagates.
+	 *
+	 */
+	template< typename... Args >
+	T * construct( Args &&... args )
+	{
+		void * address = pool_take( &pool_ );
+		if ( !address )
+		{
+			return 0;
+		}
+
+		try
+		{
+			return new ( address ) T( std::forward< Args >( args )... );
+		}
+		catch ( ... )
+		{
+			pool_return( &pool_, address );
+			throw;
+		}
+	}
+
+	/**
+	 * ObjectPool::destroy
+	 *
+	 * Destroys an object obtained from construct and returns its element to the pool.
+	 *
+	 */
+	void destroy( T * object )
+	{
+		if ( object )
+		{
+			object->~T( );
+			pool_return( &pool_, object );
+		}
+	}
+
+	/**
+	 * ObjectPool::make
+	 *
+	 * As construct, but returns a Handle that destroys the object and returns it to
+	 * the pool once it goes out of scope. The handle is empty if the pool is empty.
+	 *
+	 */
+	template< typename... Args >
+	Handle make( Args &&... args )
+	{
+		return Handle( construct( std::forward< Args >( args )... ), Deleter( this ) );
+	}
+
+	/**
+	 * ObjectPool::empty
+	 *
+	 * Returns true if there are no more objects available in the pool.
+	 *
+	 */
+	bool empty( )
+	{
+		return pool_is_empty( &pool_ ) != 0;
+	}
+
+	/**
+	 * ObjectPool::get
+	 *
+	 * Returns the underlying pool_t.
+	 *
+	 */
+	pool_t * get( )
+	{
+		return &pool_;
+	}
+
+	ObjectPool( const ObjectPool & ) = delete;
+	ObjectPool & operator=( const ObjectPool & ) = delete;
+
+private:
+
+	/* Free elements hold a pointer to the next free element, so elements must be
+	 * suitably aligned for both T and that pointer */
+	static std::size_t alignment( )
+	{
+		return alignof( T ) > alignof( int8_t * ) ? alignof( T ) : alignof( int8_t * );
+	}
+
+	pool_t pool_;
+};
+
+} /* namespace mem */
+
+#endif /* __MEM_OBJECT_POOL_HPP */
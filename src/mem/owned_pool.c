@@ -0,0 +1,231 @@
+#include "owned_pool.h"
+#include "internal/atomic.h"
+
+
+/**
+ * _owned_pool_contains
+ *
+ * Returns 1 if the given address lies within the pool's buffer, 0 otherwise.
+ *
+ */
+static int _owned_pool_contains( owned_pool_t * pool, void * address )
+{
+	int8_t * element = ( int8_t * ) address;
+	return pool->pool.buffer && element >= pool->pool.buffer && element < pool->pool.buffer + pool->pool.size;
+}
+
+
+/**
+ * owned_pool_new
+ *
+ * Allocate a new owned_pool_t object using the given allocator, and initialise it
+ * as with owned_pool_init. Should call owned_pool_delete to release the
+ * owned_pool_t object, and its underlying memory.
+ *
+ */
+owned_pool_t * owned_pool_new( size_t element_size, size_t num_elements, allocator_t * allocator )
+{
+	owned_pool_t * pool = ( owned_pool_t * ) allocator_alloc( sizeof( owned_pool_t ), allocator );
+	if ( pool )
+	{
+		owned_pool_init( pool, element_size, num_elements, allocator );
+	}
+	return pool;
+}
+
+
+/**
+ * owned_pool_delete
+ *
+ * Releases the given owned_pool_t object and its underlying memory. Use this
+ * function to release an owned_pool_t object created with owned_pool_new.
+ *
+ */
+void owned_pool_delete( owned_pool_t * pool )
+{
+	if ( pool )
+	{
+		allocator_t * allocator = pool->pool.allocator;
+		owned_pool_cleanup( pool );
+		allocator_free( pool, allocator );
+	}
+}
+
+
+/**
+ * owned_pool_init
+ *
+ * Initialises the given owned_pool_t object as with pool_init, owned by the calling
+ * thread. Should call owned_pool_cleanup to release the underlying memory.
+ *
+ */
+void owned_pool_init( owned_pool_t * pool, size_t element_size, size_t num_elements, allocator_t * allocator )
+{
+	if ( pool )
+	{
+		pool_init( &pool->pool, element_size, num_elements, allocator );
+		pool->owner = pthread_self( );
+		pool->remote = 0;
+	}
+}
+
+
+/**
+ * owned_pool_cleanup
+ *
+ * Releases the underlying memory of the given owned_pool_t object (the owned_pool_t
+ * object itself is not released).
+ *
+ */
+void owned_pool_cleanup( owned_pool_t * pool )
+{
+	if ( pool )
+	{
+		pool_cleanup( &pool->pool );
+		pool->remote = 0;
+
+		/* Note that the allocator is deliberately retained for owned_pool_delete */
+	}
+}
+
+
+/**
+ * owned_pool_claim
+ *
+ * Makes the calling thread the owner of the pool.
+ *
+ */
+void owned_pool_claim( owned_pool_t * pool )
+{
+	if ( pool )
+	{
+		pool->owner = pthread_self( );
+	}
+}
+
+
+/**
+ * owned_pool_is_owner
+ *
+ * Returns 1 if the calling thread owns the pool, 0 otherwise.
+ *
+ */
+int owned_pool_is_owner( owned_pool_t * pool )
+{
+	return pool && pthread_equal( pthread_self( ), pool->owner );
+}
+
+
+/**
+ * owned_pool_take
+ *
+ * Takes an element from the owner's free list, and only once that is empty takes
+ * over the list of remote frees as the new free list - as both lists are linked in
+ * the same way, this needs just a single atomic exchange however long the list is.
+ *
+ */
+void * owned_pool_take( owned_pool_t * pool )
+{
+	void * element;
+
+	if ( !pool )
+	{
+		return 0;
+	}
+
+	element = pool_take( &pool->pool );
+	if ( !element && ATOMIC_LOAD_RELAXED( &pool->remote ) )
+	{
+		pool->pool.next = ATOMIC_EXCHANGE_ACQUIRE( &pool->remote, ( int8_t * ) 0 );
+		element = pool_take( &pool->pool );
+	}
+
+	return element;
+}
+
+
+/**
+ * owned_pool_return
+ *
+ * Returns an element to the owner's free list if called by the owner, or pushes it
+ * onto the list of remote frees otherwise.
+ *
+ */
+void owned_pool_return( owned_pool_t * pool, void * address )
+{
+	int8_t * head;
+
+	if ( !pool || !address )
+	{
+		return;
+	}
+
+	if ( pthread_equal( pthread_self( ), pool->owner ) )
+	{
+		pool_return( &pool->pool, address );
+		return;
+	}
+
+	/* The buffer cannot change under us - the pool cannot be trimmed while this
+	 * element is still outstanding */
+	if ( !_owned_pool_contains( pool, address ) )
+	{
+		return;
+	}
+
+	head = ATOMIC_LOAD_RELAXED( &pool->remote );
+	do
+	{
+		*( ( int8_t ** ) address ) = head;
+	}
+	while ( !ATOMIC_COMPARE_EXCHANGE_ACQ_REL( &pool->remote, &head, ( int8_t * ) address ) );
+}
+
+
+/**
+ * owned_pool_reclaim
+ *
+ * Moves every element returned by other threads back onto the owner's free list,
+ * returning the number of elements reclaimed.
+ *
+ */
+size_t owned_pool_reclaim( owned_pool_t * pool )
+{
+	int8_t * list, * tail;
+	size_t count = 1;
+
+	if ( !pool || !ATOMIC_LOAD_RELAXED( &pool->remote ) )
+	{
+		return 0;
+	}
+
+	/* Only the owner removes elements from the remote list, so it cannot have
+	 * become empty since the check above */
+	list = ATOMIC_EXCHANGE_ACQUIRE( &pool->remote, ( int8_t * ) 0 );
+	for ( tail = list; *( ( int8_t ** ) tail ); tail = *( ( int8_t ** ) tail ) )
+	{
+		++count;
+	}
+
+	*( ( int8_t ** ) tail ) = pool->pool.next;
+	pool->pool.next = list;
+	return count;
+}
+
+
+/**
+ * owned_pool_is_empty
+ *
+ * Returns 1 if there are no more elements available in the pool, including any
+ * returned by other threads, or 0 otherwise.
+ *
+ */
+int owned_pool_is_empty( owned_pool_t * pool )
+{
+	if ( !pool )
+	{
+		return 1;
+	}
+
+	return pool_is_empty( &pool->pool ) && !ATOMIC_LOAD_RELAXED( &pool->remote );
+}
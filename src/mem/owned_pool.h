@@ -0,0 +1,147 @@
+#ifndef __MEM_OWNED_POOL_H
+#define __MEM_OWNED_POOL_H
+
+#include <pthread.h>
+#include "pool.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * owned_pool_t
+ *
+ * A pool_t owned by a single thread, which takes elements from and returns elements
+ * to the pool without any synchronisation. Any other thread may return elements to
+ * the pool too - these are pushed onto a lock-free list of remote frees, which the
+ * owner reclaims in bulk once its own free list runs out.
+ *
+ */
+typedef struct owned_pool_t
+{
+	/* The pool itself, touched only by the owning thread */
+	pool_t pool;
+
+	/* The thread that owns the pool */
+	pthread_t owner;
+
+	/* Keeps the remote list below off the cache line(s) written by the owner */
+	int8_t padding[ POOL_CACHE_LINE_SIZE ];
+
+	/* The elements returned by other threads since the owner last reclaimed them,
+	 * linked through their first pointer as in the pool's own free list */
+	int8_t * remote;
+
+} owned_pool_t;
+
+
+/**
+ * owned_pool_new
+ *
+ * Allocate a new owned_pool_t object using the given allocator, and initialise it
+ * as with owned_pool_init. Should call owned_pool_delete to release the
+ * owned_pool_t object, and its underlying memory.
+ *
+ */
+owned_pool_t * owned_pool_new( size_t element_size, size_t num_elements, allocator_t * allocator );
+
+
+/**
+ * owned_pool_delete
+ *
+ * Releases the given owned_pool_t object and its underlying memory. Use this
+ * function to release an owned_pool_t object created with owned_pool_new.
+ *
+ */
+void owned_pool_delete( owned_pool_t * pool );
+
+
+/**
+ * owned_pool_init
+ *
+ * Initialises the given owned_pool_t object as with pool_init, owned by the calling
+ * thread. Should call owned_pool_cleanup to release the underlying memory.
+ *
+ */
+void owned_pool_init( owned_pool_t * pool, size_t element_size, size_t num_elements, allocator_t * allocator );
+
+
+/**
+ * owned_pool_cleanup
+ *
+ * Releases the underlying memory of the given owned_pool_t object (the owned_pool_t
+ * object itself is not released). Use this function to clean up an owned_pool_t
+ * object that was initialised with the owned_pool_init function.
+ *
+ */
+void owned_pool_cleanup( owned_pool_t * pool );
+
+
+/**
+ * owned_pool_claim
+ *
+ * Makes the calling thread the owner of the pool. The previous owner must no longer
+ * be using the pool, and must hand it over with suitable synchronisation (e.g. a
+ * mutex or a thread join).
+ *
+ */
+void owned_pool_claim( owned_pool_t * pool );
+
+
+/**
+ * owned_pool_is_owner
+ *
+ * Returns 1 if the calling thread owns the pool, 0 otherwise.
+ *
+ */
+int owned_pool_is_owner( owned_pool_t * pool );
+
+
+/**
+ * owned_pool_take
+ *
+ * Takes an element from the pool, returning null if the pool is empty. Must only be
+ * called by the owning thread. Elements are taken from the owner's free list, and
+ * only once that is empty are elements returned by other threads reclaimed.
+ *
+ */
+void * owned_pool_take( owned_pool_t * pool );
+
+
+/**
+ * owned_pool_return
+ *
+ * Returns an element to the pool. May be called by any thread - the owner returns
+ * the element directly to its free list, and any other thread pushes it onto the
+ * list of remote frees. Addresses outside of the pool are ignored.
+ *
+ */
+void owned_pool_return( owned_pool_t * pool, void * address );
+
+
+/**
+ * owned_pool_reclaim
+ *
+ * Moves every element returned by other threads back onto the owner's free list,
+ * returning the number of elements reclaimed. Must only be called by the owning
+ * thread (owned_pool_take does so automatically when the free list is empty).
+ *
+ */
+size_t owned_pool_reclaim( owned_pool_t * pool );
+
+
+/**
+ * owned_pool_is_empty
+ *
+ * Returns 1 if there are no more elements available in the pool, including any
+ * returned by other threads, or 0 otherwise.
+ *
+ */
+int owned_pool_is_empty( owned_pool_t * pool );
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+#endif /* __MEM_OWNED_POOL_H */
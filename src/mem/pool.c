@@ -1,15 +1,68 @@
+#define LIBMEM_INLINE
 #include "pool.h"
 
 
+/* Allocates the buffer for the given pool, whose size, element size and alignment
+ * have already been computed, and threads its elements onto the free list. Returns
+ * 1 on success, or 0 if the buffer could not be allocated */
+static int _pool_allocate( pool_t * pool )
+{
+	int8_t * current, * last;
+
+	pool->block = ( int8_t * ) allocator_alloc(
+		pool->size + ( pool->alignment - 1 ),
+		pool->allocator
+	);
+
+	if ( !pool->block )
+	{
+		return 0;
+	}
+
+	pool->buffer = pool->block;
+	if ( ( size_t ) pool->block % pool->alignment )
+	{
+		pool->buffer += pool->alignment - ( ( size_t ) pool->block % pool->alignment );
+	}
+
+	pool->next = pool->buffer;
+
+	current = pool->buffer;
+	last = current + pool->size - pool->element_size;
+
+	while ( current < last )
+	{
+		*( ( int8_t ** ) current ) = current + pool->element_size;
+		current += pool->element_size;
+	}
+
+	*( ( int8_t ** ) last ) = 0;
+	return 1;
+}
+
+
+
 /* Allocates a pool_t structure and initialises it with capacity for the given
  * number of element of the given size, using the given allocator. The returned
  * pool should be passed to pool_delete once it is no longer needed */
 pool_t * pool_new( size_t element_size, size_t num_elements, allocator_t * allocator )
+{
+	return pool_new_aligned( element_size, num_elements, 0, allocator );
+}
+
+
+/* As pool_new, but lays the pool out as described by pool_init_aligned */
+pool_t * pool_new_aligned(
+	size_t element_size,
+	size_t num_elements,
+	size_t alignment,
+	allocator_t * allocator
+)
 {
 	pool_t * result = ( pool_t * ) allocator_alloc( sizeof( pool_t ), allocator );
 	if ( result )
 	{
-		pool_init( result, element_size, num_elements, allocator );
+		pool_init_aligned( result, element_size, num_elements, alignment, allocator );
 	}
 	return result;
 }
@@ -40,41 +93,74 @@ void pool_delete( pool_t * pool )
  * can distinguish between a legitimately initialised pool and a garbage pool).
  */
 void pool_init( pool_t * pool, size_t element_size, size_t num_elements, allocator_t * allocator )
+{
+	pool_init_aligned( pool, element_size, num_elements, 0, allocator );
+}
+
+
+/* As pool_init, but both the beginning of the buffer and every element within it
+ * are aligned to the given number of bytes (which should be a power of two). Each
+ * element is padded up to a multiple of the alignment, so passing POOL_CACHE_LINE_SIZE
+ * places every element on its own cache line(s). An alignment of zero is equivalent
+ * to calling pool_init */
+void pool_init_aligned(
+	pool_t * pool,
+	size_t element_size,
+	size_t num_elements,
+	size_t alignment,
+	allocator_t * allocator
+)
 {
 	if ( pool && allocator )
 	{
-		if ( element_size && num_elements )
+		pool->buffer = pool->block = pool->next = 0;
+		pool->size = 0;
+		pool->element_size = 0;
+		pool->alignment = 1;
+		pool->trimmed = 0;
+		pool->allocator = allocator;
+
+		if ( !element_size || !num_elements )
 		{
-			if ( element_size < sizeof( int8_t * ) )
-			{
-				element_size = sizeof( int8_t * );
-			}
+			return;
+		}
 
-			pool->size = element_size * num_elements;
-			pool->buffer = allocator_alloc( pool->size, allocator );
-			pool->next = pool->buffer;
+		/* Each free element holds a pointer to the next free element */
+		if ( element_size < sizeof( int8_t * ) )
+		{
+			element_size = sizeof( int8_t * );
+		}
 
-			if ( pool->buffer )
+		/* Pad each element out to the requested alignment, and reserve enough
+		 * additional space to shift the beginning of the buffer onto the same
+		 * boundary */
+		if ( alignment > 1 )
+		{
+			if ( element_size % alignment )
 			{
-				int8_t * current = pool->buffer;
-				int8_t * last = current + pool->size - element_size;
-
-				while ( current < last )
-				{
-					*( ( int8_t ** ) current ) = current + element_size;
-					current += element_size;
-				}
-
-				*( ( int8_t ** ) last ) = 0;
+				element_size += alignment - ( element_size % alignment );
 			}
 		}
 		else
 		{
-			pool->buffer = pool->next = 0;
-			pool->size = 0;
+			alignment = 1;
 		}
 
-		pool->allocator = allocator;
+		/* Give up (leaving a valid empty pool) if the size computation overflows */
+		if ( num_elements > ( ( size_t ) -1 - ( alignment - 1 ) ) / element_size )
+		{
+			return;
+		}
+
+		pool->size = element_size * num_elements;
+		pool->element_size = element_size;
+		pool->alignment = alignment;
+
+		if ( !_pool_allocate( pool ) )
+		{
+			pool->size = 0;
+			pool->element_size = 0;
+		}
 	}
 }
 
@@ -85,14 +171,17 @@ void pool_cleanup( pool_t * pool )
 {
 	if ( pool )
 	{
-		if ( pool->buffer && pool->allocator )
+		if ( pool->block && pool->allocator )
 		{
-			allocator_free( pool->buffer, pool->allocator );
+			allocator_free( pool->block, pool->allocator );
 		}
 
 		pool->buffer = 0;
+		pool->block = 0;
 		pool->next = 0;
 		pool->size = 0;
+		pool->element_size = 0;
+		pool->trimmed = 0;
 
 		/* Note we're deliberately not resetting pool->allocator here such
 		 * that if pool_delete is called afterwards, the allocator is still
@@ -103,32 +192,43 @@ void pool_cleanup( pool_t * pool )
 }
 
 
-/* Take an unused element from the pool and returns a pointer to it */
-void * pool_take( pool_t * pool )
+/* Take an unused element from the pool and returns a pointer to it. The name is
+ * parenthesised (here and below) such that it is not replaced by the LIBMEM_INLINE
+ * macro of the same name */
+void * ( pool_take )( pool_t * pool )
 {
-	if ( pool && pool->next )
+	int8_t * result;
+
+	if ( !pool )
+	{
+		return 0;
+	}
+
+	/* Reallocate the buffer of a trimmed pool */
+	if ( !pool->next && pool->trimmed )
 	{
-		int8_t * result = pool->next;
-		pool->next = *( ( int8_t ** ) pool->next );
-		return result;
+		pool->size = pool->trimmed;
+		if ( !_pool_allocate( pool ) )
+		{
+			pool->size = 0;
+			return 0;
+		}
+		pool->trimmed = 0;
 	}
 
-	return 0;
+	result = pool->next;
+	if ( result )
+	{
+		pool->next = *( ( int8_t ** ) result );
+	}
+	return result;
 }
 
 
 /* Return an element to the pool */
-void pool_return( pool_t * pool, void * address )
+void ( pool_return )( pool_t * pool, void * address )
 {
-	if ( pool && address )
-	{
-		void * end = ( ( int8_t * ) pool->buffer ) + pool->size;
-		if ( address >= ( ( void * ) pool->buffer ) && address < end )
-		{
-			*( ( int8_t ** ) address ) = pool->next;
-			pool->next = ( int8_t * ) address;
-		}
-	}
+	pool_return_inline( pool, address );
 }
 
 
@@ -137,7 +237,7 @@ int pool_is_empty( pool_t * pool )
 {
 	if ( pool )
 	{
-		if ( pool->next )
+		if ( pool->next || pool->trimmed )
 		{
 			return 0;
 		}
@@ -145,3 +245,36 @@ int pool_is_empty( pool_t * pool )
 
 	return 1;
 }
+
+
+/* If every element of the given pool is free, releases the pool's buffer back to
+ * its allocator - the buffer is reallocated when an element is next taken. Returns
+ * the number of bytes released (0 if any element is still in use) */
+size_t pool_trim( pool_t * pool )
+{
+	size_t free_bytes = 0, released;
+	int8_t * current;
+
+	if ( !pool || !pool->block || !pool->allocator )
+	{
+		return 0;
+	}
+
+	for ( current = pool->next; current; current = *( ( int8_t ** ) current ) )
+	{
+		free_bytes += pool->element_size;
+	}
+
+	if ( free_bytes != pool->size )
+	{
+		return 0;
+	}
+
+	released = pool->size + ( pool->alignment - 1 );
+	allocator_free( pool->block, pool->allocator );
+
+	pool->trimmed = pool->size;
+	pool->buffer = pool->block = pool->next = 0;
+	pool->size = 0;
+	return released;
+}
@@ -8,18 +8,39 @@
 extern "C" {
 #endif
 
+/* The cache line size assumed when laying out pools with pool_init_aligned. Pass
+ * this as the alignment to give every element its own cache line(s), such that
+ * elements used by different threads never share a line */
+#ifndef POOL_CACHE_LINE_SIZE
+#define POOL_CACHE_LINE_SIZE 64
+#endif
+
 /* A fixed-size pool of fixed-size, fixed-address objects */
 typedef struct pool_t
 {
 	/* A pointer to the beginning of the buffer */
 	int8_t * buffer;
 
+	/* A pointer to the block of memory returned by the allocator. This differs from
+	 * the buffer above only when the buffer has been aligned */
+	int8_t * block;
+
 	/* A pointer to the next free element in the buffer */
 	int8_t * next;
 
 	/* The total size of the buffer in bytes */
 	size_t size;
 
+	/* The distance in bytes between consecutive elements in the buffer */
+	size_t element_size;
+
+	/* The alignment of the buffer and its elements (1 if unaligned) */
+	size_t alignment;
+
+	/* The size of the buffer released by pool_trim, which is reallocated by the
+	 * next call to pool_take (0 if the pool has not been trimmed) */
+	size_t trimmed;
+
 	/* A pointer to the allocator that was used to allocate the above buffer */
 	allocator_t * allocator;
 
@@ -30,6 +51,14 @@ typedef struct pool_t
  * pool should be passed to pool_delete once it is no longer needed */
 pool_t * pool_new( size_t element_size, size_t num_elements, allocator_t * allocator );
 
+/* As pool_new, but lays the pool out as described by pool_init_aligned */
+pool_t * pool_new_aligned(
+	size_t element_size,
+	size_t num_elements,
+	size_t alignment,
+	allocator_t * allocator
+);
+
 /* Releases the given pool_t structure and the resources it consumes. This function
  * should be used to release a pool returned by pool_new */
 void pool_delete( pool_t * pool );
@@ -47,11 +76,25 @@ void pool_delete( pool_t * pool );
  */
 void pool_init( pool_t * pool, size_t element_size, size_t num_elements, allocator_t * allocator );
 
+/* As pool_init, but both the beginning of the buffer and every element within it
+ * are aligned to the given number of bytes (which should be a power of two). Each
+ * element is padded up to a multiple of the alignment, so passing POOL_CACHE_LINE_SIZE
+ * places every element on its own cache line(s). An alignment of zero is equivalent
+ * to calling pool_init */
+void pool_init_aligned(
+	pool_t * pool,
+	size_t element_size,
+	size_t num_elements,
+	size_t alignment,
+	allocator_t * allocator
+);
+
 /* Releases the underlying memory used by the given pool_t object. Use this function
  * to release the underlying resources for a pool initialised by pool_init */
 void pool_cleanup( pool_t * pool );
 
-/* Take an unused element from the pool and returns a pointer to it */
+/* Take an unused element from the pool and returns a pointer to it. If the pool
+ * has been trimmed, its buffer is reallocated first (returning null on failure) */
 void * pool_take( pool_t * pool );
 
 /* Return an element to the pool */
@@ -60,6 +103,49 @@ void pool_return( pool_t * pool, void * address );
 /* Return 1 if there are no more free elements in the pool to return, or 0 otherwise */
 int pool_is_empty( pool_t * pool );
 
+/* If every element of the given pool is free, releases the pool's buffer back to
+ * its allocator - the buffer is reallocated when an element is next taken. Returns
+ * the number of bytes released (0 if any element is still in use).
+ *
+ * Note this walks the pool's free list, so takes time proportional to the number
+ * of free elements */
+size_t pool_trim( pool_t * pool );
+
+#if defined(LIBMEM_INLINE)
+
+/* Header-inline equivalent of pool_take (see LIBMEM_INLINE) */
+MEM_INLINE void * pool_take_inline( pool_t * pool )
+{
+	if ( pool && pool->next )
+	{
+		int8_t * result = pool->next;
+		pool->next = *( ( int8_t ** ) pool->next );
+		return result;
+	}
+
+	/* Leave a trimmed pool to the out-of-line function */
+	return ( pool_take )( pool );
+}
+
+/* Header-inline equivalent of pool_return (see LIBMEM_INLINE) */
+MEM_INLINE void pool_return_inline( pool_t * pool, void * address )
+{
+	if ( pool && address )
+	{
+		void * end = ( ( int8_t * ) pool->buffer ) + pool->size;
+		if ( address >= ( ( void * ) pool->buffer ) && address < end )
+		{
+			*( ( int8_t ** ) address ) = pool->next;
+			pool->next = ( int8_t * ) address;
+		}
+	}
+}
+
+#define pool_take( pool ) pool_take_inline( pool )
+#define pool_return( pool, address ) pool_return_inline( pool, address )
+
+#endif /* LIBMEM_INLINE */
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif
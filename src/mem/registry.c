@@ -0,0 +1,556 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <string.h>
+
+#include "registry.h"
+#include "io.h"
+
+
+/* The list of registered entries, and the lock guarding it */
+static registry_entry_t * _registry_entries = 0;
+static pthread_mutex_t _registry_lock;
+static pthread_once_t _registry_lock_once = PTHREAD_ONCE_INIT;
+
+
+/**
+ * _registry_snapshot_t
+ *
+ * A registered entry as captured by registry_format, such that it can be formatted
+ * without holding the lock.
+ *
+ */
+typedef struct _registry_snapshot_t
+{
+	const char * name;
+	const char * type;
+	registry_stats_t stats;
+} _registry_snapshot_t;
+
+
+/**
+ * _registry_metrics
+ *
+ * The name and description of each statistic, in the order of the fields of
+ * registry_stats_t.
+ *
+ */
+static const char * const _registry_metrics[][ 2 ] =
+{
+	{ "bytes_in_use", "Bytes currently in use." },
+	{ "bytes_peak", "Maximum bytes ever in use." },
+	{ "bytes_capacity", "Bytes the object can hold, or may use." },
+	{ "elements_in_use", "Elements currently in use." },
+	{ "elements", "Elements the object can hold." }
+};
+
+#define _REGISTRY_NUM_METRICS ( sizeof( _registry_metrics ) / sizeof( _registry_metrics[ 0 ] ) )
+
+
+/**
+ * _registry_lock_init
+ *
+ * Initialises the lock guarding the list of entries as an error checking mutex,
+ * such that a stats function calling back into the registry from within
+ * registry_format is refused, rather than deadlocking.
+ *
+ */
+static void _registry_lock_init( void )
+{
+	pthread_mutexattr_t attributes;
+
+	pthread_mutexattr_init( &attributes );
+	pthread_mutexattr_settype( &attributes, PTHREAD_MUTEX_ERRORCHECK );
+	pthread_mutex_init( &_registry_lock, &attributes );
+	pthread_mutexattr_destroy( &attributes );
+}
+
+
+/**
+ * _registry_lock_acquire
+ *
+ * Locks the list of entries, returning 1 on success, or 0 if the calling thread
+ * already holds the lock (i.e. it is running a stats function).
+ *
+ */
+static int _registry_lock_acquire( void )
+{
+	pthread_once( &_registry_lock_once, _registry_lock_init );
+	return pthread_mutex_lock( &_registry_lock ) == 0;
+}
+
+
+/**
+ * _registry_stat
+ *
+ * Returns the statistic with the given index.
+ *
+ */
+static size_t _registry_stat( registry_stats_t * stats, size_t index )
+{
+	switch ( index )
+	{
+	case 0: return stats->bytes_in_use;
+	case 1: return stats->bytes_peak;
+	case 2: return stats->bytes_capacity;
+	case 3: return stats->elements_in_use;
+	default: return stats->elements;
+	}
+}
+
+
+/**
+ * _registry_stats_counted / _registry_stats_budget / _registry_stats_pool /
+ * _registry_stats_buffer
+ *
+ * registry_stats_function_t adapters for the built-in types.
+ *
+ */
+static void _registry_stats_counted( void * object, registry_stats_t * stats )
+{
+	allocator_counted_t * allocator = ( allocator_counted_t * ) object;
+	stats->bytes_in_use = allocator_counted_get_current_count( allocator );
+	stats->bytes_peak = allocator_counted_get_peak_count( allocator );
+}
+
+static void _registry_stats_budget( void * object, registry_stats_t * stats )
+{
+	allocator_budget_t * allocator = ( allocator_budget_t * ) object;
+	stats->bytes_in_use = allocator_budget_get_current_count( allocator );
+	stats->bytes_peak = allocator_budget_get_peak_count( allocator );
+	if ( allocator->hard_limit )
+	{
+		stats->bytes_capacity = allocator->hard_limit;
+	}
+}
+
+static void _registry_stats_pool( void * object, registry_stats_t * stats )
+{
+	pool_t * pool = ( pool_t * ) object;
+	size_t free_elements = 0;
+	int8_t * current;
+
+	/* Empty pools (no elements, a failed allocation or cleaned up) have no element
+	 * size to divide by */
+	if ( !pool->element_size )
+	{
+		stats->elements = stats->elements_in_use = 0;
+		stats->bytes_capacity = stats->bytes_in_use = 0;
+		return;
+	}
+
+	for ( current = pool->next; current; current = *( ( int8_t ** ) current ) )
+	{
+		++free_elements;
+	}
+
+	stats->elements = ( pool->trimmed ? pool->trimmed : pool->size ) / pool->element_size;
+	stats->elements_in_use = pool->trimmed ? 0 : stats->elements - free_elements;
+	stats->bytes_capacity = stats->elements * pool->element_size;
+	stats->bytes_in_use = stats->elements_in_use * pool->element_size;
+}
+
+static void _registry_stats_buffer( void * object, registry_stats_t * stats )
+{
+	buffer_t * buffer = ( buffer_t * ) object;
+	stats->bytes_in_use = buffer_data_length( buffer );
+	stats->bytes_capacity = buffer_capacity( buffer );
+}
+
+
+/**
+ * _registry_append
+ *
+ * Appends the given string to the output.
+ *
+ */
+static void _registry_append( buffer_t * output, const char * text )
+{
+	buffer_append( output, strlen( text ), ( void * ) text );
+}
+
+
+/**
+ * _registry_append_number
+ *
+ * Appends the given number to the output, in decimal.
+ *
+ */
+static void _registry_append_number( buffer_t * output, size_t value )
+{
+	char text[ 32 ];
+	sprintf( text, "%lu", ( unsigned long ) value );
+	_registry_append( output, text );
+}
+
+
+/**
+ * _registry_append_quoted
+ *
+ * Appends the given string to the output in double quotes, escaping it as required
+ * by JSON strings and Prometheus label values.
+ *
+ */
+static void _registry_append_quoted( buffer_t * output, const char * text, int format )
+{
+	_registry_append( output, "\"" );
+
+	for ( ; text && *text; ++text )
+	{
+		char escape[ 8 ];
+		unsigned char c = ( unsigned char ) *text;
+
+		if ( c == '"' || c == '\\' )
+		{
+			sprintf( escape, "\\%c", c );
+		}
+		else if ( c == '\n' )
+		{
+			strcpy( escape, "\\n" );
+		}
+		else if ( c < 0x20 && format == REGISTRY_JSON )
+		{
+			sprintf( escape, "\\u%04x", c );
+		}
+		else
+		{
+			escape[ 0 ] = ( char ) c;
+			escape[ 1 ] = 0;
+		}
+
+		_registry_append( output, escape );
+	}
+
+	_registry_append( output, "\"" );
+}
+
+
+/**
+ * _registry_format_json
+ *
+ * Appends the given snapshot of the entries and their statistics to the output as
+ * JSON.
+ *
+ */
+static void _registry_format_json( buffer_t * output, _registry_snapshot_t * entries, size_t count )
+{
+	_registry_snapshot_t * entry;
+	size_t metric;
+
+	_registry_append( output, "[" );
+
+	for ( entry = entries; entry < entries + count; ++entry )
+	{
+		_registry_append( output, entry == entries ? "\n\t{ \"name\": " : ",\n\t{ \"name\": " );
+		_registry_append_quoted( output, entry->name, REGISTRY_JSON );
+		_registry_append( output, ", \"type\": " );
+		_registry_append_quoted( output, entry->type, REGISTRY_JSON );
+
+		for ( metric = 0; metric < _REGISTRY_NUM_METRICS; ++metric )
+		{
+			if ( _registry_stat( &entry->stats, metric ) != REGISTRY_UNKNOWN )
+			{
+				_registry_append( output, ", \"" );
+				_registry_append( output, _registry_metrics[ metric ][ 0 ] );
+				_registry_append( output, "\": " );
+				_registry_append_number( output, _registry_stat( &entry->stats, metric ) );
+			}
+		}
+
+		_registry_append( output, " }" );
+	}
+
+	_registry_append( output, count ? "\n]\n" : "]\n" );
+}
+
+
+/**
+ * _registry_format_prometheus
+ *
+ * Appends the given snapshot of the entries and their statistics to the output in
+ * the Prometheus text exposition format.
+ *
+ */
+static void _registry_format_prometheus( buffer_t * output, _registry_snapshot_t * entries, size_t count )
+{
+	_registry_snapshot_t * entry;
+	size_t metric;
+
+	for ( metric = 0; metric < _REGISTRY_NUM_METRICS; ++metric )
+	{
+		_registry_append( output, "# HELP libmem_" );
+		_registry_append( output, _registry_metrics[ metric ][ 0 ] );
+		_registry_append( output, " " );
+		_registry_append( output, _registry_metrics[ metric ][ 1 ] );
+		_registry_append( output, "\n# TYPE libmem_" );
+		_registry_append( output, _registry_metrics[ metric ][ 0 ] );
+		_registry_append( output, " gauge\n" );
+
+		for ( entry = entries; entry < entries + count; ++entry )
+		{
+			size_t value = _registry_stat( &entry->stats, metric );
+			if ( value == REGISTRY_UNKNOWN )
+			{
+				continue;
+			}
+
+			_registry_append( output, "libmem_" );
+			_registry_append( output, _registry_metrics[ metric ][ 0 ] );
+			_registry_append( output, "{name=" );
+			_registry_append_quoted( output, entry->name, REGISTRY_PROMETHEUS );
+			_registry_append( output, ",type=" );
+			_registry_append_quoted( output, entry->type, REGISTRY_PROMETHEUS );
+			_registry_append( output, "} " );
+			_registry_append_number( output, value );
+			_registry_append( output, "\n" );
+		}
+	}
+}
+
+
+/**
+ * registry_entry_init
+ *
+ * Initialises the given entry to report the given object, of the given type, under
+ * the given name by calling the given function.
+ *
+ */
+void registry_entry_init(
+	registry_entry_t * entry,
+	const char * name,
+	const char * type,
+	registry_stats_function_t stats,
+	void * object
+)
+{
+	if ( entry )
+	{
+		entry->name = name;
+		entry->type = type;
+		entry->stats = stats;
+		entry->object = object;
+		entry->prev = entry->next = 0;
+	}
+}
+
+
+/**
+ * registry_entry_init_counted
+ *
+ * Initialises the given entry to report the given counted allocator.
+ *
+ */
+void registry_entry_init_counted( registry_entry_t * entry, const char * name, allocator_counted_t * allocator )
+{
+	registry_entry_init( entry, name, "counted", _registry_stats_counted, allocator );
+}
+
+
+/**
+ * registry_entry_init_budget
+ *
+ * Initialises the given entry to report the given budget allocator.
+ *
+ */
+void registry_entry_init_budget( registry_entry_t * entry, const char * name, allocator_budget_t * allocator )
+{
+	registry_entry_init( entry, name, "budget", _registry_stats_budget, allocator );
+}
+
+
+/**
+ * registry_entry_init_pool
+ *
+ * Initialises the given entry to report the given pool.
+ *
+ */
+void registry_entry_init_pool( registry_entry_t * entry, const char * name, pool_t * pool )
+{
+	registry_entry_init( entry, name, "pool", _registry_stats_pool, pool );
+}
+
+
+/**
+ * registry_entry_init_buffer
+ *
+ * Initialises the given entry to report the given buffer.
+ *
+ */
+void registry_entry_init_buffer( registry_entry_t * entry, const char * name, buffer_t * buffer )
+{
+	registry_entry_init( entry, name, "buffer", _registry_stats_buffer, buffer );
+}
+
+
+/**
+ * registry_register
+ *
+ * Adds the given entry to the registry.
+ *
+ */
+void registry_register( registry_entry_t * entry )
+{
+	if ( entry && _registry_lock_acquire( ) )
+	{
+		entry->prev = 0;
+		entry->next = _registry_entries;
+		if ( _registry_entries )
+		{
+			_registry_entries->prev = entry;
+		}
+		_registry_entries = entry;
+
+		pthread_mutex_unlock( &_registry_lock );
+	}
+}
+
+
+/**
+ * registry_unregister
+ *
+ * Removes the given entry from the registry.
+ *
+ */
+void registry_unregister( registry_entry_t * entry )
+{
+	if ( entry && _registry_lock_acquire( ) )
+	{
+		if ( entry->prev )
+		{
+			entry->prev->next = entry->next;
+		}
+		else if ( _registry_entries == entry )
+		{
+			_registry_entries = entry->next;
+		}
+
+		if ( entry->next )
+		{
+			entry->next->prev = entry->prev;
+		}
+
+		entry->prev = entry->next = 0;
+
+		pthread_mutex_unlock( &_registry_lock );
+	}
+}
+
+
+/**
+ * registry_format
+ *
+ * Appends a snapshot of the statistics of every registered entry, in the given
+ * format, to the given buffer. Returns the number of bytes appended.
+ *
+ */
+size_t registry_format( buffer_t * output, int format )
+{
+	size_t length = buffer_data_length( output );
+	registry_entry_t * entry;
+	buffer_t snapshot;
+	size_t count;
+
+	if ( !output || !_registry_lock_acquire( ) )
+	{
+		return 0;
+	}
+
+	/* Read every object's statistics before formatting any, for consistency, but
+	 * leave the formatting itself until the lock has been released */
+	buffer_init( &snapshot, allocator_default( ) );
+	for ( entry = _registry_entries; entry; entry = entry->next )
+	{
+		_registry_snapshot_t record;
+		record.name = entry->name;
+		record.type = entry->type;
+		record.stats.bytes_in_use = record.stats.bytes_peak = record.stats.bytes_capacity = REGISTRY_UNKNOWN;
+		record.stats.elements_in_use = record.stats.elements = REGISTRY_UNKNOWN;
+
+		if ( entry->stats )
+		{
+			entry->stats( entry->object, &record.stats );
+		}
+
+		if ( !buffer_append( &snapshot, sizeof( record ), &record ) )
+		{
+			break;
+		}
+	}
+
+	pthread_mutex_unlock( &_registry_lock );
+
+	if ( !entry )
+	{
+		count = buffer_data_length( &snapshot ) / sizeof( _registry_snapshot_t );
+		if ( format == REGISTRY_PROMETHEUS )
+		{
+			_registry_format_prometheus( output, ( _registry_snapshot_t * ) buffer_data_pointer( &snapshot ), count );
+		}
+		else
+		{
+			_registry_format_json( output, ( _registry_snapshot_t * ) buffer_data_pointer( &snapshot ), count );
+		}
+	}
+
+	buffer_cleanup( &snapshot );
+
+	return buffer_data_length( output ) - length;
+}
+
+
+/**
+ * registry_dump
+ *
+ * Writes a snapshot of the registry, in the given format, to the given file.
+ * Returns the number of bytes written.
+ *
+ */
+size_t registry_dump( FILE * file, int format )
+{
+	buffer_t output;
+	size_t written = 0;
+
+	if ( !file )
+	{
+		return 0;
+	}
+
+	buffer_init( &output, allocator_default( ) );
+	if ( registry_format( &output, format ) )
+	{
+		written = fwrite( buffer_data_pointer( &output ), 1, buffer_data_length( &output ), file );
+	}
+	buffer_cleanup( &output );
+
+	return written;
+}
+
+
+/**
+ * registry_dump_fd
+ *
+ * Writes a snapshot of the registry, in the given format, to the given file
+ * descriptor. Returns the number of bytes written.
+ *
+ */
+size_t registry_dump_fd( int fd, int format )
+{
+	buffer_t output;
+	size_t written = 0;
+
+	buffer_init( &output, allocator_default( ) );
+	registry_format( &output, format );
+
+	while ( written < buffer_data_length( &output ) )
+	{
+		ssize_t result = buffer_write_fd( &output, fd, written );
+		if ( result <= 0 )
+		{
+			break;
+		}
+		written += ( size_t ) result;
+	}
+
+	buffer_cleanup( &output );
+	return written;
+}
@@ -0,0 +1,232 @@
+#ifndef __MEM_REGISTRY_H
+#define __MEM_REGISTRY_H
+
+#include "allocator_budget.h"
+#include "buffer.h"
+#include "pool.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * REGISTRY_JSON
+ *
+ * Registry format - a JSON array with one object per registered entry, holding its
+ * name, type and known statistics.
+ *
+ */
+#define REGISTRY_JSON 0
+
+
+/**
+ * REGISTRY_PROMETHEUS
+ *
+ * Registry format - the Prometheus text exposition format, with one gauge per
+ * statistic (libmem_bytes_in_use, libmem_bytes_peak, libmem_bytes_capacity,
+ * libmem_elements_in_use and libmem_elements), labelled with each entry's name and
+ * type.
+ *
+ */
+#define REGISTRY_PROMETHEUS 1
+
+
+/**
+ * REGISTRY_UNKNOWN
+ *
+ * The value of a statistic that an object does not track. Unknown statistics are
+ * omitted from the registry's output.
+ *
+ */
+#define REGISTRY_UNKNOWN ( ( size_t ) -1 )
+
+
+/**
+ * registry_stats_t
+ *
+ * The statistics reported for a registered object.
+ *
+ */
+typedef struct registry_stats_t
+{
+	/* The number of bytes currently in use */
+	size_t bytes_in_use;
+
+	/* The maximum number of bytes ever in use */
+	size_t bytes_peak;
+
+	/* The number of bytes the object can hold, or may use */
+	size_t bytes_capacity;
+
+	/* The number of elements currently in use */
+	size_t elements_in_use;
+
+	/* The number of elements the object can hold */
+	size_t elements;
+
+} registry_stats_t;
+
+
+/**
+ * registry_stats_function_t
+ *
+ * Fills in the statistics of the given object. The statistics are initialised to
+ * REGISTRY_UNKNOWN before the function is called.
+ *
+ * The function is called with the registry locked, so must not call back into the
+ * registry - any such call is refused (registering and unregistering have no
+ * effect, and registry_format returns 0).
+ *
+ */
+typedef void ( * registry_stats_function_t )( void * object, registry_stats_t * stats );
+
+
+/**
+ * registry_entry_t
+ *
+ * Registers an object with the registry under a name. Entries are intrusive - the
+ * caller owns the registry_entry_t (typically embedding it alongside the object it
+ * describes), and must keep it and its name alive until it is unregistered.
+ *
+ */
+typedef struct registry_entry_t
+{
+	/* The name the object is registered under */
+	const char * name;
+
+	/* The type of the object (e.g. "pool") */
+	const char * type;
+
+	/* The function that reports the object's statistics */
+	registry_stats_function_t stats;
+
+	/* The object to report */
+	void * object;
+
+	/* The neighbouring entries in the list of registered entries */
+	struct registry_entry_t * prev;
+	struct registry_entry_t * next;
+
+} registry_entry_t;
+
+
+/**
+ * registry_entry_init
+ *
+ * Initialises the given entry to report the given object, of the given type, under
+ * the given name by calling the given function. The entry is not registered until
+ * passed to registry_register.
+ *
+ */
+void registry_entry_init(
+	registry_entry_t * entry,
+	const char * name,
+	const char * type,
+	registry_stats_function_t stats,
+	void * object
+);
+
+
+/**
+ * registry_entry_init_counted
+ *
+ * Initialises the given entry to report the current and peak counts of the given
+ * counted allocator.
+ *
+ */
+void registry_entry_init_counted( registry_entry_t * entry, const char * name, allocator_counted_t * allocator );
+
+
+/**
+ * registry_entry_init_budget
+ *
+ * Initialises the given entry to report the current and peak counts of the given
+ * budget allocator, with its hard limit (if any) as its capacity.
+ *
+ */
+void registry_entry_init_budget( registry_entry_t * entry, const char * name, allocator_budget_t * allocator );
+
+
+/**
+ * registry_entry_init_pool
+ *
+ * Initialises the given entry to report the occupancy of the given pool. Counting
+ * the free elements takes time proportional to their number.
+ *
+ */
+void registry_entry_init_pool( registry_entry_t * entry, const char * name, pool_t * pool );
+
+
+/**
+ * registry_entry_init_buffer
+ *
+ * Initialises the given entry to report the data length and capacity of the given
+ * buffer.
+ *
+ */
+void registry_entry_init_buffer( registry_entry_t * entry, const char * name, buffer_t * buffer );
+
+
+/**
+ * registry_register
+ *
+ * Adds the given entry to the registry. Registering an already registered entry is
+ * not permitted.
+ *
+ */
+void registry_register( registry_entry_t * entry );
+
+
+/**
+ * registry_unregister
+ *
+ * Removes the given entry from the registry. Must be called before the entry, or
+ * the object it describes, is released.
+ *
+ */
+void registry_unregister( registry_entry_t * entry );
+
+
+/**
+ * registry_format
+ *
+ * Appends a snapshot of the statistics of every registered entry, in the given
+ * REGISTRY_* format, to the given buffer. Returns the number of bytes appended.
+ *
+ * The registry is guarded by a lock, so entries may be registered and reported
+ * from any thread - but the objects themselves are not locked, so statistics read
+ * while another thread is using an object may be momentarily inconsistent. The
+ * lock is held only while the statistics are read; the snapshot is formatted after
+ * releasing it, so an entry's name and type must stay valid for as long as a
+ * concurrent registry_format may be formatting it (string literals are simplest).
+ *
+ */
+size_t registry_format( buffer_t * output, int format );
+
+
+/**
+ * registry_dump
+ *
+ * Writes a snapshot of the registry, in the given REGISTRY_* format, to the given
+ * file. Returns the number of bytes written.
+ *
+ */
+size_t registry_dump( FILE * file, int format );
+
+
+/**
+ * registry_dump_fd
+ *
+ * Writes a snapshot of the registry, in the given REGISTRY_* format, to the given
+ * file descriptor (e.g. a socket accepted from a scraper). Returns the number of
+ * bytes written, which is less than the length of the snapshot only on error.
+ *
+ */
+size_t registry_dump_fd( int fd, int format );
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+#endif /* __MEM_REGISTRY_H */
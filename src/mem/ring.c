@@ -0,0 +1,582 @@
+#define _GNU_SOURCE
+
+#include "ring.h"
+#include "internal/atomic.h"
+
+#include <string.h>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+
+/**
+ * _ring_round_capacity
+ *
+ * Rounds the given capacity up to a power of two (returning 0 for a capacity of 0
+ * or on overflow).
+ *
+ */
+static size_t _ring_round_capacity( size_t capacity )
+{
+	size_t result = 1;
+
+	if ( !capacity )
+	{
+		return 0;
+	}
+
+	while ( result < capacity )
+	{
+		result <<= 1;
+		if ( !result )
+		{
+			return 0;
+		}
+	}
+
+	return result;
+}
+
+
+/**
+ * _ring_load
+ *
+ * Reads a position counter that may be written by the other side of an SPSC ring.
+ *
+ */
+static size_t _ring_load( ring_t * ring, size_t * counter )
+{
+	if ( ring->flags & RING_SPSC )
+	{
+		return ATOMIC_LOAD_ACQUIRE( counter );
+	}
+	return *counter;
+}
+
+
+/**
+ * _ring_store
+ *
+ * Publishes a position counter that may be read by the other side of an SPSC ring.
+ *
+ */
+static void _ring_store( ring_t * ring, size_t * counter, size_t value )
+{
+	if ( ring->flags & RING_SPSC )
+	{
+		ATOMIC_STORE_RELEASE( counter, value );
+	}
+	else
+	{
+		*counter = value;
+	}
+}
+
+
+/**
+ * _ring_map_mirrored
+ *
+ * Maps the given number of bytes of shared memory twice, back to back, storing
+ * the address of the first mapping in the ring. Returns 1 on success, 0 otherwise.
+ *
+ */
+static int _ring_map_mirrored( ring_t * ring, size_t capacity )
+{
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+	size_t page_size = ( size_t ) sysconf( _SC_PAGESIZE );
+	int8_t * base;
+	int fd;
+
+	if ( capacity < page_size )
+	{
+		capacity = page_size;
+	}
+
+	if ( capacity > ( ( size_t ) -1 ) / 2 )
+	{
+		return 0;
+	}
+
+	fd = memfd_create( "libmem-ring", MFD_CLOEXEC );
+	if ( fd < 0 )
+	{
+		return 0;
+	}
+
+	if ( ftruncate( fd, ( off_t ) capacity ) != 0 )
+	{
+		close( fd );
+		return 0;
+	}
+
+	/* Reserve enough address space for both mappings, then map the same
+	 * memory over each half of it */
+	base = mmap( 0, 2 * capacity, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+	if ( base == MAP_FAILED )
+	{
+		close( fd );
+		return 0;
+	}
+
+	if ( mmap( base, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0 ) == MAP_FAILED ||
+		mmap( base + capacity, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0 ) == MAP_FAILED )
+	{
+		munmap( base, 2 * capacity );
+		close( fd );
+		return 0;
+	}
+
+	/* The mappings keep the memory alive */
+	close( fd );
+
+	ring->data = base;
+	ring->capacity = capacity;
+	return 1;
+#else
+	( void ) ring;
+	( void ) capacity;
+	return 0;
+#endif
+}
+
+
+/**
+ * _ring_unmap_mirrored
+ *
+ * Releases the mappings created by _ring_map_mirrored.
+ *
+ */
+static void _ring_unmap_mirrored( ring_t * ring )
+{
+#if defined(__linux__)
+	munmap( ring->data, 2 * ring->capacity );
+#else
+	( void ) ring;
+#endif
+}
+
+
+/**
+ * _ring_spans
+ *
+ * Describes the given number of bytes starting at the given position counter as
+ * up to two spans, split where they wrap around the end of the ring.
+ *
+ */
+static size_t _ring_spans( ring_t * ring, size_t position, size_t length, span_t spans[ 2 ] )
+{
+	size_t offset, first;
+
+	if ( !length || !spans )
+	{
+		return 0;
+	}
+
+	offset = position & ( ring->capacity - 1 );
+	first = ring->capacity - offset;
+	if ( ( ring->flags & RING_MIRRORED ) || first > length )
+	{
+		first = length;
+	}
+
+	spans[ 0 ].data = ring->data + offset;
+	spans[ 0 ].length = first;
+	if ( first == length )
+	{
+		return 1;
+	}
+
+	spans[ 1 ].data = ring->data;
+	spans[ 1 ].length = length - first;
+	return 2;
+}
+
+
+/**
+ * ring_new
+ *
+ * Allocate a new ring_t object using the given allocator, and initialise it as
+ * with ring_init. Should call ring_delete to release the ring_t object, and its
+ * underlying memory.
+ *
+ */
+ring_t * ring_new( size_t capacity, int flags, allocator_t * allocator )
+{
+	ring_t * ring = ( ring_t * ) allocator_alloc( sizeof( ring_t ), allocator );
+	if ( ring )
+	{
+		ring_init( ring, capacity, flags, allocator );
+	}
+	return ring;
+}
+
+
+/**
+ * ring_delete
+ *
+ * Releases the given ring_t object and its underlying memory. Use this function
+ * to release a ring_t object created with ring_new.
+ *
+ */
+void ring_delete( ring_t * ring )
+{
+	if ( ring )
+	{
+		allocator_t * allocator = ring->storage.allocator;
+		ring_cleanup( ring );
+		allocator_free( ring, allocator );
+	}
+}
+
+
+/**
+ * ring_init
+ *
+ * Initialises the given ring_t object as an empty ring with room for at least the
+ * given number of bytes (rounded up to a power of two), allocated from the given
+ * allocator. flags is a combination of the RING_* flags. Should call ring_cleanup
+ * to release the underlying memory. If the capacity is 0 or the memory cannot be
+ * allocated, the ring is initialised with zero capacity.
+ *
+ */
+void ring_init( ring_t * ring, size_t capacity, int flags, allocator_t * allocator )
+{
+	if ( !ring )
+	{
+		return;
+	}
+
+	buffer_init( &ring->storage, allocator );
+	ring->data = 0;
+	ring->capacity = 0;
+	ring->read = 0;
+	ring->write = 0;
+	ring->flags = flags;
+
+	capacity = _ring_round_capacity( capacity );
+	if ( !capacity )
+	{
+		return;
+	}
+
+	if ( flags & RING_MIRRORED )
+	{
+		if ( _ring_map_mirrored( ring, capacity ) )
+		{
+			return;
+		}
+		ring->flags &= ~RING_MIRRORED;
+	}
+
+	if ( buffer_grow( &ring->storage, capacity ) == capacity && buffer_data_pointer( &ring->storage ) )
+	{
+		ring->data = ( int8_t * ) buffer_data_pointer( &ring->storage );
+		ring->capacity = capacity;
+	}
+	else
+	{
+		buffer_cleanup( &ring->storage );
+	}
+}
+
+
+/**
+ * ring_cleanup
+ *
+ * Releases the underlying memory of the given ring_t object (the ring_t object
+ * itself is not released). Use this function to clean up a ring_t object that was
+ * initialised with the ring_init function.
+ *
+ */
+void ring_cleanup( ring_t * ring )
+{
+	if ( ring )
+	{
+		if ( ring->data && ( ring->flags & RING_MIRRORED ) )
+		{
+			_ring_unmap_mirrored( ring );
+		}
+
+		/* Note that the storage's allocator is retained for ring_delete */
+		buffer_cleanup( &ring->storage );
+		ring->data = 0;
+		ring->capacity = 0;
+		ring->read = 0;
+		ring->write = 0;
+	}
+}
+
+
+/**
+ * ring_capacity
+ *
+ * Returns the number of bytes the ring can hold.
+ *
+ */
+size_t ring_capacity( ring_t * ring )
+{
+	return ring ? ring->capacity : 0;
+}
+
+
+/**
+ * ring_data_length
+ *
+ * Returns the number of bytes that have been committed but not yet consumed.
+ *
+ */
+size_t ring_data_length( ring_t * ring )
+{
+	if ( !ring )
+	{
+		return 0;
+	}
+	return _ring_load( ring, &ring->write ) - ring->read;
+}
+
+
+/**
+ * ring_space
+ *
+ * Returns the number of bytes that can be committed before the ring is full.
+ *
+ */
+size_t ring_space( ring_t * ring )
+{
+	if ( !ring )
+	{
+		return 0;
+	}
+	return ring->capacity - ( ring->write - _ring_load( ring, &ring->read ) );
+}
+
+
+/**
+ * ring_reserve
+ *
+ * Returns a pointer to the largest contiguous block of free memory at the write
+ * position of the ring, storing its length in the given length pointer.
+ *
+ */
+void * ring_reserve( ring_t * ring, size_t * length )
+{
+	size_t space, offset, contiguous;
+
+	space = ring_space( ring );
+	if ( !space )
+	{
+		if ( length )
+		{
+			*length = 0;
+		}
+		return 0;
+	}
+
+	offset = ring->write & ( ring->capacity - 1 );
+	contiguous = ring->capacity - offset;
+	if ( ( ring->flags & RING_MIRRORED ) || contiguous > space )
+	{
+		contiguous = space;
+	}
+
+	if ( length )
+	{
+		*length = contiguous;
+	}
+	return ring->data + offset;
+}
+
+
+/**
+ * ring_reserve_spans
+ *
+ * Describes all free memory in the ring, starting at the write position, as up to
+ * two spans. Returns the number of spans written to the given array.
+ *
+ */
+size_t ring_reserve_spans( ring_t * ring, span_t spans[ 2 ] )
+{
+	return ring ? _ring_spans( ring, ring->write, ring_space( ring ), spans ) : 0;
+}
+
+
+/**
+ * ring_commit
+ *
+ * Appends the given number of bytes, previously initialised via ring_reserve, to
+ * the data in the ring. Returns the number of bytes committed, which is limited
+ * to the space remaining in the ring.
+ *
+ */
+size_t ring_commit( ring_t * ring, size_t length )
+{
+	size_t space = ring_space( ring );
+	if ( length > space )
+	{
+		length = space;
+	}
+
+	if ( length )
+	{
+		_ring_store( ring, &ring->write, ring->write + length );
+	}
+	return length;
+}
+
+
+/**
+ * ring_peek
+ *
+ * Returns a pointer to the largest contiguous block of data at the read position
+ * of the ring, storing its length in the given length pointer.
+ *
+ */
+void * ring_peek( ring_t * ring, size_t * length )
+{
+	size_t available, offset, contiguous;
+
+	available = ring_data_length( ring );
+	if ( !available )
+	{
+		if ( length )
+		{
+			*length = 0;
+		}
+		return 0;
+	}
+
+	offset = ring->read & ( ring->capacity - 1 );
+	contiguous = ring->capacity - offset;
+	if ( ( ring->flags & RING_MIRRORED ) || contiguous > available )
+	{
+		contiguous = available;
+	}
+
+	if ( length )
+	{
+		*length = contiguous;
+	}
+	return ring->data + offset;
+}
+
+
+/**
+ * ring_peek_spans
+ *
+ * Describes all data in the ring, starting at the read position, as up to two
+ * spans. Returns the number of spans written to the given array.
+ *
+ */
+size_t ring_peek_spans( ring_t * ring, span_t spans[ 2 ] )
+{
+	return ring ? _ring_spans( ring, ring->read, ring_data_length( ring ), spans ) : 0;
+}
+
+
+/**
+ * ring_consume
+ *
+ * Releases the given number of bytes from the read position of the ring, making
+ * the space available to the producer. Returns the number of bytes consumed, which
+ * is limited to the amount of data in the ring.
+ *
+ */
+size_t ring_consume( ring_t * ring, size_t length )
+{
+	size_t available = ring_data_length( ring );
+	if ( length > available )
+	{
+		length = available;
+	}
+
+	if ( length )
+	{
+		_ring_store( ring, &ring->read, ring->read + length );
+	}
+	return length;
+}
+
+
+/**
+ * ring_write
+ *
+ * Copies up to the given number of bytes into the ring, wrapping around the end of
+ * the ring if necessary. Returns the number of bytes written, which is limited to
+ * the space remaining in the ring.
+ *
+ */
+size_t ring_write( ring_t * ring, size_t length, const void * data )
+{
+	size_t space, offset, first;
+
+	if ( !data )
+	{
+		return 0;
+	}
+
+	space = ring_space( ring );
+	if ( length > space )
+	{
+		length = space;
+	}
+	if ( !length )
+	{
+		return 0;
+	}
+
+	offset = ring->write & ( ring->capacity - 1 );
+	first = ring->capacity - offset;
+	if ( first > length )
+	{
+		first = length;
+	}
+
+	memcpy( ring->data + offset, data, first );
+	memcpy( ring->data, ( const int8_t * ) data + first, length - first );
+
+	_ring_store( ring, &ring->write, ring->write + length );
+	return length;
+}
+
+
+/**
+ * ring_read
+ *
+ * Copies up to the given number of bytes out of the ring and consumes them. Returns
+ * the number of bytes read, which is limited to the amount of data in the ring.
+ *
+ */
+size_t ring_read( ring_t * ring, size_t length, void * data )
+{
+	size_t available, offset, first;
+
+	if ( !data )
+	{
+		return 0;
+	}
+
+	available = ring_data_length( ring );
+	if ( length > available )
+	{
+		length = available;
+	}
+	if ( !length )
+	{
+		return 0;
+	}
+
+	offset = ring->read & ( ring->capacity - 1 );
+	first = ring->capacity - offset;
+	if ( first > length )
+	{
+		first = length;
+	}
+
+	memcpy( data, ring->data + offset, first );
+	memcpy( ( int8_t * ) data + first, ring->data, length - first );
+
+	_ring_store( ring, &ring->read, ring->read + length );
+	return length;
+}
@@ -0,0 +1,237 @@
+#ifndef __MEM_RING_H
+#define __MEM_RING_H
+
+#include "buffer.h"
+#include "span.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * RING_SPSC
+ *
+ * Ring flag - the ring may be shared by exactly one producer thread (calling
+ * ring_reserve, ring_commit, ring_write and ring_space) and one consumer thread
+ * (calling ring_peek, ring_consume, ring_read and ring_data_length) without any
+ * further locking.
+ *
+ */
+#define RING_SPSC 0x1
+
+
+/**
+ * RING_MIRRORED
+ *
+ * Ring flag - the ring's memory is mapped twice, back to back, such that spans
+ * returned by ring_reserve and ring_peek never need to be split at the end of the
+ * ring. Capacity is rounded up to a multiple of the page size. Where this is not
+ * supported (currently anywhere other than Linux), the flag is cleared by ring_init
+ * and the ring falls back to ordinary storage.
+ *
+ */
+#define RING_MIRRORED 0x2
+
+
+/**
+ * ring_t
+ *
+ * A fixed-capacity circular FIFO of bytes.
+ *
+ */
+typedef struct ring_t
+{
+	/* The storage for the ring (unused by mirrored rings) */
+	buffer_t storage;
+
+	/* A pointer to the beginning of the ring's memory */
+	int8_t * data;
+
+	/* The capacity of the ring in bytes (always a power of two) */
+	size_t capacity;
+
+	/* The total number of bytes ever consumed from the ring (wraps around) */
+	size_t read;
+
+	/* The total number of bytes ever committed to the ring (wraps around) */
+	size_t write;
+
+	/* The RING_* flags the ring was initialised with */
+	int flags;
+
+} ring_t;
+
+
+/**
+ * ring_new
+ *
+ * Allocate a new ring_t object using the given allocator, and initialise it as
+ * with ring_init. Should call ring_delete to release the ring_t object, and its
+ * underlying memory.
+ *
+ */
+ring_t * ring_new( size_t capacity, int flags, allocator_t * allocator );
+
+
+/**
+ * ring_delete
+ *
+ * Releases the given ring_t object and its underlying memory. Use this function
+ * to release a ring_t object created with ring_new.
+ *
+ */
+void ring_delete( ring_t * ring );
+
+
+/**
+ * ring_init
+ *
+ * Initialises the given ring_t object as an empty ring with room for at least the
+ * given number of bytes (rounded up to a power of two), allocated from the given
+ * allocator. flags is a combination of the RING_* flags. Should call ring_cleanup
+ * to release the underlying memory. If the capacity is 0 or the memory cannot be
+ * allocated, the ring is initialised with zero capacity.
+ *
+ */
+void ring_init( ring_t * ring, size_t capacity, int flags, allocator_t * allocator );
+
+
+/**
+ * ring_cleanup
+ *
+ * Releases the underlying memory of the given ring_t object (the ring_t object
+ * itself is not released). Use this function to clean up a ring_t object that was
+ * initialised with the ring_init function.
+ *
+ */
+void ring_cleanup( ring_t * ring );
+
+
+/**
+ * ring_capacity
+ *
+ * Returns the number of bytes the ring can hold.
+ *
+ */
+size_t ring_capacity( ring_t * ring );
+
+
+/**
+ * ring_data_length
+ *
+ * Returns the number of bytes that have been committed but not yet consumed.
+ *
+ */
+size_t ring_data_length( ring_t * ring );
+
+
+/**
+ * ring_space
+ *
+ * Returns the number of bytes that can be committed before the ring is full.
+ *
+ */
+size_t ring_space( ring_t * ring );
+
+
+/**
+ * ring_reserve
+ *
+ * Returns a pointer to the largest contiguous block of free memory at the write
+ * position of the ring, storing its length in the given length pointer. The block
+ * can be initialised at some later point, and then made visible to the consumer
+ * with ring_commit. Returns null (and a length of zero) if the ring is full.
+ *
+ * Unless the ring is mirrored, a second call (after committing the first block)
+ * may be required to obtain the free memory that wraps around to the beginning
+ * of the ring.
+ *
+ */
+void * ring_reserve( ring_t * ring, size_t * length );
+
+
+/**
+ * ring_reserve_spans
+ *
+ * Describes all free memory in the ring, starting at the write position, as up to
+ * two spans (the second being the free memory that wraps around to the beginning
+ * of the ring). Returns the number of spans written to the given array.
+ *
+ */
+size_t ring_reserve_spans( ring_t * ring, span_t spans[ 2 ] );
+
+
+/**
+ * ring_commit
+ *
+ * Appends the given number of bytes, previously initialised via ring_reserve, to
+ * the data in the ring. Returns the number of bytes committed, which is limited
+ * to the space remaining in the ring.
+ *
+ */
+size_t ring_commit( ring_t * ring, size_t length );
+
+
+/**
+ * ring_peek
+ *
+ * Returns a pointer to the largest contiguous block of data at the read position
+ * of the ring, storing its length in the given length pointer. The data remains
+ * in the ring until released with ring_consume. Returns null (and a length of
+ * zero) if the ring is empty.
+ *
+ * Unless the ring is mirrored, a second call (after consuming the first block) may
+ * be required to obtain the data that wraps around to the beginning of the ring.
+ *
+ */
+void * ring_peek( ring_t * ring, size_t * length );
+
+
+/**
+ * ring_peek_spans
+ *
+ * Describes all data in the ring, starting at the read position, as up to two
+ * spans (the second being the data that wraps around to the beginning of the
+ * ring). Returns the number of spans written to the given array.
+ *
+ */
+size_t ring_peek_spans( ring_t * ring, span_t spans[ 2 ] );
+
+
+/**
+ * ring_consume
+ *
+ * Releases the given number of bytes from the read position of the ring, making
+ * the space available to the producer. Returns the number of bytes consumed, which
+ * is limited to the amount of data in the ring.
+ *
+ */
+size_t ring_consume( ring_t * ring, size_t length );
+
+
+/**
+ * ring_write
+ *
+ * Copies up to the given number of bytes into the ring, wrapping around the end of
+ * the ring if necessary. Returns the number of bytes written, which is limited to
+ * the space remaining in the ring.
+ *
+ */
+size_t ring_write( ring_t * ring, size_t length, const void * data );
+
+
+/**
+ * ring_read
+ *
+ * Copies up to the given number of bytes out of the ring and consumes them. Returns
+ * the number of bytes read, which is limited to the amount of data in the ring.
+ *
+ */
+size_t ring_read( ring_t * ring, size_t length, void * data );
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+#endif /* __MEM_RING_H */
@@ -0,0 +1,780 @@
+#define _GNU_SOURCE
+
+#include "shared_pool.h"
+#include "allocator.h"
+#include "internal/atomic.h"
+
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SHARED_POOL_SUPPORTED
+#endif
+
+/* Identifies a fully initialised shared pool region ("lmsp") */
+#define SHARED_POOL_MAGIC 0x6c6d7370
+
+/* The first element starts on its own cache line, away from the contended head */
+#define SHARED_POOL_DATA_ALIGNMENT 64
+
+
+/**
+ * _shared_pool_round_up
+ *
+ * Rounds the given value up to a multiple of the given power of two.
+ *
+ */
+static size_t _shared_pool_round_up( size_t value, size_t alignment )
+{
+	return ( value + alignment - 1 ) & ~( alignment - 1 );
+}
+
+
+/**
+ * _shared_pool_reset
+ *
+ * Leaves the given shared_pool_t object detached.
+ *
+ */
+static void _shared_pool_reset( shared_pool_t * pool )
+{
+	pool->header = 0;
+	pool->data = 0;
+	pool->size = 0;
+	pool->element_size = 0;
+	pool->num_elements = 0;
+	pool->fd = -1;
+}
+
+
+/**
+ * _shared_pool_element
+ *
+ * Returns the address in this process of the element with the given index plus
+ * one, as stored in free list links.
+ *
+ */
+static int8_t * _shared_pool_element( shared_pool_t * pool, uint32_t link )
+{
+	return pool->data + ( size_t )( link - 1 ) * pool->element_size;
+}
+
+
+/**
+ * _shared_pool_link
+ *
+ * Returns the index plus one of the given element, as stored in free list links,
+ * or 0 if the address is not that of an element in the pool.
+ *
+ */
+static uint32_t _shared_pool_link( shared_pool_t * pool, const void * element )
+{
+	const int8_t * address = ( const int8_t * ) element;
+	size_t offset;
+
+	if ( !pool || !pool->header || address < pool->data )
+	{
+		return 0;
+	}
+
+	offset = ( size_t )( address - pool->data );
+	if ( offset % pool->element_size || offset / pool->element_size >= pool->num_elements )
+	{
+		return 0;
+	}
+
+	return ( uint32_t )( offset / pool->element_size + 1 );
+}
+
+
+#if defined(SHARED_POOL_SUPPORTED)
+
+/**
+ * _shared_pool_map
+ *
+ * Maps the shared pool in the given file descriptor (at the given address if
+ * possible, or anywhere if null), taking ownership of the descriptor. Returns 1 on
+ * success, 0 otherwise (in which case the descriptor has been closed).
+ *
+ */
+static int _shared_pool_map( shared_pool_t * pool, int fd, void * address )
+{
+	uint64_t element_size, num_elements, data_offset, region_size;
+	shared_pool_header_t * header;
+	struct stat status;
+	size_t size;
+	void * mapping;
+
+	if ( fstat( fd, &status ) != 0 || status.st_size < ( off_t ) sizeof( shared_pool_header_t ) )
+	{
+		close( fd );
+		return 0;
+	}
+
+	size = ( size_t ) status.st_size;
+	if ( ( off_t ) size != status.st_size )
+	{
+		close( fd );
+		return 0;
+	}
+
+	mapping = mmap( address, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+	if ( mapping == MAP_FAILED )
+	{
+		close( fd );
+		return 0;
+	}
+
+	/* Never trust the layout of a region until it has been fully initialised, and
+	 * never follow it beyond the end of the mapping. The layout is read once, and
+	 * only this validated copy is used from then on */
+	header = ( shared_pool_header_t * ) mapping;
+	if ( ATOMIC_LOAD_ACQUIRE( &header->magic ) != SHARED_POOL_MAGIC )
+	{
+		munmap( mapping, size );
+		close( fd );
+		return 0;
+	}
+
+	element_size = ATOMIC_LOAD_RELAXED( &header->element_size );
+	num_elements = ATOMIC_LOAD_RELAXED( &header->num_elements );
+	data_offset = ATOMIC_LOAD_RELAXED( &header->data_offset );
+	region_size = ATOMIC_LOAD_RELAXED( &header->size );
+	if ( region_size > size ||
+		element_size < sizeof( uint32_t ) ||
+		num_elements == 0 ||
+		num_elements > SHARED_POOL_MAX_ELEMENTS ||
+		data_offset > region_size ||
+		( region_size - data_offset ) / element_size < num_elements )
+	{
+		munmap( mapping, size );
+		close( fd );
+		return 0;
+	}
+
+	pool->header = header;
+	pool->data = ( int8_t * ) mapping + data_offset;
+	pool->size = size;
+	pool->element_size = ( size_t ) element_size;
+	pool->num_elements = ( size_t ) num_elements;
+	pool->fd = fd;
+	return 1;
+}
+
+
+/**
+ * _shared_pool_format
+ *
+ * Sizes the shared memory object in the given file descriptor for a pool of the
+ * given geometry, and lays out the pool with every element free. Returns 1 on
+ * success, 0 otherwise.
+ *
+ */
+static int _shared_pool_format( int fd, size_t element_size, size_t num_elements )
+{
+	shared_pool_header_t * header;
+	size_t data_offset, size, i;
+	int8_t * data;
+	void * mapping;
+
+	element_size = _shared_pool_round_up(
+		element_size < sizeof( uint32_t ) ? sizeof( uint32_t ) : element_size,
+		SHARED_POOL_ALIGNMENT
+	);
+	data_offset = _shared_pool_round_up( sizeof( shared_pool_header_t ), SHARED_POOL_DATA_ALIGNMENT );
+
+	if ( element_size > ( ( size_t ) -1 - data_offset ) / num_elements )
+	{
+		return 0;
+	}
+
+	size = data_offset + element_size * num_elements;
+	if ( ( off_t ) size < 0 || ( off_t ) size < ( off_t ) data_offset || ftruncate( fd, ( off_t ) size ) != 0 )
+	{
+		return 0;
+	}
+
+	mapping = mmap( 0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+	if ( mapping == MAP_FAILED )
+	{
+		return 0;
+	}
+
+	header = ( shared_pool_header_t * ) mapping;
+	header->num_elements = ( uint32_t ) num_elements;
+	header->element_size = element_size;
+	header->data_offset = data_offset;
+	header->size = size;
+	header->base = 0;
+
+	/* Thread every element onto the free list, in order */
+	data = ( int8_t * ) mapping + data_offset;
+	for ( i = 0; i < num_elements; ++i )
+	{
+		*( uint32_t * )( data + i * element_size ) = i + 1 < num_elements ? ( uint32_t )( i + 2 ) : 0;
+	}
+	header->head = 1;
+
+	/* Publish the layout before anyone attaching can see the region as valid */
+	ATOMIC_STORE_RELEASE( &header->magic, SHARED_POOL_MAGIC );
+
+	munmap( mapping, size );
+	return 1;
+}
+
+
+/**
+ * _shared_pool_relocate
+ *
+ * Calls the given callback for every element that is not on the free list of the
+ * given pool. Returns 1 on success, 0 if the memory to track free elements could
+ * not be allocated.
+ *
+ */
+static int _shared_pool_relocate(
+	shared_pool_t * pool,
+	ptrdiff_t delta,
+	shared_pool_relocate_callback_t callback,
+	void * context
+)
+{
+	size_t num_elements = pool->num_elements, count, i;
+	uint8_t * free_map;
+	uint32_t link;
+
+	free_map = ( uint8_t * ) allocator_alloc( ( num_elements + 7 ) / 8, allocator_default( ) );
+	if ( !free_map )
+	{
+		return 0;
+	}
+
+	memset( free_map, 0, ( num_elements + 7 ) / 8 );
+
+	/* No more links are followed than there are elements, should the list have been
+	 * corrupted (e.g. by a process that died part way through an update) */
+	link = ( uint32_t ) pool->header->head;
+	for ( count = 0; link && link <= num_elements && count < num_elements; ++count )
+	{
+		free_map[ ( link - 1 ) / 8 ] |= ( uint8_t )( 1 << ( ( link - 1 ) % 8 ) );
+		link = *( uint32_t * ) _shared_pool_element( pool, link );
+	}
+
+	for ( i = 0; i < num_elements; ++i )
+	{
+		if ( !( free_map[ i / 8 ] & ( 1 << ( i % 8 ) ) ) )
+		{
+			callback( pool->data + i * pool->element_size, delta, context );
+		}
+	}
+
+	allocator_free( free_map, allocator_default( ) );
+	return 1;
+}
+
+#endif /* SHARED_POOL_SUPPORTED */
+
+
+/**
+ * shared_pool_create
+ *
+ * Creates a shared memory object holding a pool of the given number of elements of
+ * the given size, and attaches the given shared_pool_t object to it.
+ *
+ */
+int shared_pool_create(
+	shared_pool_t * pool,
+	const char * name,
+	size_t element_size,
+	size_t num_elements
+)
+{
+#if defined(SHARED_POOL_SUPPORTED)
+	int fd;
+
+	if ( !pool )
+	{
+		return 0;
+	}
+
+	_shared_pool_reset( pool );
+
+	/* Processes can only share the free list if its updates are truly atomic */
+	if ( !ATOMIC_ALWAYS_LOCK_FREE( sizeof( uint64_t ) ) )
+	{
+		return 0;
+	}
+
+	if ( !element_size || !num_elements || num_elements > SHARED_POOL_MAX_ELEMENTS )
+	{
+		return 0;
+	}
+
+	if ( name )
+	{
+		fd = shm_open( name, O_RDWR | O_CREAT | O_EXCL, 0600 );
+	}
+	else
+	{
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+		/* Deliberately not close-on-exec, such that the pool can be handed to a
+		 * child process by its descriptor */
+		fd = memfd_create( "libmem-shared-pool", 0 );
+#else
+		fd = -1;
+#endif
+	}
+
+	if ( fd < 0 )
+	{
+		return 0;
+	}
+
+	if ( !_shared_pool_format( fd, element_size, num_elements ) )
+	{
+		close( fd );
+		if ( name )
+		{
+			shm_unlink( name );
+		}
+		return 0;
+	}
+
+	if ( !_shared_pool_map( pool, fd, 0 ) )
+	{
+		if ( name )
+		{
+			shm_unlink( name );
+		}
+		return 0;
+	}
+
+	return 1;
+#else
+	if ( pool )
+	{
+		_shared_pool_reset( pool );
+	}
+	( void ) name;
+	( void ) element_size;
+	( void ) num_elements;
+	return 0;
+#endif
+}
+
+
+/**
+ * shared_pool_create_file
+ *
+ * As shared_pool_create, but the pool is held in the file at the given path (which
+ * is created, or truncated if it already exists). Returns 1 on success, 0
+ * otherwise.
+ *
+ */
+int shared_pool_create_file(
+	shared_pool_t * pool,
+	const char * path,
+	size_t element_size,
+	size_t num_elements
+)
+{
+#if defined(SHARED_POOL_SUPPORTED)
+	int fd;
+
+	if ( !pool )
+	{
+		return 0;
+	}
+
+	_shared_pool_reset( pool );
+
+	if ( !path || !ATOMIC_ALWAYS_LOCK_FREE( sizeof( uint64_t ) ) )
+	{
+		return 0;
+	}
+
+	if ( !element_size || !num_elements || num_elements > SHARED_POOL_MAX_ELEMENTS )
+	{
+		return 0;
+	}
+
+	fd = open( path, O_RDWR | O_CREAT | O_TRUNC, 0666 );
+	if ( fd < 0 )
+	{
+		return 0;
+	}
+
+	if ( !_shared_pool_format( fd, element_size, num_elements ) )
+	{
+		close( fd );
+		return 0;
+	}
+
+	if ( !_shared_pool_map( pool, fd, 0 ) )
+	{
+		return 0;
+	}
+
+	pool->header->base = ( uint64_t )( size_t ) pool->header;
+	return 1;
+#else
+	if ( pool )
+	{
+		_shared_pool_reset( pool );
+	}
+	( void ) path;
+	( void ) element_size;
+	( void ) num_elements;
+	return 0;
+#endif
+}
+
+
+/**
+ * shared_pool_open_file
+ *
+ * Attaches the given shared_pool_t object to the pool persisted in the file at the
+ * given path, mapping it at its previous address where possible, and otherwise
+ * calling the given callback (if any) for every element in use. Returns 1 on
+ * success, 0 otherwise.
+ *
+ */
+int shared_pool_open_file(
+	shared_pool_t * pool,
+	const char * path,
+	shared_pool_relocate_callback_t callback,
+	void * context
+)
+{
+#if defined(SHARED_POOL_SUPPORTED)
+	shared_pool_header_t header;
+	uint64_t base;
+	int fd;
+
+	if ( !pool )
+	{
+		return 0;
+	}
+
+	_shared_pool_reset( pool );
+
+	if ( !path || !ATOMIC_ALWAYS_LOCK_FREE( sizeof( uint64_t ) ) )
+	{
+		return 0;
+	}
+
+	fd = open( path, O_RDWR );
+	if ( fd < 0 )
+	{
+		return 0;
+	}
+
+	/* Ask for the previous address, so that pointers into the pool stay valid */
+	if ( pread( fd, &header, sizeof( header ), 0 ) != ( ssize_t ) sizeof( header ) )
+	{
+		close( fd );
+		return 0;
+	}
+
+	if ( !_shared_pool_map( pool, fd, ( void * )( size_t ) header.base ) )
+	{
+		return 0;
+	}
+
+	base = ( uint64_t )( size_t ) pool->header;
+	if ( pool->header->base != base )
+	{
+		if ( callback && pool->header->base &&
+			!_shared_pool_relocate( pool, ( ptrdiff_t )( base - pool->header->base ), callback, context ) )
+		{
+			shared_pool_detach( pool );
+			return 0;
+		}
+
+		pool->header->base = base;
+	}
+
+	return 1;
+#else
+	if ( pool )
+	{
+		_shared_pool_reset( pool );
+	}
+	( void ) path;
+	( void ) callback;
+	( void ) context;
+	return 0;
+#endif
+}
+
+
+/**
+ * shared_pool_sync
+ *
+ * Flushes the contents of a file-backed pool to its file, blocking until the write
+ * has completed. Returns 1 on success, 0 otherwise.
+ *
+ */
+int shared_pool_sync( shared_pool_t * pool )
+{
+	if ( !pool || !pool->header )
+	{
+		return 0;
+	}
+
+#if defined(SHARED_POOL_SUPPORTED)
+	return msync( pool->header, pool->size, MS_SYNC ) == 0;
+#else
+	return 0;
+#endif
+}
+
+
+/**
+ * shared_pool_attach
+ *
+ * Attaches the given shared_pool_t object to the existing shared pool with the
+ * given name. Returns 1 on success, 0 otherwise.
+ *
+ */
+int shared_pool_attach( shared_pool_t * pool, const char * name )
+{
+#if defined(SHARED_POOL_SUPPORTED)
+	int fd;
+
+	if ( !pool )
+	{
+		return 0;
+	}
+
+	_shared_pool_reset( pool );
+
+	if ( !name || !ATOMIC_ALWAYS_LOCK_FREE( sizeof( uint64_t ) ) )
+	{
+		return 0;
+	}
+
+	fd = shm_open( name, O_RDWR, 0 );
+	return fd >= 0 && _shared_pool_map( pool, fd, 0 );
+#else
+	if ( pool )
+	{
+		_shared_pool_reset( pool );
+	}
+	( void ) name;
+	return 0;
+#endif
+}
+
+
+/**
+ * shared_pool_attach_fd
+ *
+ * Attaches the given shared_pool_t object to the shared pool referred to by (a
+ * duplicate of) the given file descriptor. Returns 1 on success, 0 otherwise.
+ *
+ */
+int shared_pool_attach_fd( shared_pool_t * pool, int fd )
+{
+#if defined(SHARED_POOL_SUPPORTED)
+	if ( !pool )
+	{
+		return 0;
+	}
+
+	_shared_pool_reset( pool );
+
+	if ( fd < 0 || !ATOMIC_ALWAYS_LOCK_FREE( sizeof( uint64_t ) ) )
+	{
+		return 0;
+	}
+
+	fd = dup( fd );
+	return fd >= 0 && _shared_pool_map( pool, fd, 0 );
+#else
+	if ( pool )
+	{
+		_shared_pool_reset( pool );
+	}
+	( void ) fd;
+	return 0;
+#endif
+}
+
+
+/**
+ * shared_pool_detach
+ *
+ * Unmaps the shared pool from this process and closes its file descriptor.
+ *
+ */
+void shared_pool_detach( shared_pool_t * pool )
+{
+	if ( pool && pool->header )
+	{
+#if defined(SHARED_POOL_SUPPORTED)
+		munmap( pool->header, pool->size );
+		close( pool->fd );
+#endif
+		_shared_pool_reset( pool );
+	}
+}
+
+
+/**
+ * shared_pool_unlink
+ *
+ * Removes the name of a shared pool created with shared_pool_create. Returns 1 on
+ * success, 0 otherwise.
+ *
+ */
+int shared_pool_unlink( const char * name )
+{
+#if defined(SHARED_POOL_SUPPORTED)
+	return name && shm_unlink( name ) == 0;
+#else
+	( void ) name;
+	return 0;
+#endif
+}
+
+
+/**
+ * shared_pool_fd
+ *
+ * Returns the file descriptor of the shared memory object backing the given pool,
+ * or -1 if the pool is not attached.
+ *
+ */
+int shared_pool_fd( shared_pool_t * pool )
+{
+	return pool && pool->header ? pool->fd : -1;
+}
+
+
+/**
+ * shared_pool_take
+ *
+ * Pops the first element from the free list, returning null if the pool is empty.
+ * Every successful update of the head bumps its change count, so a head that was
+ * popped and pushed back by another process in the meantime is never mistaken for
+ * an unchanged one. As the list lives in shared memory, a link outside the pool
+ * (e.g. a freed element overwritten by a misbehaving process) ends the list.
+ *
+ */
+void * shared_pool_take( shared_pool_t * pool )
+{
+	uint64_t head, desired;
+	uint32_t link, next;
+	int8_t * element;
+
+	if ( !pool || !pool->header )
+	{
+		return 0;
+	}
+
+	head = ATOMIC_LOAD_ACQUIRE( &pool->header->head );
+	do
+	{
+		link = ( uint32_t ) head;
+		if ( !link || link > pool->num_elements )
+		{
+			return 0;
+		}
+
+		/* The element may be taken (and overwritten) by another process before the
+		 * exchange below, in which case the exchange fails and this stale link is
+		 * discarded */
+		element = _shared_pool_element( pool, link );
+		next = ATOMIC_LOAD_RELAXED( ( uint32_t * ) element );
+		desired = ( ( ( head >> 32 ) + 1 ) << 32 ) | next;
+	}
+	while ( !ATOMIC_COMPARE_EXCHANGE_ACQ_REL( &pool->header->head, &head, desired ) );
+
+	return element;
+}
+
+
+/**
+ * shared_pool_return
+ *
+ * Pushes the given element onto the free list. Addresses that are not elements of
+ * the pool are ignored.
+ *
+ */
+void shared_pool_return( shared_pool_t * pool, void * element )
+{
+	uint64_t head, desired;
+	uint32_t link = _shared_pool_link( pool, element );
+
+	if ( !link )
+	{
+		return;
+	}
+
+	head = ATOMIC_LOAD_RELAXED( &pool->header->head );
+	do
+	{
+		ATOMIC_STORE_RELAXED( ( uint32_t * ) element, ( uint32_t ) head );
+		desired = ( ( ( head >> 32 ) + 1 ) << 32 ) | link;
+	}
+	while ( !ATOMIC_COMPARE_EXCHANGE_ACQ_REL( &pool->header->head, &head, desired ) );
+}
+
+
+/**
+ * shared_pool_is_empty
+ *
+ * Returns 1 if there are no more elements available in the pool, 0 otherwise.
+ *
+ */
+int shared_pool_is_empty( shared_pool_t * pool )
+{
+	if ( !pool || !pool->header )
+	{
+		return 1;
+	}
+
+	return ( uint32_t ) ATOMIC_LOAD_RELAXED( &pool->header->head ) == 0;
+}
+
+
+/**
+ * shared_pool_offset
+ *
+ * Returns the offset of the given element from the beginning of the shared region,
+ * or 0 if the element is not in the pool.
+ *
+ */
+size_t shared_pool_offset( shared_pool_t * pool, const void * element )
+{
+	if ( !_shared_pool_link( pool, element ) )
+	{
+		return 0;
+	}
+
+	return ( size_t )( ( const int8_t * ) element - ( const int8_t * ) pool->header );
+}
+
+
+/**
+ * shared_pool_address
+ *
+ * Returns the address in this process of the element at the given offset, or null
+ * if the offset is not that of an element in the pool.
+ *
+ */
+void * shared_pool_address( shared_pool_t * pool, size_t offset )
+{
+	int8_t * element;
+
+	if ( !pool || !pool->header || offset < ( size_t )( pool->data - ( int8_t * ) pool->header ) || offset >= pool->size )
+	{
+		return 0;
+	}
+
+	element = ( int8_t * ) pool->header + offset;
+	return _shared_pool_link( pool, element ) ? element : 0;
+}
@@ -0,0 +1,290 @@
+#ifndef __MEM_SHARED_POOL_H
+#define __MEM_SHARED_POOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * SHARED_POOL_ALIGNMENT
+ *
+ * The alignment of every element in a shared pool, relative to the beginning of
+ * the shared region (which is always page aligned).
+ *
+ */
+#ifndef SHARED_POOL_ALIGNMENT
+#define SHARED_POOL_ALIGNMENT 16
+#endif
+
+
+/**
+ * SHARED_POOL_MAX_ELEMENTS
+ *
+ * The maximum number of elements in a shared pool, such that an element's index
+ * (plus one) always fits in the 32 bits of a free list link.
+ *
+ */
+#define SHARED_POOL_MAX_ELEMENTS 0xfffffffe
+
+
+/**
+ * shared_pool_header_t
+ *
+ * The header at the beginning of a shared region, describing the pool that follows
+ * it. Every field has a fixed size, and free elements are linked by index rather
+ * than by address, so the region is valid wherever (and in however many processes)
+ * it is mapped.
+ *
+ */
+typedef struct shared_pool_header_t
+{
+	/* SHARED_POOL_MAGIC once the region has been fully initialised */
+	uint32_t magic;
+
+	/* The number of elements in the pool */
+	uint32_t num_elements;
+
+	/* The top of the free list - a count of the changes made to the list in the
+	 * upper 32 bits (guarding against ABA), and the index plus one of the first
+	 * free element (0 if the pool is empty) in the lower 32 bits */
+	uint64_t head;
+
+	/* The distance in bytes between consecutive elements */
+	uint64_t element_size;
+
+	/* The offset in bytes of the first element from the beginning of the region */
+	uint64_t data_offset;
+
+	/* The total size of the region in bytes */
+	uint64_t size;
+
+	/* The address at which the region was last mapped by shared_pool_create_file or
+	 * shared_pool_open_file, used to detect that a file-backed pool has moved */
+	uint64_t base;
+
+} shared_pool_header_t;
+
+
+/**
+ * shared_pool_relocate_callback_t
+ *
+ * Called by shared_pool_open_file for each element in use when a file-backed pool
+ * is mapped at a different address than when it was last opened, such that any
+ * pointers held within the element can be adjusted. The delta is the new address
+ * of the region minus its previous address.
+ *
+ */
+typedef void ( * shared_pool_relocate_callback_t )( void * element, ptrdiff_t delta, void * context );
+
+
+/**
+ * shared_pool_t
+ *
+ * A process's view of a fixed-size pool of fixed-size elements held in shared
+ * memory. Any number of processes may take elements from and return elements to
+ * the same pool concurrently, without locking. Elements are identified across
+ * processes by their offsets within the region (see shared_pool_offset).
+ *
+ */
+typedef struct shared_pool_t
+{
+	/* The shared region, as mapped into this process */
+	shared_pool_header_t * header;
+
+	/* The first element, as mapped into this process */
+	int8_t * data;
+
+	/* The length of this process's mapping in bytes */
+	size_t size;
+
+	/* The distance in bytes between consecutive elements, and the number of
+	 * elements - copied from the header once validated, as any attached process
+	 * could later overwrite the header */
+	size_t element_size;
+	size_t num_elements;
+
+	/* The file descriptor of the shared memory object (-1 if not attached) */
+	int fd;
+
+} shared_pool_t;
+
+
+/**
+ * shared_pool_create
+ *
+ * Creates a shared memory object holding a pool of the given number of elements of
+ * the given size, and attaches the given shared_pool_t object to it. The object is
+ * named via shm_open if a name is given (failing if it already exists), and is an
+ * anonymous memfd otherwise, whose file descriptor (see shared_pool_fd) can be
+ * inherited or passed to another process. Returns 1 on success, 0 otherwise (in
+ * which case the pool is left detached). Should call shared_pool_detach once the
+ * pool is no longer required, and shared_pool_unlink to remove a named object.
+ *
+ */
+int shared_pool_create(
+	shared_pool_t * pool,
+	const char * name,
+	size_t element_size,
+	size_t num_elements
+);
+
+
+/**
+ * shared_pool_create_file
+ *
+ * As shared_pool_create, but the pool is held in the file at the given path (which
+ * is created, or truncated if it already exists), such that its contents persist
+ * once every process has detached. The pool can later be restored, in this or any
+ * other process, with shared_pool_open_file. Returns 1 on success, 0 otherwise.
+ *
+ */
+int shared_pool_create_file(
+	shared_pool_t * pool,
+	const char * path,
+	size_t element_size,
+	size_t num_elements
+);
+
+
+/**
+ * shared_pool_open_file
+ *
+ * Attaches the given shared_pool_t object to the pool persisted in the file at the
+ * given path by shared_pool_create_file. The file is mapped as is - elements, and
+ * the free list, need no fix-up, and the file is mapped at its previous address
+ * where possible. Should it be mapped elsewhere, the given callback (if any) is
+ * called for every element in use, to adjust any pointers held within it. This
+ * requires that no other process is using the pool. Returns 1 on success, 0
+ * otherwise.
+ *
+ */
+int shared_pool_open_file(
+	shared_pool_t * pool,
+	const char * path,
+	shared_pool_relocate_callback_t callback,
+	void * context
+);
+
+
+/**
+ * shared_pool_sync
+ *
+ * Flushes the contents of a file-backed pool to its file, blocking until the write
+ * has completed. Returns 1 on success, 0 otherwise.
+ *
+ */
+int shared_pool_sync( shared_pool_t * pool );
+
+
+/**
+ * shared_pool_attach
+ *
+ * Attaches the given shared_pool_t object to the existing shared pool with the
+ * given name. Returns 1 on success, 0 otherwise (including if the object is not a
+ * fully initialised shared pool). Should call shared_pool_detach once the pool is
+ * no longer required.
+ *
+ */
+int shared_pool_attach( shared_pool_t * pool, const char * name );
+
+
+/**
+ * shared_pool_attach_fd
+ *
+ * As shared_pool_attach, but attaches to the shared pool referred to by the given
+ * file descriptor (e.g. received from the creating process). The descriptor is
+ * duplicated, so remains owned by the caller.
+ *
+ */
+int shared_pool_attach_fd( shared_pool_t * pool, int fd );
+
+
+/**
+ * shared_pool_detach
+ *
+ * Unmaps the shared pool from this process and closes its file descriptor. The
+ * pool itself (and its elements) remain available to other attached processes.
+ *
+ */
+void shared_pool_detach( shared_pool_t * pool );
+
+
+/**
+ * shared_pool_unlink
+ *
+ * Removes the name of a shared pool created with shared_pool_create, such that it
+ * is released once every process has detached. Returns 1 on success, 0 otherwise.
+ *
+ */
+int shared_pool_unlink( const char * name );
+
+
+/**
+ * shared_pool_fd
+ *
+ * Returns the file descriptor of the shared memory object backing the given pool,
+ * or -1 if the pool is not attached.
+ *
+ */
+int shared_pool_fd( shared_pool_t * pool );
+
+
+/**
+ * shared_pool_take
+ *
+ * Takes an element from the pool, returning its address in this process, or null
+ * if the pool is empty.
+ *
+ */
+void * shared_pool_take( shared_pool_t * pool );
+
+
+/**
+ * shared_pool_return
+ *
+ * Returns an element to the pool. The element may have been taken by any attached
+ * process, so long as the given address is its address in this process.
+ *
+ */
+void shared_pool_return( shared_pool_t * pool, void * element );
+
+
+/**
+ * shared_pool_is_empty
+ *
+ * Returns 1 if there are no more elements available in the pool, 0 otherwise.
+ *
+ */
+int shared_pool_is_empty( shared_pool_t * pool );
+
+
+/**
+ * shared_pool_offset
+ *
+ * Returns the offset of the given element from the beginning of the shared region,
+ * which identifies the element in every attached process (see shared_pool_address).
+ * Returns 0 (never a valid element offset) if the element is not in the pool.
+ *
+ */
+size_t shared_pool_offset( shared_pool_t * pool, const void * element );
+
+
+/**
+ * shared_pool_address
+ *
+ * Returns the address in this process of the element at the given offset (as
+ * returned by shared_pool_offset in any attached process), or null if the offset
+ * is not that of an element in the pool.
+ *
+ */
+void * shared_pool_address( shared_pool_t * pool, size_t offset );
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+#endif /* __MEM_SHARED_POOL_H */
@@ -0,0 +1,563 @@
+#include "internal/simd.h"
+#include "internal/atomic.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Vector kernels are compiled with per-function target attributes, so the rest of
+ * the library does not require any particular instruction set */
+#if ( defined(__x86_64__) || defined(__i386__) ) && \
+	( defined(__clang__) || __GNUC__ > 4 || ( __GNUC__ == 4 && __GNUC_MINOR__ >= 9 ) )
+#include <immintrin.h>
+#define SIMD_X86
+#define SIMD_TARGET( isa ) __attribute__(( target( isa ) ))
+#if defined(__clang__) || __GNUC__ >= 6
+#define SIMD_X86_AVX512
+#endif
+#endif
+
+
+/* How far ahead of the loads (in bytes) the streaming copies prefetch the source */
+#define SIMD_PREFETCH_DISTANCE 512
+
+
+/**
+ * simd_kernels_t
+ *
+ * The kernels for a single instruction set level.
+ *
+ */
+typedef struct simd_kernels_t
+{
+	void ( * fill )( int8_t * destination, int value, size_t length );
+	void ( * copy_streaming )( int8_t * destination, const int8_t * source, size_t length );
+	const int8_t * ( * find )( const int8_t * data, int value, size_t length );
+	int ( * equal )( const int8_t * a, const int8_t * b, size_t length );
+
+} simd_kernels_t;
+
+
+/* Scalar kernels - the C library is typically already well optimised for these */
+
+static void _simd_fill_scalar( int8_t * destination, int value, size_t length )
+{
+	memset( destination, value, length );
+}
+
+static void _simd_copy_streaming_scalar( int8_t * destination, const int8_t * source, size_t length )
+{
+	memcpy( destination, source, length );
+}
+
+static const int8_t * _simd_find_scalar( const int8_t * data, int value, size_t length )
+{
+	return ( const int8_t * ) memchr( data, value, length );
+}
+
+static int _simd_equal_scalar( const int8_t * a, const int8_t * b, size_t length )
+{
+	return memcmp( a, b, length ) == 0;
+}
+
+
+#if defined(SIMD_X86)
+
+/* SSE2 kernels */
+
+SIMD_TARGET( "sse2" )
+static void _simd_fill_sse2( int8_t * destination, int value, size_t length )
+{
+	__m128i v = _mm_set1_epi8( ( char ) value );
+
+	for ( ; length >= 16; destination += 16, length -= 16 )
+	{
+		_mm_storeu_si128( ( __m128i * ) destination, v );
+	}
+
+	memset( destination, value, length );
+}
+
+SIMD_TARGET( "sse2" )
+static void _simd_copy_streaming_sse2( int8_t * destination, const int8_t * source, size_t length )
+{
+	/* Non-temporal stores must be aligned, so copy up to the first boundary */
+	size_t head = ( 16 - ( ( size_t ) destination & 15 ) ) & 15;
+	if ( head > length )
+	{
+		head = length;
+	}
+
+	memcpy( destination, source, head );
+	destination += head;
+	source += head;
+	length -= head;
+
+	for ( ; length >= 64; destination += 64, source += 64, length -= 64 )
+	{
+		_mm_prefetch( ( const char * ) source + SIMD_PREFETCH_DISTANCE, _MM_HINT_NTA );
+		_mm_stream_si128( ( __m128i * ) destination, _mm_loadu_si128( ( const __m128i * ) source ) );
+		_mm_stream_si128( ( __m128i * ) destination + 1, _mm_loadu_si128( ( const __m128i * ) source + 1 ) );
+		_mm_stream_si128( ( __m128i * ) destination + 2, _mm_loadu_si128( ( const __m128i * ) source + 2 ) );
+		_mm_stream_si128( ( __m128i * ) destination + 3, _mm_loadu_si128( ( const __m128i * ) source + 3 ) );
+	}
+
+	for ( ; length >= 16; destination += 16, source += 16, length -= 16 )
+	{
+		_mm_stream_si128( ( __m128i * ) destination, _mm_loadu_si128( ( const __m128i * ) source ) );
+	}
+
+	_mm_sfence( );
+	memcpy( destination, source, length );
+}
+
+SIMD_TARGET( "sse2" )
+static const int8_t * _simd_find_sse2( const int8_t * data, int value, size_t length )
+{
+	__m128i v = _mm_set1_epi8( ( char ) value );
+
+	for ( ; length >= 16; data += 16, length -= 16 )
+	{
+		int mask = _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_loadu_si128( ( const __m128i * ) data ), v ) );
+		if ( mask )
+		{
+			return data + __builtin_ctz( ( unsigned int ) mask );
+		}
+	}
+
+	return _simd_find_scalar( data, value, length );
+}
+
+SIMD_TARGET( "sse2" )
+static int _simd_equal_sse2( const int8_t * a, const int8_t * b, size_t length )
+{
+	for ( ; length >= 16; a += 16, b += 16, length -= 16 )
+	{
+		__m128i x = _mm_loadu_si128( ( const __m128i * ) a );
+		__m128i y = _mm_loadu_si128( ( const __m128i * ) b );
+		if ( _mm_movemask_epi8( _mm_cmpeq_epi8( x, y ) ) != 0xFFFF )
+		{
+			return 0;
+		}
+	}
+
+	return _simd_equal_scalar( a, b, length );
+}
+
+
+/* AVX2 kernels */
+
+SIMD_TARGET( "avx2" )
+static void _simd_fill_avx2( int8_t * destination, int value, size_t length )
+{
+	__m256i v = _mm256_set1_epi8( ( char ) value );
+
+	for ( ; length >= 32; destination += 32, length -= 32 )
+	{
+		_mm256_storeu_si256( ( __m256i * ) destination, v );
+	}
+
+	memset( destination, value, length );
+}
+
+SIMD_TARGET( "avx2" )
+static void _simd_copy_streaming_avx2( int8_t * destination, const int8_t * source, size_t length )
+{
+	size_t head = ( 32 - ( ( size_t ) destination & 31 ) ) & 31;
+	if ( head > length )
+	{
+		head = length;
+	}
+
+	memcpy( destination, source, head );
+	destination += head;
+	source += head;
+	length -= head;
+
+	for ( ; length >= 64; destination += 64, source += 64, length -= 64 )
+	{
+		_mm_prefetch( ( const char * ) source + SIMD_PREFETCH_DISTANCE, _MM_HINT_NTA );
+		_mm256_stream_si256( ( __m256i * ) destination, _mm256_loadu_si256( ( const __m256i * ) source ) );
+		_mm256_stream_si256( ( __m256i * ) destination + 1, _mm256_loadu_si256( ( const __m256i * ) source + 1 ) );
+	}
+
+	for ( ; length >= 32; destination += 32, source += 32, length -= 32 )
+	{
+		_mm256_stream_si256( ( __m256i * ) destination, _mm256_loadu_si256( ( const __m256i * ) source ) );
+	}
+
+	_mm_sfence( );
+	memcpy( destination, source, length );
+}
+
+SIMD_TARGET( "avx2" )
+static const int8_t * _simd_find_avx2( const int8_t * data, int value, size_t length )
+{
+	__m256i v = _mm256_set1_epi8( ( char ) value );
+
+	for ( ; length >= 32; data += 32, length -= 32 )
+	{
+		int mask = _mm256_movemask_epi8( _mm256_cmpeq_epi8( _mm256_loadu_si256( ( const __m256i * ) data ), v ) );
+		if ( mask )
+		{
+			return data + __builtin_ctz( ( unsigned int ) mask );
+		}
+	}
+
+	return _simd_find_scalar( data, value, length );
+}
+
+SIMD_TARGET( "avx2" )
+static int _simd_equal_avx2( const int8_t * a, const int8_t * b, size_t length )
+{
+	for ( ; length >= 32; a += 32, b += 32, length -= 32 )
+	{
+		__m256i x = _mm256_loadu_si256( ( const __m256i * ) a );
+		__m256i y = _mm256_loadu_si256( ( const __m256i * ) b );
+		if ( ( unsigned int ) _mm256_movemask_epi8( _mm256_cmpeq_epi8( x, y ) ) != 0xFFFFFFFFu )
+		{
+			return 0;
+		}
+	}
+
+	return _simd_equal_scalar( a, b, length );
+}
+
+
+#if defined(SIMD_X86_AVX512)
+
+/* AVX-512 kernels (requiring the F and BW subsets) */
+
+SIMD_TARGET( "avx512f,avx512bw" )
+static void _simd_fill_avx512( int8_t * destination, int value, size_t length )
+{
+	__m512i v = _mm512_set1_epi8( ( char ) value );
+
+	for ( ; length >= 64; destination += 64, length -= 64 )
+	{
+		_mm512_storeu_si512( ( void * ) destination, v );
+	}
+
+	memset( destination, value, length );
+}
+
+SIMD_TARGET( "avx512f,avx512bw" )
+static void _simd_copy_streaming_avx512( int8_t * destination, const int8_t * source, size_t length )
+{
+	size_t head = ( 64 - ( ( size_t ) destination & 63 ) ) & 63;
+	if ( head > length )
+	{
+		head = length;
+	}
+
+	memcpy( destination, source, head );
+	destination += head;
+	source += head;
+	length -= head;
+
+	for ( ; length >= 64; destination += 64, source += 64, length -= 64 )
+	{
+		_mm_prefetch( ( const char * ) source + SIMD_PREFETCH_DISTANCE, _MM_HINT_NTA );
+		_mm512_stream_si512( ( void * ) destination, _mm512_loadu_si512( ( const void * ) source ) );
+	}
+
+	_mm_sfence( );
+	memcpy( destination, source, length );
+}
+
+SIMD_TARGET( "avx512f,avx512bw" )
+static const int8_t * _simd_find_avx512( const int8_t * data, int value, size_t length )
+{
+	__m512i v = _mm512_set1_epi8( ( char ) value );
+
+	for ( ; length >= 64; data += 64, length -= 64 )
+	{
+		__mmask64 mask = _mm512_cmpeq_epi8_mask( _mm512_loadu_si512( ( const void * ) data ), v );
+		if ( mask )
+		{
+			return data + __builtin_ctzll( mask );
+		}
+	}
+
+	return _simd_find_scalar( data, value, length );
+}
+
+SIMD_TARGET( "avx512f,avx512bw" )
+static int _simd_equal_avx512( const int8_t * a, const int8_t * b, size_t length )
+{
+	for ( ; length >= 64; a += 64, b += 64, length -= 64 )
+	{
+		__m512i x = _mm512_loadu_si512( ( const void * ) a );
+		__m512i y = _mm512_loadu_si512( ( const void * ) b );
+		if ( _mm512_cmpneq_epi8_mask( x, y ) )
+		{
+			return 0;
+		}
+	}
+
+	return _simd_equal_scalar( a, b, length );
+}
+
+#endif /* SIMD_X86_AVX512 */
+#endif /* SIMD_X86 */
+
+
+/* The kernels for each level, indexed by SIMD_* level */
+static const simd_kernels_t _simd_kernels[] =
+{
+	{ _simd_fill_scalar, _simd_copy_streaming_scalar, _simd_find_scalar, _simd_equal_scalar }
+#if defined(SIMD_X86)
+	, { _simd_fill_sse2, _simd_copy_streaming_sse2, _simd_find_sse2, _simd_equal_sse2 }
+	, { _simd_fill_avx2, _simd_copy_streaming_avx2, _simd_find_avx2, _simd_equal_avx2 }
+#if defined(SIMD_X86_AVX512)
+	, { _simd_fill_avx512, _simd_copy_streaming_avx512, _simd_find_avx512, _simd_equal_avx512 }
+#endif
+#endif
+};
+
+
+/* The level currently in use (-1 until first detected) */
+static int _simd_current = -1;
+
+/* The size of the last level cache (0 if unknown, 1 until first detected) */
+static size_t _simd_cache_size = 1;
+
+
+/**
+ * _simd_detect
+ *
+ * Returns the highest level supported by both the compiler and the CPU.
+ *
+ */
+static int _simd_detect( void )
+{
+#if defined(SIMD_X86)
+	__builtin_cpu_init( );
+#if defined(SIMD_X86_AVX512)
+	if ( __builtin_cpu_supports( "avx512f" ) && __builtin_cpu_supports( "avx512bw" ) )
+	{
+		return SIMD_AVX512;
+	}
+#endif
+	if ( __builtin_cpu_supports( "avx2" ) )
+	{
+		return SIMD_AVX2;
+	}
+	if ( __builtin_cpu_supports( "sse2" ) )
+	{
+		return SIMD_SSE2;
+	}
+#endif
+	return SIMD_SCALAR;
+}
+
+
+/**
+ * _simd_get
+ *
+ * Returns the kernels for the level currently in use, detecting it on first use.
+ * Racing detections store the same level, so need no further synchronisation.
+ *
+ */
+static const simd_kernels_t * _simd_get( void )
+{
+	int level = ATOMIC_LOAD_RELAXED( &_simd_current );
+	if ( level < 0 )
+	{
+		level = _simd_detect( );
+		ATOMIC_STORE_RELAXED( &_simd_current, level );
+	}
+	return &_simd_kernels[ level ];
+}
+
+
+/**
+ * simd_level
+ *
+ * Returns the level the kernels are currently dispatched to.
+ *
+ */
+int simd_level( void )
+{
+	return ( int )( _simd_get( ) - _simd_kernels );
+}
+
+
+/**
+ * simd_set_level
+ *
+ * Dispatches the kernels to the given level, or the highest supported level if
+ * that is lower. Returns the level now in use.
+ *
+ */
+int simd_set_level( int level )
+{
+	int supported = _simd_detect( );
+
+	if ( level > supported )
+	{
+		level = supported;
+	}
+	else if ( level < SIMD_SCALAR )
+	{
+		level = SIMD_SCALAR;
+	}
+
+	ATOMIC_STORE_RELAXED( &_simd_current, level );
+	return level;
+}
+
+
+/**
+ * _simd_read_cache_attribute
+ *
+ * Reads an attribute of one of the first CPU's caches from sysfs into the given
+ * string. Returns 1 on success, 0 otherwise.
+ *
+ */
+static int _simd_read_cache_attribute( int index, const char * name, char * value, size_t length )
+{
+#if defined(__linux__)
+	char path[ 128 ];
+	FILE * file;
+	int result;
+
+	sprintf( path, "/sys/devices/system/cpu/cpu0/cache/index%d/%s", index, name );
+	file = fopen( path, "r" );
+	if ( !file )
+	{
+		return 0;
+	}
+
+	result = fgets( value, ( int ) length, file ) != 0;
+	fclose( file );
+	return result;
+#else
+	( void ) index;
+	( void ) name;
+	( void ) value;
+	( void ) length;
+	return 0;
+#endif
+}
+
+
+/**
+ * _simd_detect_cache_size
+ *
+ * Returns the size of the highest level data (or unified) cache reported by sysfs,
+ * or 0 if there is none.
+ *
+ */
+static size_t _simd_detect_cache_size( void )
+{
+	size_t result = 0;
+	int index, highest = 0;
+
+	for ( index = 0; index < 16; ++index )
+	{
+		char level[ 16 ], type[ 32 ], size[ 32 ];
+		unsigned long amount;
+		char unit = 0;
+
+		if ( !_simd_read_cache_attribute( index, "level", level, sizeof( level ) ) ||
+			!_simd_read_cache_attribute( index, "type", type, sizeof( type ) ) ||
+			!_simd_read_cache_attribute( index, "size", size, sizeof( size ) ) )
+		{
+			break;
+		}
+
+		if ( strncmp( type, "Instruction", 11 ) == 0 || atoi( level ) < highest )
+		{
+			continue;
+		}
+
+		if ( sscanf( size, "%lu%c", &amount, &unit ) < 1 )
+		{
+			continue;
+		}
+
+		if ( unit == 'K' )
+		{
+			amount *= 1024;
+		}
+		else if ( unit == 'M' )
+		{
+			amount *= 1024 * 1024;
+		}
+
+		highest = atoi( level );
+		result = ( size_t ) amount;
+	}
+
+	return result;
+}
+
+
+/**
+ * simd_cache_size
+ *
+ * Returns the size in bytes of the CPU's last level data cache, or 0 if it cannot
+ * be determined. Racing detections store the same size.
+ *
+ */
+size_t simd_cache_size( void )
+{
+	size_t size = ATOMIC_LOAD_RELAXED( &_simd_cache_size );
+	if ( size == 1 )
+	{
+		size = _simd_detect_cache_size( );
+		ATOMIC_STORE_RELAXED( &_simd_cache_size, size );
+	}
+	return size;
+}
+
+
+/**
+ * simd_fill
+ *
+ * Sets the given number of bytes to the given value, as memset.
+ *
+ */
+void simd_fill( void * destination, int value, size_t length )
+{
+	_simd_get( )->fill( ( int8_t * ) destination, value, length );
+}
+
+
+/**
+ * simd_copy_streaming
+ *
+ * Copies the given number of bytes, as memcpy, but with non-temporal stores.
+ *
+ */
+void simd_copy_streaming( void * destination, const void * source, size_t length )
+{
+	_simd_get( )->copy_streaming( ( int8_t * ) destination, ( const int8_t * ) source, length );
+}
+
+
+/**
+ * simd_find
+ *
+ * Returns a pointer to the first byte with the given value, or null if there is
+ * none, as memchr.
+ *
+ */
+void * simd_find( const void * data, int value, size_t length )
+{
+	return ( void * ) _simd_get( )->find( ( const int8_t * ) data, value, length );
+}
+
+
+/**
+ * simd_equal
+ *
+ * Returns 1 if the given blocks of memory hold the same bytes, or 0 otherwise.
+ *
+ */
+int simd_equal( const void * a, const void * b, size_t length )
+{
+	return _simd_get( )->equal( ( const int8_t * ) a, ( const int8_t * ) b, length );
+}
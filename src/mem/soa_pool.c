@@ -0,0 +1,251 @@
+#include "soa_pool.h"
+
+
+/**
+ * _soa_pool_array_length
+ *
+ * Returns the number of bytes occupied by the array of the given field, padded such
+ * that the next array is aligned. Returns zero on overflow.
+ *
+ */
+static size_t _soa_pool_array_length( size_t field_size, size_t num_elements )
+{
+	if ( field_size > ( ( size_t ) -1 - SOA_POOL_ALIGNMENT ) / num_elements )
+	{
+		return 0;
+	}
+	return ( field_size * num_elements + SOA_POOL_ALIGNMENT - 1 ) & ~( ( size_t ) SOA_POOL_ALIGNMENT - 1 );
+}
+
+
+/**
+ * soa_pool_new
+ *
+ * Allocate a new soa_pool_t object using the given allocator, and initialise it as
+ * with soa_pool_init.
+ *
+ */
+soa_pool_t * soa_pool_new(
+	const size_t * field_sizes,
+	size_t num_fields,
+	size_t num_elements,
+	allocator_t * allocator
+)
+{
+	soa_pool_t * pool = ( soa_pool_t * ) allocator_alloc( sizeof( soa_pool_t ), allocator );
+	if ( pool )
+	{
+		soa_pool_init( pool, field_sizes, num_fields, num_elements, allocator );
+	}
+	return pool;
+}
+
+
+/**
+ * soa_pool_delete
+ *
+ * Releases the given soa_pool_t object and its elements.
+ *
+ */
+void soa_pool_delete( soa_pool_t * pool )
+{
+	if ( pool )
+	{
+		allocator_t * allocator = pool->allocator;
+		soa_pool_cleanup( pool );
+		allocator_free( pool, allocator );
+	}
+}
+
+
+/**
+ * soa_pool_init
+ *
+ * Initialises the given soa_pool_t object with the given number of elements, each
+ * made up of fields of the given sizes.
+ *
+ */
+void soa_pool_init(
+	soa_pool_t * pool,
+	const size_t * field_sizes,
+	size_t num_fields,
+	size_t num_elements,
+	allocator_t * allocator
+)
+{
+	size_t field, length = SOA_POOL_ALIGNMENT - 1;
+	int8_t * array;
+
+	if ( !pool )
+	{
+		return;
+	}
+
+	handle_pool_init( &pool->handles, 0, 0, allocator );
+	pool->num_fields = 0;
+	pool->block = 0;
+	pool->allocator = allocator;
+
+	for ( field = 0; field < SOA_POOL_MAX_FIELDS; ++field )
+	{
+		pool->fields[ field ] = 0;
+		pool->field_sizes[ field ] = 0;
+	}
+
+	if ( !field_sizes || !num_fields || num_fields > SOA_POOL_MAX_FIELDS || !num_elements )
+	{
+		return;
+	}
+
+	/* Allow for aligning the first array, and each array being padded */
+	for ( field = 0; field < num_fields; ++field )
+	{
+		size_t array_length = _soa_pool_array_length( field_sizes[ field ], num_elements );
+		if ( !array_length || array_length > ( size_t ) -1 - length )
+		{
+			return;
+		}
+		length += array_length;
+	}
+
+	handle_pool_init( &pool->handles, 0, num_elements, allocator );
+	if ( pool->handles.num_elements != num_elements )
+	{
+		return;
+	}
+
+	pool->block = ( int8_t * ) allocator_alloc( length, allocator );
+	if ( !pool->block )
+	{
+		handle_pool_cleanup( &pool->handles );
+		return;
+	}
+
+	array = pool->block + ( SOA_POOL_ALIGNMENT - ( ( size_t ) pool->block ) % SOA_POOL_ALIGNMENT ) % SOA_POOL_ALIGNMENT;
+	for ( field = 0; field < num_fields; ++field )
+	{
+		pool->fields[ field ] = array;
+		pool->field_sizes[ field ] = field_sizes[ field ];
+		array += _soa_pool_array_length( field_sizes[ field ], num_elements );
+	}
+	pool->num_fields = num_fields;
+}
+
+
+/**
+ * soa_pool_cleanup
+ *
+ * Releases the elements of the given soa_pool_t object.
+ *
+ */
+void soa_pool_cleanup( soa_pool_t * pool )
+{
+	size_t field;
+
+	if ( pool )
+	{
+		handle_pool_cleanup( &pool->handles );
+		allocator_free( pool->block, pool->allocator );
+		pool->block = 0;
+
+		for ( field = 0; field < pool->num_fields; ++field )
+		{
+			pool->fields[ field ] = 0;
+		}
+		pool->num_fields = 0;
+
+		/* Note that the allocator is deliberately retained for soa_pool_delete */
+	}
+}
+
+
+/**
+ * soa_pool_take
+ *
+ * Takes an unused element from the pool, returning a handle to it, or HANDLE_NULL
+ * if the pool is empty.
+ *
+ */
+handle_t soa_pool_take( soa_pool_t * pool )
+{
+	return pool ? handle_pool_take( &pool->handles ) : HANDLE_NULL;
+}
+
+
+/**
+ * soa_pool_return
+ *
+ * Returns the element referred to by the given handle to the pool. Returns 1 if the
+ * element was returned, or 0 if the handle is stale.
+ *
+ */
+int soa_pool_return( soa_pool_t * pool, handle_t handle )
+{
+	return pool ? handle_pool_return( &pool->handles, handle ) : 0;
+}
+
+
+/**
+ * soa_pool_get
+ *
+ * Returns a pointer to the given field of the element referred to by the given
+ * handle, or null if the handle is stale or there is no such field.
+ *
+ */
+void * soa_pool_get( soa_pool_t * pool, handle_t handle, size_t field )
+{
+	if ( !pool || field >= pool->num_fields || !handle_pool_is_valid( &pool->handles, handle ) )
+	{
+		return 0;
+	}
+	return pool->fields[ field ] + handle_index( handle ) * pool->field_sizes[ field ];
+}
+
+
+/**
+ * soa_pool_field
+ *
+ * Returns a pointer to the array holding the given field of every element.
+ *
+ */
+void * soa_pool_field( soa_pool_t * pool, size_t field )
+{
+	return pool && field < pool->num_fields ? pool->fields[ field ] : 0;
+}
+
+
+/**
+ * soa_pool_handle
+ *
+ * Returns the handle to the element with the given index if it is currently taken,
+ * or HANDLE_NULL otherwise.
+ *
+ */
+handle_t soa_pool_handle( soa_pool_t * pool, size_t index )
+{
+	return pool ? handle_pool_handle( &pool->handles, index ) : HANDLE_NULL;
+}
+
+
+/**
+ * soa_pool_capacity
+ *
+ * Returns the number of elements in the pool.
+ *
+ */
+size_t soa_pool_capacity( soa_pool_t * pool )
+{
+	return pool ? pool->handles.num_elements : 0;
+}
+
+
+/**
+ * soa_pool_is_empty
+ *
+ * Returns 1 if there are no more free elements in the pool, or 0 otherwise.
+ *
+ */
+int soa_pool_is_empty( soa_pool_t * pool )
+{
+	return !pool || handle_pool_is_empty( &pool->handles );
+}
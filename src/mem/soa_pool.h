@@ -0,0 +1,192 @@
+#ifndef __MEM_SOA_POOL_H
+#define __MEM_SOA_POOL_H
+
+#include "handle_pool.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * SOA_POOL_MAX_FIELDS
+ *
+ * The maximum number of fields (or groups of fields) an SoA pool can hold.
+ *
+ */
+#define SOA_POOL_MAX_FIELDS 16
+
+
+/**
+ * SOA_POOL_ALIGNMENT
+ *
+ * The alignment of each field array of an SoA pool, such that every array starts
+ * on its own cache line (and is suitably aligned for vector loads).
+ *
+ */
+#ifndef SOA_POOL_ALIGNMENT
+#define SOA_POOL_ALIGNMENT 64
+#endif
+
+
+/**
+ * soa_pool_t
+ *
+ * A fixed-size pool whose elements are stored as a structure of arrays - one array
+ * per field, all indexed by the element's handle - so that scanning one field of
+ * every element touches only that field's memory. Fields that are used together
+ * can be grouped by passing the size of a struct holding them (e.g. a hot group
+ * read on every sweep, and a cold group read rarely).
+ *
+ * Elements are referred to by generational handles, as with handle_pool_t.
+ *
+ */
+typedef struct soa_pool_t
+{
+	/* The handles, and the free list shared by all fields */
+	handle_pool_t handles;
+
+	/* The array holding each field of every element */
+	int8_t * fields[ SOA_POOL_MAX_FIELDS ];
+
+	/* The size of each field in bytes */
+	size_t field_sizes[ SOA_POOL_MAX_FIELDS ];
+
+	/* The number of fields */
+	size_t num_fields;
+
+	/* The block of memory holding all field arrays */
+	int8_t * block;
+
+	/* The allocator used to allocate the field arrays */
+	allocator_t * allocator;
+
+} soa_pool_t;
+
+
+/**
+ * soa_pool_new
+ *
+ * Allocate a new soa_pool_t object using the given allocator, and initialise it as
+ * with soa_pool_init. Should call soa_pool_delete to release it.
+ *
+ */
+soa_pool_t * soa_pool_new(
+	const size_t * field_sizes,
+	size_t num_fields,
+	size_t num_elements,
+	allocator_t * allocator
+);
+
+
+/**
+ * soa_pool_delete
+ *
+ * Releases the given soa_pool_t object and its elements. Use this function to
+ * release a soa_pool_t object created with soa_pool_new.
+ *
+ */
+void soa_pool_delete( soa_pool_t * pool );
+
+
+/**
+ * soa_pool_init
+ *
+ * Initialises the given soa_pool_t object with the given number of elements, each
+ * made up of fields of the given sizes (up to SOA_POOL_MAX_FIELDS), allocated with
+ * the given allocator. Should call soa_pool_cleanup to release the elements. If the
+ * elements cannot be allocated, the pool has no elements.
+ *
+ */
+void soa_pool_init(
+	soa_pool_t * pool,
+	const size_t * field_sizes,
+	size_t num_fields,
+	size_t num_elements,
+	allocator_t * allocator
+);
+
+
+/**
+ * soa_pool_cleanup
+ *
+ * Releases the elements of the given soa_pool_t object (the soa_pool_t object
+ * itself is not released). All handles are invalidated.
+ *
+ */
+void soa_pool_cleanup( soa_pool_t * pool );
+
+
+/**
+ * soa_pool_take
+ *
+ * Takes an unused element from the pool, returning a handle to it, or HANDLE_NULL
+ * if the pool is empty.
+ *
+ */
+handle_t soa_pool_take( soa_pool_t * pool );
+
+
+/**
+ * soa_pool_return
+ *
+ * Returns the element referred to by the given handle to the pool, invalidating the
+ * handle. Returns 1 if the element was returned, or 0 if the handle is stale.
+ *
+ */
+int soa_pool_return( soa_pool_t * pool, handle_t handle );
+
+
+/**
+ * soa_pool_get
+ *
+ * Returns a pointer to the given field of the element referred to by the given
+ * handle, or null if the handle is stale or there is no such field.
+ *
+ */
+void * soa_pool_get( soa_pool_t * pool, handle_t handle, size_t field );
+
+
+/**
+ * soa_pool_field
+ *
+ * Returns a pointer to the array holding the given field of every element, such
+ * that the field of the element with index i is at i times the field's size. Use
+ * soa_pool_handle to tell which indices are currently taken.
+ *
+ */
+void * soa_pool_field( soa_pool_t * pool, size_t field );
+
+
+/**
+ * soa_pool_handle
+ *
+ * Returns the handle to the element with the given index if it is currently taken,
+ * or HANDLE_NULL otherwise.
+ *
+ */
+handle_t soa_pool_handle( soa_pool_t * pool, size_t index );
+
+
+/**
+ * soa_pool_capacity
+ *
+ * Returns the number of elements in the pool (i.e. the length of each field array).
+ *
+ */
+size_t soa_pool_capacity( soa_pool_t * pool );
+
+
+/**
+ * soa_pool_is_empty
+ *
+ * Returns 1 if there are no more free elements in the pool, or 0 otherwise.
+ *
+ */
+int soa_pool_is_empty( soa_pool_t * pool );
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+#endif /* __MEM_SOA_POOL_H */
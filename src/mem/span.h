@@ -0,0 +1,30 @@
+#ifndef __MEM_SPAN_H
+#define __MEM_SPAN_H
+
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * span_t
+ *
+ * Describes a contiguous block of memory - the libmem equivalent of struct iovec.
+ *
+ */
+typedef struct span_t
+{
+	/* A pointer to the beginning of the block */
+	void * data;
+
+	/* The length of the block in bytes */
+	size_t length;
+
+} span_t;
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+#endif /* __MEM_SPAN_H */
@@ -0,0 +1,212 @@
+#ifndef __MEM_STD_ALLOCATOR_HPP
+#define __MEM_STD_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <new>
+
+#include "allocator.h"
+
+#if __cplusplus >= 201703L && defined( __has_include )
+#if __has_include( <memory_resource> )
+#include <memory_resource>
+#define LIBMEM_HAS_MEMORY_RESOURCE 1
+#endif
+#endif
+
+namespace mem
+{
+
+namespace detail
+{
+
+/**
+ * allocate_aligned
+ *
+ * Allocates the given number of bytes from an allocator_t, aligned to the given
+ * boundary. The allocator_t interface has no notion of alignment, so requests for
+ * more than pointer alignment over-allocate and store the original block address
+ * immediately before the aligned address (as allocator_aligned_t does). Returns
+ * null on failure.
+ *
+ */
+inline void * allocate_aligned( allocator_t * allocator, std::size_t length, std::size_t alignment )
+{
+	char * block, * aligned;
+
+	/* allocator_t implementations may legitimately return null for zero-length
+	 * requests, which the standard interfaces do not allow */
+	if ( !length )
+	{
+		length = 1;
+	}
+
+	if ( alignment <= alignof( void * ) )
+	{
+		return allocator_alloc( length, allocator );
+	}
+
+	if ( length > ( std::size_t ) -1 - alignment - sizeof( void * ) )
+	{
+		return 0;
+	}
+
+	block = static_cast< char * >( allocator_alloc( length + alignment + sizeof( void * ), allocator ) );
+	if ( !block )
+	{
+		return 0;
+	}
+
+	aligned = block + sizeof( void * ) + alignment - 1;
+	aligned -= ( std::size_t ) aligned % alignment;
+	*( reinterpret_cast< char ** >( aligned ) - 1 ) = block;
+	return aligned;
+}
+
+/**
+ * deallocate_aligned
+ *
+ * Releases memory obtained from allocate_aligned with the same alignment.
+ *
+ */
+inline void deallocate_aligned( allocator_t * allocator, void * address, std::size_t alignment )
+{
+	if ( address && alignment > alignof( void * ) )
+	{
+		address = *( static_cast< char ** >( address ) - 1 );
+	}
+	allocator_free( address, allocator );
+}
+
+} /* namespace detail */
+
+
+/**
+ * StdAllocator
+ *
+ * A stateful standard library Allocator that draws memory from an allocator_t, such
+ * that standard containers can be backed by any libmem allocator. Two StdAllocators
+ * compare equal when they share the same allocator_t.
+ *
+ */
+template< typename T >
+class StdAllocator
+{
+public:
+
+	typedef T value_type;
+
+	StdAllocator( ) : allocator_( allocator_default( ) )
+	{
+	}
+
+	StdAllocator( allocator_t * allocator ) : allocator_( allocator )
+	{
+	}
+
+	template< typename U >
+	StdAllocator( const StdAllocator< U > & other ) : allocator_( other.get( ) )
+	{
+	}
+
+	T * allocate( std::size_t count )
+	{
+		void * result;
+
+		if ( count > ( std::size_t ) -1 / sizeof( T ) )
+		{
+			throw std::bad_alloc( );
+		}
+
+		result = detail::allocate_aligned( allocator_, count * sizeof( T ), alignof( T ) );
+		if ( !result )
+		{
+			throw std::bad_alloc( );
+		}
+
+		return static_cast< T * >( result );
+	}
+
+	void deallocate( T * address, std::size_t count )
+	{
+		( void ) count;
+		detail::deallocate_aligned( allocator_, address, alignof( T ) );
+	}
+
+	allocator_t * get( ) const
+	{
+		return allocator_;
+	}
+
+private:
+
+	allocator_t * allocator_;
+};
+
+template< typename T, typename U >
+bool operator==( const StdAllocator< T > & lhs, const StdAllocator< U > & rhs )
+{
+	return lhs.get( ) == rhs.get( );
+}
+
+template< typename T, typename U >
+bool operator!=( const StdAllocator< T > & lhs, const StdAllocator< U > & rhs )
+{
+	return lhs.get( ) != rhs.get( );
+}
+
+
+#if defined( LIBMEM_HAS_MEMORY_RESOURCE )
+
+/**
+ * MemoryResource
+ *
+ * Exposes an allocator_t as a std::pmr::memory_resource, such that std::pmr
+ * containers can be backed by any libmem allocator. Two MemoryResources compare
+ * equal when they share the same allocator_t.
+ *
+ */
+class MemoryResource : public std::pmr::memory_resource
+{
+public:
+
+	explicit MemoryResource( allocator_t * allocator ) : allocator_( allocator )
+	{
+	}
+
+	allocator_t * get( ) const
+	{
+		return allocator_;
+	}
+
+private:
+
+	void * do_allocate( std::size_t length, std::size_t alignment ) override
+	{
+		void * result = detail::allocate_aligned( allocator_, length, alignment );
+		if ( !result )
+		{
+			throw std::bad_alloc( );
+		}
+		return result;
+	}
+
+	void do_deallocate( void * address, std::size_t length, std::size_t alignment ) override
+	{
+		( void ) length;
+		detail::deallocate_aligned( allocator_, address, alignment );
+	}
+
+	bool do_is_equal( const std::pmr::memory_resource & other ) const noexcept override
+	{
+		const MemoryResource * resource = dynamic_cast< const MemoryResource * >( &other );
+		return resource && resource->allocator_ == allocator_;
+	}
+
+	allocator_t * allocator_;
+};
+
+#endif /* LIBMEM_HAS_MEMORY_RESOURCE */
+
+} /* namespace mem */
+
+#endif /* __MEM_STD_ALLOCATOR_HPP */
@@ -0,0 +1,200 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+
+#include "trim.h"
+
+
+/* The list of registered hooks, and the lock guarding it */
+static trim_hook_t * _trim_hooks = 0;
+static pthread_mutex_t _trim_lock;
+static pthread_once_t _trim_lock_once = PTHREAD_ONCE_INIT;
+
+
+/**
+ * _trim_lock_init
+ *
+ * Initialises the lock guarding the list of hooks as an error checking mutex, such
+ * that a hook calling back into the trim API from within trim_all is refused,
+ * rather than deadlocking.
+ *
+ */
+static void _trim_lock_init( void )
+{
+	pthread_mutexattr_t attributes;
+
+	pthread_mutexattr_init( &attributes );
+	pthread_mutexattr_settype( &attributes, PTHREAD_MUTEX_ERRORCHECK );
+	pthread_mutex_init( &_trim_lock, &attributes );
+	pthread_mutexattr_destroy( &attributes );
+}
+
+
+/**
+ * _trim_lock_acquire
+ *
+ * Locks the list of hooks, returning 1 on success, or 0 if the calling thread
+ * already holds the lock (i.e. it is running a hook).
+ *
+ */
+static int _trim_lock_acquire( void )
+{
+	pthread_once( &_trim_lock_once, _trim_lock_init );
+	return pthread_mutex_lock( &_trim_lock ) == 0;
+}
+
+
+/**
+ * _trim_buffer
+ *
+ * trim_function_t adapter for buffer_trim.
+ *
+ */
+static size_t _trim_buffer( void * object, size_t limit )
+{
+	buffer_t * buffer = ( buffer_t * ) object;
+	size_t capacity = buffer_capacity( buffer );
+	return capacity - buffer_trim( buffer, limit );
+}
+
+
+/**
+ * _trim_pool
+ *
+ * trim_function_t adapter for pool_trim.
+ *
+ */
+static size_t _trim_pool( void * object, size_t limit )
+{
+	( void ) limit;
+	return pool_trim( ( pool_t * ) object );
+}
+
+
+/**
+ * trim_hook_init
+ *
+ * Initialises the given hook to trim the given object by calling the given function
+ * with the given limit. The hook is not registered until passed to trim_register.
+ *
+ */
+void trim_hook_init( trim_hook_t * hook, trim_function_t trim, void * object, size_t limit )
+{
+	if ( hook )
+	{
+		hook->trim = trim;
+		hook->object = object;
+		hook->limit = limit;
+		hook->prev = hook->next = 0;
+	}
+}
+
+
+/**
+ * trim_hook_init_buffer
+ *
+ * Initialises the given hook to trim the given buffer to the given maximum capacity
+ * (see buffer_trim).
+ *
+ */
+void trim_hook_init_buffer( trim_hook_t * hook, buffer_t * buffer, size_t max_capacity )
+{
+	trim_hook_init( hook, _trim_buffer, buffer, max_capacity );
+}
+
+
+/**
+ * trim_hook_init_pool
+ *
+ * Initialises the given hook to release the given pool's buffer whenever all of
+ * its elements are free (see pool_trim).
+ *
+ */
+void trim_hook_init_pool( trim_hook_t * hook, pool_t * pool )
+{
+	trim_hook_init( hook, _trim_pool, pool, 0 );
+}
+
+
+/**
+ * trim_register
+ *
+ * Adds the given hook to the list of hooks called by trim_all.
+ *
+ */
+void trim_register( trim_hook_t * hook )
+{
+	if ( hook && _trim_lock_acquire( ) )
+	{
+		hook->prev = 0;
+		hook->next = _trim_hooks;
+		if ( _trim_hooks )
+		{
+			_trim_hooks->prev = hook;
+		}
+		_trim_hooks = hook;
+
+		pthread_mutex_unlock( &_trim_lock );
+	}
+}
+
+
+/**
+ * trim_unregister
+ *
+ * Removes the given hook from the list of hooks called by trim_all.
+ *
+ */
+void trim_unregister( trim_hook_t * hook )
+{
+	if ( hook && _trim_lock_acquire( ) )
+	{
+		if ( hook->prev )
+		{
+			hook->prev->next = hook->next;
+		}
+		else if ( _trim_hooks == hook )
+		{
+			_trim_hooks = hook->next;
+		}
+
+		if ( hook->next )
+		{
+			hook->next->prev = hook->prev;
+		}
+
+		hook->prev = hook->next = 0;
+
+		pthread_mutex_unlock( &_trim_lock );
+	}
+}
+
+
+/**
+ * trim_all
+ *
+ * Calls every registered hook, returning the total number of bytes released (0 if
+ * called from within a hook).
+ *
+ */
+size_t trim_all( void )
+{
+	size_t released = 0;
+	trim_hook_t * hook;
+
+	if ( !_trim_lock_acquire( ) )
+	{
+		return 0;
+	}
+
+	for ( hook = _trim_hooks; hook; hook = hook->next )
+	{
+		if ( hook->trim )
+		{
+			released += hook->trim( hook->object, hook->limit );
+		}
+	}
+
+	pthread_mutex_unlock( &_trim_lock );
+	return released;
+}
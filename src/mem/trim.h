@@ -0,0 +1,117 @@
+#ifndef __MEM_TRIM_H
+#define __MEM_TRIM_H
+
+#include "buffer.h"
+#include "pool.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * trim_function_t
+ *
+ * Releases unused memory held by the given object, keeping at most the given
+ * limit (whose meaning is up to the function). Returns the number of bytes released.
+ *
+ */
+typedef size_t ( * trim_function_t )( void * object, size_t limit );
+
+
+/**
+ * trim_hook_t
+ *
+ * Registers an object with trim_all. Hooks are intrusive - the caller owns the
+ * trim_hook_t (typically embedding it alongside the object it describes), and must
+ * keep it alive until it is unregistered.
+ *
+ */
+typedef struct trim_hook_t
+{
+	/* The function that trims the object */
+	trim_function_t trim;
+
+	/* The object to trim */
+	void * object;
+
+	/* The limit passed to the trim function */
+	size_t limit;
+
+	/* The neighbouring hooks in the list of registered hooks */
+	struct trim_hook_t * prev;
+	struct trim_hook_t * next;
+
+} trim_hook_t;
+
+
+/**
+ * trim_hook_init
+ *
+ * Initialises the given hook to trim the given object by calling the given function
+ * with the given limit. The hook is not registered until passed to trim_register.
+ *
+ */
+void trim_hook_init( trim_hook_t * hook, trim_function_t trim, void * object, size_t limit );
+
+
+/**
+ * trim_hook_init_buffer
+ *
+ * Initialises the given hook to trim the given buffer to the given maximum capacity
+ * (see buffer_trim).
+ *
+ */
+void trim_hook_init_buffer( trim_hook_t * hook, buffer_t * buffer, size_t max_capacity );
+
+
+/**
+ * trim_hook_init_pool
+ *
+ * Initialises the given hook to release the given pool's buffer whenever all of
+ * its elements are free (see pool_trim).
+ *
+ */
+void trim_hook_init_pool( trim_hook_t * hook, pool_t * pool );
+
+
+/**
+ * trim_register
+ *
+ * Adds the given hook to the list of hooks called by trim_all. Registering an
+ * already registered hook is not permitted.
+ *
+ */
+void trim_register( trim_hook_t * hook );
+
+
+/**
+ * trim_unregister
+ *
+ * Removes the given hook from the list of hooks called by trim_all. Must be called
+ * before the hook, or the object it describes, is released.
+ *
+ */
+void trim_unregister( trim_hook_t * hook );
+
+
+/**
+ * trim_all
+ *
+ * Calls every registered hook, returning the total number of bytes released. This
+ * is intended to be called by a memory pressure handler.
+ *
+ * The list of hooks is guarded by a mutex, so hooks may be registered and called
+ * from any thread - but the objects themselves are not locked, so trim_all must
+ * only be called when no other thread can be using them. Hooks run with the mutex
+ * held, so must not call back into the trim API - any such call (trim_register,
+ * trim_unregister or trim_all) is refused and has no effect.
+ *
+ */
+size_t trim_all( void );
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+#endif /* __MEM_TRIM_H */
@@ -0,0 +1,182 @@
+#include <string.h>
+
+#include "../mem/allocator_buddy.h"
+#include "../mem/internal/unused.h"
+#include "testing.h"
+
+static void _ensure_allocator_buddy_init_allocates_region_from_parent( void )
+{
+	allocator_counted_t parent;
+	allocator_buddy_t buddy;
+
+	allocator_counted_init_default( &parent );
+	allocator_buddy_init( &buddy, 1000, allocator_counted_get( &parent ) );
+	TEST_REQUIRE( buddy.capacity == 1024 );
+	TEST_REQUIRE( allocator_counted_get_current_count( &parent ) > 1024 );
+	allocator_buddy_cleanup( &buddy );
+	TEST_REQUIRE( allocator_counted_get_current_count( &parent ) == 0 );
+	TEST_REQUIRE( buddy.capacity == 0 );
+	TEST_REQUIRE( allocator_alloc( 1, allocator_buddy_get( &buddy ) ) == 0 );
+}
+
+static void _ensure_allocator_buddy_splits_and_coalesces_blocks( void )
+{
+	allocator_buddy_t buddy;
+	allocator_buddy_stats_t stats;
+	allocator_t * alloc;
+	void * block;
+
+	allocator_buddy_init_default( &buddy, 1024 );
+	alloc = allocator_buddy_get( &buddy );
+
+	block = allocator_alloc( 20, alloc );
+	TEST_REQUIRE( block == buddy.region );
+	allocator_buddy_stats( &buddy, &stats );
+	TEST_REQUIRE( stats.capacity == 1024 );
+	TEST_REQUIRE( stats.used == ALLOCATOR_BUDDY_MIN_BLOCK );
+	TEST_REQUIRE( stats.free == 1024 - ALLOCATOR_BUDDY_MIN_BLOCK );
+	TEST_REQUIRE( stats.largest_free == 512 );
+	TEST_REQUIRE( stats.free_blocks == buddy.levels - 1 );
+
+	allocator_free( block, alloc );
+	allocator_buddy_stats( &buddy, &stats );
+	TEST_REQUIRE( stats.used == 0 );
+	TEST_REQUIRE( stats.largest_free == 1024 );
+	TEST_REQUIRE( stats.free_blocks == 1 );
+
+	TEST_REQUIRE( allocator_alloc( 0, alloc ) == 0 );
+	TEST_REQUIRE( allocator_alloc( 1025, alloc ) == 0 );
+	allocator_free( 0, alloc );
+	allocator_buddy_cleanup( &buddy );
+}
+
+static void _ensure_allocator_buddy_only_coalesces_free_buddies( void )
+{
+	allocator_buddy_t buddy;
+	allocator_buddy_stats_t stats;
+	allocator_t * alloc;
+	int8_t * blocks[ 4 ];
+	size_t index;
+
+	allocator_buddy_init_default( &buddy, 1024 );
+	alloc = allocator_buddy_get( &buddy );
+
+	for ( index = 0; index < 4; ++index )
+	{
+		blocks[ index ] = ( int8_t * ) allocator_alloc( 200, alloc );
+		TEST_REQUIRE( blocks[ index ] );
+		TEST_REQUIRE( ( size_t )( blocks[ index ] - buddy.region ) % 256 == 0 );
+	}
+	TEST_REQUIRE( allocator_alloc( 1, alloc ) == 0 );
+
+	/* Freeing blocks 0 and 2 leaves 512 bytes free, but no block larger than 256 */
+	allocator_free( blocks[ 0 ], alloc );
+	allocator_free( blocks[ 2 ], alloc );
+	allocator_buddy_stats( &buddy, &stats );
+	TEST_REQUIRE( stats.free == 512 );
+	TEST_REQUIRE( stats.largest_free == 256 );
+	TEST_REQUIRE( stats.free_blocks == 2 );
+	TEST_REQUIRE( allocator_alloc( 300, alloc ) == 0 );
+
+	allocator_free( blocks[ 1 ], alloc );
+	allocator_buddy_stats( &buddy, &stats );
+	TEST_REQUIRE( stats.largest_free == 512 );
+	TEST_REQUIRE( stats.free_blocks == 2 );
+
+	allocator_free( blocks[ 3 ], alloc );
+	allocator_buddy_stats( &buddy, &stats );
+	TEST_REQUIRE( stats.largest_free == 1024 );
+	TEST_REQUIRE( stats.free_blocks == 1 );
+
+	allocator_buddy_cleanup( &buddy );
+}
+
+static void _ensure_allocator_buddy_uses_caller_storage( void )
+{
+	static int8_t storage[ 4096 ];
+	allocator_buddy_t buddy;
+	allocator_t * alloc;
+	void * block;
+
+	allocator_buddy_init_storage( &buddy, storage, sizeof( storage ) );
+	alloc = allocator_buddy_get( &buddy );
+	TEST_REQUIRE( buddy.capacity == 2048 );
+	TEST_REQUIRE( buddy.parent == 0 );
+
+	block = allocator_alloc( 2048, alloc );
+	TEST_REQUIRE( block == storage );
+	TEST_REQUIRE( allocator_alloc( 1, alloc ) == 0 );
+	allocator_free( block, alloc );
+	allocator_buddy_cleanup( &buddy );
+
+	allocator_buddy_init_storage( &buddy, storage, 16 );
+	TEST_REQUIRE( buddy.capacity == 0 );
+	TEST_REQUIRE( allocator_alloc( 1, allocator_buddy_get( &buddy ) ) == 0 );
+}
+
+static void _ensure_allocator_buddy_blocks_do_not_overlap( void )
+{
+	allocator_buddy_t buddy;
+	allocator_buddy_stats_t stats;
+	allocator_t * alloc;
+	int8_t * blocks[ 64 ];
+	size_t lengths[ 64 ];
+	size_t round, index, offset;
+	unsigned int seed = 1;
+
+	allocator_buddy_init_default( &buddy, 65536 );
+	alloc = allocator_buddy_get( &buddy );
+
+	for ( index = 0; index < 64; ++index )
+	{
+		blocks[ index ] = 0;
+	}
+
+	for ( round = 0; round < 4096; ++round )
+	{
+		seed = seed * 1103515245 + 12345;
+		index = ( seed >> 8 ) % 64;
+
+		if ( blocks[ index ] )
+		{
+			for ( offset = 0; offset < lengths[ index ]; ++offset )
+			{
+				TEST_REQUIRE( blocks[ index ][ offset ] == ( int8_t ) index );
+			}
+			allocator_free( blocks[ index ], alloc );
+			blocks[ index ] = 0;
+		}
+		else
+		{
+			lengths[ index ] = 1 + ( seed >> 16 ) % 2000;
+			blocks[ index ] = ( int8_t * ) allocator_alloc( lengths[ index ], alloc );
+			if ( blocks[ index ] )
+			{
+				memset( blocks[ index ], ( int ) index, lengths[ index ] );
+			}
+		}
+	}
+
+	for ( index = 0; index < 64; ++index )
+	{
+		allocator_free( blocks[ index ], alloc );
+	}
+
+	allocator_buddy_stats( &buddy, &stats );
+	TEST_REQUIRE( stats.used == 0 );
+	TEST_REQUIRE( stats.free_blocks == 1 );
+	allocator_buddy_cleanup( &buddy );
+}
+
+int main( int argc, char * argv[] )
+{
+	UNUSED( argc );
+	UNUSED( argv );
+
+	_ensure_allocator_buddy_init_allocates_region_from_parent( );
+	_ensure_allocator_buddy_splits_and_coalesces_blocks( );
+	_ensure_allocator_buddy_only_coalesces_free_buddies( );
+	_ensure_allocator_buddy_uses_caller_storage( );
+	_ensure_allocator_buddy_blocks_do_not_overlap( );
+	return 0;
+}
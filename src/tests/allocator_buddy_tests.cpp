@@ -0,0 +1 @@
+allocator_buddy_tests.c
\ No newline at end of file
@@ -0,0 +1,165 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "../mem/allocator_budget.h"
+#include "../mem/internal/unused.h"
+#include "testing.h"
+
+static void _count_callback( allocator_budget_t * budget, void * context )
+{
+	UNUSED( budget );
+	++*( ( size_t * ) context );
+}
+
+static void _ensure_allocator_budget_refuses_allocations_above_hard_limit( void )
+{
+	allocator_counted_t parent;
+	allocator_budget_t budget;
+	allocator_t * alloc;
+	void * a, * b;
+
+	allocator_counted_init_default( &parent );
+	allocator_budget_init( &budget, allocator_counted_get( &parent ), 0, 100 );
+	alloc = allocator_budget_get( &budget );
+
+	a = allocator_alloc( 60, alloc );
+	TEST_REQUIRE( a );
+	TEST_REQUIRE( allocator_budget_get_current_count( &budget ) == 60 );
+	TEST_REQUIRE( allocator_alloc( 41, alloc ) == 0 );
+	TEST_REQUIRE( budget.failures == 1 );
+	TEST_REQUIRE( allocator_budget_get_current_count( &budget ) == 60 );
+
+	b = allocator_alloc( 40, alloc );
+	TEST_REQUIRE( b );
+	TEST_REQUIRE( allocator_budget_get_current_count( &budget ) == 100 );
+
+	allocator_free( a, alloc );
+	allocator_free( b, alloc );
+	TEST_REQUIRE( allocator_budget_get_current_count( &budget ) == 0 );
+	TEST_REQUIRE( allocator_budget_get_peak_count( &budget ) == 100 );
+	TEST_REQUIRE( allocator_counted_get_current_count( &parent ) == 0 );
+
+	TEST_REQUIRE( allocator_alloc( 0, alloc ) == 0 );
+	allocator_free( 0, alloc );
+}
+
+static void _ensure_allocator_budget_calls_callback_once_per_crossing( void )
+{
+	allocator_budget_t budget;
+	allocator_t * alloc;
+	size_t calls = 0;
+	void * a, * b, * c;
+
+	allocator_budget_init_default( &budget, 100, 0 );
+	allocator_budget_set_callback( &budget, &_count_callback, &calls );
+	alloc = allocator_budget_get( &budget );
+
+	a = allocator_alloc( 100, alloc );
+	TEST_REQUIRE( calls == 0 );
+	b = allocator_alloc( 10, alloc );
+	TEST_REQUIRE( calls == 1 );
+	c = allocator_alloc( 10, alloc );
+	TEST_REQUIRE( calls == 1 );
+
+	allocator_free( c, alloc );
+	allocator_free( b, alloc );
+	b = allocator_alloc( 10, alloc );
+	TEST_REQUIRE( calls == 2 );
+
+	allocator_free( a, alloc );
+	allocator_free( b, alloc );
+}
+
+static void _ensure_allocator_budget_charges_ancestors( void )
+{
+	allocator_budget_t process, tenant_a, tenant_b;
+	size_t calls = 0;
+	void * a, * b;
+
+	allocator_budget_init_default( &process, 150, 200 );
+	allocator_budget_set_callback( &process, &_count_callback, &calls );
+	allocator_budget_init_child( &tenant_a, &process, 0, 150 );
+	allocator_budget_init_child( &tenant_b, &process, 0, 150 );
+
+	a = allocator_alloc( 120, allocator_budget_get( &tenant_a ) );
+	TEST_REQUIRE( a );
+	TEST_REQUIRE( allocator_budget_get_current_count( &process ) == 120 );
+	TEST_REQUIRE( allocator_alloc( 40, allocator_budget_get( &tenant_a ) ) == 0 );
+	TEST_REQUIRE( tenant_a.failures == 1 && process.failures == 0 );
+
+	/* The process budget refuses the allocation, so the tenant is not charged */
+	TEST_REQUIRE( allocator_alloc( 100, allocator_budget_get( &tenant_b ) ) == 0 );
+	TEST_REQUIRE( process.failures == 1 );
+	TEST_REQUIRE( allocator_budget_get_current_count( &tenant_b ) == 0 );
+
+	b = allocator_alloc( 50, allocator_budget_get( &tenant_b ) );
+	TEST_REQUIRE( b );
+	TEST_REQUIRE( allocator_budget_get_current_count( &process ) == 170 );
+	TEST_REQUIRE( calls == 1 );
+
+	allocator_free( a, allocator_budget_get( &tenant_a ) );
+	allocator_free( b, allocator_budget_get( &tenant_b ) );
+	TEST_REQUIRE( allocator_budget_get_current_count( &process ) == 0 );
+	TEST_REQUIRE( allocator_budget_get_peak_count( &process ) == 170 );
+}
+
+static void * _budget_thread( void * arg )
+{
+	allocator_t * alloc = allocator_budget_get( ( allocator_budget_t * ) arg );
+	void * blocks[ 4 ];
+	size_t iteration, index;
+
+	for ( iteration = 0; iteration < 1000; ++iteration )
+	{
+		for ( index = 0; index < 4; ++index )
+		{
+			blocks[ index ] = allocator_alloc( 64, alloc );
+		}
+		for ( index = 0; index < 4; ++index )
+		{
+			allocator_free( blocks[ index ], alloc );
+		}
+		if ( iteration % 64 == 0 )
+		{
+			sched_yield( );
+		}
+	}
+
+	return 0;
+}
+
+static void _ensure_allocator_budget_accounting_is_thread_safe( void )
+{
+	allocator_budget_t process, tenants[ 4 ];
+	pthread_t threads[ 4 ];
+	size_t index;
+
+	allocator_budget_init_default( &process, 0, 640 );
+	for ( index = 0; index < 4; ++index )
+	{
+		allocator_budget_init_child( &tenants[ index ], &process, 0, 0 );
+		TEST_REQUIRE( pthread_create( &threads[ index ], 0, &_budget_thread, &tenants[ index ] ) == 0 );
+	}
+	for ( index = 0; index < 4; ++index )
+	{
+		pthread_join( threads[ index ], 0 );
+		TEST_REQUIRE( allocator_budget_get_current_count( &tenants[ index ] ) == 0 );
+	}
+
+	TEST_REQUIRE( allocator_budget_get_current_count( &process ) == 0 );
+	TEST_REQUIRE( allocator_budget_get_peak_count( &process ) <= 640 );
+}
+
+int main( int argc, char * argv[] )
+{
+	UNUSED( argc );
+	UNUSED( argv );
+
+	_ensure_allocator_budget_refuses_allocations_above_hard_limit( );
+	_ensure_allocator_budget_calls_callback_once_per_crossing( );
+	_ensure_allocator_budget_charges_ancestors( );
+	_ensure_allocator_budget_accounting_is_thread_safe( );
+	return 0;
+}
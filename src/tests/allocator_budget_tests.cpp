@@ -0,0 +1 @@
+allocator_budget_tests.c
\ No newline at end of file
@@ -0,0 +1,241 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+#include "../mem/allocator_cached.h"
+#include "../mem/internal/unused.h"
+#include "testing.h"
+
+static void _ensure_allocator_cached_reuses_freed_blocks( void )
+{
+	allocator_counted_t parent;
+	allocator_cached_t cached;
+	allocator_t * alloc;
+	size_t count;
+	void * a, * b;
+
+	allocator_counted_init_default( &parent );
+	allocator_cached_init( &cached, allocator_counted_get( &parent ), 0, 0 );
+	alloc = allocator_cached_get( &cached );
+
+	a = allocator_alloc( 24, alloc );
+	TEST_REQUIRE( a );
+	memset( a, 0xff, 24 );
+	TEST_REQUIRE( allocator_cached_count( &cached ) == cached.batch - 1 );
+	count = allocator_counted_get_current_count( &parent );
+
+	allocator_free( a, alloc );
+	TEST_REQUIRE( allocator_cached_count( &cached ) == cached.batch );
+	b = allocator_alloc( 32, alloc );
+	TEST_REQUIRE( b == a );
+	TEST_REQUIRE( allocator_counted_get_current_count( &parent ) == count );
+	allocator_free( b, alloc );
+
+	TEST_REQUIRE( allocator_alloc( 0, alloc ) == 0 );
+	allocator_free( 0, alloc );
+
+	allocator_cached_cleanup( &cached );
+	TEST_REQUIRE( allocator_counted_get_current_count( &parent ) == 0 );
+}
+
+static void _ensure_allocator_cached_passes_large_blocks_to_parent( void )
+{
+	allocator_counted_t parent;
+	allocator_cached_t cached;
+	allocator_t * alloc;
+	void * block;
+
+	allocator_counted_init_default( &parent );
+	allocator_cached_init( &cached, allocator_counted_get( &parent ), 0, 0 );
+	alloc = allocator_cached_get( &cached );
+
+	block = allocator_alloc( 4096, alloc );
+	TEST_REQUIRE( block );
+	TEST_REQUIRE( allocator_counted_get_current_count( &parent ) >= 4096 );
+	TEST_REQUIRE( allocator_cached_count( &cached ) == 0 );
+	allocator_free( block, alloc );
+	TEST_REQUIRE( allocator_counted_get_current_count( &parent ) == 0 );
+
+	allocator_cached_cleanup( &cached );
+}
+
+static void _ensure_allocator_cached_uses_given_sizes( void )
+{
+	static const size_t sizes[] = { 1, 100 };
+	allocator_counted_t parent;
+	allocator_cached_t cached;
+	allocator_t * alloc;
+	void * a, * b;
+
+	allocator_counted_init_default( &parent );
+	allocator_cached_init( &cached, allocator_counted_get( &parent ), sizes, 2 );
+	alloc = allocator_cached_get( &cached );
+	TEST_REQUIRE( cached.num_classes == 2 );
+	TEST_REQUIRE( cached.sizes[ 0 ] == sizeof( void * ) );
+
+	a = allocator_alloc( 50, alloc );
+	TEST_REQUIRE( a );
+	memset( a, 0xff, 50 );
+	TEST_REQUIRE( allocator_cached_count( &cached ) == cached.batch - 1 );
+
+	b = allocator_alloc( 101, alloc );
+	TEST_REQUIRE( b );
+	TEST_REQUIRE( allocator_cached_count( &cached ) == cached.batch - 1 );
+
+	allocator_free( b, alloc );
+	allocator_free( a, alloc );
+	allocator_cached_cleanup( &cached );
+	TEST_REQUIRE( allocator_counted_get_current_count( &parent ) == 0 );
+}
+
+static void _ensure_allocator_cached_sorts_given_sizes( void )
+{
+	static const size_t sizes[] = { 256, 1, 64, 100 };
+	allocator_cached_t cached;
+
+	allocator_cached_init( &cached, allocator_default( ), sizes, 4 );
+	TEST_REQUIRE( cached.num_classes == 4 );
+	TEST_REQUIRE( cached.sizes[ 0 ] == sizeof( void * ) );
+	TEST_REQUIRE( cached.sizes[ 1 ] == 64 );
+	TEST_REQUIRE( cached.sizes[ 2 ] == 100 );
+	TEST_REQUIRE( cached.sizes[ 3 ] == 256 );
+	allocator_cached_cleanup( &cached );
+}
+
+
+static void _ensure_allocator_cached_releases_surplus_blocks( void )
+{
+	allocator_counted_t parent;
+	allocator_cached_t cached;
+	allocator_t * alloc;
+	void * blocks[ ALLOCATOR_CACHED_LIMIT * 2 ];
+	size_t index;
+
+	allocator_counted_init_default( &parent );
+	allocator_cached_init( &cached, allocator_counted_get( &parent ), 0, 0 );
+	alloc = allocator_cached_get( &cached );
+
+	for ( index = 0; index < ALLOCATOR_CACHED_LIMIT * 2; ++index )
+	{
+		blocks[ index ] = allocator_alloc( 64, alloc );
+		TEST_REQUIRE( blocks[ index ] );
+	}
+	for ( index = 0; index < ALLOCATOR_CACHED_LIMIT * 2; ++index )
+	{
+		allocator_free( blocks[ index ], alloc );
+		TEST_REQUIRE( allocator_cached_count( &cached ) <= cached.limit );
+	}
+
+	allocator_cached_flush( &cached );
+	TEST_REQUIRE( allocator_cached_count( &cached ) == 0 );
+	TEST_REQUIRE( allocator_counted_get_current_count( &parent ) == 0 );
+
+	/* The cache is recreated on next use */
+	blocks[ 0 ] = allocator_alloc( 64, alloc );
+	TEST_REQUIRE( blocks[ 0 ] );
+	allocator_free( blocks[ 0 ], alloc );
+	TEST_REQUIRE( allocator_cached_count( &cached ) == cached.batch );
+
+	allocator_cached_cleanup( &cached );
+	TEST_REQUIRE( allocator_counted_get_current_count( &parent ) == 0 );
+}
+
+static void * _cached_thread( void * arg )
+{
+	allocator_t * alloc = allocator_cached_get( ( allocator_cached_t * ) arg );
+	void * blocks[ 16 ];
+	size_t index;
+
+	for ( index = 0; index < 16; ++index )
+	{
+		blocks[ index ] = allocator_alloc( 16 * ( index + 1 ), alloc );
+		sched_yield( );
+	}
+	for ( index = 0; index < 16; ++index )
+	{
+		allocator_free( blocks[ index ], alloc );
+		sched_yield( );
+	}
+
+	return 0;
+}
+
+static volatile int _cached_flushed = 0;
+static volatile int _cached_cleaned_up = 0;
+
+static void * _cached_thread_flush( void * arg )
+{
+	_cached_thread( arg );
+	allocator_cached_flush( ( allocator_cached_t * ) arg );
+	_cached_flushed = 1;
+
+	while ( !_cached_cleaned_up )
+	{
+		sched_yield( );
+	}
+
+	return 0;
+}
+
+static void _ensure_allocator_cached_flush_releases_thread_cache( void )
+{
+	allocator_counted_t parent;
+	allocator_cached_t cached;
+	pthread_t thread;
+
+	allocator_counted_init_default( &parent );
+	allocator_cached_init( &cached, allocator_counted_get( &parent ), 0, 0 );
+
+	/* The allocator is cleaned up while the thread is still running, so nothing is
+	 * released when it exits */
+	TEST_REQUIRE( pthread_create( &thread, 0, &_cached_thread_flush, &cached ) == 0 );
+	while ( !_cached_flushed )
+	{
+		sched_yield( );
+	}
+	allocator_cached_cleanup( &cached );
+	_cached_cleaned_up = 1;
+	pthread_join( thread, 0 );
+
+	TEST_REQUIRE( allocator_counted_get_current_count( &parent ) == 0 );
+}
+
+static void _ensure_allocator_cached_drains_on_thread_exit( void )
+{
+	allocator_counted_t parent;
+	allocator_cached_t cached;
+	pthread_t threads[ 4 ];
+	size_t index;
+
+	allocator_counted_init_default( &parent );
+	allocator_cached_init( &cached, allocator_counted_get( &parent ), 0, 0 );
+
+	for ( index = 0; index < 4; ++index )
+	{
+		TEST_REQUIRE( pthread_create( &threads[ index ], 0, &_cached_thread, &cached ) == 0 );
+	}
+	for ( index = 0; index < 4; ++index )
+	{
+		pthread_join( threads[ index ], 0 );
+	}
+
+	TEST_REQUIRE( allocator_counted_get_current_count( &parent ) == 0 );
+	allocator_cached_cleanup( &cached );
+}
+
+int main( int argc, char * argv[] )
+{
+	UNUSED( argc );
+	UNUSED( argv );
+
+	_ensure_allocator_cached_reuses_freed_blocks( );
+	_ensure_allocator_cached_passes_large_blocks_to_parent( );
+	_ensure_allocator_cached_uses_given_sizes( );
+	_ensure_allocator_cached_sorts_given_sizes( );
+	_ensure_allocator_cached_releases_surplus_blocks( );
+	_ensure_allocator_cached_flush_releases_thread_cache( );
+	_ensure_allocator_cached_drains_on_thread_exit( );
+	return 0;
+}
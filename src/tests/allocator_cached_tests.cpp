@@ -0,0 +1 @@
+allocator_cached_tests.c
\ No newline at end of file
@@ -0,0 +1,132 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+#include "../mem/allocator_concurrent.h"
+#include "../mem/internal/unused.h"
+#include "testing.h"
+
+#define _THREADS 4
+#define _ITERATIONS 2000
+
+static void * _concurrent_thread( void * arg )
+{
+	allocator_t * alloc = ( allocator_t * ) arg;
+	void * blocks[ 8 ];
+	size_t iteration, index;
+
+	for ( iteration = 0; iteration < _ITERATIONS; ++iteration )
+	{
+		for ( index = 0; index < 8; ++index )
+		{
+			blocks[ index ] = allocator_alloc( 8 + index * 8, alloc );
+			if ( blocks[ index ] )
+			{
+				memset( blocks[ index ], ( int ) index, 8 + index * 8 );
+			}
+		}
+		for ( index = 0; index < 8; ++index )
+		{
+			allocator_free( blocks[ index ], alloc );
+		}
+		if ( iteration % 64 == 0 )
+		{
+			sched_yield( );
+		}
+	}
+
+	return 0;
+}
+
+static void _run_threads( allocator_t * alloc )
+{
+	pthread_t threads[ _THREADS ];
+	size_t index;
+
+	for ( index = 0; index < _THREADS; ++index )
+	{
+		TEST_REQUIRE( pthread_create( &threads[ index ], 0, &_concurrent_thread, alloc ) == 0 );
+	}
+	for ( index = 0; index < _THREADS; ++index )
+	{
+		pthread_join( threads[ index ], 0 );
+	}
+}
+
+static void _ensure_allocator_concurrent_forwards_to_parent( int strategy )
+{
+	allocator_counted_t parent;
+	allocator_concurrent_t concurrent;
+	allocator_t * alloc;
+	void * block;
+
+	allocator_counted_init_default( &parent );
+	allocator_concurrent_init( &concurrent, allocator_counted_get( &parent ), strategy );
+	alloc = allocator_concurrent_get( &concurrent );
+	TEST_REQUIRE( concurrent.strategy == strategy );
+
+	block = allocator_alloc( 100, alloc );
+	TEST_REQUIRE( block );
+	TEST_REQUIRE( allocator_counted_get_current_count( &parent ) >= 100 );
+	allocator_free( block, alloc );
+	TEST_REQUIRE( allocator_counted_get_current_count( &parent ) == 0 );
+
+	TEST_REQUIRE( allocator_alloc( 0, alloc ) == 0 );
+	allocator_free( 0, alloc );
+}
+
+static void _ensure_allocator_concurrent_guards_parent( int strategy )
+{
+	allocator_counted_t parent;
+	allocator_concurrent_t concurrent;
+
+	allocator_counted_init_default( &parent );
+	allocator_concurrent_init( &concurrent, allocator_counted_get( &parent ), strategy );
+	_run_threads( allocator_concurrent_get( &concurrent ) );
+	TEST_REQUIRE( allocator_counted_get_current_count( &parent ) == 0 );
+	TEST_REQUIRE( allocator_counted_get_peak_count( &parent ) > 0 );
+}
+
+static void _ensure_allocator_concurrent_returns_blocks_to_their_stripe( void )
+{
+	allocator_counted_t parents[ 4 ];
+	allocator_t * parent_allocs[ 4 ];
+	allocator_concurrent_t concurrent;
+	size_t index, total = 0;
+
+	for ( index = 0; index < 4; ++index )
+	{
+		allocator_counted_init_default( &parents[ index ] );
+		parent_allocs[ index ] = allocator_counted_get( &parents[ index ] );
+	}
+
+	allocator_concurrent_init_striped( &concurrent, parent_allocs, 4 );
+	TEST_REQUIRE( concurrent.strategy == ALLOCATOR_CONCURRENT_STRIPED );
+	TEST_REQUIRE( concurrent.num_stripes == 4 );
+
+	_run_threads( allocator_concurrent_get( &concurrent ) );
+
+	for ( index = 0; index < 4; ++index )
+	{
+		TEST_REQUIRE( allocator_counted_get_current_count( &parents[ index ] ) == 0 );
+		total += allocator_counted_get_peak_count( &parents[ index ] );
+	}
+	TEST_REQUIRE( total > 0 );
+}
+
+int main( int argc, char * argv[] )
+{
+	UNUSED( argc );
+	UNUSED( argv );
+
+	_ensure_allocator_concurrent_forwards_to_parent( ALLOCATOR_CONCURRENT_SPINLOCK );
+	_ensure_allocator_concurrent_forwards_to_parent( ALLOCATOR_CONCURRENT_STRIPED );
+	_ensure_allocator_concurrent_forwards_to_parent( ALLOCATOR_CONCURRENT_COMBINING );
+	_ensure_allocator_concurrent_guards_parent( ALLOCATOR_CONCURRENT_SPINLOCK );
+	_ensure_allocator_concurrent_guards_parent( ALLOCATOR_CONCURRENT_STRIPED );
+	_ensure_allocator_concurrent_guards_parent( ALLOCATOR_CONCURRENT_COMBINING );
+	_ensure_allocator_concurrent_returns_blocks_to_their_stripe( );
+	return 0;
+}
@@ -0,0 +1 @@
+allocator_concurrent_tests.c
\ No newline at end of file
@@ -0,0 +1,229 @@
+#include "../mem/allocator_stack.h"
+#include "../mem/internal/unused.h"
+#include "testing.h"
+
+static void _ensure_allocator_stack_init_allocates_storage_from_parent( void )
+{
+	allocator_counted_t parent;
+	allocator_stack_t stack;
+
+	allocator_counted_init_default( &parent );
+	allocator_stack_init( &stack, 1024, allocator_counted_get( &parent ), 0 );
+	TEST_REQUIRE( allocator_counted_get_current_count( &parent ) == 1024 );
+	TEST_REQUIRE( allocator_stack_used( &stack ) == 0 );
+	allocator_stack_cleanup( &stack );
+	TEST_REQUIRE( allocator_counted_get_current_count( &parent ) == 0 );
+}
+
+static void _ensure_allocator_stack_returns_aligned_blocks_from_storage( void )
+{
+	allocator_stack_t stack;
+	allocator_t * alloc;
+	int8_t * a, * b;
+
+	allocator_stack_init_default( &stack, 1024, 0 );
+	alloc = allocator_stack_get( &stack );
+	a = ( int8_t * ) allocator_alloc( 3, alloc );
+	b = ( int8_t * ) allocator_alloc( 5, alloc );
+	TEST_REQUIRE( a && b );
+	TEST_REQUIRE( b >= a + 3 );
+	TEST_REQUIRE( ( ( size_t ) a ) % ALLOCATOR_STACK_ALIGNMENT == 0 );
+	TEST_REQUIRE( ( ( size_t ) b ) % ALLOCATOR_STACK_ALIGNMENT == 0 );
+	TEST_REQUIRE( a >= stack.storage.begin && b + 5 <= stack.storage.begin + 1024 );
+	TEST_REQUIRE( allocator_alloc( 0, alloc ) == 0 );
+	allocator_stack_cleanup( &stack );
+}
+
+static void _ensure_allocator_stack_free_releases_top_block( void )
+{
+	allocator_stack_t stack;
+	allocator_t * alloc;
+	size_t used;
+	void * a, * b;
+
+	allocator_stack_init_default( &stack, 1024, 0 );
+	alloc = allocator_stack_get( &stack );
+	a = allocator_alloc( 16, alloc );
+	used = allocator_stack_used( &stack );
+	b = allocator_alloc( 16, alloc );
+	TEST_REQUIRE( allocator_stack_used( &stack ) > used );
+	allocator_free( b, alloc );
+	TEST_REQUIRE( allocator_stack_used( &stack ) == used );
+	TEST_REQUIRE( allocator_alloc( 16, alloc ) == b );
+	allocator_free( b, alloc );
+	allocator_free( a, alloc );
+	TEST_REQUIRE( allocator_stack_used( &stack ) == 0 );
+	allocator_free( 0, alloc );
+	allocator_stack_cleanup( &stack );
+}
+
+static void _ensure_allocator_stack_defers_release_of_lower_blocks( void )
+{
+	allocator_stack_t stack;
+	allocator_t * alloc;
+	size_t used;
+	void * a, * b, * c;
+
+	allocator_stack_init_default( &stack, 1024, 0 );
+	alloc = allocator_stack_get( &stack );
+	a = allocator_alloc( 16, alloc );
+	used = allocator_stack_used( &stack );
+	b = allocator_alloc( 16, alloc );
+	c = allocator_alloc( 16, alloc );
+	allocator_free( b, alloc );
+	TEST_REQUIRE( allocator_stack_used( &stack ) > used );
+	allocator_free( c, alloc );
+	TEST_REQUIRE( allocator_stack_used( &stack ) == used );
+	allocator_free( a, alloc );
+	TEST_REQUIRE( allocator_stack_used( &stack ) == 0 );
+	allocator_stack_cleanup( &stack );
+}
+
+static void _ensure_allocator_stack_restore_releases_blocks_since_marker( void )
+{
+	allocator_stack_t stack;
+	allocator_stack_marker_t outer, inner;
+	allocator_t * alloc;
+	size_t used;
+	void * a, * b;
+
+	allocator_stack_init_default( &stack, 1024, 0 );
+	alloc = allocator_stack_get( &stack );
+	a = allocator_alloc( 16, alloc );
+	used = allocator_stack_used( &stack );
+	outer = allocator_stack_mark( &stack );
+	b = allocator_alloc( 16, alloc );
+	inner = allocator_stack_mark( &stack );
+	allocator_alloc( 16, alloc );
+	allocator_alloc( 16, alloc );
+	allocator_stack_restore( &stack, inner );
+	TEST_REQUIRE( allocator_alloc( 16, alloc ) != 0 );
+	allocator_stack_restore( &stack, outer );
+	TEST_REQUIRE( allocator_stack_used( &stack ) == used );
+	TEST_REQUIRE( allocator_alloc( 16, alloc ) == b );
+	allocator_stack_restore( &stack, outer );
+
+	/* Blocks beneath a marker that were freed are released when it is restored */
+	allocator_alloc( 16, alloc );
+	allocator_free( a, alloc );
+	TEST_REQUIRE( allocator_stack_used( &stack ) > used );
+	allocator_stack_restore( &stack, outer );
+	TEST_REQUIRE( allocator_stack_used( &stack ) == 0 );
+	allocator_stack_cleanup( &stack );
+}
+
+static void _ensure_allocator_stack_ignores_stale_markers( void )
+{
+	allocator_stack_t stack;
+	allocator_stack_marker_t marker;
+	allocator_t * alloc;
+	size_t used;
+	void * a, * b;
+
+	allocator_stack_init_default( &stack, 1024, 0 );
+	alloc = allocator_stack_get( &stack );
+	a = allocator_alloc( 16, alloc );
+	marker = allocator_stack_mark( &stack );
+
+	/* Releasing the marker's topmost block, then allocating a larger block in its
+	 * place, leaves the marker pointing into the new block */
+	allocator_free( a, alloc );
+	TEST_REQUIRE( allocator_stack_used( &stack ) == 0 );
+	b = allocator_alloc( 64, alloc );
+	TEST_REQUIRE( b == a );
+	used = allocator_stack_used( &stack );
+	allocator_stack_restore( &stack, marker );
+	TEST_REQUIRE( allocator_stack_used( &stack ) == used );
+
+	allocator_free( b, alloc );
+	TEST_REQUIRE( allocator_stack_used( &stack ) == 0 );
+	TEST_REQUIRE( stack.top == 0 );
+	allocator_stack_cleanup( &stack );
+}
+
+static void _ensure_allocator_stack_fails_when_full_without_overflow( void )
+{
+	allocator_counted_t parent;
+	allocator_stack_t stack;
+	allocator_t * alloc;
+
+	allocator_counted_init_default( &parent );
+	allocator_stack_init( &stack, 64, allocator_counted_get( &parent ), 0 );
+	alloc = allocator_stack_get( &stack );
+	TEST_REQUIRE( allocator_alloc( 64, alloc ) == 0 );
+	TEST_REQUIRE( allocator_alloc( 16, alloc ) != 0 );
+	TEST_REQUIRE( allocator_counted_get_current_count( &parent ) == 64 );
+	allocator_stack_cleanup( &stack );
+}
+
+static void _ensure_allocator_stack_overflows_into_parent_when_full( void )
+{
+	allocator_counted_t parent;
+	allocator_stack_t stack;
+	allocator_stack_marker_t marker;
+	allocator_t * alloc;
+	void * a, * b, * c;
+
+	allocator_counted_init_default( &parent );
+	allocator_stack_init( &stack, 64, allocator_counted_get( &parent ), ALLOCATOR_STACK_OVERFLOW );
+	alloc = allocator_stack_get( &stack );
+	marker = allocator_stack_mark( &stack );
+	a = allocator_alloc( 32, alloc );
+	b = allocator_alloc( 100, alloc );
+	c = allocator_alloc( 100, alloc );
+	TEST_REQUIRE( a && b && c );
+	TEST_REQUIRE( ( ( size_t ) b ) % ALLOCATOR_STACK_ALIGNMENT == 0 );
+	TEST_REQUIRE( allocator_counted_get_current_count( &parent ) > 64 + 200 );
+	allocator_free( b, alloc );
+	TEST_REQUIRE( allocator_counted_get_current_count( &parent ) > 64 + 100 );
+	TEST_REQUIRE( allocator_counted_get_current_count( &parent ) < 64 + 200 );
+	allocator_stack_restore( &stack, marker );
+	TEST_REQUIRE( allocator_counted_get_current_count( &parent ) == 64 );
+	TEST_REQUIRE( allocator_stack_used( &stack ) == 0 );
+	allocator_alloc( 100, alloc );
+	allocator_stack_cleanup( &stack );
+	TEST_REQUIRE( allocator_counted_get_current_count( &parent ) == 0 );
+}
+
+static void _ensure_allocator_stack_init_storage_uses_given_storage( void )
+{
+	int8_t storage[ 256 ];
+	allocator_stack_t stack;
+	int8_t * a;
+
+	allocator_stack_init_storage( &stack, storage, sizeof( storage ), allocator_always_fail( ), 0 );
+	a = ( int8_t * ) allocator_alloc( 100, allocator_stack_get( &stack ) );
+	TEST_REQUIRE( a >= storage && a + 100 <= storage + sizeof( storage ) );
+	allocator_free( a, allocator_stack_get( &stack ) );
+	allocator_stack_cleanup( &stack );
+}
+
+static void _ensure_allocator_stack_gracefully_copes_with_failed_init( void )
+{
+	allocator_stack_t stack;
+	allocator_stack_init( &stack, 1024, allocator_always_fail( ), 0 );
+	TEST_REQUIRE( allocator_alloc( 16, allocator_stack_get( &stack ) ) == 0 );
+	allocator_stack_cleanup( &stack );
+	allocator_stack_init( 0, 1024, allocator_default( ), 0 );
+	allocator_stack_cleanup( 0 );
+	allocator_stack_reset( 0 );
+	TEST_REQUIRE( allocator_stack_used( 0 ) == 0 );
+}
+
+int main( int argc, char * argv[] )
+{
+	UNUSED( argc );
+	UNUSED( argv );
+
+	_ensure_allocator_stack_init_allocates_storage_from_parent( );
+	_ensure_allocator_stack_returns_aligned_blocks_from_storage( );
+	_ensure_allocator_stack_free_releases_top_block( );
+	_ensure_allocator_stack_defers_release_of_lower_blocks( );
+	_ensure_allocator_stack_restore_releases_blocks_since_marker( );
+	_ensure_allocator_stack_ignores_stale_markers( );
+	_ensure_allocator_stack_fails_when_full_without_overflow( );
+	_ensure_allocator_stack_overflows_into_parent_when_full( );
+	_ensure_allocator_stack_init_storage_uses_given_storage( );
+	_ensure_allocator_stack_gracefully_copes_with_failed_init( );
+	return 0;
+}
@@ -0,0 +1 @@
+allocator_stack_tests.c
\ No newline at end of file
@@ -0,0 +1,174 @@
+#include <string.h>
+
+#include "../mem/allocator_tlsf.h"
+#include "../mem/internal/unused.h"
+#include "testing.h"
+
+static void _ensure_allocator_tlsf_init_allocates_region_from_parent( void )
+{
+	allocator_counted_t parent;
+	allocator_tlsf_t tlsf;
+	void * block;
+
+	allocator_counted_init_default( &parent );
+	allocator_tlsf_init( &tlsf, 1000, allocator_counted_get( &parent ) );
+	TEST_REQUIRE( tlsf.capacity >= 1000 );
+	TEST_REQUIRE( allocator_counted_get_current_count( &parent ) > 1000 );
+
+	block = allocator_alloc( 1000, allocator_tlsf_get( &tlsf ) );
+	TEST_REQUIRE( block );
+	allocator_free( block, allocator_tlsf_get( &tlsf ) );
+
+	allocator_tlsf_cleanup( &tlsf );
+	TEST_REQUIRE( allocator_counted_get_current_count( &parent ) == 0 );
+	TEST_REQUIRE( tlsf.capacity == 0 );
+	TEST_REQUIRE( allocator_alloc( 1, allocator_tlsf_get( &tlsf ) ) == 0 );
+}
+
+static void _ensure_allocator_tlsf_returns_aligned_blocks( void )
+{
+	allocator_tlsf_t tlsf;
+	allocator_t * alloc;
+	int8_t * a, * b;
+
+	allocator_tlsf_init_default( &tlsf, 4096 );
+	alloc = allocator_tlsf_get( &tlsf );
+
+	a = ( int8_t * ) allocator_alloc( 3, alloc );
+	b = ( int8_t * ) allocator_alloc( 5, alloc );
+	TEST_REQUIRE( a && b );
+	TEST_REQUIRE( ( ( size_t ) a ) % ALLOCATOR_TLSF_ALIGNMENT == 0 );
+	TEST_REQUIRE( ( ( size_t ) b ) % ALLOCATOR_TLSF_ALIGNMENT == 0 );
+	TEST_REQUIRE( b >= a + 3 || a >= b + 5 );
+	TEST_REQUIRE( tlsf.used == 2 * ALLOCATOR_TLSF_ALIGNMENT );
+
+	TEST_REQUIRE( allocator_alloc( 0, alloc ) == 0 );
+	TEST_REQUIRE( allocator_alloc( tlsf.capacity + 1, alloc ) == 0 );
+	allocator_free( 0, alloc );
+
+	allocator_free( a, alloc );
+	allocator_free( b, alloc );
+	TEST_REQUIRE( tlsf.used == 0 );
+	allocator_tlsf_cleanup( &tlsf );
+}
+
+static void _ensure_allocator_tlsf_coalesces_free_neighbours( void )
+{
+	allocator_tlsf_t tlsf;
+	allocator_t * alloc;
+	void * a, * b, * c, * whole;
+
+	allocator_tlsf_init_default( &tlsf, 4096 );
+	alloc = allocator_tlsf_get( &tlsf );
+
+	whole = allocator_alloc( tlsf.capacity, alloc );
+	TEST_REQUIRE( whole );
+	TEST_REQUIRE( allocator_alloc( 1, alloc ) == 0 );
+	allocator_free( whole, alloc );
+
+	a = allocator_alloc( 1000, alloc );
+	b = allocator_alloc( 1000, alloc );
+	c = allocator_alloc( 1000, alloc );
+	TEST_REQUIRE( a && b && c );
+	TEST_REQUIRE( allocator_alloc( tlsf.capacity, alloc ) == 0 );
+
+	/* Freeing the middle block last merges it with both neighbours */
+	allocator_free( a, alloc );
+	allocator_free( c, alloc );
+	TEST_REQUIRE( allocator_alloc( 2500, alloc ) == 0 );
+	allocator_free( b, alloc );
+
+	TEST_REQUIRE( allocator_alloc( tlsf.capacity, alloc ) == whole );
+	allocator_free( whole, alloc );
+	allocator_tlsf_cleanup( &tlsf );
+}
+
+static void _ensure_allocator_tlsf_uses_caller_storage( void )
+{
+	static int8_t storage[ 4096 ];
+	allocator_tlsf_t tlsf;
+	allocator_t * alloc;
+	int8_t * block;
+
+	allocator_tlsf_init_storage( &tlsf, storage, sizeof( storage ) );
+	alloc = allocator_tlsf_get( &tlsf );
+	TEST_REQUIRE( tlsf.parent == 0 );
+	TEST_REQUIRE( tlsf.capacity > 3000 && tlsf.capacity < sizeof( storage ) );
+
+	block = ( int8_t * ) allocator_alloc( 3000, alloc );
+	TEST_REQUIRE( block >= storage && block + 3000 <= storage + sizeof( storage ) );
+	allocator_free( block, alloc );
+	allocator_tlsf_cleanup( &tlsf );
+
+	allocator_tlsf_init_storage( &tlsf, storage, 8 );
+	TEST_REQUIRE( tlsf.capacity == 0 );
+	TEST_REQUIRE( allocator_alloc( 1, allocator_tlsf_get( &tlsf ) ) == 0 );
+}
+
+static void _ensure_allocator_tlsf_blocks_do_not_overlap( void )
+{
+	allocator_tlsf_t tlsf;
+	allocator_t * alloc;
+	int8_t * blocks[ 64 ];
+	size_t lengths[ 64 ];
+	size_t round, index, offset;
+	unsigned int seed = 1;
+	void * whole;
+
+	allocator_tlsf_init_default( &tlsf, 65536 );
+	alloc = allocator_tlsf_get( &tlsf );
+
+	for ( index = 0; index < 64; ++index )
+	{
+		blocks[ index ] = 0;
+	}
+
+	for ( round = 0; round < 4096; ++round )
+	{
+		seed = seed * 1103515245 + 12345;
+		index = ( seed >> 8 ) % 64;
+
+		if ( blocks[ index ] )
+		{
+			for ( offset = 0; offset < lengths[ index ]; ++offset )
+			{
+				TEST_REQUIRE( blocks[ index ][ offset ] == ( int8_t ) index );
+			}
+			allocator_free( blocks[ index ], alloc );
+			blocks[ index ] = 0;
+		}
+		else
+		{
+			lengths[ index ] = 1 + ( seed >> 16 ) % 3000;
+			blocks[ index ] = ( int8_t * ) allocator_alloc( lengths[ index ], alloc );
+			if ( blocks[ index ] )
+			{
+				memset( blocks[ index ], ( int ) index, lengths[ index ] );
+			}
+		}
+	}
+
+	for ( index = 0; index < 64; ++index )
+	{
+		allocator_free( blocks[ index ], alloc );
+	}
+
+	TEST_REQUIRE( tlsf.used == 0 );
+	whole = allocator_alloc( tlsf.capacity, alloc );
+	TEST_REQUIRE( whole );
+	allocator_free( whole, alloc );
+	allocator_tlsf_cleanup( &tlsf );
+}
+
+int main( int argc, char * argv[] )
+{
+	UNUSED( argc );
+	UNUSED( argv );
+
+	_ensure_allocator_tlsf_init_allocates_region_from_parent( );
+	_ensure_allocator_tlsf_returns_aligned_blocks( );
+	_ensure_allocator_tlsf_coalesces_free_neighbours( );
+	_ensure_allocator_tlsf_uses_caller_storage( );
+	_ensure_allocator_tlsf_blocks_do_not_overlap( );
+	return 0;
+}
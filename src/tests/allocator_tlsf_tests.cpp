@@ -0,0 +1 @@
+allocator_tlsf_tests.c
\ No newline at end of file
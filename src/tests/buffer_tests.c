@@ -398,6 +398,373 @@ static void _ensure_buffer_reserve_returns_non_null_pointer_on_success( void )
 	buffer_cleanup( &buffer );
 }
 
+static void _ensure_buffer_prepare_does_not_move_write_position( void )
+{
+	char data[] = "abcd";
+	int8_t * prepared;
+	buffer_t buffer;
+	buffer_init( &buffer, allocator_default( ) );
+	buffer_append( &buffer, 4, data );
+	prepared = ( int8_t * ) buffer_prepare( &buffer, 16 );
+	TEST_REQUIRE( prepared );
+	TEST_REQUIRE( prepared == ( const int8_t * ) buffer_data_pointer( &buffer ) + 4 );
+	TEST_REQUIRE( buffer_capacity( &buffer ) >= 20 );
+	TEST_REQUIRE( buffer_data_length( &buffer ) == 4 );
+	buffer_cleanup( &buffer );
+}
+
+static void _ensure_buffer_prepare_copes_with_null_buffer( void )
+{
+	TEST_REQUIRE( buffer_prepare( 0, 16 ) == 0 );
+}
+
+static void _ensure_buffer_commit_appends_prepared_bytes( void )
+{
+	int8_t * prepared;
+	buffer_t buffer;
+	buffer_init( &buffer, allocator_default( ) );
+	prepared = ( int8_t * ) buffer_prepare( &buffer, 16 );
+	memcpy( prepared, "abc", 3 );
+	TEST_REQUIRE( buffer_commit( &buffer, 3 ) == 3 );
+	TEST_REQUIRE( buffer_data_length( &buffer ) == 3 );
+	TEST_REQUIRE( memcmp( buffer_data_pointer( &buffer ), "abc", 3 ) == 0 );
+	buffer_cleanup( &buffer );
+}
+
+static void _ensure_buffer_commit_is_limited_to_capacity( void )
+{
+	buffer_t buffer;
+	buffer_init( &buffer, allocator_default( ) );
+	TEST_REQUIRE( buffer_commit( &buffer, 8 ) == 0 );
+	buffer_grow( &buffer, 8 );
+	TEST_REQUIRE( buffer_commit( &buffer, 12 ) == 8 );
+	TEST_REQUIRE( buffer_data_length( &buffer ) == 8 );
+	TEST_REQUIRE( buffer_commit( 0, 8 ) == 0 );
+	buffer_cleanup( &buffer );
+}
+
+static void _ensure_buffer_init_storage_uses_given_storage( void )
+{
+	char data[] = "abcd";
+	int8_t storage[ 16 ];
+	allocator_counted_t alloc;
+	buffer_t buffer;
+
+	allocator_counted_init_default( &alloc );
+	buffer_init_storage( &buffer, storage, sizeof( storage ), allocator_counted_get( &alloc ) );
+	TEST_REQUIRE( buffer_capacity( &buffer ) == sizeof( storage ) );
+	TEST_REQUIRE( buffer_data_length( &buffer ) == 0 );
+	TEST_REQUIRE( buffer_append( &buffer, 4, data ) == 4 );
+	TEST_REQUIRE( buffer_data_pointer( &buffer ) == storage );
+	TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) == 0 );
+	buffer_cleanup( &buffer );
+	TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) == 0 );
+}
+
+static void _ensure_buffer_init_storage_moves_to_allocator_when_full( void )
+{
+	char data[] = "abcdefgh";
+	int8_t storage[ 8 ];
+	allocator_counted_t alloc;
+	buffer_t buffer;
+
+	allocator_counted_init_default( &alloc );
+	buffer_init_storage( &buffer, storage, sizeof( storage ), allocator_counted_get( &alloc ) );
+	buffer_append( &buffer, 6, data );
+	TEST_REQUIRE( buffer_append( &buffer, 6, data ) == 6 );
+	TEST_REQUIRE( buffer_data_pointer( &buffer ) != storage );
+	TEST_REQUIRE( buffer_data_length( &buffer ) == 12 );
+	TEST_REQUIRE( memcmp( buffer_data_pointer( &buffer ), "abcdefabcdef", 12 ) == 0 );
+	TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) == 12 );
+	buffer_cleanup( &buffer );
+	TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) == 0 );
+}
+
+static void _ensure_buffer_init_storage_copes_with_missing_storage( void )
+{
+	int8_t storage[ 8 ];
+	buffer_t buffer;
+
+	buffer_init_storage( &buffer, 0, sizeof( storage ), allocator_default( ) );
+	TEST_REQUIRE( buffer_capacity( &buffer ) == 0 );
+	buffer_init_storage( &buffer, storage, 0, allocator_default( ) );
+	TEST_REQUIRE( buffer_capacity( &buffer ) == 0 );
+	buffer_init_storage( 0, storage, sizeof( storage ), allocator_default( ) );
+	buffer_cleanup( &buffer );
+}
+
+static void _ensure_buffer_trim_limits_capacity_to_given_maximum( void )
+{
+	char data[] = "abcd";
+	allocator_counted_t alloc;
+	buffer_t buffer;
+
+	allocator_counted_init_default( &alloc );
+	buffer_init( &buffer, allocator_counted_get( &alloc ) );
+	buffer_grow( &buffer, 1024 );
+	buffer_append( &buffer, 4, data );
+	TEST_REQUIRE( buffer_trim( &buffer, 2048 ) == 1024 );
+	TEST_REQUIRE( buffer_trim( &buffer, 64 ) == 64 );
+	TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) == 64 );
+	TEST_REQUIRE( buffer_data_length( &buffer ) == 4 );
+	TEST_REQUIRE( memcmp( buffer_data_pointer( &buffer ), "abcd", 4 ) == 0 );
+	TEST_REQUIRE( buffer_trim( &buffer, 2 ) == 4 );
+	buffer_cleanup( &buffer );
+	TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) == 0 );
+}
+
+static void _ensure_buffer_shrink_to_fit_releases_storage_of_empty_buffer( void )
+{
+	allocator_counted_t alloc;
+	buffer_t buffer;
+
+	allocator_counted_init_default( &alloc );
+	buffer_init( &buffer, allocator_counted_get( &alloc ) );
+	buffer_grow( &buffer, 1024 );
+	TEST_REQUIRE( buffer_shrink_to_fit( &buffer ) == 0 );
+	TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) == 0 );
+	TEST_REQUIRE( buffer_reserve( &buffer, 16 ) );
+	buffer_cleanup( &buffer );
+	TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) == 0 );
+}
+
+static void _ensure_buffer_trim_leaves_caller_storage_alone( void )
+{
+	int8_t storage[ 64 ];
+	buffer_t buffer;
+
+	buffer_init_storage( &buffer, storage, sizeof( storage ), allocator_default( ) );
+	TEST_REQUIRE( buffer_shrink_to_fit( &buffer ) == sizeof( storage ) );
+	TEST_REQUIRE( buffer_data_pointer( &buffer ) == storage );
+	TEST_REQUIRE( buffer_trim( 0, 0 ) == 0 );
+	buffer_cleanup( &buffer );
+}
+
+static void _ensure_buffer_fill_appends_given_value( void )
+{
+	char data[] = "ab";
+	buffer_t buffer;
+
+	buffer_init( &buffer, allocator_default( ) );
+	buffer_append( &buffer, 2, data );
+	TEST_REQUIRE( buffer_fill( &buffer, 100, 'x' ) == 100 );
+	TEST_REQUIRE( buffer_data_length( &buffer ) == 102 );
+	TEST_REQUIRE( ( ( char * ) buffer_data_pointer( &buffer ) )[ 1 ] == 'b' );
+	TEST_REQUIRE( ( ( char * ) buffer_data_pointer( &buffer ) )[ 2 ] == 'x' );
+	TEST_REQUIRE( ( ( char * ) buffer_data_pointer( &buffer ) )[ 101 ] == 'x' );
+	TEST_REQUIRE( buffer_fill( &buffer, 0, 'x' ) == 0 );
+	TEST_REQUIRE( buffer_fill( 0, 10, 'x' ) == 0 );
+	buffer_cleanup( &buffer );
+}
+
+static void _ensure_buffer_find_searches_data_from_offset( void )
+{
+	buffer_t buffer;
+	char * data;
+
+	buffer_init( &buffer, allocator_default( ) );
+	buffer_fill( &buffer, 200, 'a' );
+	data = ( char * ) buffer_data_pointer( &buffer );
+	data[ 10 ] = data[ 150 ] = 'b';
+	TEST_REQUIRE( buffer_find( &buffer, 0, 'b' ) == data + 10 );
+	TEST_REQUIRE( buffer_find( &buffer, 11, 'b' ) == data + 150 );
+	TEST_REQUIRE( buffer_find( &buffer, 151, 'b' ) == 0 );
+	TEST_REQUIRE( buffer_find( &buffer, 200, 'a' ) == 0 );
+	TEST_REQUIRE( buffer_find( 0, 0, 'a' ) == 0 );
+	buffer_rewind( &buffer );
+	TEST_REQUIRE( buffer_find( &buffer, 0, 'a' ) == 0 );
+	buffer_cleanup( &buffer );
+}
+
+static void _ensure_buffer_equal_compares_data_and_length( void )
+{
+	char data[ 100 ];
+	buffer_t buffer;
+
+	memset( data, 'z', sizeof( data ) );
+	buffer_init( &buffer, allocator_default( ) );
+	TEST_REQUIRE( buffer_equal( &buffer, 0, 0 ) );
+	buffer_fill( &buffer, sizeof( data ), 'z' );
+	TEST_REQUIRE( buffer_equal( &buffer, sizeof( data ), data ) );
+	TEST_REQUIRE( !buffer_equal( &buffer, sizeof( data ) - 1, data ) );
+	data[ 99 ] = 'y';
+	TEST_REQUIRE( !buffer_equal( &buffer, sizeof( data ), data ) );
+	TEST_REQUIRE( !buffer_equal( &buffer, sizeof( data ), 0 ) );
+	TEST_REQUIRE( !buffer_equal( 0, 0, 0 ) );
+	buffer_cleanup( &buffer );
+}
+
+static void _ensure_buffer_grow_preserves_data_above_stream_threshold( void )
+{
+	buffer_t buffer;
+	size_t i, length = 100003;
+	unsigned char * data;
+
+	buffer_init( &buffer, allocator_default( ) );
+	buffer_set_stream_threshold( &buffer, 4096 );
+	data = ( unsigned char * ) buffer_reserve( &buffer, length );
+	for ( i = 0; i < length; ++i )
+	{
+		data[ i ] = ( unsigned char ) i;
+	}
+	buffer_grow( &buffer, 1 );
+	data = ( unsigned char * ) buffer_data_pointer( &buffer );
+	for ( i = 0; i < length; ++i )
+	{
+		TEST_REQUIRE( data[ i ] == ( unsigned char ) i );
+	}
+	buffer_cleanup( &buffer );
+}
+
+static void _ensure_buffer_stream_threshold_defaults_to_detected_threshold( void )
+{
+	buffer_t buffer;
+	buffer_init( &buffer, allocator_default( ) );
+	TEST_REQUIRE( buffer_stream_threshold( &buffer ) > 0 );
+	TEST_REQUIRE( buffer_stream_threshold( &buffer ) == buffer_stream_threshold( 0 ) );
+	buffer_set_stream_threshold( &buffer, 12345 );
+	TEST_REQUIRE( buffer_stream_threshold( &buffer ) == 12345 );
+	buffer_set_stream_threshold( &buffer, 0 );
+	TEST_REQUIRE( buffer_stream_threshold( &buffer ) == buffer_stream_threshold( 0 ) );
+	buffer_set_stream_threshold( 0, 12345 );
+	buffer_cleanup( &buffer );
+}
+
+#if defined(__cplusplus)
+static const char * _buffer_test_file = "buffer_tests_cpp.tmp";
+#else
+static const char * _buffer_test_file = "buffer_tests.tmp";
+#endif
+
+static size_t _read_test_file( char * data, size_t length )
+{
+	size_t result = 0;
+	FILE * file = fopen( _buffer_test_file, "rb" );
+	if ( file )
+	{
+		result = fread( data, 1, length, file );
+		fclose( file );
+	}
+	return result;
+}
+
+static void _ensure_buffer_init_file_fails_when_given_bad_arguments( void )
+{
+	buffer_t buffer;
+	TEST_REQUIRE( buffer_init_file( 0, _buffer_test_file ) == 0 );
+	TEST_REQUIRE( buffer_init_file( &buffer, 0 ) == 0 );
+	TEST_REQUIRE( buffer_init_file( &buffer, "no/such/directory/buffer" ) == 0 );
+	TEST_REQUIRE( buffer_reserve( &buffer, 1 ) == 0 );
+	buffer_cleanup( &buffer );
+}
+
+static void _ensure_buffer_file_writes_appended_data_to_file( void )
+{
+	char data[] = "journal";
+	char output[ 16 ];
+	buffer_t buffer;
+
+	remove( _buffer_test_file );
+	TEST_REQUIRE( buffer_init_file( &buffer, _buffer_test_file ) );
+	TEST_REQUIRE( buffer_capacity( &buffer ) == 0 );
+	TEST_REQUIRE( buffer_append( &buffer, 7, data ) == 7 );
+	TEST_REQUIRE( buffer_capacity( &buffer ) >= 7 );
+	TEST_REQUIRE( buffer_sync( &buffer ) );
+	buffer_cleanup( &buffer );
+	TEST_REQUIRE( _read_test_file( output, sizeof( output ) ) == 7 );
+	TEST_REQUIRE( memcmp( output, "journal", 7 ) == 0 );
+	remove( _buffer_test_file );
+}
+
+static void _ensure_buffer_file_appends_to_existing_file( void )
+{
+	char first[] = "abc", second[] = "def";
+	char output[ 16 ];
+	buffer_t buffer;
+
+	remove( _buffer_test_file );
+	buffer_init_file( &buffer, _buffer_test_file );
+	buffer_append( &buffer, 3, first );
+	buffer_cleanup( &buffer );
+
+	TEST_REQUIRE( buffer_init_file( &buffer, _buffer_test_file ) );
+	TEST_REQUIRE( buffer_data_length( &buffer ) == 3 );
+	TEST_REQUIRE( memcmp( buffer_data_pointer( &buffer ), "abc", 3 ) == 0 );
+	buffer_append( &buffer, 3, second );
+	buffer_cleanup( &buffer );
+
+	TEST_REQUIRE( _read_test_file( output, sizeof( output ) ) == 6 );
+	TEST_REQUIRE( memcmp( output, "abcdef", 6 ) == 0 );
+	remove( _buffer_test_file );
+}
+
+static void _ensure_buffer_file_preserves_data_when_grown( void )
+{
+	int i;
+	buffer_t buffer;
+
+	remove( _buffer_test_file );
+	buffer_init_file( &buffer, _buffer_test_file );
+	for ( i = 0; i < 100000; ++i )
+	{
+		TEST_REQUIRE( buffer_append( &buffer, sizeof( i ), &i ) == sizeof( i ) );
+	}
+	TEST_REQUIRE( buffer_data_length( &buffer ) == 100000 * sizeof( i ) );
+	for ( i = 0; i < 100000; ++i )
+	{
+		TEST_REQUIRE( ( ( int * ) buffer_data_pointer( &buffer ) )[ i ] == i );
+	}
+	buffer_cleanup( &buffer );
+	remove( _buffer_test_file );
+}
+
+static void _ensure_buffer_file_is_truncated_to_data_length_on_cleanup( void )
+{
+	char data[] = "abcdef";
+	char output[ 16 ];
+	buffer_t buffer;
+
+	remove( _buffer_test_file );
+	buffer_init_file( &buffer, _buffer_test_file );
+	buffer_append( &buffer, 6, data );
+	buffer_rewind( &buffer );
+	buffer_append( &buffer, 2, data );
+	buffer_cleanup( &buffer );
+	TEST_REQUIRE( buffer.fd == -1 && buffer.flags == 0 );
+	TEST_REQUIRE( _read_test_file( output, sizeof( output ) ) == 2 );
+	remove( _buffer_test_file );
+}
+
+static void _ensure_buffer_file_shrinks_to_whole_pages( void )
+{
+	char data[] = "abcd";
+	char output[ 16 ];
+	buffer_t buffer;
+	size_t capacity;
+
+	remove( _buffer_test_file );
+	buffer_init_file( &buffer, _buffer_test_file );
+	buffer_grow( &buffer, 1 << 20 );
+	buffer_append( &buffer, 4, data );
+	capacity = buffer_shrink_to_fit( &buffer );
+	TEST_REQUIRE( capacity >= 4 && capacity < ( 1 << 20 ) );
+	TEST_REQUIRE( memcmp( buffer_data_pointer( &buffer ), "abcd", 4 ) == 0 );
+	TEST_REQUIRE( buffer_append( &buffer, 4, data ) == 4 );
+	buffer_cleanup( &buffer );
+	TEST_REQUIRE( _read_test_file( output, sizeof( output ) ) == 8 );
+	TEST_REQUIRE( memcmp( output, "abcdabcd", 8 ) == 0 );
+	remove( _buffer_test_file );
+}
+
+static void _ensure_buffer_sync_fails_for_heap_buffers( void )
+{
+	buffer_t buffer;
+	buffer_init( &buffer, allocator_default( ) );
+	TEST_REQUIRE( buffer_sync( &buffer ) == 0 );
+	TEST_REQUIRE( buffer_sync( 0 ) == 0 );
+	buffer_cleanup( &buffer );
+}
+
 int main( int argc, char * argv[] )
 {
 	UNUSED( argc );
@@ -446,5 +813,27 @@ int main( int argc, char * argv[] )
 	_ensure_buffer_reserve_copes_with_cleaned_up_buffer( );
 	_ensure_buffer_reserve_does_not_mutate_buffer_when_given_zero_data_length( );
 	_ensure_buffer_reserve_returns_non_null_pointer_on_success( );
+	_ensure_buffer_prepare_does_not_move_write_position( );
+	_ensure_buffer_prepare_copes_with_null_buffer( );
+	_ensure_buffer_commit_appends_prepared_bytes( );
+	_ensure_buffer_commit_is_limited_to_capacity( );
+	_ensure_buffer_init_storage_uses_given_storage( );
+	_ensure_buffer_init_storage_moves_to_allocator_when_full( );
+	_ensure_buffer_init_storage_copes_with_missing_storage( );
+	_ensure_buffer_trim_limits_capacity_to_given_maximum( );
+	_ensure_buffer_shrink_to_fit_releases_storage_of_empty_buffer( );
+	_ensure_buffer_trim_leaves_caller_storage_alone( );
+	_ensure_buffer_fill_appends_given_value( );
+	_ensure_buffer_find_searches_data_from_offset( );
+	_ensure_buffer_equal_compares_data_and_length( );
+	_ensure_buffer_grow_preserves_data_above_stream_threshold( );
+	_ensure_buffer_stream_threshold_defaults_to_detected_threshold( );
+	_ensure_buffer_init_file_fails_when_given_bad_arguments( );
+	_ensure_buffer_file_writes_appended_data_to_file( );
+	_ensure_buffer_file_appends_to_existing_file( );
+	_ensure_buffer_file_preserves_data_when_grown( );
+	_ensure_buffer_file_is_truncated_to_data_length_on_cleanup( );
+	_ensure_buffer_file_shrinks_to_whole_pages( );
+	_ensure_buffer_sync_fails_for_heap_buffers( );
 	return 0;
 }
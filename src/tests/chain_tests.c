@@ -0,0 +1,225 @@
+#include <string.h>
+
+#include "../mem/chain.h"
+#include "../mem/internal/unused.h"
+#include "testing.h"
+
+static void _ensure_chain_new_returns_null_when_allocation_fails( void )
+{
+	TEST_REQUIRE( chain_new( 16, allocator_always_fail( ) ) == 0 );
+}
+
+static void _ensure_chain_new_initialises_empty_chain( void )
+{
+	chain_t * chain = chain_new( 0, allocator_default( ) );
+	TEST_REQUIRE( chain );
+	TEST_REQUIRE( chain->segment_size == CHAIN_DEFAULT_SEGMENT_SIZE );
+	TEST_REQUIRE( chain_data_length( chain ) == 0 );
+	TEST_REQUIRE( chain_segment_count( chain ) == 0 );
+	chain_delete( chain );
+}
+
+static void _ensure_chain_delete_releases_all_memory( void )
+{
+	allocator_counted_t alloc;
+	chain_t * chain;
+
+	allocator_counted_init_default( &alloc );
+	chain = chain_new( 4, allocator_counted_get( &alloc ) );
+	chain_append( chain, 10, "0123456789" );
+	chain_delete( chain );
+	TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) == 0 );
+}
+
+static void _ensure_chain_delete_copes_with_null_chain( void )
+{
+	chain_delete( 0 );
+}
+
+static void _ensure_chain_cleanup_copes_with_cleaned_up_chain( void )
+{
+	chain_t chain;
+	chain_init( &chain, 4, allocator_default( ) );
+	chain_append( &chain, 6, "abcdef" );
+	chain_cleanup( &chain );
+	chain_cleanup( &chain );
+	TEST_REQUIRE( chain_data_length( &chain ) == 0 );
+}
+
+static void _ensure_chain_append_links_segments_without_moving_data( void )
+{
+	chain_t chain;
+	void * first;
+
+	chain_init( &chain, 4, allocator_default( ) );
+	TEST_REQUIRE( chain_append( &chain, 3, "abc" ) == 3 );
+	first = chain.head;
+	TEST_REQUIRE( chain_append( &chain, 7, "defghij" ) == 7 );
+	TEST_REQUIRE( chain.head == first );
+	TEST_REQUIRE( chain_data_length( &chain ) == 10 );
+	TEST_REQUIRE( chain_segment_count( &chain ) == 3 );
+	chain_cleanup( &chain );
+}
+
+static void _ensure_chain_append_returns_zero_when_allocation_fails( void )
+{
+	chain_t chain;
+	chain_init( &chain, 4, allocator_always_fail( ) );
+	TEST_REQUIRE( chain_append( &chain, 3, "abc" ) == 0 );
+	TEST_REQUIRE( chain_data_length( &chain ) == 0 );
+	chain_cleanup( &chain );
+}
+
+static void _ensure_chain_spans_describe_data_in_order( void )
+{
+	span_t spans[ 4 ];
+	chain_t chain;
+
+	chain_init( &chain, 4, allocator_default( ) );
+	chain_append( &chain, 10, "0123456789" );
+	TEST_REQUIRE( chain_spans( &chain, spans, 4 ) == 3 );
+	TEST_REQUIRE( spans[ 0 ].length == 4 && memcmp( spans[ 0 ].data, "0123", 4 ) == 0 );
+	TEST_REQUIRE( spans[ 1 ].length == 4 && memcmp( spans[ 1 ].data, "4567", 4 ) == 0 );
+	TEST_REQUIRE( spans[ 2 ].length == 2 && memcmp( spans[ 2 ].data, "89", 2 ) == 0 );
+	TEST_REQUIRE( chain_spans( &chain, spans, 2 ) == 2 );
+	chain_cleanup( &chain );
+}
+
+static void _ensure_chain_reserve_returns_contiguous_block( void )
+{
+	span_t spans[ 4 ];
+	char * block;
+	chain_t chain;
+
+	chain_init( &chain, 8, allocator_default( ) );
+	chain_append( &chain, 5, "abcde" );
+	block = ( char * ) chain_reserve( &chain, 6 );
+	TEST_REQUIRE( block );
+	memcpy( block, "fghijk", 6 );
+	TEST_REQUIRE( chain_data_length( &chain ) == 11 );
+	TEST_REQUIRE( chain_spans( &chain, spans, 4 ) == 2 );
+	TEST_REQUIRE( spans[ 1 ].data == block && spans[ 1 ].length == 6 );
+	TEST_REQUIRE( chain_reserve( &chain, 9 ) == 0 );
+	TEST_REQUIRE( chain_reserve( &chain, 0 ) == 0 );
+	chain_cleanup( &chain );
+}
+
+static void _ensure_chain_rewind_reuses_segments( void )
+{
+	allocator_counted_t alloc;
+	size_t peak;
+	chain_t chain;
+
+	allocator_counted_init_default( &alloc );
+	chain_init( &chain, 4, allocator_counted_get( &alloc ) );
+	chain_append( &chain, 12, "0123456789ab" );
+	peak = allocator_counted_get_peak_count( &alloc );
+	chain_rewind( &chain );
+	TEST_REQUIRE( chain_data_length( &chain ) == 0 );
+	TEST_REQUIRE( chain_segment_count( &chain ) == 0 );
+	chain_append( &chain, 12, "cdefghijklmn" );
+	TEST_REQUIRE( allocator_counted_get_peak_count( &alloc ) == peak );
+	TEST_REQUIRE( chain_segment_count( &chain ) == 3 );
+	chain_cleanup( &chain );
+	TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) == 0 );
+}
+
+static void _ensure_chain_flatten_copies_all_data_to_buffer( void )
+{
+	buffer_t buffer;
+	chain_t chain;
+
+	chain_init( &chain, 4, allocator_default( ) );
+	buffer_init( &buffer, allocator_default( ) );
+	chain_append( &chain, 10, "0123456789" );
+	TEST_REQUIRE( chain_flatten( &chain, &buffer ) == 10 );
+	TEST_REQUIRE( buffer_data_length( &buffer ) == 10 );
+	TEST_REQUIRE( memcmp( buffer_data_pointer( &buffer ), "0123456789", 10 ) == 0 );
+	buffer_cleanup( &buffer );
+	chain_cleanup( &chain );
+}
+
+static void _ensure_chain_functions_cope_with_null_chain( void )
+{
+	span_t spans[ 1 ];
+	chain_init( 0, 4, allocator_default( ) );
+	chain_cleanup( 0 );
+	chain_rewind( 0 );
+	TEST_REQUIRE( chain_data_length( 0 ) == 0 );
+	TEST_REQUIRE( chain_segment_count( 0 ) == 0 );
+	TEST_REQUIRE( chain_append( 0, 1, "a" ) == 0 );
+	TEST_REQUIRE( chain_reserve( 0, 1 ) == 0 );
+	TEST_REQUIRE( chain_spans( 0, spans, 1 ) == 0 );
+	TEST_REQUIRE( chain_flatten( 0, 0 ) == 0 );
+}
+
+static void _ensure_chain_prepare_describes_free_space_across_segments( void )
+{
+	span_t spans[ 4 ];
+	chain_t chain;
+
+	chain_init( &chain, 4, allocator_default( ) );
+	chain_append( &chain, 3, "abc" );
+	TEST_REQUIRE( chain_prepare( &chain, 6, spans, 4 ) == 3 );
+	TEST_REQUIRE( spans[ 0 ].length == 1 );
+	TEST_REQUIRE( spans[ 1 ].length == 4 );
+	TEST_REQUIRE( spans[ 2 ].length == 1 );
+	TEST_REQUIRE( chain_data_length( &chain ) == 3 );
+	TEST_REQUIRE( chain_prepare( &chain, 6, spans, 2 ) == 2 );
+	chain_cleanup( &chain );
+}
+
+static void _ensure_chain_commit_appends_prepared_bytes( void )
+{
+	span_t spans[ 4 ];
+	chain_t chain;
+
+	chain_init( &chain, 4, allocator_default( ) );
+	chain_append( &chain, 3, "abc" );
+	chain_prepare( &chain, 6, spans, 4 );
+	memcpy( spans[ 0 ].data, "d", 1 );
+	memcpy( spans[ 1 ].data, "efgh", 4 );
+	TEST_REQUIRE( chain_commit( &chain, 5 ) == 5 );
+	TEST_REQUIRE( chain_data_length( &chain ) == 8 );
+	TEST_REQUIRE( chain_spans( &chain, spans, 4 ) == 2 );
+	TEST_REQUIRE( memcmp( spans[ 1 ].data, "efgh", 4 ) == 0 );
+	TEST_REQUIRE( chain_append( &chain, 2, "ij" ) == 2 );
+	TEST_REQUIRE( chain_segment_count( &chain ) == 3 );
+	chain_cleanup( &chain );
+}
+
+static void _ensure_chain_commit_is_limited_to_prepared_space( void )
+{
+	span_t spans[ 4 ];
+	chain_t chain;
+
+	chain_init( &chain, 4, allocator_default( ) );
+	chain_prepare( &chain, 6, spans, 4 );
+	TEST_REQUIRE( chain_commit( &chain, 100 ) == 8 );
+	TEST_REQUIRE( chain_data_length( &chain ) == 8 );
+	TEST_REQUIRE( chain_commit( 0, 1 ) == 0 );
+	chain_cleanup( &chain );
+}
+
+int main( int argc, char * argv[] )
+{
+	UNUSED( argc );
+	UNUSED( argv );
+
+	_ensure_chain_new_returns_null_when_allocation_fails( );
+	_ensure_chain_new_initialises_empty_chain( );
+	_ensure_chain_delete_releases_all_memory( );
+	_ensure_chain_delete_copes_with_null_chain( );
+	_ensure_chain_cleanup_copes_with_cleaned_up_chain( );
+	_ensure_chain_append_links_segments_without_moving_data( );
+	_ensure_chain_append_returns_zero_when_allocation_fails( );
+	_ensure_chain_spans_describe_data_in_order( );
+	_ensure_chain_reserve_returns_contiguous_block( );
+	_ensure_chain_rewind_reuses_segments( );
+	_ensure_chain_flatten_copies_all_data_to_buffer( );
+	_ensure_chain_functions_cope_with_null_chain( );
+	_ensure_chain_prepare_describes_free_space_across_segments( );
+	_ensure_chain_commit_appends_prepared_bytes( );
+	_ensure_chain_commit_is_limited_to_prepared_space( );
+	return 0;
+}
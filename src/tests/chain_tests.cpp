@@ -0,0 +1 @@
+chain_tests.c
\ No newline at end of file
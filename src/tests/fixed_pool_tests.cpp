@@ -0,0 +1,116 @@
+#include "../mem/fixed_pool.hpp"
+#include "../mem/internal/unused.h"
+#include "testing.h"
+
+typedef mem::FixedPool< 24, 8 > _small_pool_t;
+typedef mem::FixedPool< 100, 64, 64 > _large_pool_t;
+
+static_assert( _small_pool_t::stride % alignof( std::max_align_t ) == 0, "stride must respect alignment" );
+static_assert( _small_pool_t::is_inline, "small pools must be held inline" );
+static_assert( !_large_pool_t::is_inline, "large pools must be allocator-backed" );
+static_assert( _large_pool_t::stride == 128, "stride must be rounded up to the alignment" );
+static_assert( mem::FixedPool< 1, 4, 1 >::stride == sizeof( void * ), "stride must hold a free list pointer" );
+
+#if __cplusplus >= 201402L
+/* Inline pools can be constructed in a constant expression */
+static constexpr mem::FixedPool< 16, 4 > _constant_pool;
+#endif
+
+static void _ensure_fixed_pool_take_returns_distinct_elements_until_empty( void )
+{
+	_small_pool_t pool;
+	void * elements[ 8 ];
+	size_t i, j;
+
+	for ( i = 0; i < 8; ++i )
+	{
+		TEST_REQUIRE( !pool.empty( ) );
+		elements[ i ] = pool.take( );
+		TEST_REQUIRE( elements[ i ] );
+		TEST_REQUIRE( ( ( size_t ) elements[ i ] ) % _small_pool_t::alignment == 0 );
+		for ( j = 0; j < i; ++j )
+		{
+			TEST_REQUIRE( elements[ i ] != elements[ j ] );
+		}
+	}
+
+	TEST_REQUIRE( pool.empty( ) );
+	TEST_REQUIRE( pool.take( ) == 0 );
+}
+
+static void _ensure_fixed_pool_reuses_released_elements( void )
+{
+	_small_pool_t pool;
+	void * first = pool.take( );
+	void * second = pool.take( );
+
+	pool.release( first );
+	pool.release( second );
+	TEST_REQUIRE( pool.take( ) == second );
+	TEST_REQUIRE( pool.take( ) == first );
+}
+
+static void _ensure_fixed_pool_indexes_elements( void )
+{
+	_small_pool_t pool;
+	mem::FixedPool< 24, 8, 8 > odd_pool;
+	size_t i;
+
+	for ( i = 0; i < 8; ++i )
+	{
+		void * element = pool.take( );
+		void * odd_element = odd_pool.take( );
+		TEST_REQUIRE( pool.index_of( element ) == i );
+		TEST_REQUIRE( pool.at( i ) == element );
+		TEST_REQUIRE( pool.contains( element ) );
+		TEST_REQUIRE( odd_pool.index_of( odd_element ) == i );
+		TEST_REQUIRE( odd_pool.at( i ) == odd_element );
+	}
+
+	TEST_REQUIRE( !pool.contains( ( char * ) pool.at( 1 ) + 1 ) );
+	TEST_REQUIRE( !pool.contains( odd_pool.at( 0 ) ) );
+}
+
+static void _ensure_fixed_pool_allocates_large_storage_from_allocator( void )
+{
+	allocator_counted_t alloc;
+	allocator_counted_init_default( &alloc );
+	{
+		_large_pool_t pool( allocator_counted_get( &alloc ) );
+		void * element = pool.take( );
+		TEST_REQUIRE( element );
+		TEST_REQUIRE( ( ( size_t ) element ) % 64 == 0 );
+		TEST_REQUIRE( pool.index_of( pool.take( ) ) == 1 );
+		TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) >= _large_pool_t::storage_size );
+	}
+	TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) == 0 );
+}
+
+static void _ensure_fixed_pool_is_empty_when_storage_cannot_be_allocated( void )
+{
+	_large_pool_t pool( allocator_always_fail( ) );
+	TEST_REQUIRE( pool.empty( ) );
+	TEST_REQUIRE( pool.take( ) == 0 );
+	TEST_REQUIRE( !pool.contains( &pool ) );
+}
+
+static void _ensure_fixed_pool_constant_pool_is_full( void )
+{
+#if __cplusplus >= 201402L
+	TEST_REQUIRE( !_constant_pool.empty( ) );
+#endif
+}
+
+int main( int argc, char * argv[] )
+{
+	UNUSED( argc );
+	UNUSED( argv );
+
+	_ensure_fixed_pool_take_returns_distinct_elements_until_empty( );
+	_ensure_fixed_pool_reuses_released_elements( );
+	_ensure_fixed_pool_indexes_elements( );
+	_ensure_fixed_pool_allocates_large_storage_from_allocator( );
+	_ensure_fixed_pool_is_empty_when_storage_cannot_be_allocated( );
+	_ensure_fixed_pool_constant_pool_is_full( );
+	return 0;
+}
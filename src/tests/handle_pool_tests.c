@@ -0,0 +1,112 @@
+#include "../mem/handle_pool.h"
+#include "../mem/internal/unused.h"
+#include "testing.h"
+
+static void _ensure_handle_pool_init_allocates_elements( void )
+{
+	allocator_counted_t alloc;
+	handle_pool_t pool;
+
+	allocator_counted_init_default( &alloc );
+	handle_pool_init( &pool, 4, 10, allocator_counted_get( &alloc ) );
+	TEST_REQUIRE( pool.num_elements == 10 );
+	TEST_REQUIRE( pool.element_size == 4 );
+	TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) == 10 * 4 + 10 * sizeof( uint32_t ) );
+	TEST_REQUIRE( !handle_pool_is_empty( &pool ) );
+	handle_pool_cleanup( &pool );
+	TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) == 0 );
+	TEST_REQUIRE( handle_pool_is_empty( &pool ) );
+	TEST_REQUIRE( handle_pool_take( &pool ) == HANDLE_NULL );
+}
+
+static void _ensure_handle_pool_resolves_handles_by_index( void )
+{
+	handle_pool_t * pool = handle_pool_new( 4, 3, allocator_default( ) );
+	handle_t handles[ 3 ];
+	size_t i;
+
+	for ( i = 0; i < 3; ++i )
+	{
+		handles[ i ] = handle_pool_take( pool );
+		TEST_REQUIRE( handles[ i ] != HANDLE_NULL );
+		TEST_REQUIRE( handle_index( handles[ i ] ) < 3 );
+		TEST_REQUIRE( handle_pool_get( pool, handles[ i ] ) == pool->elements + handle_index( handles[ i ] ) * 4 );
+		*( ( uint32_t * ) handle_pool_get( pool, handles[ i ] ) ) = ( uint32_t ) i;
+	}
+
+	TEST_REQUIRE( handle_pool_is_empty( pool ) );
+	TEST_REQUIRE( handle_pool_take( pool ) == HANDLE_NULL );
+	TEST_REQUIRE( pool->count == 3 );
+
+	for ( i = 0; i < 3; ++i )
+	{
+		TEST_REQUIRE( *( ( uint32_t * ) handle_pool_get( pool, handles[ i ] ) ) == i );
+		TEST_REQUIRE( handle_pool_return( pool, handles[ i ] ) );
+	}
+
+	TEST_REQUIRE( pool->count == 0 );
+	handle_pool_delete( pool );
+}
+
+static void _ensure_handle_pool_rejects_stale_handles( void )
+{
+	handle_pool_t pool;
+	handle_t first, second;
+
+	handle_pool_init( &pool, 8, 1, allocator_default( ) );
+
+	first = handle_pool_take( &pool );
+	TEST_REQUIRE( handle_pool_is_valid( &pool, first ) );
+	TEST_REQUIRE( handle_pool_return( &pool, first ) );
+	TEST_REQUIRE( handle_pool_handle( &pool, 0 ) == HANDLE_NULL );
+	TEST_REQUIRE( !handle_pool_is_valid( &pool, first ) );
+	TEST_REQUIRE( handle_pool_get( &pool, first ) == 0 );
+	TEST_REQUIRE( !handle_pool_return( &pool, first ) );
+
+	/* The element is reused, under a new generation */
+	second = handle_pool_take( &pool );
+	TEST_REQUIRE( second != first );
+	TEST_REQUIRE( handle_index( second ) == handle_index( first ) );
+	TEST_REQUIRE( handle_pool_get( &pool, second ) == pool.elements );
+	TEST_REQUIRE( handle_pool_get( &pool, first ) == 0 );
+	TEST_REQUIRE( !handle_pool_return( &pool, first ) );
+	TEST_REQUIRE( handle_pool_is_valid( &pool, second ) );
+	TEST_REQUIRE( handle_pool_handle( &pool, 0 ) == second );
+	TEST_REQUIRE( handle_pool_handle( &pool, 1 ) == HANDLE_NULL );
+
+	TEST_REQUIRE( handle_pool_get( &pool, HANDLE_NULL ) == 0 );
+	TEST_REQUIRE( handle_pool_get( &pool, second + 1 ) == 0 );
+	TEST_REQUIRE( handle_pool_get( 0, second ) == 0 );
+
+	handle_pool_cleanup( &pool );
+}
+
+static void _ensure_handle_pool_generations_never_produce_null( void )
+{
+	handle_pool_t pool;
+	handle_t handle;
+	size_t i;
+
+	handle_pool_init( &pool, 1, 1, allocator_default( ) );
+
+	for ( i = 0; i < ( ( size_t ) 1 << ( 32 - HANDLE_POOL_INDEX_BITS ) ) + 2; ++i )
+	{
+		handle = handle_pool_take( &pool );
+		TEST_REQUIRE( handle != HANDLE_NULL );
+		TEST_REQUIRE( handle_pool_return( &pool, handle ) );
+	}
+
+	handle_pool_cleanup( &pool );
+}
+
+int main( int argc, char * argv[] )
+{
+	UNUSED( argc );
+	UNUSED( argv );
+
+	_ensure_handle_pool_init_allocates_elements( );
+	_ensure_handle_pool_resolves_handles_by_index( );
+	_ensure_handle_pool_rejects_stale_handles( );
+	_ensure_handle_pool_generations_never_produce_null( );
+	return 0;
+}
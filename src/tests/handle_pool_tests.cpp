@@ -0,0 +1 @@
+handle_pool_tests.c
\ No newline at end of file
@@ -0,0 +1,93 @@
+#define LIBMEM_INLINE
+
+#include "../mem/allocator.h"
+#include "../mem/buffer.h"
+#include "../mem/pool.h"
+#include "../mem/internal/unused.h"
+#include "testing.h"
+
+
+static void _ensure_allocator_alloc_inline_matches_allocator_alloc( void )
+{
+	void * mem;
+	TEST_REQUIRE( allocator_alloc( 1024, 0 ) == 0 );
+	TEST_REQUIRE( allocator_alloc( 1024, allocator_always_fail( ) ) == 0 );
+	mem = allocator_alloc( 1024, allocator_default( ) );
+	TEST_REQUIRE( mem );
+	allocator_free( mem, allocator_default( ) );
+	allocator_free( 0, 0 );
+}
+
+
+static void _ensure_pool_take_inline_matches_pool_take( void )
+{
+	void * first, * second;
+	pool_t pool;
+	pool_init( &pool, 16, 2, allocator_default( ) );
+	first = pool_take( &pool );
+	second = pool_take( &pool );
+	TEST_REQUIRE( first && second && first != second );
+	TEST_REQUIRE( pool_take( &pool ) == 0 );
+	TEST_REQUIRE( pool_take( 0 ) == 0 );
+	pool_return( &pool, second );
+	TEST_REQUIRE( pool_take( &pool ) == second );
+	pool_cleanup( &pool );
+}
+
+
+static void _ensure_pool_return_inline_ignores_address_not_in_pool( void )
+{
+	unsigned item_not_in_pool;
+	pool_t pool;
+	pool_init( &pool, 4, 1, allocator_default( ) );
+	pool_return( &pool, &item_not_in_pool );
+	pool_return( 0, &item_not_in_pool );
+	TEST_REQUIRE( pool_take( &pool ) != &item_not_in_pool );
+	TEST_REQUIRE( pool_take( &pool ) == 0 );
+	pool_cleanup( &pool );
+}
+
+
+static void _ensure_buffer_reserve_inline_grows_buffer_when_required( void )
+{
+	int8_t * first, * second;
+	buffer_t buffer;
+	buffer_init( &buffer, allocator_default( ) );
+	first = ( int8_t * ) buffer_reserve( &buffer, 8 );
+	TEST_REQUIRE( first );
+	TEST_REQUIRE( buffer_capacity( &buffer ) == 8 );
+	second = ( int8_t * ) buffer_reserve( &buffer, 8 );
+	TEST_REQUIRE( second );
+	TEST_REQUIRE( buffer_data_length( &buffer ) == 16 );
+	buffer_cleanup( &buffer );
+}
+
+
+static void _ensure_buffer_reserve_inline_uses_existing_capacity( void )
+{
+	int8_t * first, * second;
+	buffer_t buffer;
+	buffer_init( &buffer, allocator_default( ) );
+	buffer_grow( &buffer, 16 );
+	first = ( int8_t * ) buffer_reserve( &buffer, 8 );
+	second = ( int8_t * ) buffer_reserve( &buffer, 8 );
+	TEST_REQUIRE( second - first == 8 );
+	TEST_REQUIRE( buffer_capacity( &buffer ) == 16 );
+	TEST_REQUIRE( buffer_reserve( &buffer, 0 ) == 0 );
+	TEST_REQUIRE( buffer_reserve( 0, 8 ) == 0 );
+	buffer_cleanup( &buffer );
+}
+
+
+int main( int argc, char * argv[] )
+{
+	UNUSED( argc );
+	UNUSED( argv );
+
+	_ensure_allocator_alloc_inline_matches_allocator_alloc( );
+	_ensure_pool_take_inline_matches_pool_take( );
+	_ensure_pool_return_inline_ignores_address_not_in_pool( );
+	_ensure_buffer_reserve_inline_grows_buffer_when_required( );
+	_ensure_buffer_reserve_inline_uses_existing_capacity( );
+	return 0;
+}
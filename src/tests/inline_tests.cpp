@@ -0,0 +1 @@
+inline_tests.c
\ No newline at end of file
@@ -0,0 +1,140 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <string.h>
+#include <unistd.h>
+
+#include "../mem/io.h"
+#include "../mem/internal/unused.h"
+#include "testing.h"
+
+static void _ensure_buffer_read_fd_reads_directly_into_buffer( void )
+{
+	char data[] = "abc";
+	int fds[ 2 ];
+	buffer_t buffer;
+
+	TEST_REQUIRE( pipe( fds ) == 0 );
+	buffer_init( &buffer, allocator_default( ) );
+	buffer_append( &buffer, 3, data );
+	TEST_REQUIRE( write( fds[ 1 ], "defgh", 5 ) == 5 );
+	TEST_REQUIRE( buffer_read_fd( &buffer, fds[ 0 ], 64 ) == 5 );
+	TEST_REQUIRE( buffer_data_length( &buffer ) == 8 );
+	TEST_REQUIRE( memcmp( buffer_data_pointer( &buffer ), "abcdefgh", 8 ) == 0 );
+	close( fds[ 1 ] );
+	TEST_REQUIRE( buffer_read_fd( &buffer, fds[ 0 ], 64 ) == 0 );
+	TEST_REQUIRE( buffer_data_length( &buffer ) == 8 );
+	close( fds[ 0 ] );
+	buffer_cleanup( &buffer );
+}
+
+static void _ensure_buffer_write_fd_writes_from_offset( void )
+{
+	char data[] = "abcdef";
+	char output[ 8 ];
+	int fds[ 2 ];
+	buffer_t buffer;
+
+	TEST_REQUIRE( pipe( fds ) == 0 );
+	buffer_init( &buffer, allocator_default( ) );
+	buffer_append( &buffer, 6, data );
+	TEST_REQUIRE( buffer_write_fd( &buffer, fds[ 1 ], 2 ) == 4 );
+	TEST_REQUIRE( buffer_write_fd( &buffer, fds[ 1 ], 6 ) == 0 );
+	TEST_REQUIRE( read( fds[ 0 ], output, sizeof( output ) ) == 4 );
+	TEST_REQUIRE( memcmp( output, "cdef", 4 ) == 0 );
+	close( fds[ 0 ] );
+	close( fds[ 1 ] );
+	buffer_cleanup( &buffer );
+}
+
+static void _ensure_chain_read_fd_reads_across_segments( void )
+{
+	span_t spans[ 4 ];
+	int fds[ 2 ];
+	chain_t chain;
+
+	TEST_REQUIRE( pipe( fds ) == 0 );
+	chain_init( &chain, 4, allocator_default( ) );
+	chain_append( &chain, 2, "ab" );
+	TEST_REQUIRE( write( fds[ 1 ], "cdefgh", 6 ) == 6 );
+	TEST_REQUIRE( chain_read_fd( &chain, fds[ 0 ], 10 ) == 6 );
+	TEST_REQUIRE( chain_data_length( &chain ) == 8 );
+	TEST_REQUIRE( chain_spans( &chain, spans, 4 ) == 2 );
+	TEST_REQUIRE( memcmp( spans[ 0 ].data, "abcd", 4 ) == 0 );
+	TEST_REQUIRE( memcmp( spans[ 1 ].data, "efgh", 4 ) == 0 );
+	close( fds[ 0 ] );
+	close( fds[ 1 ] );
+	chain_cleanup( &chain );
+}
+
+static void _ensure_chain_write_fd_writes_all_segments_from_offset( void )
+{
+	char output[ 16 ];
+	int fds[ 2 ];
+	chain_t chain;
+
+	TEST_REQUIRE( pipe( fds ) == 0 );
+	chain_init( &chain, 4, allocator_default( ) );
+	chain_append( &chain, 10, "0123456789" );
+	TEST_REQUIRE( chain_write_fd( &chain, fds[ 1 ], 5 ) == 5 );
+	TEST_REQUIRE( read( fds[ 0 ], output, sizeof( output ) ) == 5 );
+	TEST_REQUIRE( memcmp( output, "56789", 5 ) == 0 );
+	TEST_REQUIRE( chain_write_fd( &chain, fds[ 1 ], 10 ) == 0 );
+	close( fds[ 0 ] );
+	close( fds[ 1 ] );
+	chain_cleanup( &chain );
+}
+
+static void _ensure_ring_read_fd_and_write_fd_wrap_around( void )
+{
+	char output[ 16 ];
+	int in[ 2 ], out[ 2 ];
+	ring_t ring;
+
+	TEST_REQUIRE( pipe( in ) == 0 );
+	TEST_REQUIRE( pipe( out ) == 0 );
+	ring_init( &ring, 16, 0, allocator_default( ) );
+	ring_commit( &ring, 12 );
+	ring_consume( &ring, 12 );
+	TEST_REQUIRE( write( in[ 1 ], "abcdefghij", 10 ) == 10 );
+	TEST_REQUIRE( ring_read_fd( &ring, in[ 0 ] ) == 10 );
+	TEST_REQUIRE( ring_data_length( &ring ) == 10 );
+	TEST_REQUIRE( ring_write_fd( &ring, out[ 1 ] ) == 10 );
+	TEST_REQUIRE( ring_data_length( &ring ) == 0 );
+	TEST_REQUIRE( ring_write_fd( &ring, out[ 1 ] ) == 0 );
+	TEST_REQUIRE( read( out[ 0 ], output, sizeof( output ) ) == 10 );
+	TEST_REQUIRE( memcmp( output, "abcdefghij", 10 ) == 0 );
+	close( in[ 0 ] );
+	close( in[ 1 ] );
+	close( out[ 0 ] );
+	close( out[ 1 ] );
+	ring_cleanup( &ring );
+}
+
+static void _ensure_io_functions_report_failed_allocation( void )
+{
+	int fds[ 2 ];
+	buffer_t buffer;
+	chain_t chain;
+
+	TEST_REQUIRE( pipe( fds ) == 0 );
+	buffer_init( &buffer, allocator_always_fail( ) );
+	chain_init( &chain, 4, allocator_always_fail( ) );
+	TEST_REQUIRE( buffer_read_fd( &buffer, fds[ 0 ], 8 ) == -1 );
+	TEST_REQUIRE( chain_read_fd( &chain, fds[ 0 ], 8 ) == -1 );
+	close( fds[ 0 ] );
+	close( fds[ 1 ] );
+}
+
+int main( int argc, char * argv[] )
+{
+	UNUSED( argc );
+	UNUSED( argv );
+
+	_ensure_buffer_read_fd_reads_directly_into_buffer( );
+	_ensure_buffer_write_fd_writes_from_offset( );
+	_ensure_chain_read_fd_reads_across_segments( );
+	_ensure_chain_write_fd_writes_all_segments_from_offset( );
+	_ensure_ring_read_fd_and_write_fd_wrap_around( );
+	_ensure_io_functions_report_failed_allocation( );
+	return 0;
+}
@@ -0,0 +1 @@
+io_tests.c
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include <stdexcept>
+
+#include "../mem/object_pool.hpp"
+#include "../mem/internal/unused.h"
+#include "testing.h"
+
+static int _live_objects = 0;
+
+struct _tracked_t
+{
+	int a;
+	int b;
+
+	_tracked_t( int a_, int b_ ) : a( a_ ), b( b_ )
+	{
+		++_live_objects;
+	}
+
+	~_tracked_t( )
+	{
+		--_live_objects;
+	}
+};
+
+struct _throwing_t
+{
+	explicit _throwing_t( bool fail )
+	{
+		if ( fail )
+		{
+			throw std::runtime_error( "construction failed" );
+		}
+	}
+};
+
+struct alignas( 64 ) _overaligned_t
+{
+	char data[ 8 ];
+};
+
+static void _ensure_object_pool_construct_forwards_arguments( void )
+{
+	mem::ObjectPool< _tracked_t > pool( 4 );
+	_tracked_t * object = pool.construct( 1, 2 );
+	TEST_REQUIRE( object );
+	TEST_REQUIRE( object->a == 1 && object->b == 2 );
+	TEST_REQUIRE( _live_objects == 1 );
+	pool.destroy( object );
+	TEST_REQUIRE( _live_objects == 0 );
+}
+
+static void _ensure_object_pool_construct_returns_null_when_empty( void )
+{
+	mem::ObjectPool< _tracked_t > pool( 1 );
+	_tracked_t * object = pool.construct( 1, 2 );
+	TEST_REQUIRE( pool.empty( ) );
+	TEST_REQUIRE( pool.construct( 3, 4 ) == 0 );
+	TEST_REQUIRE( _live_objects == 1 );
+	pool.destroy( object );
+}
+
+static void _ensure_object_pool_construct_returns_element_when_constructor_throws( void )
+{
+	mem::ObjectPool< _throwing_t > pool( 1 );
+	bool thrown = false;
+	try
+	{
+		pool.construct( true );
+	}
+	catch ( const std::runtime_error & )
+	{
+		thrown = true;
+	}
+	TEST_REQUIRE( thrown );
+	TEST_REQUIRE( !pool.empty( ) );
+}
+
+static void _ensure_object_pool_make_returns_object_to_pool_when_released( void )
+{
+	mem::ObjectPool< _tracked_t > pool( 1 );
+	{
+		mem::ObjectPool< _tracked_t >::Handle handle = pool.make( 5, 6 );
+		TEST_REQUIRE( handle );
+		TEST_REQUIRE( handle->a == 5 );
+		TEST_REQUIRE( pool.empty( ) );
+	}
+	TEST_REQUIRE( _live_objects == 0 );
+	TEST_REQUIRE( !pool.empty( ) );
+}
+
+static void _ensure_object_pool_make_returns_empty_handle_when_empty( void )
+{
+	mem::ObjectPool< _tracked_t > pool( 1 );
+	mem::ObjectPool< _tracked_t >::Handle first = pool.make( 1, 1 );
+	mem::ObjectPool< _tracked_t >::Handle second = pool.make( 2, 2 );
+	TEST_REQUIRE( first );
+	TEST_REQUIRE( !second );
+}
+
+static void _ensure_object_pool_respects_type_alignment( void )
+{
+	mem::ObjectPool< _overaligned_t > pool( 4 );
+	_overaligned_t * first = pool.construct( );
+	_overaligned_t * second = pool.construct( );
+	TEST_REQUIRE( first && second );
+	TEST_REQUIRE( ( ( size_t ) first ) % 64 == 0 );
+	TEST_REQUIRE( ( ( size_t ) second ) % 64 == 0 );
+	pool.destroy( first );
+	pool.destroy( second );
+}
+
+static void _ensure_object_pool_releases_storage_on_destruction( void )
+{
+	allocator_counted_t alloc;
+	allocator_counted_init_default( &alloc );
+	{
+		mem::ObjectPool< _tracked_t > pool( 16, allocator_counted_get( &alloc ) );
+		pool.destroy( pool.construct( 1, 2 ) );
+	}
+	TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) == 0 );
+}
+
+int main( int argc, char * argv[] )
+{
+	UNUSED( argc );
+	UNUSED( argv );
+
+	_ensure_object_pool_construct_forwards_arguments( );
+	_ensure_object_pool_construct_returns_null_when_empty( );
+	_ensure_object_pool_construct_returns_element_when_constructor_throws( );
+	_ensure_object_pool_make_returns_object_to_pool_when_released( );
+	_ensure_object_pool_make_returns_empty_handle_when_empty( );
+	_ensure_object_pool_respects_type_alignment( );
+	_ensure_object_pool_releases_storage_on_destruction( );
+	return 0;
+}
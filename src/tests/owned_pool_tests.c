@@ -0,0 +1,247 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "../mem/owned_pool.h"
+#include "../mem/internal/unused.h"
+#include "testing.h"
+
+#define _OWNED_POOL_THREADS 4
+#define _OWNED_POOL_PER_THREAD 64
+
+typedef struct _owned_pool_batch_t
+{
+	owned_pool_t * pool;
+	void ** elements;
+	size_t count;
+	int is_owner;
+} _owned_pool_batch_t;
+
+static void * _return_batch( void * context )
+{
+	_owned_pool_batch_t * batch = ( _owned_pool_batch_t * ) context;
+	size_t i;
+
+	batch->is_owner = owned_pool_is_owner( batch->pool );
+	for ( i = 0; i < batch->count; ++i )
+	{
+		owned_pool_return( batch->pool, batch->elements[ i ] );
+		if ( i % 8 == 0 )
+		{
+			sched_yield( );
+		}
+	}
+
+	return 0;
+}
+
+static void _return_from_thread( owned_pool_t * pool, void ** elements, size_t count )
+{
+	_owned_pool_batch_t batch;
+	pthread_t thread;
+
+	batch.pool = pool;
+	batch.elements = elements;
+	batch.count = count;
+	batch.is_owner = 1;
+	TEST_REQUIRE( pthread_create( &thread, 0, _return_batch, &batch ) == 0 );
+	TEST_REQUIRE( pthread_join( thread, 0 ) == 0 );
+	TEST_REQUIRE( !batch.is_owner );
+}
+
+static void * _claim_and_return( void * context )
+{
+	_owned_pool_batch_t * batch = ( _owned_pool_batch_t * ) context;
+	owned_pool_claim( batch->pool );
+	batch->is_owner = owned_pool_is_owner( batch->pool );
+	owned_pool_return( batch->pool, batch->elements[ 0 ] );
+	return 0;
+}
+
+static void _ensure_owned_pool_owner_takes_and_returns_locally( void )
+{
+	owned_pool_t pool;
+	void * a, * b;
+
+	owned_pool_init( &pool, 24, 2, allocator_default( ) );
+	TEST_REQUIRE( owned_pool_is_owner( &pool ) );
+
+	a = owned_pool_take( &pool );
+	b = owned_pool_take( &pool );
+	TEST_REQUIRE( a && b && a != b );
+	TEST_REQUIRE( owned_pool_is_empty( &pool ) );
+	TEST_REQUIRE( owned_pool_take( &pool ) == 0 );
+
+	owned_pool_return( &pool, a );
+	TEST_REQUIRE( pool.remote == 0 );
+	TEST_REQUIRE( owned_pool_take( &pool ) == a );
+
+	owned_pool_cleanup( &pool );
+}
+
+static void _ensure_owned_pool_reclaims_remote_frees_when_empty( void )
+{
+	owned_pool_t pool;
+	void * elements[ 3 ];
+	void * first, * second;
+
+	owned_pool_init( &pool, 24, 3, allocator_default( ) );
+	elements[ 0 ] = owned_pool_take( &pool );
+	elements[ 1 ] = owned_pool_take( &pool );
+	elements[ 2 ] = owned_pool_take( &pool );
+
+	_return_from_thread( &pool, elements, 2 );
+	TEST_REQUIRE( pool.remote );
+	TEST_REQUIRE( pool_is_empty( &pool.pool ) );
+	TEST_REQUIRE( !owned_pool_is_empty( &pool ) );
+
+	first = owned_pool_take( &pool );
+	second = owned_pool_take( &pool );
+	TEST_REQUIRE( pool.remote == 0 );
+	TEST_REQUIRE( ( first == elements[ 0 ] && second == elements[ 1 ] ) ||
+		( first == elements[ 1 ] && second == elements[ 0 ] ) );
+	TEST_REQUIRE( owned_pool_take( &pool ) == 0 );
+	TEST_REQUIRE( owned_pool_is_empty( &pool ) );
+
+	owned_pool_cleanup( &pool );
+}
+
+static void _ensure_owned_pool_reclaim_moves_remote_frees_to_free_list( void )
+{
+	owned_pool_t pool;
+	void * elements[ 4 ];
+	size_t i;
+
+	owned_pool_init( &pool, 16, 5, allocator_default( ) );
+	for ( i = 0; i < 4; ++i )
+	{
+		elements[ i ] = owned_pool_take( &pool );
+	}
+
+	TEST_REQUIRE( owned_pool_reclaim( &pool ) == 0 );
+	_return_from_thread( &pool, elements, 4 );
+	TEST_REQUIRE( owned_pool_reclaim( &pool ) == 4 );
+	TEST_REQUIRE( pool.remote == 0 );
+
+	for ( i = 0; i < 5; ++i )
+	{
+		TEST_REQUIRE( owned_pool_take( &pool ) );
+	}
+	TEST_REQUIRE( owned_pool_is_empty( &pool ) );
+
+	owned_pool_cleanup( &pool );
+}
+
+static void _ensure_owned_pool_ignores_foreign_remote_frees( void )
+{
+	owned_pool_t pool;
+	void * foreign[ 2 ];
+	int8_t local;
+
+	owned_pool_init( &pool, 16, 1, allocator_default( ) );
+	foreign[ 0 ] = &local;
+	foreign[ 1 ] = 0;
+	_return_from_thread( &pool, foreign, 2 );
+	TEST_REQUIRE( pool.remote == 0 );
+
+	owned_pool_return( 0, &local );
+	TEST_REQUIRE( owned_pool_take( 0 ) == 0 );
+	TEST_REQUIRE( owned_pool_reclaim( 0 ) == 0 );
+	TEST_REQUIRE( owned_pool_is_empty( 0 ) );
+
+	owned_pool_cleanup( &pool );
+}
+
+static void _ensure_owned_pool_accepts_concurrent_remote_frees( void )
+{
+	_owned_pool_batch_t batches[ _OWNED_POOL_THREADS ];
+	pthread_t threads[ _OWNED_POOL_THREADS ];
+	void * elements[ _OWNED_POOL_THREADS * _OWNED_POOL_PER_THREAD ];
+	size_t i, count = 0;
+	owned_pool_t pool;
+
+	owned_pool_init( &pool, 32, _OWNED_POOL_THREADS * _OWNED_POOL_PER_THREAD, allocator_default( ) );
+	for ( i = 0; i < _OWNED_POOL_THREADS * _OWNED_POOL_PER_THREAD; ++i )
+	{
+		elements[ i ] = owned_pool_take( &pool );
+		TEST_REQUIRE( elements[ i ] );
+	}
+
+	for ( i = 0; i < _OWNED_POOL_THREADS; ++i )
+	{
+		batches[ i ].pool = &pool;
+		batches[ i ].elements = elements + i * _OWNED_POOL_PER_THREAD;
+		batches[ i ].count = _OWNED_POOL_PER_THREAD;
+		TEST_REQUIRE( pthread_create( &threads[ i ], 0, _return_batch, &batches[ i ] ) == 0 );
+	}
+
+	/* The owner keeps taking whatever has been returned so far, while the other
+	 * threads are still returning elements */
+	while ( count < _OWNED_POOL_THREADS * _OWNED_POOL_PER_THREAD / 2 )
+	{
+		if ( owned_pool_take( &pool ) )
+		{
+			++count;
+		}
+		else
+		{
+			sched_yield( );
+		}
+	}
+
+	for ( i = 0; i < _OWNED_POOL_THREADS; ++i )
+	{
+		TEST_REQUIRE( pthread_join( threads[ i ], 0 ) == 0 );
+	}
+
+	while ( owned_pool_take( &pool ) )
+	{
+		++count;
+	}
+
+	TEST_REQUIRE( count == _OWNED_POOL_THREADS * _OWNED_POOL_PER_THREAD );
+	TEST_REQUIRE( owned_pool_is_empty( &pool ) );
+	owned_pool_cleanup( &pool );
+}
+
+static void _ensure_owned_pool_can_be_claimed_by_another_thread( void )
+{
+	_owned_pool_batch_t batch;
+	pthread_t thread;
+	owned_pool_t * pool;
+	void * element;
+
+	pool = owned_pool_new( 16, 1, allocator_default( ) );
+	TEST_REQUIRE( pool );
+	element = owned_pool_take( pool );
+
+	batch.pool = pool;
+	batch.elements = &element;
+	batch.count = 1;
+	batch.is_owner = 0;
+	TEST_REQUIRE( pthread_create( &thread, 0, _claim_and_return, &batch ) == 0 );
+	TEST_REQUIRE( pthread_join( thread, 0 ) == 0 );
+
+	/* The new owner returned the element straight to the free list */
+	TEST_REQUIRE( batch.is_owner );
+	TEST_REQUIRE( !owned_pool_is_owner( pool ) );
+	TEST_REQUIRE( pool->remote == 0 );
+	TEST_REQUIRE( !pool_is_empty( &pool->pool ) );
+
+	owned_pool_delete( pool );
+}
+
+int main( int argc, char * argv[] )
+{
+	UNUSED( argc );
+	UNUSED( argv );
+
+	_ensure_owned_pool_owner_takes_and_returns_locally( );
+	_ensure_owned_pool_reclaims_remote_frees_when_empty( );
+	_ensure_owned_pool_reclaim_moves_remote_frees_to_free_list( );
+	_ensure_owned_pool_ignores_foreign_remote_frees( );
+	_ensure_owned_pool_accepts_concurrent_remote_frees( );
+	_ensure_owned_pool_can_be_claimed_by_another_thread( );
+	return 0;
+}
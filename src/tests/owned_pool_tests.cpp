@@ -0,0 +1 @@
+owned_pool_tests.c
\ No newline at end of file
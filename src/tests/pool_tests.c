@@ -215,6 +215,134 @@ static void _ensure_pool_is_empty_returns_zero_on_non_empty_legitimate_pool( voi
 	pool_cleanup( &pool );
 }
 
+static void _ensure_pool_new_aligned_returns_aligned_pool( void )
+{
+	pool_t * pool = pool_new_aligned( 24, 4, 32, allocator_default( ) );
+	TEST_REQUIRE( pool );
+	TEST_REQUIRE( pool->buffer );
+	TEST_REQUIRE( ( ( size_t ) pool->buffer ) % 32 == 0 );
+	TEST_REQUIRE( pool->element_size == 32 );
+	pool_delete( pool );
+}
+
+static void _ensure_pool_init_aligned_with_zero_alignment_matches_pool_init( void )
+{
+	pool_t pool;
+	pool_init_aligned( &pool, 12, 4, 0, allocator_default( ) );
+	TEST_REQUIRE( pool.buffer == pool.block );
+	TEST_REQUIRE( pool.element_size == 12 );
+	TEST_REQUIRE( pool.size == 12 * 4 );
+	pool_cleanup( &pool );
+}
+
+static void _ensure_pool_init_aligned_pads_elements_to_cache_lines( void )
+{
+	int8_t * first, * second;
+	pool_t pool;
+	pool_init_aligned( &pool, 48, 8, POOL_CACHE_LINE_SIZE, allocator_default( ) );
+	first = ( int8_t * ) pool_take( &pool );
+	second = ( int8_t * ) pool_take( &pool );
+	TEST_REQUIRE( first && second );
+	TEST_REQUIRE( ( ( size_t ) first ) % POOL_CACHE_LINE_SIZE == 0 );
+	TEST_REQUIRE( ( ( size_t ) second ) % POOL_CACHE_LINE_SIZE == 0 );
+	TEST_REQUIRE( second - first == POOL_CACHE_LINE_SIZE );
+	pool_cleanup( &pool );
+}
+
+static void _ensure_pool_init_aligned_hands_out_every_element( void )
+{
+	unsigned count = 0;
+	pool_t pool;
+	pool_init_aligned( &pool, 100, 5, 64, allocator_default( ) );
+	while ( pool_take( &pool ) )
+	{
+		++count;
+	}
+	TEST_REQUIRE( count == 5 );
+	pool_cleanup( &pool );
+}
+
+static void _ensure_pool_init_aligned_copes_with_size_overflow( void )
+{
+	pool_t pool;
+	pool_init_aligned( &pool, 64, ( ( size_t ) -1 ) / 32, 64, allocator_default( ) );
+	TEST_REQUIRE( pool_is_empty( &pool ) );
+	pool_cleanup( &pool );
+}
+
+static void _ensure_pool_cleanup_releases_aligned_buffer( void )
+{
+	allocator_counted_t alloc;
+	pool_t pool;
+
+	allocator_counted_init_default( &alloc );
+	pool_init_aligned( &pool, 4, 16, 128, allocator_counted_get( &alloc ) );
+	TEST_REQUIRE( ( ( size_t ) pool.buffer ) % 128 == 0 );
+	pool_cleanup( &pool );
+	TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) == 0 );
+}
+
+static void _ensure_pool_trim_releases_buffer_of_unused_pool( void )
+{
+	allocator_counted_t alloc;
+	pool_t pool;
+	void * element;
+
+	allocator_counted_init_default( &alloc );
+	pool_init_aligned( &pool, 24, 8, 16, allocator_counted_get( &alloc ) );
+	element = pool_take( &pool );
+	pool_return( &pool, element );
+	TEST_REQUIRE( pool_trim( &pool ) >= 8 * 32 );
+	TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) == 0 );
+	TEST_REQUIRE( !pool_is_empty( &pool ) );
+	TEST_REQUIRE( pool_trim( &pool ) == 0 );
+	pool_cleanup( &pool );
+}
+
+static void _ensure_pool_trim_keeps_buffer_while_elements_are_in_use( void )
+{
+	allocator_counted_t alloc;
+	pool_t pool;
+
+	allocator_counted_init_default( &alloc );
+	pool_init( &pool, 16, 4, allocator_counted_get( &alloc ) );
+	pool_take( &pool );
+	TEST_REQUIRE( pool_trim( &pool ) == 0 );
+	TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) > 0 );
+	pool_cleanup( &pool );
+	TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) == 0 );
+}
+
+static void _ensure_pool_take_restores_trimmed_pool( void )
+{
+	int i;
+	allocator_counted_t alloc;
+	pool_t pool;
+
+	allocator_counted_init_default( &alloc );
+	pool_init_aligned( &pool, 24, 4, 16, allocator_counted_get( &alloc ) );
+	pool_trim( &pool );
+	for ( i = 0; i < 4; ++i )
+	{
+		void * element = pool_take( &pool );
+		TEST_REQUIRE( element );
+		TEST_REQUIRE( ( ( size_t ) element ) % 16 == 0 );
+	}
+	TEST_REQUIRE( pool_take( &pool ) == 0 );
+	TEST_REQUIRE( pool_is_empty( &pool ) );
+	pool_cleanup( &pool );
+	TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) == 0 );
+}
+
+static void _ensure_pool_trim_gracefully_handles_null_and_empty_pools( void )
+{
+	pool_t pool;
+	TEST_REQUIRE( pool_trim( 0 ) == 0 );
+	pool_init( &pool, 0, 4, allocator_default( ) );
+	TEST_REQUIRE( pool_trim( &pool ) == 0 );
+	pool_cleanup( &pool );
+}
+
 int main( int argc, char * argv[] )
 {
 	UNUSED( argc );
@@ -244,6 +372,16 @@ int main( int argc, char * argv[] )
 	_ensure_pool_is_empty_gracefully_handles_cleaned_up_pool( );
 	_ensure_pool_is_empty_returns_non_zero_on_empty_legitimate_pool( );
 	_ensure_pool_is_empty_returns_zero_on_non_empty_legitimate_pool( );
+	_ensure_pool_new_aligned_returns_aligned_pool( );
+	_ensure_pool_init_aligned_with_zero_alignment_matches_pool_init( );
+	_ensure_pool_init_aligned_pads_elements_to_cache_lines( );
+	_ensure_pool_init_aligned_hands_out_every_element( );
+	_ensure_pool_init_aligned_copes_with_size_overflow( );
+	_ensure_pool_cleanup_releases_aligned_buffer( );
+	_ensure_pool_trim_releases_buffer_of_unused_pool( );
+	_ensure_pool_trim_keeps_buffer_while_elements_are_in_use( );
+	_ensure_pool_take_restores_trimmed_pool( );
+	_ensure_pool_trim_gracefully_handles_null_and_empty_pools( );
 	return 0;
 }
 
@@ -0,0 +1,198 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <string.h>
+#include <unistd.h>
+
+#include "../mem/registry.h"
+#include "../mem/internal/unused.h"
+#include "testing.h"
+
+static char * _format( buffer_t * output, int format )
+{
+	char terminator = 0;
+	buffer_init( output, allocator_default( ) );
+	TEST_REQUIRE( registry_format( output, format ) > 0 );
+	buffer_append( output, 1, &terminator );
+	return ( char * ) buffer_data_pointer( output );
+}
+
+static void _ensure_registry_formats_empty_registry( void )
+{
+	buffer_t output;
+
+	TEST_REQUIRE( strcmp( _format( &output, REGISTRY_JSON ), "[]\n" ) == 0 );
+	buffer_cleanup( &output );
+
+	TEST_REQUIRE( strstr( _format( &output, REGISTRY_PROMETHEUS ), "# TYPE libmem_bytes_in_use gauge\n" ) );
+	TEST_REQUIRE( !strstr( ( char * ) buffer_data_pointer( &output ), "{" ) );
+	buffer_cleanup( &output );
+}
+
+static void _ensure_registry_reports_registered_objects( void )
+{
+	allocator_counted_t counted;
+	pool_t pool;
+	buffer_t buffer, output;
+	registry_entry_t entries[ 3 ];
+	char data[] = "abcdef";
+	void * block, * element;
+	char * text;
+
+	allocator_counted_init_default( &counted );
+	block = allocator_alloc( 100, allocator_counted_get( &counted ) );
+	pool_init( &pool, 16, 8, allocator_default( ) );
+	element = pool_take( &pool );
+	buffer_init( &buffer, allocator_default( ) );
+	buffer_append( &buffer, 6, data );
+
+	registry_entry_init_counted( &entries[ 0 ], "requests", &counted );
+	registry_entry_init_pool( &entries[ 1 ], "sessions", &pool );
+	registry_entry_init_buffer( &entries[ 2 ], "scratch", &buffer );
+	registry_register( &entries[ 0 ] );
+	registry_register( &entries[ 1 ] );
+	registry_register( &entries[ 2 ] );
+
+	text = _format( &output, REGISTRY_JSON );
+	TEST_REQUIRE( strstr( text, "{ \"name\": \"requests\", \"type\": \"counted\", \"bytes_in_use\": 100, \"bytes_peak\": 100 }" ) );
+	TEST_REQUIRE( strstr( text, "{ \"name\": \"sessions\", \"type\": \"pool\", \"bytes_in_use\": 16, \"bytes_capacity\": 128, \"elements_in_use\": 1, \"elements\": 8 }" ) );
+	TEST_REQUIRE( strstr( text, "{ \"name\": \"scratch\", \"type\": \"buffer\", \"bytes_in_use\": 6, \"bytes_capacity\": " ) );
+	buffer_cleanup( &output );
+
+	text = _format( &output, REGISTRY_PROMETHEUS );
+	TEST_REQUIRE( strstr( text, "libmem_bytes_in_use{name=\"requests\",type=\"counted\"} 100\n" ) );
+	TEST_REQUIRE( strstr( text, "libmem_elements{name=\"sessions\",type=\"pool\"} 8\n" ) );
+	TEST_REQUIRE( !strstr( text, "libmem_elements{name=\"requests\"" ) );
+	buffer_cleanup( &output );
+
+	registry_unregister( &entries[ 1 ] );
+	text = _format( &output, REGISTRY_JSON );
+	TEST_REQUIRE( !strstr( text, "sessions" ) );
+	TEST_REQUIRE( strstr( text, "requests" ) && strstr( text, "scratch" ) );
+	buffer_cleanup( &output );
+
+	registry_unregister( &entries[ 0 ] );
+	registry_unregister( &entries[ 2 ] );
+
+	allocator_free( block, allocator_counted_get( &counted ) );
+	pool_return( &pool, element );
+	pool_cleanup( &pool );
+	buffer_cleanup( &buffer );
+}
+
+static void _ensure_registry_reports_empty_pools( void )
+{
+	registry_entry_t entry;
+	buffer_t output;
+	pool_t pool;
+	char * text;
+
+	pool_init( &pool, 16, 0, allocator_default( ) );
+	registry_entry_init_pool( &entry, "empty", &pool );
+	registry_register( &entry );
+
+	text = _format( &output, REGISTRY_JSON );
+	TEST_REQUIRE( strstr( text, "{ \"name\": \"empty\", \"type\": \"pool\", \"bytes_in_use\": 0, \"bytes_capacity\": 0, \"elements_in_use\": 0, \"elements\": 0 }" ) );
+	buffer_cleanup( &output );
+
+	pool_init( &pool, 16, 4, allocator_default( ) );
+	pool_cleanup( &pool );
+	text = _format( &output, REGISTRY_PROMETHEUS );
+	TEST_REQUIRE( strstr( text, "libmem_elements{name=\"empty\",type=\"pool\"} 0\n" ) );
+	buffer_cleanup( &output );
+
+	registry_unregister( &entry );
+}
+
+static void _ensure_registry_escapes_names( void )
+{
+	allocator_budget_t budget;
+	registry_entry_t entry;
+	buffer_t output;
+	char * text;
+
+	allocator_budget_init_default( &budget, 0, 4096 );
+	registry_entry_init_budget( &entry, "tenant \"a\"\\", &budget );
+	registry_register( &entry );
+
+	text = _format( &output, REGISTRY_JSON );
+	TEST_REQUIRE( strstr( text, "\"name\": \"tenant \\\"a\\\"\\\\\"" ) );
+	TEST_REQUIRE( strstr( text, "\"bytes_capacity\": 4096" ) );
+	buffer_cleanup( &output );
+
+	text = _format( &output, REGISTRY_PROMETHEUS );
+	TEST_REQUIRE( strstr( text, "libmem_bytes_capacity{name=\"tenant \\\"a\\\"\\\\\",type=\"budget\"} 4096\n" ) );
+	buffer_cleanup( &output );
+
+	registry_unregister( &entry );
+}
+
+static void _ensure_registry_dumps_to_file_descriptor( void )
+{
+	allocator_counted_t counted;
+	registry_entry_t entry;
+	char text[ 256 ];
+	size_t written;
+	ssize_t length;
+	int fds[ 2 ];
+
+	allocator_counted_init_default( &counted );
+	registry_entry_init_counted( &entry, "dumped", &counted );
+	registry_register( &entry );
+
+	TEST_REQUIRE( pipe( fds ) == 0 );
+	written = registry_dump_fd( fds[ 1 ], REGISTRY_JSON );
+	TEST_REQUIRE( written > 0 && written < sizeof( text ) );
+	length = read( fds[ 0 ], text, sizeof( text ) - 1 );
+	TEST_REQUIRE( length == ( ssize_t ) written );
+	text[ length ] = 0;
+	TEST_REQUIRE( strstr( text, "\"dumped\"" ) );
+	close( fds[ 0 ] );
+	close( fds[ 1 ] );
+
+	TEST_REQUIRE( registry_dump( 0, REGISTRY_JSON ) == 0 );
+	registry_unregister( &entry );
+}
+
+static void _reentrant_stats( void * object, registry_stats_t * stats )
+{
+	registry_entry_t * other = ( registry_entry_t * ) object;
+	buffer_t output;
+
+	buffer_init( &output, allocator_default( ) );
+	stats->elements = registry_format( &output, REGISTRY_JSON );
+	buffer_cleanup( &output );
+
+	registry_register( other );
+}
+
+static void _ensure_registry_refuses_calls_from_stats_functions( void )
+{
+	registry_entry_t entry, other;
+	buffer_t output;
+	char * text;
+
+	registry_entry_init( &other, "other", "test", 0, 0 );
+	registry_entry_init( &entry, "reentrant", "test", _reentrant_stats, &other );
+	registry_register( &entry );
+
+	text = _format( &output, REGISTRY_JSON );
+	TEST_REQUIRE( strstr( text, "\"elements\": 0" ) );
+	TEST_REQUIRE( !strstr( text, "\"other\"" ) );
+	buffer_cleanup( &output );
+
+	registry_unregister( &entry );
+}
+
+int main( int argc, char * argv[] )
+{
+	UNUSED( argc );
+	UNUSED( argv );
+
+	_ensure_registry_formats_empty_registry( );
+	_ensure_registry_reports_registered_objects( );
+	_ensure_registry_reports_empty_pools( );
+	_ensure_registry_escapes_names( );
+	_ensure_registry_dumps_to_file_descriptor( );
+	_ensure_registry_refuses_calls_from_stats_functions( );
+	return 0;
+}
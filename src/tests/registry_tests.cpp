@@ -0,0 +1 @@
+registry_tests.c
\ No newline at end of file
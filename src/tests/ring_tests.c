@@ -0,0 +1,302 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+#include "../mem/ring.h"
+#include "../mem/internal/unused.h"
+#include "testing.h"
+
+#define SPSC_TEST_BYTES ( 256 * 1024 )
+
+static void _ensure_ring_new_returns_null_when_allocation_fails( void )
+{
+	TEST_REQUIRE( ring_new( 64, 0, allocator_always_fail( ) ) == 0 );
+}
+
+static void _ensure_ring_delete_releases_all_memory( void )
+{
+	allocator_counted_t alloc;
+	ring_t * ring;
+
+	allocator_counted_init_default( &alloc );
+	ring = ring_new( 64, 0, allocator_counted_get( &alloc ) );
+	TEST_REQUIRE( ring );
+	TEST_REQUIRE( ring_capacity( ring ) == 64 );
+	ring_delete( ring );
+	TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) == 0 );
+}
+
+static void _ensure_ring_delete_copes_with_null_ring( void )
+{
+	ring_delete( 0 );
+}
+
+static void _ensure_ring_init_rounds_capacity_up_to_power_of_two( void )
+{
+	ring_t ring;
+	ring_init( &ring, 100, 0, allocator_default( ) );
+	TEST_REQUIRE( ring_capacity( &ring ) == 128 );
+	TEST_REQUIRE( ring_space( &ring ) == 128 );
+	TEST_REQUIRE( ring_data_length( &ring ) == 0 );
+	ring_cleanup( &ring );
+}
+
+static void _ensure_ring_init_leaves_zero_capacity_empty( void )
+{
+	allocator_counted_t alloc;
+	size_t length;
+	ring_t ring;
+
+	allocator_counted_init_default( &alloc );
+	ring_init( &ring, 0, 0, allocator_counted_get( &alloc ) );
+	TEST_REQUIRE( ring_capacity( &ring ) == 0 );
+	TEST_REQUIRE( ring_reserve( &ring, &length ) == 0 );
+	TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) == 0 );
+	ring_cleanup( &ring );
+
+	ring_init( &ring, 0, RING_MIRRORED, allocator_counted_get( &alloc ) );
+	TEST_REQUIRE( ring_capacity( &ring ) == 0 );
+	TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) == 0 );
+	ring_cleanup( &ring );
+}
+
+static void _ensure_ring_init_copes_with_failed_allocation( void )
+{
+	size_t length;
+	ring_t ring;
+	ring_init( &ring, 64, 0, allocator_always_fail( ) );
+	TEST_REQUIRE( ring_capacity( &ring ) == 0 );
+	TEST_REQUIRE( ring_reserve( &ring, &length ) == 0 );
+	TEST_REQUIRE( ring_write( &ring, 4, "abcd" ) == 0 );
+	ring_cleanup( &ring );
+}
+
+static void _ensure_ring_cleanup_copes_with_cleaned_up_ring( void )
+{
+	ring_t ring;
+	ring_init( &ring, 64, 0, allocator_default( ) );
+	ring_cleanup( &ring );
+	ring_cleanup( &ring );
+	TEST_REQUIRE( ring_capacity( &ring ) == 0 );
+}
+
+static void _ensure_ring_reserve_and_commit_make_data_visible( void )
+{
+	size_t length;
+	char * span;
+	ring_t ring;
+
+	ring_init( &ring, 16, 0, allocator_default( ) );
+	span = ( char * ) ring_reserve( &ring, &length );
+	TEST_REQUIRE( span && length == 16 );
+	memcpy( span, "hello", 5 );
+	TEST_REQUIRE( ring_data_length( &ring ) == 0 );
+	TEST_REQUIRE( ring_commit( &ring, 5 ) == 5 );
+	TEST_REQUIRE( ring_data_length( &ring ) == 5 );
+	span = ( char * ) ring_peek( &ring, &length );
+	TEST_REQUIRE( span && length == 5 );
+	TEST_REQUIRE( memcmp( span, "hello", 5 ) == 0 );
+	ring_cleanup( &ring );
+}
+
+static void _ensure_ring_commit_is_limited_to_available_space( void )
+{
+	ring_t ring;
+	ring_init( &ring, 16, 0, allocator_default( ) );
+	TEST_REQUIRE( ring_commit( &ring, 20 ) == 16 );
+	TEST_REQUIRE( ring_space( &ring ) == 0 );
+	TEST_REQUIRE( ring_commit( &ring, 1 ) == 0 );
+	ring_cleanup( &ring );
+}
+
+static void _ensure_ring_consume_is_limited_to_available_data( void )
+{
+	ring_t ring;
+	ring_init( &ring, 16, 0, allocator_default( ) );
+	ring_write( &ring, 4, "abcd" );
+	TEST_REQUIRE( ring_consume( &ring, 10 ) == 4 );
+	TEST_REQUIRE( ring_data_length( &ring ) == 0 );
+	TEST_REQUIRE( ring_peek( &ring, 0 ) == 0 );
+	ring_cleanup( &ring );
+}
+
+static void _ensure_ring_spans_split_at_end_of_ring( void )
+{
+	size_t length;
+	ring_t ring;
+
+	ring_init( &ring, 16, 0, allocator_default( ) );
+	ring_commit( &ring, 12 );
+	ring_consume( &ring, 12 );
+	TEST_REQUIRE( ring_reserve( &ring, &length ) );
+	TEST_REQUIRE( length == 4 );
+	ring_commit( &ring, 10 );
+	TEST_REQUIRE( ring_peek( &ring, &length ) );
+	TEST_REQUIRE( length == 4 );
+	ring_consume( &ring, 4 );
+	TEST_REQUIRE( ring_peek( &ring, &length ) );
+	TEST_REQUIRE( length == 6 );
+	ring_cleanup( &ring );
+}
+
+static void _ensure_ring_write_and_read_wrap_around( void )
+{
+	char output[ 16 ];
+	ring_t ring;
+
+	ring_init( &ring, 16, 0, allocator_default( ) );
+	ring_commit( &ring, 10 );
+	ring_consume( &ring, 10 );
+	TEST_REQUIRE( ring_write( &ring, 12, "abcdefghijkl" ) == 12 );
+	TEST_REQUIRE( ring_write( &ring, 12, "mnopqrstuvwx" ) == 4 );
+	TEST_REQUIRE( ring_read( &ring, sizeof( output ), output ) == 16 );
+	TEST_REQUIRE( memcmp( output, "abcdefghijklmnop", 16 ) == 0 );
+	TEST_REQUIRE( ring_data_length( &ring ) == 0 );
+	ring_cleanup( &ring );
+}
+
+static void _ensure_ring_functions_cope_with_null_ring( void )
+{
+	size_t length = 1;
+	char data[ 4 ];
+	TEST_REQUIRE( ring_capacity( 0 ) == 0 );
+	TEST_REQUIRE( ring_data_length( 0 ) == 0 );
+	TEST_REQUIRE( ring_space( 0 ) == 0 );
+	TEST_REQUIRE( ring_reserve( 0, &length ) == 0 && length == 0 );
+	TEST_REQUIRE( ring_peek( 0, &length ) == 0 );
+	TEST_REQUIRE( ring_commit( 0, 4 ) == 0 );
+	TEST_REQUIRE( ring_consume( 0, 4 ) == 0 );
+	TEST_REQUIRE( ring_write( 0, 4, data ) == 0 );
+	TEST_REQUIRE( ring_read( 0, 4, data ) == 0 );
+	ring_cleanup( 0 );
+}
+
+static void _ensure_ring_mirrored_spans_never_split( void )
+{
+	size_t length;
+	char * span;
+	ring_t ring;
+
+	ring_init( &ring, 16, RING_MIRRORED, allocator_default( ) );
+	TEST_REQUIRE( ring_capacity( &ring ) >= 16 );
+	if ( ring.flags & RING_MIRRORED )
+	{
+		ring_commit( &ring, ring_capacity( &ring ) - 2 );
+		ring_consume( &ring, ring_capacity( &ring ) - 2 );
+		span = ( char * ) ring_reserve( &ring, &length );
+		TEST_REQUIRE( length == ring_capacity( &ring ) );
+		memcpy( span, "wrapped", 7 );
+		ring_commit( &ring, 7 );
+		TEST_REQUIRE( ring.data[ 0 ] == 'a' );
+		span = ( char * ) ring_peek( &ring, &length );
+		TEST_REQUIRE( length == 7 );
+		TEST_REQUIRE( memcmp( span, "wrapped", 7 ) == 0 );
+	}
+	ring_cleanup( &ring );
+}
+
+static void * _spsc_producer( void * context )
+{
+	ring_t * ring = ( ring_t * ) context;
+	size_t sent = 0;
+	unsigned char value = 0;
+
+	while ( sent < SPSC_TEST_BYTES )
+	{
+		size_t length, i;
+		unsigned char * span = ( unsigned char * ) ring_reserve( ring, &length );
+		if ( length > SPSC_TEST_BYTES - sent )
+		{
+			length = SPSC_TEST_BYTES - sent;
+		}
+		for ( i = 0; i < length; ++i )
+		{
+			span[ i ] = value++;
+		}
+		sent += ring_commit( ring, length );
+		if ( !length )
+		{
+			sched_yield( );
+		}
+	}
+
+	return 0;
+}
+
+static void _ensure_ring_spsc_transfers_data_between_threads( void )
+{
+	pthread_t producer;
+	size_t received = 0;
+	unsigned char expected = 0;
+	int valid = 1;
+	ring_t ring;
+
+	ring_init( &ring, 256, RING_SPSC, allocator_default( ) );
+	TEST_REQUIRE( pthread_create( &producer, 0, &_spsc_producer, &ring ) == 0 );
+
+	while ( received < SPSC_TEST_BYTES )
+	{
+		size_t length, i;
+		unsigned char * span = ( unsigned char * ) ring_peek( &ring, &length );
+		for ( i = 0; i < length; ++i )
+		{
+			valid &= span[ i ] == expected++;
+		}
+		received += ring_consume( &ring, length );
+		if ( !length )
+		{
+			sched_yield( );
+		}
+	}
+
+	pthread_join( producer, 0 );
+	TEST_REQUIRE( valid );
+	ring_cleanup( &ring );
+}
+
+static void _ensure_ring_spans_describe_wrapped_memory( void )
+{
+	span_t spans[ 2 ];
+	ring_t ring;
+
+	ring_init( &ring, 16, 0, allocator_default( ) );
+	TEST_REQUIRE( ring_peek_spans( &ring, spans ) == 0 );
+	TEST_REQUIRE( ring_reserve_spans( &ring, spans ) == 1 );
+	TEST_REQUIRE( spans[ 0 ].length == 16 );
+	ring_commit( &ring, 12 );
+	ring_consume( &ring, 8 );
+	TEST_REQUIRE( ring_reserve_spans( &ring, spans ) == 2 );
+	TEST_REQUIRE( spans[ 0 ].length == 4 && spans[ 1 ].length == 8 );
+	TEST_REQUIRE( spans[ 1 ].data == ring.data );
+	ring_commit( &ring, 6 );
+	TEST_REQUIRE( ring_peek_spans( &ring, spans ) == 2 );
+	TEST_REQUIRE( spans[ 0 ].length == 8 && spans[ 1 ].length == 2 );
+	TEST_REQUIRE( ring_peek_spans( 0, spans ) == 0 );
+	ring_cleanup( &ring );
+}
+
+int main( int argc, char * argv[] )
+{
+	UNUSED( argc );
+	UNUSED( argv );
+
+	_ensure_ring_new_returns_null_when_allocation_fails( );
+	_ensure_ring_delete_releases_all_memory( );
+	_ensure_ring_delete_copes_with_null_ring( );
+	_ensure_ring_init_rounds_capacity_up_to_power_of_two( );
+	_ensure_ring_init_leaves_zero_capacity_empty( );
+	_ensure_ring_init_copes_with_failed_allocation( );
+	_ensure_ring_cleanup_copes_with_cleaned_up_ring( );
+	_ensure_ring_reserve_and_commit_make_data_visible( );
+	_ensure_ring_commit_is_limited_to_available_space( );
+	_ensure_ring_consume_is_limited_to_available_data( );
+	_ensure_ring_spans_split_at_end_of_ring( );
+	_ensure_ring_write_and_read_wrap_around( );
+	_ensure_ring_functions_cope_with_null_ring( );
+	_ensure_ring_mirrored_spans_never_split( );
+	_ensure_ring_spsc_transfers_data_between_threads( );
+	_ensure_ring_spans_describe_wrapped_memory( );
+	return 0;
+}
@@ -0,0 +1 @@
+ring_tests.c
\ No newline at end of file
@@ -0,0 +1,424 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <fcntl.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../mem/shared_pool.h"
+#include "../mem/internal/unused.h"
+#include "testing.h"
+
+static void _ensure_shared_pool_take_returns_distinct_elements_until_empty( void )
+{
+	shared_pool_t pool;
+	void * elements[ 4 ];
+	size_t i, j;
+
+	TEST_REQUIRE( shared_pool_create( &pool, 0, 24, 4 ) );
+	TEST_REQUIRE( shared_pool_fd( &pool ) >= 0 );
+
+	for ( i = 0; i < 4; ++i )
+	{
+		TEST_REQUIRE( !shared_pool_is_empty( &pool ) );
+		elements[ i ] = shared_pool_take( &pool );
+		TEST_REQUIRE( elements[ i ] );
+		TEST_REQUIRE( ( ( size_t ) elements[ i ] ) % SHARED_POOL_ALIGNMENT == 0 );
+		memset( elements[ i ], 0xff, 24 );
+		for ( j = 0; j < i; ++j )
+		{
+			TEST_REQUIRE( elements[ i ] != elements[ j ] );
+		}
+	}
+
+	TEST_REQUIRE( shared_pool_is_empty( &pool ) );
+	TEST_REQUIRE( shared_pool_take( &pool ) == 0 );
+
+	shared_pool_return( &pool, elements[ 2 ] );
+	TEST_REQUIRE( shared_pool_take( &pool ) == elements[ 2 ] );
+
+	shared_pool_detach( &pool );
+	TEST_REQUIRE( shared_pool_fd( &pool ) == -1 );
+	TEST_REQUIRE( shared_pool_take( &pool ) == 0 );
+}
+
+static void _ensure_shared_pool_ignores_foreign_addresses( void )
+{
+	shared_pool_t pool;
+	char * element;
+
+	TEST_REQUIRE( shared_pool_create( &pool, 0, 32, 2 ) );
+	element = ( char * ) shared_pool_take( &pool );
+
+	shared_pool_return( &pool, element + 1 );
+	shared_pool_return( &pool, &pool );
+	TEST_REQUIRE( shared_pool_take( &pool ) );
+	TEST_REQUIRE( shared_pool_is_empty( &pool ) );
+
+	TEST_REQUIRE( shared_pool_offset( &pool, element + 1 ) == 0 );
+	TEST_REQUIRE( shared_pool_address( &pool, 0 ) == 0 );
+	TEST_REQUIRE( shared_pool_address( &pool, shared_pool_offset( &pool, element ) + 1 ) == 0 );
+	shared_pool_detach( &pool );
+}
+
+static void _ensure_shared_pool_stops_at_corrupt_links( void )
+{
+	shared_pool_t pool;
+	void * element;
+
+	TEST_REQUIRE( shared_pool_create( &pool, 0, 16, 4 ) );
+
+	/* A freed element overwritten after its return */
+	element = shared_pool_take( &pool );
+	shared_pool_return( &pool, element );
+	*( ( uint32_t * ) element ) = 0xffffffff;
+	TEST_REQUIRE( shared_pool_take( &pool ) == element );
+	TEST_REQUIRE( shared_pool_take( &pool ) == 0 );
+
+	/* A head linking past the last element */
+	pool.header->head = 5;
+	TEST_REQUIRE( shared_pool_take( &pool ) == 0 );
+
+	/* A layout rewritten after attaching is not trusted */
+	pool.header->element_size = 1 << 20;
+	pool.header->num_elements = 1000;
+	pool.header->head = 1000;
+	TEST_REQUIRE( shared_pool_take( &pool ) == 0 );
+	TEST_REQUIRE( shared_pool_address( &pool, shared_pool_offset( &pool, element ) + 16 ) == ( char * ) element + 16 );
+	TEST_REQUIRE( shared_pool_offset( &pool, ( char * ) element + 64 ) == 0 );
+	pool.header->head = 2;
+	TEST_REQUIRE( shared_pool_take( &pool ) == ( char * ) element + 16 );
+
+	shared_pool_detach( &pool );
+}
+
+static void _ensure_shared_pool_offsets_identify_elements_across_mappings( void )
+{
+	shared_pool_t first, second;
+	char * element, * alias;
+
+	TEST_REQUIRE( shared_pool_create( &first, 0, 64, 8 ) );
+	TEST_REQUIRE( shared_pool_attach_fd( &second, shared_pool_fd( &first ) ) );
+	TEST_REQUIRE( second.header != first.header );
+
+	element = ( char * ) shared_pool_take( &first );
+	strcpy( element, "zero copy" );
+
+	alias = ( char * ) shared_pool_address( &second, shared_pool_offset( &first, element ) );
+	TEST_REQUIRE( alias && alias != element );
+	TEST_REQUIRE( strcmp( alias, "zero copy" ) == 0 );
+
+	/* Elements taken through one mapping can be returned through the other */
+	shared_pool_return( &second, alias );
+	TEST_REQUIRE( shared_pool_take( &first ) == element );
+	strcpy( element, "zero copy" );
+
+	/* The memory outlives any one mapping of it */
+	shared_pool_detach( &first );
+	TEST_REQUIRE( strcmp( alias, "zero copy" ) == 0 );
+	shared_pool_detach( &second );
+}
+
+static void _ensure_shared_pool_is_shared_with_child_process( void )
+{
+	shared_pool_t pool;
+	size_t offset = 0;
+	int fds[ 2 ], status;
+	char * message;
+	pid_t child;
+
+	TEST_REQUIRE( shared_pool_create( &pool, 0, 64, 4 ) );
+	TEST_REQUIRE( pipe( fds ) == 0 );
+
+	child = fork( );
+	TEST_REQUIRE( child >= 0 );
+	if ( child == 0 )
+	{
+		shared_pool_t attached;
+		if ( !shared_pool_attach_fd( &attached, shared_pool_fd( &pool ) ) )
+		{
+			_exit( 1 );
+		}
+
+		message = ( char * ) shared_pool_take( &attached );
+		if ( !message )
+		{
+			_exit( 2 );
+		}
+
+		strcpy( message, "from the child" );
+		offset = shared_pool_offset( &attached, message );
+		_exit( write( fds[ 1 ], &offset, sizeof( offset ) ) == sizeof( offset ) ? 0 : 3 );
+	}
+
+	TEST_REQUIRE( read( fds[ 0 ], &offset, sizeof( offset ) ) == sizeof( offset ) );
+	TEST_REQUIRE( waitpid( child, &status, 0 ) == child );
+	TEST_REQUIRE( WIFEXITED( status ) && WEXITSTATUS( status ) == 0 );
+
+	message = ( char * ) shared_pool_address( &pool, offset );
+	TEST_REQUIRE( message );
+	TEST_REQUIRE( strcmp( message, "from the child" ) == 0 );
+
+	shared_pool_return( &pool, message );
+	TEST_REQUIRE( shared_pool_take( &pool ) == message );
+
+	close( fds[ 0 ] );
+	close( fds[ 1 ] );
+	shared_pool_detach( &pool );
+}
+
+static void _ensure_shared_pool_survives_concurrent_processes( void )
+{
+	shared_pool_t pool;
+	int i, status, failures = 0;
+	pid_t child;
+
+	TEST_REQUIRE( shared_pool_create( &pool, 0, sizeof( pid_t ), 3 ) );
+
+	child = fork( );
+	TEST_REQUIRE( child >= 0 );
+
+	/* Both processes repeatedly take an element, mark it as their own, and check
+	 * that nobody else took it too */
+	for ( i = 0; i < 20000; ++i )
+	{
+		pid_t * element = ( pid_t * ) shared_pool_take( &pool );
+		if ( element )
+		{
+			*element = getpid( );
+			if ( i % 64 == 0 )
+			{
+				sched_yield( );
+			}
+			failures += *element != getpid( );
+			shared_pool_return( &pool, element );
+		}
+	}
+
+	if ( child == 0 )
+	{
+		_exit( failures ? 1 : 0 );
+	}
+
+	TEST_REQUIRE( waitpid( child, &status, 0 ) == child );
+	TEST_REQUIRE( WIFEXITED( status ) && WEXITSTATUS( status ) == 0 );
+	TEST_REQUIRE( failures == 0 );
+
+	/* Every element is back on the free list */
+	for ( i = 0; i < 3; ++i )
+	{
+		TEST_REQUIRE( shared_pool_take( &pool ) );
+	}
+	TEST_REQUIRE( shared_pool_is_empty( &pool ) );
+	shared_pool_detach( &pool );
+}
+
+static void _ensure_shared_pool_can_be_attached_by_name( void )
+{
+	shared_pool_t pool, attached, duplicate;
+	char name[ 64 ];
+	void * element;
+
+	sprintf( name, "/libmem-shared-pool-tests-%d", ( int ) getpid( ) );
+	shared_pool_unlink( name );
+
+	TEST_REQUIRE( shared_pool_create( &pool, name, 16, 2 ) );
+	TEST_REQUIRE( !shared_pool_create( &duplicate, name, 16, 2 ) );
+	TEST_REQUIRE( shared_pool_attach( &attached, name ) );
+
+	element = shared_pool_take( &attached );
+	TEST_REQUIRE( element );
+	TEST_REQUIRE( shared_pool_address( &pool, shared_pool_offset( &attached, element ) ) );
+	TEST_REQUIRE( shared_pool_take( &pool ) );
+	TEST_REQUIRE( shared_pool_is_empty( &pool ) && shared_pool_is_empty( &attached ) );
+
+	TEST_REQUIRE( shared_pool_unlink( name ) );
+	TEST_REQUIRE( !shared_pool_attach( &duplicate, name ) );
+	TEST_REQUIRE( !shared_pool_unlink( name ) );
+
+	shared_pool_detach( &attached );
+	shared_pool_detach( &pool );
+}
+
+static void _ensure_shared_pool_rejects_invalid_regions( void )
+{
+	shared_pool_t pool;
+	int fds[ 2 ];
+
+	TEST_REQUIRE( !shared_pool_create( &pool, 0, 0, 4 ) );
+	TEST_REQUIRE( !shared_pool_create( &pool, 0, 16, 0 ) );
+	TEST_REQUIRE( !shared_pool_create( &pool, 0, ( size_t ) -1, 4 ) );
+	TEST_REQUIRE( !shared_pool_attach_fd( &pool, -1 ) );
+	TEST_REQUIRE( !shared_pool_attach( &pool, 0 ) );
+
+	TEST_REQUIRE( pipe( fds ) == 0 );
+	TEST_REQUIRE( !shared_pool_attach_fd( &pool, fds[ 0 ] ) );
+	TEST_REQUIRE( pool.fd == -1 && pool.header == 0 );
+	close( fds[ 0 ] );
+	close( fds[ 1 ] );
+
+	shared_pool_detach( &pool );
+	shared_pool_detach( 0 );
+	TEST_REQUIRE( shared_pool_take( 0 ) == 0 );
+	TEST_REQUIRE( shared_pool_is_empty( 0 ) );
+}
+
+#if defined(__cplusplus)
+static const char * _shared_pool_test_file = "shared_pool_tests_cpp.tmp";
+#else
+static const char * _shared_pool_test_file = "shared_pool_tests.tmp";
+#endif
+
+typedef struct _shared_pool_node_t
+{
+	struct _shared_pool_node_t * next;
+	int value;
+} _shared_pool_node_t;
+
+static void _relocate_node( void * element, ptrdiff_t delta, void * context )
+{
+	_shared_pool_node_t * node = ( _shared_pool_node_t * ) element;
+	if ( node->next )
+	{
+		node->next = ( _shared_pool_node_t * )( ( char * ) node->next + delta );
+	}
+	++*( int * ) context;
+}
+
+/* Creates a file-backed pool holding a list of two nodes and one returned element,
+ * returning the offset of the head of the list */
+static size_t _create_node_file( void ** base, size_t * size )
+{
+	shared_pool_t pool;
+	_shared_pool_node_t * a, * b;
+	void * c;
+	size_t offset;
+
+	TEST_REQUIRE( shared_pool_create_file( &pool, _shared_pool_test_file, sizeof( _shared_pool_node_t ), 8 ) );
+	a = ( _shared_pool_node_t * ) shared_pool_take( &pool );
+	b = ( _shared_pool_node_t * ) shared_pool_take( &pool );
+	c = shared_pool_take( &pool );
+	a->next = b;
+	a->value = 1;
+	b->next = 0;
+	b->value = 2;
+	shared_pool_return( &pool, c );
+
+	TEST_REQUIRE( shared_pool_sync( &pool ) );
+	offset = shared_pool_offset( &pool, a );
+	*base = pool.header;
+	*size = pool.size;
+	shared_pool_detach( &pool );
+	return offset;
+}
+
+static void _require_node_list( shared_pool_t * pool, size_t offset )
+{
+	_shared_pool_node_t * a = ( _shared_pool_node_t * ) shared_pool_address( pool, offset );
+	TEST_REQUIRE( a && a->value == 1 );
+	TEST_REQUIRE( shared_pool_offset( pool, a->next ) == offset + pool->header->element_size );
+	TEST_REQUIRE( a->next->value == 2 && !a->next->next );
+}
+
+static void _ensure_shared_pool_file_is_restored_without_fix_up( void )
+{
+	shared_pool_t pool;
+	size_t offset, size, i;
+	int relocated = 0;
+	void * base;
+
+	offset = _create_node_file( &base, &size );
+	TEST_REQUIRE( shared_pool_open_file( &pool, _shared_pool_test_file, _relocate_node, &relocated ) );
+	TEST_REQUIRE( relocated == 0 || ( void * ) pool.header != base );
+	_require_node_list( &pool, offset );
+
+	/* The free list survives too - the returned element comes back first */
+	TEST_REQUIRE( shared_pool_offset( &pool, shared_pool_take( &pool ) ) == offset + 2 * pool.header->element_size );
+	for ( i = 3; i < 8; ++i )
+	{
+		TEST_REQUIRE( shared_pool_take( &pool ) );
+	}
+	TEST_REQUIRE( shared_pool_is_empty( &pool ) );
+
+	shared_pool_detach( &pool );
+	remove( _shared_pool_test_file );
+}
+
+static void _ensure_shared_pool_file_relocates_elements_in_use_when_moved( void )
+{
+	shared_pool_t pool;
+	size_t offset, size;
+	int relocated = 0, fd;
+	void * base, * blocker;
+
+	offset = _create_node_file( &base, &size );
+
+	/* Occupy the pool's previous address, forcing it to be mapped elsewhere */
+	fd = open( _shared_pool_test_file, O_RDONLY );
+	TEST_REQUIRE( fd >= 0 );
+	blocker = mmap( base, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	TEST_REQUIRE( blocker != MAP_FAILED );
+	close( fd );
+
+	TEST_REQUIRE( shared_pool_open_file( &pool, _shared_pool_test_file, _relocate_node, &relocated ) );
+	if ( blocker == base )
+	{
+		TEST_REQUIRE( ( void * ) pool.header != base );
+		TEST_REQUIRE( relocated == 2 );
+	}
+	_require_node_list( &pool, offset );
+	shared_pool_detach( &pool );
+
+	/* Once relocated, reopening at the new address needs no further relocation */
+	TEST_REQUIRE( shared_pool_open_file( &pool, _shared_pool_test_file, 0, 0 ) );
+	_require_node_list( &pool, offset );
+	shared_pool_detach( &pool );
+
+	munmap( blocker, size );
+	remove( _shared_pool_test_file );
+}
+
+static void _ensure_shared_pool_open_file_rejects_other_files( void )
+{
+	shared_pool_t pool;
+	FILE * file;
+
+	remove( _shared_pool_test_file );
+	TEST_REQUIRE( !shared_pool_open_file( &pool, _shared_pool_test_file, 0, 0 ) );
+	TEST_REQUIRE( !shared_pool_open_file( &pool, 0, 0, 0 ) );
+	TEST_REQUIRE( !shared_pool_create_file( &pool, 0, 16, 4 ) );
+	TEST_REQUIRE( !shared_pool_sync( &pool ) );
+
+	file = fopen( _shared_pool_test_file, "wb" );
+	TEST_REQUIRE( file );
+	TEST_REQUIRE( fwrite( "this is not a shared pool, just some text long enough", 1, 53, file ) == 53 );
+	fclose( file );
+
+	TEST_REQUIRE( !shared_pool_open_file( &pool, _shared_pool_test_file, 0, 0 ) );
+	TEST_REQUIRE( pool.header == 0 && pool.fd == -1 );
+	remove( _shared_pool_test_file );
+}
+
+int main( int argc, char * argv[] )
+{
+	UNUSED( argc );
+	UNUSED( argv );
+
+	_ensure_shared_pool_take_returns_distinct_elements_until_empty( );
+	_ensure_shared_pool_ignores_foreign_addresses( );
+	_ensure_shared_pool_stops_at_corrupt_links( );
+	_ensure_shared_pool_offsets_identify_elements_across_mappings( );
+	_ensure_shared_pool_is_shared_with_child_process( );
+	_ensure_shared_pool_survives_concurrent_processes( );
+	_ensure_shared_pool_can_be_attached_by_name( );
+	_ensure_shared_pool_rejects_invalid_regions( );
+	_ensure_shared_pool_file_is_restored_without_fix_up( );
+	_ensure_shared_pool_file_relocates_elements_in_use_when_moved( );
+	_ensure_shared_pool_open_file_rejects_other_files( );
+	return 0;
+}
@@ -0,0 +1 @@
+shared_pool_tests.c
\ No newline at end of file
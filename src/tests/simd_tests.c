@@ -0,0 +1,155 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "../mem/internal/simd.h"
+#include "../mem/internal/unused.h"
+#include "testing.h"
+
+#define SIMD_TEST_LENGTH 1200
+
+/* Lengths and offsets chosen to exercise the vector loops and the scalar tails at
+ * every level */
+static const size_t _lengths[] = { 0, 1, 15, 16, 17, 31, 32, 33, 63, 64, 65, 127, 200, 256, 1100 };
+static const size_t _offsets[] = { 0, 1, 7, 31 };
+
+#define COUNT( array ) ( sizeof( array ) / sizeof( array[ 0 ] ) )
+
+static void _ensure_simd_set_level_clamps_to_supported_level( void )
+{
+	int highest = simd_set_level( SIMD_AVX512 );
+	TEST_REQUIRE( highest >= SIMD_SCALAR && highest <= SIMD_AVX512 );
+	TEST_REQUIRE( simd_level( ) == highest );
+	TEST_REQUIRE( simd_set_level( -1 ) == SIMD_SCALAR );
+	TEST_REQUIRE( simd_level( ) == SIMD_SCALAR );
+	simd_set_level( highest );
+}
+
+static void _ensure_simd_cache_size_is_stable( void )
+{
+	size_t size = simd_cache_size( );
+	TEST_REQUIRE( size == 0 || size >= 1024 );
+	TEST_REQUIRE( simd_cache_size( ) == size );
+}
+
+static void _ensure_simd_fill_sets_exactly_the_given_bytes( void )
+{
+	unsigned char data[ SIMD_TEST_LENGTH ];
+	size_t i, j, k;
+
+	for ( i = 0; i < COUNT( _lengths ); ++i )
+	{
+		for ( j = 0; j < COUNT( _offsets ); ++j )
+		{
+			memset( data, 0, sizeof( data ) );
+			simd_fill( data + _offsets[ j ], 0xAB, _lengths[ i ] );
+			for ( k = 0; k < sizeof( data ); ++k )
+			{
+				int inside = k >= _offsets[ j ] && k < _offsets[ j ] + _lengths[ i ];
+				TEST_REQUIRE( data[ k ] == ( inside ? 0xAB : 0 ) );
+			}
+		}
+	}
+}
+
+static void _ensure_simd_copy_streaming_copies_exactly_the_given_bytes( void )
+{
+	unsigned char source[ SIMD_TEST_LENGTH ], destination[ SIMD_TEST_LENGTH ];
+	size_t i, j, k;
+
+	for ( k = 0; k < sizeof( source ); ++k )
+	{
+		source[ k ] = ( unsigned char ) ( k * 7 + 1 );
+	}
+
+	for ( i = 0; i < COUNT( _lengths ); ++i )
+	{
+		for ( j = 0; j < COUNT( _offsets ); ++j )
+		{
+			memset( destination, 0, sizeof( destination ) );
+			simd_copy_streaming( destination + _offsets[ j ], source + 3, _lengths[ i ] );
+			for ( k = 0; k < sizeof( destination ); ++k )
+			{
+				int inside = k >= _offsets[ j ] && k < _offsets[ j ] + _lengths[ i ];
+				TEST_REQUIRE( destination[ k ] == ( inside ? source[ k - _offsets[ j ] + 3 ] : 0 ) );
+			}
+		}
+	}
+}
+
+static void _ensure_simd_find_returns_first_matching_byte( void )
+{
+	unsigned char data[ SIMD_TEST_LENGTH ];
+	size_t i, j;
+
+	memset( data, 'a', sizeof( data ) );
+	for ( i = 0; i < COUNT( _lengths ); ++i )
+	{
+		for ( j = 0; j < _lengths[ i ]; ++j )
+		{
+			data[ 5 + j ] = 0xF0;
+			data[ 5 + _lengths[ i ] - 1 ] = 0xF0;
+			TEST_REQUIRE( simd_find( data + 5, 0xF0, _lengths[ i ] ) == data + 5 + j );
+			data[ 5 + j ] = 'a';
+			data[ 5 + _lengths[ i ] - 1 ] = 'a';
+		}
+		TEST_REQUIRE( simd_find( data + 5, 0xF0, _lengths[ i ] ) == 0 );
+	}
+}
+
+static void _ensure_simd_find_ignores_bytes_beyond_length( void )
+{
+	unsigned char data[ SIMD_TEST_LENGTH ];
+	memset( data, 'a', sizeof( data ) );
+	data[ 100 ] = 'b';
+	TEST_REQUIRE( simd_find( data, 'b', 100 ) == 0 );
+	TEST_REQUIRE( simd_find( data, 'b', 101 ) == data + 100 );
+}
+
+static void _ensure_simd_equal_detects_any_difference( void )
+{
+	unsigned char a[ SIMD_TEST_LENGTH ], b[ SIMD_TEST_LENGTH ];
+	size_t i, j;
+
+	for ( i = 0; i < sizeof( a ); ++i )
+	{
+		a[ i ] = b[ i ] = ( unsigned char ) i;
+	}
+
+	for ( i = 0; i < COUNT( _lengths ); ++i )
+	{
+		TEST_REQUIRE( simd_equal( a + 1, b + 1, _lengths[ i ] ) );
+		for ( j = 0; j < _lengths[ i ]; ++j )
+		{
+			b[ 1 + j ] ^= 0x80;
+			TEST_REQUIRE( !simd_equal( a + 1, b + 1, _lengths[ i ] ) );
+			b[ 1 + j ] ^= 0x80;
+		}
+	}
+
+	b[ 200 ] ^= 1;
+	TEST_REQUIRE( simd_equal( a, b, 200 ) );
+}
+
+int main( int argc, char * argv[] )
+{
+	int level, highest;
+	UNUSED( argc );
+	UNUSED( argv );
+
+	_ensure_simd_set_level_clamps_to_supported_level( );
+	_ensure_simd_cache_size_is_stable( );
+
+	/* Run every test against every level the machine supports */
+	highest = simd_level( );
+	for ( level = SIMD_SCALAR; level <= highest; ++level )
+	{
+		TEST_REQUIRE( simd_set_level( level ) == level );
+		_ensure_simd_fill_sets_exactly_the_given_bytes( );
+		_ensure_simd_copy_streaming_copies_exactly_the_given_bytes( );
+		_ensure_simd_find_returns_first_matching_byte( );
+		_ensure_simd_find_ignores_bytes_beyond_length( );
+		_ensure_simd_equal_detects_any_difference( );
+	}
+
+	return 0;
+}
@@ -0,0 +1 @@
+simd_tests.c
\ No newline at end of file
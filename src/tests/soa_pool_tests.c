@@ -0,0 +1,134 @@
+#include <string.h>
+
+#include "../mem/soa_pool.h"
+#include "../mem/internal/unused.h"
+#include "testing.h"
+
+typedef struct _connection_cold_t
+{
+	char name[ 240 ];
+	size_t requests;
+
+} _connection_cold_t;
+
+static void _ensure_soa_pool_init_lays_out_aligned_field_arrays( void )
+{
+	size_t sizes[ 3 ];
+	allocator_counted_t alloc;
+	soa_pool_t pool;
+	size_t field;
+
+	sizes[ 0 ] = sizeof( uint64_t );
+	sizes[ 1 ] = sizeof( _connection_cold_t );
+	sizes[ 2 ] = 1;
+
+	allocator_counted_init_default( &alloc );
+	soa_pool_init( &pool, sizes, 3, 100, allocator_counted_get( &alloc ) );
+	TEST_REQUIRE( soa_pool_capacity( &pool ) == 100 );
+	TEST_REQUIRE( pool.num_fields == 3 );
+
+	for ( field = 0; field < 3; ++field )
+	{
+		int8_t * array = ( int8_t * ) soa_pool_field( &pool, field );
+		TEST_REQUIRE( array );
+		TEST_REQUIRE( ( ( size_t ) array ) % SOA_POOL_ALIGNMENT == 0 );
+		if ( field )
+		{
+			TEST_REQUIRE( array >= ( int8_t * ) soa_pool_field( &pool, field - 1 ) + sizes[ field - 1 ] * 100 );
+		}
+	}
+	TEST_REQUIRE( soa_pool_field( &pool, 3 ) == 0 );
+
+	soa_pool_cleanup( &pool );
+	TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) == 0 );
+	TEST_REQUIRE( soa_pool_capacity( &pool ) == 0 );
+	TEST_REQUIRE( soa_pool_take( &pool ) == HANDLE_NULL );
+
+	soa_pool_init( &pool, sizes, SOA_POOL_MAX_FIELDS + 1, 100, allocator_counted_get( &alloc ) );
+	TEST_REQUIRE( soa_pool_capacity( &pool ) == 0 );
+	soa_pool_cleanup( &pool );
+}
+
+static void _ensure_soa_pool_stores_fields_by_index( void )
+{
+	size_t sizes[ 2 ];
+	soa_pool_t * pool;
+	handle_t a, b;
+	uint64_t * deadline;
+	_connection_cold_t * cold;
+
+	sizes[ 0 ] = sizeof( uint64_t );
+	sizes[ 1 ] = sizeof( _connection_cold_t );
+	pool = soa_pool_new( sizes, 2, 4, allocator_default( ) );
+
+	a = soa_pool_take( pool );
+	b = soa_pool_take( pool );
+	TEST_REQUIRE( a != HANDLE_NULL && b != HANDLE_NULL );
+
+	deadline = ( uint64_t * ) soa_pool_get( pool, a, 0 );
+	TEST_REQUIRE( deadline == ( uint64_t * ) soa_pool_field( pool, 0 ) + handle_index( a ) );
+	*deadline = 42;
+	cold = ( _connection_cold_t * ) soa_pool_get( pool, a, 1 );
+	TEST_REQUIRE( cold == ( _connection_cold_t * ) soa_pool_field( pool, 1 ) + handle_index( a ) );
+	strcpy( cold->name, "a" );
+
+	TEST_REQUIRE( soa_pool_get( pool, a, 2 ) == 0 );
+	TEST_REQUIRE( soa_pool_return( pool, a ) );
+	TEST_REQUIRE( soa_pool_get( pool, a, 0 ) == 0 );
+	TEST_REQUIRE( !soa_pool_return( pool, a ) );
+	TEST_REQUIRE( soa_pool_return( pool, b ) );
+
+	soa_pool_delete( pool );
+}
+
+static void _ensure_soa_pool_supports_sweeping_one_field( void )
+{
+	size_t sizes[ 2 ], index, expired = 0;
+	soa_pool_t pool;
+	handle_t handles[ 8 ];
+	uint64_t * deadlines;
+
+	sizes[ 0 ] = sizeof( uint64_t );
+	sizes[ 1 ] = sizeof( _connection_cold_t );
+	soa_pool_init( &pool, sizes, 2, 8, allocator_default( ) );
+
+	for ( index = 0; index < 8; ++index )
+	{
+		handles[ index ] = soa_pool_take( &pool );
+		*( uint64_t * ) soa_pool_get( &pool, handles[ index ], 0 ) = index;
+	}
+	TEST_REQUIRE( soa_pool_is_empty( &pool ) );
+
+	soa_pool_return( &pool, handles[ 1 ] );
+	soa_pool_return( &pool, handles[ 6 ] );
+
+	/* Expire every taken element with a deadline below 5, reading only the
+	 * deadline array */
+	deadlines = ( uint64_t * ) soa_pool_field( &pool, 0 );
+	for ( index = 0; index < soa_pool_capacity( &pool ); ++index )
+	{
+		handle_t handle = soa_pool_handle( &pool, index );
+		if ( handle != HANDLE_NULL && deadlines[ index ] < 5 )
+		{
+			TEST_REQUIRE( soa_pool_return( &pool, handle ) );
+			++expired;
+		}
+	}
+
+	TEST_REQUIRE( expired == 4 );
+	TEST_REQUIRE( soa_pool_handle( &pool, handle_index( handles[ 7 ] ) ) == handles[ 7 ] );
+	TEST_REQUIRE( soa_pool_handle( &pool, handle_index( handles[ 0 ] ) ) == HANDLE_NULL );
+	TEST_REQUIRE( soa_pool_handle( &pool, 8 ) == HANDLE_NULL );
+	soa_pool_cleanup( &pool );
+}
+
+int main( int argc, char * argv[] )
+{
+	UNUSED( argc );
+	UNUSED( argv );
+
+	_ensure_soa_pool_init_lays_out_aligned_field_arrays( );
+	_ensure_soa_pool_stores_fields_by_index( );
+	_ensure_soa_pool_supports_sweeping_one_field( );
+	return 0;
+}
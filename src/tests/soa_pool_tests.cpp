@@ -0,0 +1 @@
+soa_pool_tests.c
\ No newline at end of file
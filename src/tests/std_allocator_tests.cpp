@@ -0,0 +1,147 @@
+#include <map>
+#include <new>
+#include <vector>
+
+#include "../mem/std_allocator.hpp"
+#include "../mem/internal/unused.h"
+#include "testing.h"
+
+struct alignas( 64 ) _overaligned_t
+{
+	char data[ 8 ];
+};
+
+static void _ensure_std_allocator_backs_vector_with_given_allocator( void )
+{
+	allocator_counted_t alloc;
+	allocator_counted_init_default( &alloc );
+	{
+		mem::StdAllocator< int > std_alloc( allocator_counted_get( &alloc ) );
+		std::vector< int, mem::StdAllocator< int > > values( std_alloc );
+		values.push_back( 1 );
+		values.push_back( 2 );
+		TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) >= 2 * sizeof( int ) );
+	}
+	TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) == 0 );
+}
+
+static void _ensure_std_allocator_supports_node_based_containers( void )
+{
+	typedef std::pair< const int, int > value_t;
+	allocator_counted_t alloc;
+	allocator_counted_init_default( &alloc );
+	{
+		mem::StdAllocator< value_t > std_alloc( allocator_counted_get( &alloc ) );
+		std::map< int, int, std::less< int >, mem::StdAllocator< value_t > > values( std::less< int >( ), std_alloc );
+		values[ 1 ] = 2;
+		values[ 3 ] = 4;
+		TEST_REQUIRE( values[ 3 ] == 4 );
+		TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) > 0 );
+	}
+	TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) == 0 );
+}
+
+static void _ensure_std_allocator_respects_type_alignment( void )
+{
+	allocator_counted_t alloc;
+	allocator_counted_init_default( &alloc );
+	{
+		mem::StdAllocator< _overaligned_t > std_alloc( allocator_counted_get( &alloc ) );
+		_overaligned_t * values = std_alloc.allocate( 3 );
+		TEST_REQUIRE( ( ( size_t ) values ) % 64 == 0 );
+		std_alloc.deallocate( values, 3 );
+	}
+	TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) == 0 );
+}
+
+static void _ensure_std_allocator_throws_when_allocation_fails( void )
+{
+	bool thrown = false;
+	mem::StdAllocator< int > std_alloc( allocator_always_fail( ) );
+	try
+	{
+		std_alloc.allocate( 1 );
+	}
+	catch ( const std::bad_alloc & )
+	{
+		thrown = true;
+	}
+	TEST_REQUIRE( thrown );
+}
+
+static void _ensure_std_allocator_compares_by_underlying_allocator( void )
+{
+	mem::StdAllocator< int > a( allocator_default( ) );
+	mem::StdAllocator< long > b( allocator_default( ) );
+	mem::StdAllocator< int > c( allocator_always_fail( ) );
+	TEST_REQUIRE( a == b );
+	TEST_REQUIRE( a != c );
+}
+
+#if defined( LIBMEM_HAS_MEMORY_RESOURCE )
+
+static void _ensure_memory_resource_backs_pmr_vector_with_given_allocator( void )
+{
+	allocator_counted_t alloc;
+	allocator_counted_init_default( &alloc );
+	{
+		mem::MemoryResource resource( allocator_counted_get( &alloc ) );
+		std::pmr::vector< int > values( &resource );
+		values.push_back( 1 );
+		TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) >= sizeof( int ) );
+	}
+	TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) == 0 );
+}
+
+static void _ensure_memory_resource_respects_requested_alignment( void )
+{
+	allocator_counted_t alloc;
+	void * address;
+
+	allocator_counted_init_default( &alloc );
+	mem::MemoryResource resource( allocator_counted_get( &alloc ) );
+	address = resource.allocate( 100, 128 );
+	TEST_REQUIRE( ( ( size_t ) address ) % 128 == 0 );
+	resource.deallocate( address, 100, 128 );
+	TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) == 0 );
+}
+
+static void _ensure_memory_resource_supports_zero_length_allocations( void )
+{
+	void * address;
+	mem::MemoryResource resource( allocator_default( ) );
+	address = resource.allocate( 0 );
+	TEST_REQUIRE( address );
+	resource.deallocate( address, 0 );
+}
+
+static void _ensure_memory_resource_compares_by_underlying_allocator( void )
+{
+	mem::MemoryResource a( allocator_default( ) );
+	mem::MemoryResource b( allocator_default( ) );
+	mem::MemoryResource c( allocator_always_fail( ) );
+	TEST_REQUIRE( a.is_equal( b ) );
+	TEST_REQUIRE( !a.is_equal( c ) );
+	TEST_REQUIRE( !a.is_equal( *std::pmr::new_delete_resource( ) ) );
+}
+
+#endif /* LIBMEM_HAS_MEMORY_RESOURCE */
+
+int main( int argc, char * argv[] )
+{
+	UNUSED( argc );
+	UNUSED( argv );
+
+	_ensure_std_allocator_backs_vector_with_given_allocator( );
+	_ensure_std_allocator_supports_node_based_containers( );
+	_ensure_std_allocator_respects_type_alignment( );
+	_ensure_std_allocator_throws_when_allocation_fails( );
+	_ensure_std_allocator_compares_by_underlying_allocator( );
+#if defined( LIBMEM_HAS_MEMORY_RESOURCE )
+	_ensure_memory_resource_backs_pmr_vector_with_given_allocator( );
+	_ensure_memory_resource_respects_requested_alignment( );
+	_ensure_memory_resource_supports_zero_length_allocations( );
+	_ensure_memory_resource_compares_by_underlying_allocator( );
+#endif
+	return 0;
+}
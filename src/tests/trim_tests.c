@@ -0,0 +1,127 @@
+#include "../mem/trim.h"
+#include "../mem/internal/unused.h"
+#include "testing.h"
+
+static size_t _trim_calls = 0;
+
+static size_t _count_trim( void * object, size_t limit )
+{
+	UNUSED( object );
+	++_trim_calls;
+	return limit;
+}
+
+static void _ensure_trim_all_calls_registered_hooks( void )
+{
+	trim_hook_t a, b, c;
+
+	_trim_calls = 0;
+	trim_hook_init( &a, _count_trim, 0, 1 );
+	trim_hook_init( &b, _count_trim, 0, 2 );
+	trim_hook_init( &c, _count_trim, 0, 4 );
+	trim_register( &a );
+	trim_register( &b );
+	trim_register( &c );
+	TEST_REQUIRE( trim_all( ) == 7 );
+	TEST_REQUIRE( _trim_calls == 3 );
+	trim_unregister( &a );
+	trim_unregister( &b );
+	trim_unregister( &c );
+}
+
+static void _ensure_trim_all_skips_unregistered_hooks( void )
+{
+	trim_hook_t a, b, c;
+
+	_trim_calls = 0;
+	trim_hook_init( &a, _count_trim, 0, 1 );
+	trim_hook_init( &b, _count_trim, 0, 2 );
+	trim_hook_init( &c, _count_trim, 0, 4 );
+	trim_register( &a );
+	trim_register( &b );
+	trim_register( &c );
+	trim_unregister( &b );
+	TEST_REQUIRE( trim_all( ) == 5 );
+	trim_unregister( &c );
+	TEST_REQUIRE( trim_all( ) == 1 );
+	trim_unregister( &a );
+	TEST_REQUIRE( trim_all( ) == 0 );
+	TEST_REQUIRE( _trim_calls == 3 );
+}
+
+static void _ensure_trim_all_trims_buffers_and_pools( void )
+{
+	allocator_counted_t alloc;
+	trim_hook_t buffer_hook, pool_hook;
+	buffer_t buffer;
+	pool_t pool;
+
+	allocator_counted_init_default( &alloc );
+	buffer_init( &buffer, allocator_counted_get( &alloc ) );
+	buffer_grow( &buffer, 4096 );
+	pool_init( &pool, 16, 16, allocator_counted_get( &alloc ) );
+
+	trim_hook_init_buffer( &buffer_hook, &buffer, 1024 );
+	trim_hook_init_pool( &pool_hook, &pool );
+	trim_register( &buffer_hook );
+	trim_register( &pool_hook );
+
+	TEST_REQUIRE( trim_all( ) == 3072 + 256 );
+	TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) == 1024 );
+	TEST_REQUIRE( trim_all( ) == 0 );
+
+	trim_unregister( &buffer_hook );
+	trim_unregister( &pool_hook );
+	buffer_cleanup( &buffer );
+	pool_cleanup( &pool );
+	TEST_REQUIRE( allocator_counted_get_current_count( &alloc ) == 0 );
+}
+
+static size_t _reentrant_trim( void * object, size_t limit )
+{
+	trim_hook_t * hook = ( trim_hook_t * ) object;
+	UNUSED( limit );
+	++_trim_calls;
+
+	/* Calls back into the trim API are refused rather than deadlocking */
+	trim_unregister( hook );
+	return trim_all( );
+}
+
+static void _ensure_trim_all_refuses_calls_from_hooks( void )
+{
+	trim_hook_t hook;
+
+	_trim_calls = 0;
+	trim_hook_init( &hook, _reentrant_trim, &hook, 0 );
+	trim_register( &hook );
+	TEST_REQUIRE( trim_all( ) == 0 );
+	TEST_REQUIRE( _trim_calls == 1 );
+
+	/* The hook is still registered */
+	TEST_REQUIRE( trim_all( ) == 0 );
+	TEST_REQUIRE( _trim_calls == 2 );
+	trim_unregister( &hook );
+	TEST_REQUIRE( trim_all( ) == 0 );
+	TEST_REQUIRE( _trim_calls == 2 );
+}
+
+static void _ensure_trim_functions_gracefully_handle_null_hooks( void )
+{
+	trim_hook_init( 0, _count_trim, 0, 0 );
+	trim_register( 0 );
+	trim_unregister( 0 );
+}
+
+int main( int argc, char * argv[] )
+{
+	UNUSED( argc );
+	UNUSED( argv );
+
+	_ensure_trim_all_calls_registered_hooks( );
+	_ensure_trim_all_skips_unregistered_hooks( );
+	_ensure_trim_all_trims_buffers_and_pools( );
+	_ensure_trim_all_refuses_calls_from_hooks( );
+	_ensure_trim_functions_gracefully_handle_null_hooks( );
+	return 0;
+}
@@ -0,0 +1 @@
+trim_tests.c
\ No newline at end of file